@@ -2,6 +2,10 @@
 
 bool hasHeader;
 
+bool isTextFormat;
+
+bool isParquetFormat;
+
 char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
 
 string s3extErrorMessage;
@@ -10,6 +14,7 @@ volatile bool QueryCancelPending = false;
 
 static bool uploadS3(const char *urlWithOptions, const char *fileToUpload);
 static bool downloadS3(const char *urlWithOptions);
+static bool benchmarkS3(const char *urlWithOptions);
 static bool checkConfig(const char *urlWithOptions);
 static void printBucketContents(const ListBucketResult &result);
 static void printTemplate();
@@ -53,6 +58,9 @@ static void printUsage(FILE *stream) {
             "config=path_to_config_file [region=region_name]\", to check the configuration.\n"
             "       gpcheckcloud -d \"s3://endpoint/bucket/prefix "
             "config=path_to_config_file [region=region_name]\", to download and output to stdout.\n"
+            "       gpcheckcloud -b \"s3://endpoint/bucket/prefix "
+            "config=path_to_config_file [region=region_name]\", to download, discard the data\n"
+            "                    and report the throughput every second.\n"
             "       gpcheckcloud -u \"/path/to/file\" \"s3://endpoint/bucket/prefix "
             "config=path_to_config_file [region=region_name]\", to upload a file.\n"
             "       gpcheckcloud -t, to show the config template.\n"
@@ -64,8 +72,9 @@ static map<char, string> parseCommandLineArgs(int argc, char *argv[]) {
     int opt = 0;
     map<char, string> optionPairs;
 
-    while ((opt = getopt(argc, argv, "c:d:u:ht")) != -1) {
+    while ((opt = getopt(argc, argv, "b:c:d:u:ht")) != -1) {
         switch (opt) {
+            case 'b':
             case 'c':
             case 'd':
             case 'h':
@@ -142,13 +151,19 @@ static void printTemplate() {
         "accessid = \"aws access id\"\n"
         "threadnum = 4\n"
         "chunksize = 67108864\n"
+        "splitsize = 1073741824\n"
         "low_speed_limit = 10240\n"
         "low_speed_time = 60\n"
         "encryption = true\n"
         "version = 1\n"
         "proxy = \"\"\n"
         "autocompress = true\n"
+        "compression_type = gzip\n"
         "verifycert = true\n"
+        "reuse_connection = true\n"
+        "http2 = false\n"
+        "autotune = true\n"
+        "connections_per_endpoint = 16\n"
         "server_side_encryption = \"\"\n"
         "# gpcheckcloud config\n"
         "gpcheckcloud_newline = \"\\n\"\n");
@@ -228,6 +243,79 @@ static bool downloadS3(const char *urlWithOptions) {
     return ret;
 }
 
+static void printBenchmarkLine(double seconds, double intervalMB, double intervalSeconds,
+                               double totalMB, const ReadAheadTuner &tuner) {
+    printf("%10.1f %10.2f %12.1f %12" PRIu64 " %6" PRIu64 "\n", seconds,
+           intervalSeconds > 0 ? intervalMB / intervalSeconds : 0, totalMB, tuner.getChunkSize(),
+           tuner.getDepth());
+    fflush(stdout);
+}
+
+// Read like downloadS3() without writing the data, printing the throughput of every second with
+// the chunk size and read-ahead depth in use, so settings can be compared on a real bucket.
+static bool benchmarkS3(const char *urlWithOptions) {
+    if (!urlWithOptions) {
+        return false;
+    }
+
+    int data_len = BUF_SIZE;
+    char data_buf[BUF_SIZE];
+    bool ret = true;
+
+    thread_setup();
+
+    GPReader *reader = reader_init(urlWithOptions);
+    if (!reader) {
+        return false;
+    }
+
+    const ReadAheadTuner &tuner = reader->getCommonReader().getKeyReader().getTuner();
+    const double MB = 1024.0 * 1024.0;
+
+    printf("%10s %10s %12s %12s %6s\n", "seconds", "MB/s", "total MB", "chunk size", "depth");
+
+    uint64_t startUsecs = GetMonotonicUsecs();
+    uint64_t lastUsecs = startUsecs;
+    uint64_t totalBytes = 0;
+    uint64_t lastBytes = 0;
+
+    do {
+        data_len = BUF_SIZE;
+
+        if (!reader_transfer_data(reader, data_buf, data_len)) {
+            fprintf(stderr, "Failed to read data from Amazon S3\n");
+            ret = false;
+            break;
+        }
+
+        totalBytes += data_len;
+
+        uint64_t nowUsecs = GetMonotonicUsecs();
+        if (nowUsecs - lastUsecs >= 1000000) {
+            printBenchmarkLine((nowUsecs - startUsecs) / 1e6, (totalBytes - lastBytes) / MB,
+                               (nowUsecs - lastUsecs) / 1e6, totalBytes / MB, tuner);
+            lastUsecs = nowUsecs;
+            lastBytes = totalBytes;
+        }
+    } while (data_len && !S3QueryIsAbortInProgress());
+
+    uint64_t endUsecs = GetMonotonicUsecs();
+    if (endUsecs > lastUsecs) {
+        printBenchmarkLine((endUsecs - startUsecs) / 1e6, (totalBytes - lastBytes) / MB,
+                           (endUsecs - lastUsecs) / 1e6, totalBytes / MB, tuner);
+    }
+
+    double seconds = (endUsecs - startUsecs) / 1e6;
+    printf("\nRead %.1f MB in %.1f seconds, %.2f MB/s.\n", totalBytes / MB, seconds,
+           seconds > 0 ? totalBytes / MB / seconds : 0);
+
+    reader_cleanup(&reader);
+
+    thread_cleanup();
+
+    return ret;
+}
+
 static bool uploadS3(const char *urlWithOptions, const char *fileToUpload) {
     if (!urlWithOptions) {
         return false;
@@ -306,6 +394,9 @@ int main(int argc, char *argv[]) {
             case 'd':
                 ret = downloadS3(arg);
                 break;
+            case 'b':
+                ret = benchmarkS3(arg);
+                break;
             case 'u':
             case 'f':
                 ret = uploadS3(optionPairs['u'].c_str(), optionPairs['f'].c_str());
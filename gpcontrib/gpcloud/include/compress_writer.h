@@ -6,6 +6,10 @@
 #include "s3macros.h"
 #include "writer.h"
 
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
 // 2MB by default
 extern uint64_t S3_ZIP_COMPRESS_CHUNKSIZE;
 
@@ -32,10 +36,19 @@ class CompressWriter : public Writer {
 
     Writer *writer;
 
+    S3CompressionType compressionType;
+
     // zlib related variables.
     z_stream zstream;
     char *out;  // Output buffer for compression.
 
+#ifdef HAVE_LIBZSTD
+    uint64_t writeOneChunkZstd(const char *buf, uint64_t count);
+    void closeZstd();
+
+    ZSTD_CStream *zstdStream;
+#endif
+
     // add this flag to make close() reentrant
     bool isClosed;
 };
@@ -7,6 +7,10 @@
 #include "s3macros.h"
 #include "s3params.h"
 
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
 // 2MB by default
 extern uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE;
 
@@ -26,19 +30,42 @@ class DecompressReader : public Reader {
 
     void setReader(Reader *reader);
 
+    // S3_COMPRESSION_GZIP (the default) or S3_COMPRESSION_ZSTD, call it before open().
+    void setCompressionType(S3CompressionType type) {
+        this->compressionType = type;
+    }
+
     void resizeDecompressReaderBuffer(uint64_t size);
 
    private:
     void decompress();
 
     uint64_t getDecompressedBytesNum() {
+#ifdef HAVE_LIBZSTD
+        if (this->compressionType == S3_COMPRESSION_ZSTD) {
+            return this->zstdOut.pos;
+        }
+#endif
         return S3_ZIP_DECOMPRESS_CHUNKSIZE - this->zstream.avail_out;
     }
 
     Reader *reader;
 
+    S3CompressionType compressionType;
+
     // zlib related variables.
     z_stream zstream;
+
+#ifdef HAVE_LIBZSTD
+    void decompressZstd();
+
+    // zstd related variables.
+    ZSTD_DStream *zstdStream;
+    ZSTD_inBuffer zstdIn;
+    ZSTD_outBuffer zstdOut;
+    bool zstdFrameEnd;      // no frame is partially decoded
+    bool zstdFlushPending;  // out was filled up, more output may be buffered in zstdStream
+#endif
     char *in;            // Input buffer for decompression.
     char *out;           // Output buffer for decompression.
     uint64_t outOffset;  // Next position to read in out buffer.
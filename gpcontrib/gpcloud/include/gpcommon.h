@@ -11,6 +11,8 @@ extern bool S3QueryIsAbortInProgress(void);
 #define EOL_CHARS_MAX_LEN 2   // '\n', '\r', '\r\n'
 extern char eolString[];
 extern bool hasHeader;
+extern bool isTextFormat;
+extern bool isParquetFormat;
 
 // TODO change to functions getgpsegmentId() and getgpsegmentCount()
 
@@ -1,6 +1,7 @@
 #ifndef __GP_READER_H__
 #define __GP_READER_H__
 
+#include "parquet_reader.h"
 #include "reader.h"
 #include "s3bucket_reader.h"
 #include "s3common_headers.h"
@@ -34,10 +35,20 @@ class GPReader : public Reader {
         return params;
     }
 
+    const S3CommonReader &getCommonReader() const {
+        return commonReader;
+    }
+
+    // columns and predicates of the scan, used when the keys are read as Parquet
+    void setParquetScanSpec(const ParquetScanSpec &spec) {
+        parquetReader.setScanSpec(spec);
+    }
+
    protected:
     S3Params params;
     S3BucketReader bucketReader;
     S3CommonReader commonReader;
+    ParquetReader parquetReader;
     S3RESTfulService restfulService;
 
     S3InterfaceService s3InterfaceService;
@@ -48,7 +59,7 @@ class GPReader : public Reader {
 };
 
 // Following 3 functions are invoked by s3_import(), need to be exception safe
-GPReader *reader_init(const char *url_with_options);
+GPReader *reader_init(const char *url_with_options, const ParquetScanSpec *parquetSpec = NULL);
 bool reader_transfer_data(GPReader *reader, char *data_buf, int &data_len);
 bool reader_cleanup(GPReader **reader);
 
@@ -0,0 +1,248 @@
+#ifndef INCLUDE_PARQUET_READER_H_
+#define INCLUDE_PARQUET_READER_H_
+
+#include "reader.h"
+#include "s3common_headers.h"
+#include "s3exception.h"
+#include "s3interface.h"
+
+// ParquetReader streams rows to the s3_parquet_import formatter as:
+//   uint32 row length (including these 4 bytes), then for each table column a tag byte from
+//   ParquetValueTag followed by the value,
+// in host byte order without alignment, so the formatter builds Datums without text parsing.
+enum ParquetValueTag {
+    PARQUET_VALUE_NULL = 0,       // no value, also used for columns the query doesn't need
+    PARQUET_VALUE_BOOL = 1,       // 1 byte
+    PARQUET_VALUE_INT32 = 2,      // 4 bytes
+    PARQUET_VALUE_INT64 = 3,      // 8 bytes
+    PARQUET_VALUE_FLOAT = 4,      // 4 bytes
+    PARQUET_VALUE_DOUBLE = 5,     // 8 bytes
+    PARQUET_VALUE_BYTES = 6,      // uint32 length, then the bytes
+    PARQUET_VALUE_DATE = 7,       // int32 days since 1970-01-01
+    PARQUET_VALUE_TIMESTAMP = 8,  // int64 microseconds since 1970-01-01 00:00:00
+};
+
+enum ParquetCompareOp {
+    PARQUET_OP_LT,
+    PARQUET_OP_LE,
+    PARQUET_OP_EQ,
+    PARQUET_OP_GE,
+    PARQUET_OP_GT,
+};
+
+// "column op value", used to skip row groups whose statistics can't satisfy it.
+struct ParquetPredicate {
+    enum Kind {
+        INT,        // integer
+        DOUBLE,     // floating point
+        STRING,     // UTF-8, compared bytewise
+        DATE,       // days since 1970-01-01, in intValue
+        TIMESTAMP,  // microseconds since 1970-01-01 00:00:00, in intValue
+    };
+
+    ParquetPredicate() : column(0), op(PARQUET_OP_EQ), kind(INT), intValue(0), doubleValue(0) {
+    }
+
+    uint32_t column;  // index into ParquetScanSpec::columns
+    ParquetCompareOp op;
+    Kind kind;
+    int64_t intValue;
+    double doubleValue;
+    string stringValue;
+};
+
+// What a scan needs from the Parquet keys, taken from the external table and the query.
+struct ParquetScanSpec {
+    vector<string> columns;               // table columns, in attribute order
+    vector<bool> projected;               // whether the query uses the column
+    vector<ParquetPredicate> predicates;  // ANDed, only used to skip row groups
+};
+
+// Parquet physical types, as in parquet.thrift
+enum ParquetPhysicalType {
+    PARQUET_BOOLEAN = 0,
+    PARQUET_INT32 = 1,
+    PARQUET_INT64 = 2,
+    PARQUET_INT96 = 3,
+    PARQUET_FLOAT = 4,
+    PARQUET_DOUBLE = 5,
+    PARQUET_BYTE_ARRAY = 6,
+    PARQUET_FIXED_LEN_BYTE_ARRAY = 7,
+};
+
+// Logical types that change how values are converted
+enum ParquetLogicalType {
+    PARQUET_LOGICAL_NONE,
+    PARQUET_LOGICAL_STRING,
+    PARQUET_LOGICAL_DATE,
+    PARQUET_LOGICAL_TIMESTAMP_MILLIS,
+    PARQUET_LOGICAL_TIMESTAMP_MICROS,
+    PARQUET_LOGICAL_TIMESTAMP_NANOS,
+    PARQUET_LOGICAL_DECIMAL,
+};
+
+// A top level field of the Parquet schema.
+struct ParquetColumnSchema {
+    ParquetColumnSchema()
+        : physicalType(PARQUET_BOOLEAN),
+          logicalType(PARQUET_LOGICAL_NONE),
+          typeLength(0),
+          scale(0),
+          optional(false),
+          nested(false),
+          leafIndex(0) {
+    }
+
+    string name;
+    int32_t physicalType;
+    int32_t logicalType;
+    int32_t typeLength;  // FIXED_LEN_BYTE_ARRAY only
+    int32_t scale;       // DECIMAL only
+    bool optional;
+    bool nested;         // a group or a repeated field, which we can't read
+    uint32_t leafIndex;  // index of its column chunk in a row group
+};
+
+struct ParquetColumnChunk {
+    ParquetColumnChunk()
+        : codec(0),
+          numValues(0),
+          dataPageOffset(0),
+          dictionaryPageOffset(0),
+          totalCompressedSize(0),
+          hasNullCount(false),
+          nullCount(0),
+          hasMinMax(false),
+          hasExternalData(false) {
+    }
+
+    // the dictionary page, if any, comes before the data pages
+    uint64_t getStart() const {
+        if (dictionaryPageOffset > 0 && dictionaryPageOffset < dataPageOffset) {
+            return dictionaryPageOffset;
+        }
+        return dataPageOffset;
+    }
+
+    int32_t codec;
+    int64_t numValues;
+    int64_t dataPageOffset;
+    int64_t dictionaryPageOffset;
+    int64_t totalCompressedSize;
+    bool hasNullCount;
+    int64_t nullCount;
+    bool hasMinMax;
+    string minValue;  // plain encoded
+    string maxValue;
+    bool hasExternalData;  // column chunk lives in another file
+};
+
+struct ParquetRowGroup {
+    ParquetRowGroup() : numRows(0) {
+    }
+
+    uint64_t getStart() const;
+    uint64_t getSize() const;
+
+    int64_t numRows;
+    vector<ParquetColumnChunk> columns;  // one per leaf of the schema
+};
+
+struct ParquetFileMetadata {
+    ParquetFileMetadata() : numRows(0), numLeaves(0) {
+    }
+
+    int64_t numRows;
+    vector<ParquetColumnSchema> columns;
+    uint32_t numLeaves;
+    vector<ParquetRowGroup> rowGroups;
+};
+
+// Parse the thrift compact encoded FileMetaData of a Parquet footer.
+void ParseParquetMetadata(const uint8_t* data, uint64_t len, ParquetFileMetadata& metadata);
+
+// Decoded values of one column in a row group
+struct ParquetColumnValues {
+    void clear() {
+        defined.clear();
+        ints.clear();
+        doubles.clear();
+        offsets.clear();
+        bytes.clear();
+    }
+
+    vector<uint8_t> defined;  // per row, 0 for NULL
+    vector<int64_t> ints;     // BOOL, INT32, INT64, DATE and TIMESTAMP values
+    vector<double> doubles;   // FLOAT and DOUBLE values
+    vector<uint64_t> offsets; // BYTES values: value i is bytes[offsets[i], offsets[i + 1])
+    vector<char> bytes;
+};
+
+// ParquetReader reads one Parquet key, or the row groups whose middle byte falls in the key
+// range, so a big key can be shared by several segments. Only the column chunks of projected
+// columns are fetched, each row group with as few range GETs as possible, and row groups whose
+// statistics fail a predicate are not fetched at all.
+class ParquetReader : public Reader {
+   public:
+    ParquetReader();
+    virtual ~ParquetReader() {
+        this->close();
+    }
+
+    virtual void open(const S3Params& params);
+
+    // read() attempts to read up to count bytes into the buffer.
+    // Return 0 if EOF. Throw exception if encounters errors.
+    virtual uint64_t read(char* buf, uint64_t count);
+
+    // This should be reentrant, has no side effects when called multiple times.
+    virtual void close();
+
+    void setS3InterfaceService(S3Interface* s3InterfaceService) {
+        this->s3InterfaceService = s3InterfaceService;
+    }
+
+    void setScanSpec(const ParquetScanSpec& spec) {
+        this->spec = spec;
+    }
+
+    const ParquetFileMetadata& getMetadata() const {
+        return metadata;
+    }
+
+    // bytes fetched from S3 since constructed
+    uint64_t getFetchedBytes() const {
+        return fetchedBytes;
+    }
+
+   private:
+    S3Interface* s3InterfaceService;
+    S3Params params;
+    ParquetScanSpec spec;
+
+    ParquetFileMetadata metadata;
+    vector<int32_t> tableToSchema;  // table column -> metadata.columns, -1 if not read
+    vector<uint8_t> columnTags;     // ParquetValueTag of each table column
+    vector<uint32_t> rowGroups;     // row groups to read, in file order
+    uint64_t rowGroupIndex;         // next one in rowGroups
+
+    vector<ParquetColumnValues> values;  // of the current row group, per table column
+    vector<uint64_t> valueCursors;       // next value per table column
+    uint64_t rowsInGroup;
+    uint64_t nextRow;
+
+    vector<char> outBuf;  // serialized rows not yet returned
+    uint64_t outPos;
+
+    uint64_t fetchedBytes;
+
+    void fetch(uint64_t offset, uint64_t len, S3VectorUInt8& data);
+    void readMetadata(uint64_t keySize);
+    void resolveColumns();
+    bool rowGroupMayMatch(const ParquetRowGroup& rowGroup) const;
+    void selectRowGroups();
+    bool loadNextRowGroup();
+    void serializeRows(uint64_t count);
+};
+
+#endif /* INCLUDE_PARQUET_READER_H_ */
@@ -6,6 +6,26 @@
 #include "s3exception.h"
 #include "s3interface.h"
 
+// A unit of work scheduled to a segment: a whole key, or a byte range of a key larger than
+// splitsize.
+struct KeyPiece {
+    KeyPiece(uint64_t keyIndex, uint64_t offset, uint64_t length)
+        : keyIndex(keyIndex), offset(offset), length(length) {
+    }
+
+    uint64_t keyIndex;  // index of the key in keyList.contents
+    uint64_t offset;
+    uint64_t length;
+};
+
+// Progress of reading a byte range of a key.
+enum RangeState {
+    RANGE_NONE,  // reading a whole key
+    RANGE_SKIP,  // skipping the line that started before the range
+    RANGE_EMIT,  // returning the lines that start within the range
+    RANGE_DONE,
+};
+
 // S3BucketReader read multiple files in a bucket.
 class S3BucketReader : public Reader {
    public:
@@ -28,6 +48,10 @@ class S3BucketReader : public Reader {
         return keyList;
     }
 
+    const vector<KeyPiece> &getKeyPieces() {
+        return keyPieces;
+    }
+
    private:
     S3Params params;
 
@@ -45,11 +69,32 @@ class S3BucketReader : public Reader {
     // copy valid data into buf and return its size.
     uint64_t readWithoutHeaderLine(char *buf, uint64_t count);
 
-    ListBucketResult keyList;  // List of matched keys/files.
-    uint64_t keyIndex;         // BucketContent index of keylist->contents.
+    ListBucketResult keyList;    // List of matched keys/files.
+    vector<KeyPiece> keyPieces;  // Pieces of keyList assigned to this segment.
+    uint64_t pieceIndex;         // Index of the next piece in keyPieces.
+
+    // Assign keys and ranges of large keys to segments, balanced by size.
+    void scheduleKeyPieces();
+
+    KeyPiece &getNextPiece();
+    S3Params constructReaderParams(BucketContent &key, uint64_t offset = 0, uint64_t length = 0);
+
+    // Open upstreamReader for the piece, return false if the piece is to be skipped.
+    bool openPiece(const KeyPiece &piece);
+
+    // State of the range being read, positions are offsets in the key.
+    RangeState rangeState;
+    uint64_t rangeStart;
+    uint64_t rangeEnd;
+    uint64_t readEnd;     // where the current upstream read stops
+    uint64_t curPos;      // offset of the next byte from upstreamReader
+    uint64_t eolMatched;  // chars of eolString matched by the last scan
+    BucketContent *rangeKey;
 
-    BucketContent &getNextKey();
-    S3Params constructReaderParams(BucketContent &key);
+    // Copy only the lines starting within [rangeStart, rangeEnd) into buf.
+    uint64_t readRange(char *buf, uint64_t count);
+    bool findLineEnd(const char *buf, uint64_t len, uint64_t pos, uint64_t bound,
+                     uint64_t *lineEnd);
 };
 
 #endif
@@ -29,6 +29,10 @@ class S3CommonReader : public Reader {
         this->s3InterfaceService = s3InterfaceService;
     }
 
+    const S3KeyReader& getKeyReader() const {
+        return keyReader;
+    }
+
    protected:
     Reader* upstreamReader;
     S3Interface* s3InterfaceService;
@@ -15,11 +15,6 @@
 
 #define S3_RANGE_HEADER_STRING_LEN 128
 
-enum S3CompressionType {
-    S3_COMPRESSION_GZIP,
-    S3_COMPRESSION_PLAIN,
-};
-
 struct BucketContent {
     BucketContent() : name(""), size(0) {
     }
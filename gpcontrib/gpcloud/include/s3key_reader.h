@@ -9,11 +9,12 @@
 struct Range {
     uint64_t offset;
     uint64_t length;
+    uint64_t seq;  // number of ranges handed out before this one
 };
 
 class OffsetMgr {
    public:
-    OffsetMgr() : keySize(0), chunkSize(0), curPos(0) {
+    OffsetMgr() : keySize(0), chunkSize(0), curPos(0), nextSeq(0) {
         pthread_mutex_init(&this->offsetLock, NULL);
     }
     ~OffsetMgr() {
@@ -46,6 +47,7 @@ class OffsetMgr {
         this->setCurPos(0);
         this->setChunkSize(0);
         this->setKeySize(0);
+        this->nextSeq = 0;
     }
 
     uint64_t getCurPos() const {
@@ -54,9 +56,68 @@ class OffsetMgr {
 
    private:
     pthread_mutex_t offsetLock;
-    uint64_t keySize;  // size of S3 key(file)
+    uint64_t keySize;  // size of S3 key(file), or end of the range being read
     uint64_t chunkSize;
     uint64_t curPos;
+    uint64_t nextSeq;
+};
+
+// ReadAheadTuner picks the chunk size and how many chunks are fetched ahead of the consumer
+// (the read-ahead depth) from what it observes. Chunks grow while that makes single fetches
+// faster, and the depth grows when the consumer has to wait for data and shrinks when chunks keep
+// being ready before they are needed. The configured chunksize and threadnum are the ceilings, as
+// S3MemoryContext preallocates that much memory, and the depth bounds how much of it is in use.
+// What is learned carries over to the next key.
+class ReadAheadTuner {
+   public:
+    ReadAheadTuner();
+    ~ReadAheadTuner();
+
+    // Set the ceilings; tuning restarts only if they or the switch changed.
+    void configure(uint64_t maxChunkSize, uint64_t maxDepth, bool enabled);
+
+    // Start a key, chunks are numbered from 0 again.
+    void restart();
+
+    // Release download threads blocked in waitForTurn().
+    void stop();
+
+    // Block a download thread until chunk seq is within the read-ahead depth, or stop() is called.
+    void waitForTurn(uint64_t seq);
+
+    // A download thread fetched len bytes in usecs microseconds.
+    void chunkFetched(uint64_t len, uint64_t usecs);
+
+    // The consumer is done with the next chunk, stalled tells whether it had to wait for it.
+    void chunkConsumed(bool stalled);
+
+    bool isEnabled() const {
+        return enabled;
+    }
+
+    uint64_t getChunkSize() const;
+    uint64_t getDepth() const;
+
+   private:
+    mutable pthread_mutex_t mutex;
+    pthread_cond_t turnCond;
+
+    bool enabled;
+    bool stopped;
+
+    uint64_t maxChunkSize;
+    uint64_t maxDepth;
+
+    uint64_t chunkSize;
+    bool chunkSizeSettled;
+    double prevThroughput;  // bytes per second of chunks half the current size, 0 if unknown
+    uint64_t sampleBytes;
+    uint64_t sampleUsecs;
+    uint64_t sampleCount;
+
+    uint64_t depth;
+    uint64_t consumedChunks;  // of the current key
+    uint64_t readyStreak;     // chunks the consumer found ready in a row
 };
 
 enum ChunkStatus {
@@ -73,6 +134,8 @@ class S3KeyReader : public Reader {
           numOfChunks(0),
           curReadingChunk(0),
           transferredKeyLen(0),
+          keyOffset(0),
+          readToKeyEnd(true),
           s3Interface(NULL),
           hasEol(false),
           eolAppended(false) {
@@ -140,6 +203,14 @@ class S3KeyReader : public Reader {
         return region;
     }
 
+    ReadAheadTuner& getTuner() {
+        return tuner;
+    }
+
+    const ReadAheadTuner& getTuner() const {
+        return tuner;
+    }
+
    private:
     pthread_mutex_t mutexErrorMessage;
 
@@ -152,8 +223,14 @@ class S3KeyReader : public Reader {
     uint64_t numOfChunks;
     uint64_t curReadingChunk;
     uint64_t transferredKeyLen;
+
+    // byte range of the key to read, an EOL is only appended when it reaches the end of the key.
+    uint64_t keyOffset;
+    bool readToKeyEnd;
+
     string region;
     OffsetMgr offsetMgr;
+    ReadAheadTuner tuner;
 
     vector<ChunkBuffer> chunkBuffers;
     vector<pthread_t> threads;
@@ -232,6 +309,8 @@ class ChunkBuffer {
     uint64_t curFileOffset;
     uint64_t curChunkOffset;
     uint64_t chunkDataSize;
+    uint64_t chunkSeq;     // position of the chunk in the key, see OffsetMgr
+    bool consumerWaited;  // read() had to wait for the chunk to be filled
 
     S3VectorUInt8 chunkData;
     OffsetMgr& offsetMgr;
@@ -35,4 +35,25 @@ extern uint64_t S3_ZIP_COMPRESS_CHUNKSIZE;
 // to enable zlib and gzip decoding with automatic header detection.
 #define S3_INFLATE_WINDOWSBITS (MAX_WBITS + 16 + 16)
 
+// zstd's default level, faster than gzip's default level at a similar ratio.
+#define S3_ZSTD_COMPRESSION_LEVEL 3
+
+// Tail of a Parquet key fetched to get its footer, large enough for most footers.
+#define S3_PARQUET_FOOTER_PREFETCH_SIZE (64 * 1024)
+
+// Parquet column chunks closer than this are fetched in one request, as reading the gap costs
+// less than another round trip.
+#define S3_PARQUET_COALESCE_GAP (64 * 1024)
+
+// Adaptive read-ahead starts with chunks of chunksize / S3_AUTOTUNE_START_DIVISOR, but not smaller
+// than S3_AUTOTUNE_MIN_CHUNKSIZE, and doubles them while S3_AUTOTUNE_SAMPLES fetches of the new
+// size are at least S3_AUTOTUNE_GAIN times faster than of the previous size.
+#define S3_AUTOTUNE_START_DIVISOR 8
+#define S3_AUTOTUNE_MIN_CHUNKSIZE (8 * 1024 * 1024)
+#define S3_AUTOTUNE_SAMPLES 2
+#define S3_AUTOTUNE_GAIN 1.1
+
+// One chunk less is fetched ahead after the consumer found this many chunks ready in a row.
+#define S3_AUTOTUNE_READY_STREAK 16
+
 #endif
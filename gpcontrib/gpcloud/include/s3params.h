@@ -7,20 +7,34 @@
 
 enum S3SSEType { SSE_NONE, SSE_S3 };
 
+enum S3CompressionType {
+    S3_COMPRESSION_GZIP,
+    S3_COMPRESSION_PLAIN,
+    S3_COMPRESSION_ZSTD,
+};
+
 class S3Params {
    public:
     S3Params(const string& sourceUrl = "", bool useHttps = true, const string& version = "",
              const string& region = "")
         : s3Url(sourceUrl, useHttps, version, region),
           keySize(0),
+          keyOffset(0),
+          keyLength(0),
           chunkSize(0),
           numOfChunks(0),
+          splitSize(0),
+          connectionsPerEndpoint(0),
           lowSpeedLimit(0),
           lowSpeedTime(0),
           proxy(""),
           debugCurl(false),
           autoCompress(false),
           verifyCert(false),
+          reuseConnection(false),
+          useHttp2(false),
+          autoTune(false),
+          compressionType(S3_COMPRESSION_GZIP),
           sseType(SSE_NONE),
           gpcheckcloud_newline("") {
     }
@@ -72,6 +86,28 @@ class S3Params {
         this->keySize = size;
     }
 
+    uint64_t getKeyOffset() const {
+        return keyOffset;
+    }
+
+    uint64_t getKeyLength() const {
+        return keyLength;
+    }
+
+    // Read only [offset, offset + length) of the key, length 0 means up to the end of the key.
+    void setKeyRange(uint64_t offset, uint64_t length) {
+        this->keyOffset = offset;
+        this->keyLength = length;
+    }
+
+    uint64_t getSplitSize() const {
+        return splitSize;
+    }
+
+    void setSplitSize(uint64_t splitSize) {
+        this->splitSize = splitSize;
+    }
+
     uint64_t getLowSpeedLimit() const {
         return lowSpeedLimit;
     }
@@ -111,6 +147,46 @@ class S3Params {
         this->autoCompress = autoCompress;
     }
 
+    S3CompressionType getCompressionType() const {
+        return compressionType;
+    }
+
+    void setCompressionType(S3CompressionType compressionType) {
+        this->compressionType = compressionType;
+    }
+
+    bool isReuseConnection() const {
+        return reuseConnection;
+    }
+
+    void setReuseConnection(bool reuseConnection) {
+        this->reuseConnection = reuseConnection;
+    }
+
+    bool isUseHttp2() const {
+        return useHttp2;
+    }
+
+    void setUseHttp2(bool useHttp2) {
+        this->useHttp2 = useHttp2;
+    }
+
+    bool isAutoTune() const {
+        return autoTune;
+    }
+
+    void setAutoTune(bool autoTune) {
+        this->autoTune = autoTune;
+    }
+
+    uint64_t getConnectionsPerEndpoint() const {
+        return connectionsPerEndpoint;
+    }
+
+    void setConnectionsPerEndpoint(uint64_t connectionsPerEndpoint) {
+        this->connectionsPerEndpoint = connectionsPerEndpoint;
+    }
+
     const S3MemoryContext& getMemoryContext() const {
         return memoryContext;
     }
@@ -150,12 +226,17 @@ class S3Params {
    private:
     S3Url s3Url;  // original url to read/write.
 
-    uint64_t keySize;  // key/file size.
+    uint64_t keySize;    // key/file size.
+    uint64_t keyOffset;  // start of the byte range to read.
+    uint64_t keyLength;  // length of the byte range to read, 0 means to the end.
 
     S3Credential cred;  // S3 credential.
 
     uint64_t chunkSize;    // chunk size
     uint64_t numOfChunks;  // number of chunks(threads).
+    uint64_t splitSize;    // keys larger than this are read by several segments, 0 to disable.
+
+    uint64_t connectionsPerEndpoint;  // max curl handles kept per endpoint
 
     uint64_t lowSpeedLimit;  // low speed limit
     uint64_t lowSpeedTime;   // low speed timeout
@@ -166,6 +247,11 @@ class S3Params {
     bool autoCompress;  // whether to compress data before uploading
     bool verifyCert;  // This option determines whether curl verifies the authenticity of the peer's
                       // certificate.
+    bool reuseConnection;  // keep connections open between requests
+    bool useHttp2;         // negotiate HTTP/2 over TLS
+    bool autoTune;         // tune chunk size and read-ahead depth to the measured throughput
+
+    S3CompressionType compressionType;  // how to compress data before uploading
 
     S3SSEType sseType;
 
@@ -10,6 +10,49 @@
 #include "s3macros.h"
 #include "s3params.h"
 
+// Process-wide pool of curl easy handles, shared by the reader and writer threads. A handle keeps
+// its connections open after a request, so the next request to the same endpoint skips the TCP
+// and TLS handshakes. DNS results and TLS sessions are shared between all handles.
+class CURLHandlePool {
+   public:
+    static CURLHandlePool& getInstance();
+
+    // Wait while the endpoint of url already has maxHandlesPerEndpoint handles in use.
+    CURL* acquire(const string& url);
+    void release(const string& url, CURL* curl);
+
+    void setMaxHandlesPerEndpoint(uint64_t maxHandles);
+
+    uint64_t getIdleHandles(const string& url);
+
+    // Close all idle handles and their connections.
+    void clear();
+
+   private:
+    CURLHandlePool();
+    ~CURLHandlePool();
+
+    struct EndpointHandles {
+        EndpointHandles() : inUse(0) {
+        }
+
+        vector<CURL*> idle;
+        uint64_t inUse;
+    };
+
+    pthread_mutex_t mutex;
+    pthread_cond_t handleReleased;
+
+    map<string, EndpointHandles> endpoints;  // keyed by "scheme://host:port"
+    uint64_t maxHandlesPerEndpoint;
+
+    CURLSH* share;
+    pthread_mutex_t shareLocks[CURL_LOCK_DATA_LAST];
+
+    static void lockShare(CURL* curl, curl_lock_data data, curl_lock_access access, void* userp);
+    static void unlockShare(CURL* curl, curl_lock_data data, void* userp);
+};
+
 class S3RESTfulService : public RESTfulService {
    public:
     S3RESTfulService();
@@ -35,6 +78,8 @@ class S3RESTfulService : public RESTfulService {
 
     bool debugCurl;
     bool verifyCert;
+    bool reuseConnection;
+    bool useHttp2;
 
     uint64_t chunkBufferSize;
     S3MemoryContext s3MemContext;
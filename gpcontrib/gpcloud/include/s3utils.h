@@ -80,4 +80,7 @@ string GetOptS3(const string& options, const string& key);
 
 string TruncateOptions(const string& url_with_options);
 
+// Microseconds from a monotonic clock, for measuring elapsed time.
+uint64_t GetMonotonicUsecs();
+
 #endif  // __S3_UTILS_H__
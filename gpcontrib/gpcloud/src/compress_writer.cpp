@@ -2,8 +2,12 @@
 
 uint64_t S3_ZIP_COMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
-CompressWriter::CompressWriter() : writer(NULL), isClosed(true) {
+CompressWriter::CompressWriter()
+    : writer(NULL), compressionType(S3_COMPRESSION_GZIP), isClosed(true) {
     this->out = new char[S3_ZIP_COMPRESS_CHUNKSIZE];
+#ifdef HAVE_LIBZSTD
+    this->zstdStream = NULL;
+#endif
 }
 
 CompressWriter::~CompressWriter() {
@@ -15,6 +19,27 @@ CompressWriter::~CompressWriter() {
 }
 
 void CompressWriter::open(const S3Params& params) {
+    this->compressionType = params.getCompressionType();
+
+    if (this->compressionType == S3_COMPRESSION_ZSTD) {
+#ifdef HAVE_LIBZSTD
+        this->zstdStream = ZSTD_createCStream();
+        S3_CHECK_OR_DIE(this->zstdStream != NULL, S3RuntimeError,
+                        "Failed to initialize zstd library");
+
+        size_t ret = ZSTD_initCStream(this->zstdStream, S3_ZSTD_COMPRESSION_LEVEL);
+        S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                        string("Failed to initialize zstd library: ") + ZSTD_getErrorName(ret));
+
+        this->isClosed = false;
+
+        this->writer->open(params);
+        return;
+#else
+        S3_DIE(S3RuntimeError, "gpcloud is built without zstd, can't write zstd compressed data");
+#endif
+    }
+
     this->zstream.zalloc = Z_NULL;
     this->zstream.zfree = Z_NULL;
     this->zstream.opaque = Z_NULL;
@@ -43,6 +68,12 @@ uint64_t CompressWriter::writeOneChunk(const char* buf, uint64_t count) {
         return 0;
     }
 
+#ifdef HAVE_LIBZSTD
+    if (this->compressionType == S3_COMPRESSION_ZSTD) {
+        return this->writeOneChunkZstd(buf, count);
+    }
+#endif
+
     this->zstream.next_in = (Byte*)buf;
     this->zstream.avail_in = count;
 
@@ -87,11 +118,70 @@ uint64_t CompressWriter::write(const char* buf, uint64_t count) {
     return writtenLen;
 }
 
+#ifdef HAVE_LIBZSTD
+uint64_t CompressWriter::writeOneChunkZstd(const char* buf, uint64_t count) {
+    ZSTD_inBuffer input = {buf, count, 0};
+
+    while (input.pos < input.size) {
+        ZSTD_outBuffer output = {this->out, S3_ZIP_COMPRESS_CHUNKSIZE, 0};
+
+        size_t ret = ZSTD_compressStream(this->zstdStream, &output, &input);
+        if (ZSTD_isError(ret)) {
+            ZSTD_freeCStream(this->zstdStream);
+            this->zstdStream = NULL;
+            this->isClosed = true;
+            S3_DIE(S3RuntimeError, string("Failed to compress data: ") + ZSTD_getErrorName(ret));
+        }
+
+        if (output.pos > 0) {
+            this->writer->write(this->out, output.pos);
+        }
+    }
+
+    return count;
+}
+
+void CompressWriter::closeZstd() {
+    size_t remaining;
+
+    do {
+        ZSTD_outBuffer output = {this->out, S3_ZIP_COMPRESS_CHUNKSIZE, 0};
+
+        remaining = ZSTD_endStream(this->zstdStream, &output);
+        if (ZSTD_isError(remaining)) {
+            break;
+        }
+
+        if (output.pos > 0) {
+            this->writer->write(this->out, output.pos);
+        }
+    } while (remaining != 0);
+
+    ZSTD_freeCStream(this->zstdStream);
+    this->zstdStream = NULL;
+    this->isClosed = true;
+
+    S3_CHECK_OR_DIE(!ZSTD_isError(remaining), S3RuntimeError,
+                    string("Failed to compress data: ") + ZSTD_getErrorName(remaining));
+
+    S3DEBUG("Compression finished: zstd frame ended.");
+
+    this->writer->close();
+}
+#endif
+
 void CompressWriter::close() {
     if (this->isClosed) {
         return;
     }
 
+#ifdef HAVE_LIBZSTD
+    if (this->compressionType == S3_COMPRESSION_ZSTD) {
+        this->closeZstd();
+        return;
+    }
+#endif
+
     int status;
     do {
         status = deflate(&this->zstream, Z_FINISH);
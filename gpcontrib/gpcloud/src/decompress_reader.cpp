@@ -2,8 +2,11 @@
 
 uint64_t S3_ZIP_DECOMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
 
-DecompressReader::DecompressReader() : isClosed(true) {
+DecompressReader::DecompressReader() : compressionType(S3_COMPRESSION_GZIP), isClosed(true) {
     this->reader = NULL;
+#ifdef HAVE_LIBZSTD
+    this->zstdStream = NULL;
+#endif
     this->in = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
     this->out = new char[S3_ZIP_DECOMPRESS_CHUNKSIZE];
     this->outOffset = 0;
@@ -24,6 +27,13 @@ void DecompressReader::resizeDecompressReaderBuffer(uint64_t size) {
     this->out = new char[size];
     this->outOffset = 0;
     this->zstream.avail_out = size;
+#ifdef HAVE_LIBZSTD
+    this->zstdIn.src = this->in;
+    this->zstdIn.size = 0;
+    this->zstdIn.pos = 0;
+    this->zstdOut.dst = this->out;
+    this->zstdOut.pos = 0;
+#endif
 }
 
 void DecompressReader::setReader(Reader *reader) {
@@ -31,6 +41,32 @@ void DecompressReader::setReader(Reader *reader) {
 }
 
 void DecompressReader::open(const S3Params &params) {
+    if (this->compressionType == S3_COMPRESSION_ZSTD) {
+#ifdef HAVE_LIBZSTD
+        this->zstdStream = ZSTD_createDStream();
+        S3_CHECK_OR_DIE(this->zstdStream != NULL, S3RuntimeError,
+                        "failed to initialize zstd library");
+        ZSTD_initDStream(this->zstdStream);
+
+        this->zstdIn.src = this->in;
+        this->zstdIn.size = 0;
+        this->zstdIn.pos = 0;
+        this->zstdOut.dst = this->out;
+        this->zstdOut.size = S3_ZIP_DECOMPRESS_CHUNKSIZE;
+        this->zstdOut.pos = 0;
+        this->zstdFrameEnd = true;
+        this->zstdFlushPending = false;
+
+        this->outOffset = 0;
+        this->isClosed = false;
+
+        this->reader->open(params);
+        return;
+#else
+        S3_DIE(S3RuntimeError, "gpcloud is built without zstd, can't read zstd compressed data");
+#endif
+    }
+
     // allocate inflate state for zlib
     zstream.zalloc = Z_NULL;
     zstream.zfree = Z_NULL;
@@ -72,6 +108,13 @@ uint64_t DecompressReader::read(char *buf, uint64_t bufSize) {
 // Read compressed data from underlying reader and decompress to this->out buffer.
 // If no more data to consume, this->zstream.avail_out == S3_ZIP_DECOMPRESS_CHUNKSIZE;
 void DecompressReader::decompress() {
+#ifdef HAVE_LIBZSTD
+    if (this->compressionType == S3_COMPRESSION_ZSTD) {
+        this->decompressZstd();
+        return;
+    }
+#endif
+
     if (this->zstream.avail_in == 0) {
         this->zstream.avail_out = S3_ZIP_DECOMPRESS_CHUNKSIZE;
         this->zstream.next_out = (Byte *)this->out;
@@ -123,7 +166,48 @@ void DecompressReader::decompress() {
     }
 }
 
+#ifdef HAVE_LIBZSTD
+// Decompress into this->out until it has some data, or the underlying reader reaches EOF.
+// Concatenated frames, as written by parallel compressors, are decoded one after another.
+void DecompressReader::decompressZstd() {
+    this->zstdOut.size = S3_ZIP_DECOMPRESS_CHUNKSIZE;
+    this->zstdOut.pos = 0;
+
+    while (this->zstdOut.pos == 0) {
+        if ((this->zstdIn.pos == this->zstdIn.size) && !this->zstdFlushPending) {
+            uint64_t hasRead = this->reader->read(this->in, S3_ZIP_DECOMPRESS_CHUNKSIZE);
+
+            if (hasRead == 0) {
+                S3_CHECK_OR_DIE(this->zstdFrameEnd, S3RuntimeError,
+                                "Failed to decompress data: truncated zstd frame");
+                S3DEBUG("No more data to decompress");
+                return;
+            }
+
+            this->zstdIn.size = hasRead;
+            this->zstdIn.pos = 0;
+        }
+
+        size_t ret = ZSTD_decompressStream(this->zstdStream, &this->zstdOut, &this->zstdIn);
+        S3_CHECK_OR_DIE(!ZSTD_isError(ret), S3RuntimeError,
+                        string("Failed to decompress data: ") + ZSTD_getErrorName(ret));
+
+        this->zstdFrameEnd = (ret == 0);
+        this->zstdFlushPending = (this->zstdOut.pos == this->zstdOut.size);
+    }
+}
+#endif
+
 void DecompressReader::close() {
+#ifdef HAVE_LIBZSTD
+    if (!this->isClosed && (this->compressionType == S3_COMPRESSION_ZSTD)) {
+        ZSTD_freeDStream(this->zstdStream);
+        this->zstdStream = NULL;
+        this->reader->close();
+        this->isClosed = true;
+    }
+#endif
+
     if (!this->isClosed) {
         inflateEnd(&zstream);
         this->reader->close();
@@ -12,15 +12,29 @@ extern "C" {
 #endif
 
 #include "access/extprotocol.h"
+#include "access/fileam.h"
+#include "access/formatter.h"
+#include "access/stratnum.h"
 #include "access/xact.h"
 #include "catalog/pg_exttable.h"
 #include "catalog/pg_proc.h"
+#include "catalog/pg_type.h"
 #include "fmgr.h"
 #include "funcapi.h"
+#include "mb/pg_wchar.h"
+#include "nodes/execnodes.h"
+#include "nodes/nodeFuncs.h"
+#include "parser/parse_func.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/date.h"
+#include "utils/guc.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
+#include "utils/pg_locale.h"
 #include "utils/resowner.h"
+#include "utils/syscache.h"
+#include "utils/timestamp.h"
 
 #ifdef __clang__
 #pragma clang diagnostic pop
@@ -30,9 +44,11 @@ extern "C" {
 PG_MODULE_MAGIC;
 PG_FUNCTION_INFO_V1(s3_export);
 PG_FUNCTION_INFO_V1(s3_import);
+PG_FUNCTION_INFO_V1(s3_parquet_import);
 
 Datum s3_export(PG_FUNCTION_ARGS);
 Datum s3_import(PG_FUNCTION_ARGS);
+Datum s3_parquet_import(PG_FUNCTION_ARGS);
 }
 
 #include "gpreader.h"
@@ -121,8 +137,54 @@ static const char *getFormatStr(FunctionCallInfo fcinfo) {
 
 bool hasHeader = false;
 
+// TEXT format escapes newlines in data, so every line terminator ends a row and large keys
+// can be split on line boundaries. CSV may quote newlines, custom formats are opaque.
+bool isTextFormat = false;
+
 char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
 
+// Keys are Parquet files, to be read column by column for the s3_parquet_import formatter.
+bool isParquetFormat = false;
+
+#define PARQUET_FORMATTER_SOURCE "s3_parquet_import"
+
+// Parquet dates and timestamps count from 1970-01-01, GPDB ones from 2000-01-01.
+#define PARQUET_EPOCH_DAYS_BEFORE_PG (POSTGRES_EPOCH_JDATE - UNIX_EPOCH_JDATE)
+#define PARQUET_EPOCH_USECS_BEFORE_PG (PARQUET_EPOCH_DAYS_BEFORE_PG * USECS_PER_DAY)
+
+// Whether the custom formatter is s3_parquet_import of this library, whatever the name the
+// function is created with.
+static bool isParquetFormatter(const char *fmtopts) {
+    const char *option = strstr(fmtopts, "formatter '");
+    if (option == NULL) {
+        return false;
+    }
+
+    const char *first = strchr(option, '\'');
+    const char *second = strchr(first + 1, '\'');
+    if (second == NULL) {
+        return false;
+    }
+
+    char *name = pnstrdup(first + 1, second - first - 1);
+    Oid funcOid = LookupFuncName(list_make1(makeString(name)), 0, NULL, true);
+    if (!OidIsValid(funcOid)) {
+        return false;
+    }
+
+    HeapTuple procTuple = SearchSysCache1(PROCOID, ObjectIdGetDatum(funcOid));
+    if (!HeapTupleIsValid(procTuple)) {
+        return false;
+    }
+
+    bool isNull;
+    Datum prosrc = SysCacheGetAttr(PROCOID, procTuple, Anum_pg_proc_prosrc, &isNull);
+    bool result = !isNull && strcmp(TextDatumGetCString(prosrc), PARQUET_FORMATTER_SOURCE) == 0;
+
+    ReleaseSysCache(procTuple);
+    return result;
+}
+
 static void parseFormatOpts(FunctionCallInfo fcinfo) {
     Relation rel = EXTPROTOCOL_GET_RELATION(fcinfo);
     ExtTableEntry *exttbl = GetExtTableEntry(rel->rd_id);
@@ -130,6 +192,13 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
     const char fmtcode = exttbl->fmtcode;
     const char *fmtopts = exttbl->fmtopts;
 
+    isTextFormat = fmttype_is_text(fmtcode);
+    isParquetFormat = fmttype_is_custom(fmtcode) && isParquetFormatter(fmtopts);
+
+    if (isParquetFormat) {
+        hasHeader = false;
+    }
+
     // only TEXT and CSV have detailed options
     if (fmttype_is_csv(fmtcode) || fmttype_is_text(fmtcode)) {
         if (strstr(fmtopts, "header") != NULL) {
@@ -171,6 +240,210 @@ static void parseFormatOpts(FunctionCallInfo fcinfo) {
     }
 }
 
+static bool markProjectedColumns(Node *node, vector<bool> *projected) {
+    if (node == NULL) {
+        return false;
+    }
+
+    if (IsA(node, Var)) {
+        AttrNumber attno = ((Var *)node)->varattno;
+        if (attno == InvalidAttrNumber) {
+            // whole-row reference
+            projected->assign(projected->size(), true);
+        } else if (attno > 0 && (size_t)attno <= projected->size()) {
+            (*projected)[attno - 1] = true;
+        }
+        return false;
+    }
+
+    return expression_tree_walker(node, (bool (*)())markProjectedColumns, projected);
+}
+
+static Node *stripRelabelType(Node *node) {
+    while (node != NULL && IsA(node, RelabelType)) {
+        node = (Node *)((RelabelType *)node)->arg;
+    }
+    return node;
+}
+
+// Turn "column op constant" into a predicate on Parquet statistics. Only comparisons whose
+// result on Parquet values is known to match the one on GPDB values are taken.
+static bool makeParquetPredicate(Node *qual, TupleDesc tupdesc, ParquetPredicate &predicate) {
+    if (!IsA(qual, OpExpr) || list_length(((OpExpr *)qual)->args) != 2) {
+        return false;
+    }
+
+    OpExpr *opExpr = (OpExpr *)qual;
+    Node *left = stripRelabelType((Node *)linitial(opExpr->args));
+    Node *right = stripRelabelType((Node *)lsecond(opExpr->args));
+
+    bool varOnLeft = true;
+    if (IsA(left, Const) && IsA(right, Var)) {
+        std::swap(left, right);
+        varOnLeft = false;
+    }
+    if (!IsA(left, Var) || !IsA(right, Const) || ((Const *)right)->constisnull) {
+        return false;
+    }
+
+    Var *var = (Var *)left;
+    Const *constant = (Const *)right;
+    if (var->varattno <= 0 || var->varattno > tupdesc->natts) {
+        return false;
+    }
+
+    int strategy = 0;
+    List *interpretations = get_op_btree_interpretation(opExpr->opno);
+    ListCell *lc;
+    foreach (lc, interpretations) {
+        OpBtreeInterpretation *interpretation = (OpBtreeInterpretation *)lfirst(lc);
+        if (interpretation->strategy >= BTLessStrategyNumber &&
+            interpretation->strategy <= BTGreaterStrategyNumber) {
+            strategy = interpretation->strategy;
+            break;
+        }
+    }
+    list_free_deep(interpretations);
+
+    switch (strategy) {
+        case BTLessStrategyNumber:
+            predicate.op = varOnLeft ? PARQUET_OP_LT : PARQUET_OP_GT;
+            break;
+        case BTLessEqualStrategyNumber:
+            predicate.op = varOnLeft ? PARQUET_OP_LE : PARQUET_OP_GE;
+            break;
+        case BTEqualStrategyNumber:
+            predicate.op = PARQUET_OP_EQ;
+            break;
+        case BTGreaterEqualStrategyNumber:
+            predicate.op = varOnLeft ? PARQUET_OP_GE : PARQUET_OP_LE;
+            break;
+        case BTGreaterStrategyNumber:
+            predicate.op = varOnLeft ? PARQUET_OP_GT : PARQUET_OP_LT;
+            break;
+        default:
+            return false;
+    }
+
+    predicate.column = var->varattno - 1;
+
+    Oid varType = tupdesc->attrs[var->varattno - 1]->atttypid;
+    Datum value = constant->constvalue;
+
+    switch (constant->consttype) {
+        case INT2OID:
+        case INT4OID:
+        case INT8OID:
+            if (varType != INT2OID && varType != INT4OID && varType != INT8OID) {
+                return false;
+            }
+            predicate.kind = ParquetPredicate::INT;
+            predicate.intValue = (constant->consttype == INT2OID)
+                                     ? DatumGetInt16(value)
+                                     : (constant->consttype == INT4OID) ? DatumGetInt32(value)
+                                                                        : DatumGetInt64(value);
+            return true;
+        case FLOAT4OID:
+        case FLOAT8OID:
+            if (varType != FLOAT4OID && varType != FLOAT8OID) {
+                return false;
+            }
+            predicate.kind = ParquetPredicate::DOUBLE;
+            predicate.doubleValue = (constant->consttype == FLOAT4OID)
+                                        ? DatumGetFloat4(value)
+                                        : DatumGetFloat8(value);
+            return !std::isnan(predicate.doubleValue);
+        case DATEOID: {
+            DateADT date = DatumGetDateADT(value);
+            if (varType != DATEOID || DATE_NOT_FINITE(date)) {
+                return false;
+            }
+            predicate.kind = ParquetPredicate::DATE;
+            predicate.intValue = date + PARQUET_EPOCH_DAYS_BEFORE_PG;
+            return true;
+        }
+        case TIMESTAMPOID:
+        case TIMESTAMPTZOID: {
+            Timestamp timestamp = DatumGetTimestamp(value);
+            if (varType != constant->consttype || TIMESTAMP_NOT_FINITE(timestamp)) {
+                return false;
+            }
+            predicate.kind = ParquetPredicate::TIMESTAMP;
+            predicate.intValue = timestamp + PARQUET_EPOCH_USECS_BEFORE_PG;
+            return true;
+        }
+        case TEXTOID: {
+            if (varType != TEXTOID && varType != VARCHAROID) {
+                return false;
+            }
+
+            // Parquet strings are UTF-8 and their statistics are ordered bytewise, which is
+            // the order of GPDB only with the C collation in a UTF-8 database.
+            if (predicate.op != PARQUET_OP_EQ &&
+                (GetDatabaseEncoding() != PG_UTF8 || !lc_collate_is_c(opExpr->inputcollid))) {
+                return false;
+            }
+
+            text *str = DatumGetTextPP(value);
+            int len = VARSIZE_ANY_EXHDR(str);
+            char *utf8 = pg_server_to_any(VARDATA_ANY(str), len, PG_UTF8);
+            if (utf8 != VARDATA_ANY(str)) {
+                len = strlen(utf8);
+            }
+
+            predicate.kind = ParquetPredicate::STRING;
+            predicate.stringValue.assign(utf8, len);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// Columns and predicates of the scan, from the projection and the quals GPDB hands to the
+// protocol. Without the quals, which come only with gp_external_enable_filter_pushdown, we don't
+// know what columns they need, so all are read.
+static void buildParquetScanSpec(FunctionCallInfo fcinfo, ParquetScanSpec &spec) {
+    TupleDesc tupdesc = RelationGetDescr(EXTPROTOCOL_GET_RELATION(fcinfo));
+    ExternalSelectDesc desc = EXTPROTOCOL_GET_EXTERNAL_SELECT_DESC(fcinfo);
+
+    for (int i = 0; i < tupdesc->natts; i++) {
+        spec.columns.push_back(NameStr(tupdesc->attrs[i]->attname));
+    }
+
+    ProjectionInfo *projInfo = (desc != NULL) ? desc->projInfo : NULL;
+    if (projInfo == NULL || !gp_external_enable_filter_pushdown) {
+        spec.projected.assign(tupdesc->natts, true);
+    } else {
+        spec.projected.assign(tupdesc->natts, false);
+
+        for (int i = 0; i < projInfo->pi_numSimpleVars; i++) {
+            int attno = projInfo->pi_varNumbers[i];
+            if (attno > 0 && attno <= tupdesc->natts) {
+                spec.projected[attno - 1] = true;
+            }
+        }
+
+        ListCell *lc;
+        foreach (lc, projInfo->pi_targetlist) {
+            GenericExprState *gstate = (GenericExprState *)lfirst(lc);
+            markProjectedColumns((Node *)gstate->arg->expr, &spec.projected);
+        }
+
+        markProjectedColumns((Node *)desc->filter_quals, &spec.projected);
+    }
+
+    if (desc != NULL) {
+        ListCell *lc;
+        foreach (lc, desc->filter_quals) {
+            ParquetPredicate predicate;
+            if (makeParquetPredicate((Node *)lfirst(lc), tupdesc, predicate)) {
+                spec.predicates.push_back(predicate);
+            }
+        }
+    }
+}
+
 typedef struct gpcloudResHandle {
     GPReader *gpreader;
     GPWriter *gpwriter;
@@ -296,7 +569,13 @@ Datum s3_import(PG_FUNCTION_ARGS) {
 
         thread_setup();
 
-        resHandle->gpreader = reader_init(url_with_options);
+        if (isParquetFormat) {
+            ParquetScanSpec spec;
+            buildParquetScanSpec(fcinfo, spec);
+            resHandle->gpreader = reader_init(url_with_options, &spec);
+        } else {
+            resHandle->gpreader = reader_init(url_with_options);
+        }
         if (!resHandle->gpreader) {
             ereport(ERROR, (0, errmsg("Failed to init gpcloud extension (segid = %d, "
                                       "segnum = %d), please check your "
@@ -372,3 +651,290 @@ Datum s3_export(PG_FUNCTION_ARGS) {
 
     PG_RETURN_INT32(data_len);
 }
+
+typedef struct parquetFormatterState {
+    Datum *values;
+    bool *nulls;
+
+    // input functions, for values without a direct conversion to the column type
+    FmgrInfo *inputFunctions;
+    Oid *typioparams;
+} parquetFormatterState;
+
+static void checkParquetValueLength(const char *pos, const char *end, size_t len) {
+    if ((size_t)(end - pos) < len) {
+        ereport(ERROR, (errcode(ERRCODE_DATA_CORRUPTED), errmsg("corrupted Parquet row")));
+    }
+}
+
+static Datum parquetInputFunctionCall(parquetFormatterState *state, Form_pg_attribute attr,
+                                      int attnum, const char *str) {
+    return InputFunctionCall(&state->inputFunctions[attnum], (char *)str,
+                             state->typioparams[attnum], attr->atttypmod);
+}
+
+static void reportParquetValueOutOfRange(Form_pg_attribute attr) {
+    ereport(ERROR, (errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+                    errmsg("Parquet value is out of range for column \"%s\"",
+                           NameStr(attr->attname))));
+}
+
+// Convert a value streamed by ParquetReader to the column type, directly for the common types
+// and through the text form for the others.
+static Datum parquetValueToDatum(parquetFormatterState *state, Form_pg_attribute attr, int attnum,
+                                 uint8 tag, const char **pos, const char *end) {
+    Oid type = attr->atttypid;
+    const char *p = *pos;
+    char str[64];
+    Datum result;
+
+    switch (tag) {
+        case PARQUET_VALUE_BOOL: {
+            checkParquetValueLength(p, end, 1);
+            bool value = (*p != 0);
+            p += 1;
+
+            if (type == BOOLOID) {
+                result = BoolGetDatum(value);
+            } else {
+                result = parquetInputFunctionCall(state, attr, attnum, value ? "true" : "false");
+            }
+            break;
+        }
+        case PARQUET_VALUE_INT32:
+        case PARQUET_VALUE_INT64: {
+            int64 value;
+            if (tag == PARQUET_VALUE_INT32) {
+                int32 value32;
+                checkParquetValueLength(p, end, sizeof(value32));
+                memcpy(&value32, p, sizeof(value32));
+                p += sizeof(value32);
+                value = value32;
+            } else {
+                checkParquetValueLength(p, end, sizeof(value));
+                memcpy(&value, p, sizeof(value));
+                p += sizeof(value);
+            }
+
+            if (type == INT2OID) {
+                if (value < INT16_MIN || value > INT16_MAX) reportParquetValueOutOfRange(attr);
+                result = Int16GetDatum((int16)value);
+            } else if (type == INT4OID) {
+                if (value < INT32_MIN || value > INT32_MAX) reportParquetValueOutOfRange(attr);
+                result = Int32GetDatum((int32)value);
+            } else if (type == INT8OID) {
+                result = Int64GetDatum(value);
+            } else if (type == FLOAT8OID) {
+                result = Float8GetDatum((float8)value);
+            } else {
+                snprintf(str, sizeof(str), INT64_FORMAT, value);
+                result = parquetInputFunctionCall(state, attr, attnum, str);
+            }
+            break;
+        }
+        case PARQUET_VALUE_FLOAT:
+        case PARQUET_VALUE_DOUBLE: {
+            double value;
+            if (tag == PARQUET_VALUE_FLOAT) {
+                float value4;
+                checkParquetValueLength(p, end, sizeof(value4));
+                memcpy(&value4, p, sizeof(value4));
+                p += sizeof(value4);
+                value = value4;
+            } else {
+                checkParquetValueLength(p, end, sizeof(value));
+                memcpy(&value, p, sizeof(value));
+                p += sizeof(value);
+            }
+
+            if (type == FLOAT4OID) {
+                result = Float4GetDatum((float4)value);
+            } else if (type == FLOAT8OID) {
+                result = Float8GetDatum(value);
+            } else {
+                if (std::isnan(value)) {
+                    strcpy(str, "NaN");
+                } else if (std::isinf(value)) {
+                    strcpy(str, (value > 0) ? "Infinity" : "-Infinity");
+                } else {
+                    snprintf(str, sizeof(str), "%.*g", (tag == PARQUET_VALUE_FLOAT) ? 9 : 17,
+                             value);
+                }
+                result = parquetInputFunctionCall(state, attr, attnum, str);
+            }
+            break;
+        }
+        case PARQUET_VALUE_DATE: {
+            int32 days;
+            checkParquetValueLength(p, end, sizeof(days));
+            memcpy(&days, p, sizeof(days));
+            p += sizeof(days);
+
+            DateADT date = (DateADT)days - PARQUET_EPOCH_DAYS_BEFORE_PG;
+            if (!IS_VALID_DATE(date)) reportParquetValueOutOfRange(attr);
+
+            if (type == DATEOID) {
+                result = DateADTGetDatum(date);
+            } else if (type == TIMESTAMPOID || type == TIMESTAMPTZOID) {
+                result = TimestampGetDatum((Timestamp)date * USECS_PER_DAY);
+            } else {
+                char *out = DatumGetCString(DirectFunctionCall1(date_out, DateADTGetDatum(date)));
+                result = parquetInputFunctionCall(state, attr, attnum, out);
+            }
+            break;
+        }
+        case PARQUET_VALUE_TIMESTAMP: {
+            int64 usecs;
+            checkParquetValueLength(p, end, sizeof(usecs));
+            memcpy(&usecs, p, sizeof(usecs));
+            p += sizeof(usecs);
+
+            // checked before the subtraction, so it can't overflow
+            if (usecs < MIN_TIMESTAMP + PARQUET_EPOCH_USECS_BEFORE_PG) {
+                reportParquetValueOutOfRange(attr);
+            }
+            Timestamp timestamp = usecs - PARQUET_EPOCH_USECS_BEFORE_PG;
+            if (!IS_VALID_TIMESTAMP(timestamp)) reportParquetValueOutOfRange(attr);
+
+            if (type == TIMESTAMPOID || type == TIMESTAMPTZOID) {
+                result = TimestampGetDatum(timestamp);
+            } else if (type == DATEOID) {
+                int64 days = timestamp / USECS_PER_DAY;
+                if (timestamp < 0 && timestamp % USECS_PER_DAY != 0) {
+                    days--;
+                }
+                result = DateADTGetDatum((DateADT)days);
+            } else {
+                Datum out = DirectFunctionCall1(timestamp_out, TimestampGetDatum(timestamp));
+                result = parquetInputFunctionCall(state, attr, attnum, DatumGetCString(out));
+            }
+            break;
+        }
+        case PARQUET_VALUE_BYTES: {
+            uint32 len;
+            checkParquetValueLength(p, end, sizeof(len));
+            memcpy(&len, p, sizeof(len));
+            p += sizeof(len);
+            checkParquetValueLength(p, end, len);
+
+            if (type == BYTEAOID) {
+                bytea *value = (bytea *)palloc(VARHDRSZ + len);
+                SET_VARSIZE(value, VARHDRSZ + len);
+                memcpy(VARDATA(value), p, len);
+                result = PointerGetDatum(value);
+            } else {
+                // Parquet strings are UTF-8
+                char *value = pg_any_to_server(p, len, PG_UTF8);
+                int valueLen = (value == p) ? (int)len : (int)strlen(value);
+
+                if (type == TEXTOID) {
+                    result = PointerGetDatum(cstring_to_text_with_len(value, valueLen));
+                } else {
+                    result = parquetInputFunctionCall(state, attr, attnum,
+                                                      pnstrdup(value, valueLen));
+                }
+            }
+            p += len;
+            break;
+        }
+        default:
+            ereport(ERROR, (errcode(ERRCODE_DATA_CORRUPTED),
+                            errmsg("corrupted Parquet row, unknown value tag %d", tag)));
+    }
+
+    *pos = p;
+    return result;
+}
+
+/*
+ * Formatter of the rows ParquetReader streams, see ParquetValueTag for the layout.
+ */
+Datum s3_parquet_import(PG_FUNCTION_ARGS) {
+    /* Must be called via the external table format manager */
+    if (!CALLED_AS_FORMATTER(fcinfo))
+        elog(ERROR, "s3_parquet_import: not called by format manager");
+
+    TupleDesc tupdesc = FORMATTER_GET_TUPDESC(fcinfo);
+    int ncolumns = tupdesc->natts;
+
+    /* first call. cache the input functions */
+    parquetFormatterState *state = (parquetFormatterState *)FORMATTER_GET_USER_CTX(fcinfo);
+    if (state == NULL) {
+        state = (parquetFormatterState *)palloc(sizeof(parquetFormatterState));
+        state->values = (Datum *)palloc(sizeof(Datum) * ncolumns);
+        state->nulls = (bool *)palloc(sizeof(bool) * ncolumns);
+        state->inputFunctions = (FmgrInfo *)palloc(sizeof(FmgrInfo) * ncolumns);
+        state->typioparams = (Oid *)palloc(sizeof(Oid) * ncolumns);
+
+        for (int i = 0; i < ncolumns; i++) {
+            if (tupdesc->attrs[i]->attisdropped) {
+                ereport(ERROR, (errcode(ERRCODE_EXTERNAL_ROUTINE_EXCEPTION),
+                                errmsg("cannot handle external table with dropped columns")));
+            }
+
+            Oid functionId;
+            getTypeInputInfo(tupdesc->attrs[i]->atttypid, &functionId, &state->typioparams[i]);
+            fmgr_info(functionId, &state->inputFunctions[i]);
+        }
+
+        FORMATTER_SET_USER_CTX(fcinfo, state);
+    }
+
+    char *dataBuf = FORMATTER_GET_DATABUF(fcinfo);
+    int dataLen = FORMATTER_GET_DATALEN(fcinfo);
+    int dataCur = FORMATTER_GET_DATACURSOR(fcinfo);
+    int remaining = dataLen - dataCur;
+
+    /*
+     * After an unexpected EOF is reported, the framework calls us again with no data, which
+     * must not raise the error again.
+     */
+    if (remaining == 0 && FORMATTER_GET_SAW_EOF(fcinfo))
+        FORMATTER_RETURN_NOTIFICATION(fcinfo, FMT_NEED_MORE_DATA);
+
+    uint32 rowLen = 0;
+    if (remaining >= (int)sizeof(rowLen)) {
+        memcpy(&rowLen, dataBuf + dataCur, sizeof(rowLen));
+    }
+
+    if (remaining < (int)sizeof(rowLen) || (uint32)remaining < rowLen) {
+        if (FORMATTER_GET_SAW_EOF(fcinfo)) {
+            FORMATTER_SET_BAD_ROW_DATA(fcinfo, dataBuf + dataCur, remaining);
+            ereport(ERROR, (errcode(ERRCODE_DATA_EXCEPTION), errmsg("unexpected end of file")));
+        }
+        FORMATTER_RETURN_NOTIFICATION(fcinfo, FMT_NEED_MORE_DATA);
+    }
+
+    if (rowLen < sizeof(rowLen)) {
+        ereport(ERROR, (errcode(ERRCODE_DATA_CORRUPTED), errmsg("corrupted Parquet row")));
+    }
+
+    /* We got here. So, we've the ENTIRE row in the buffer */
+    FORMATTER_SET_BAD_ROW_DATA(fcinfo, dataBuf + dataCur, rowLen);
+
+    MemoryContext oldContext = MemoryContextSwitchTo(FORMATTER_GET_PER_ROW_MEM_CTX(fcinfo));
+
+    const char *p = dataBuf + dataCur + sizeof(rowLen);
+    const char *rowEnd = dataBuf + dataCur + rowLen;
+    for (int i = 0; i < ncolumns; i++) {
+        checkParquetValueLength(p, rowEnd, 1);
+        uint8 tag = *p++;
+
+        state->nulls[i] = (tag == PARQUET_VALUE_NULL);
+        state->values[i] =
+            state->nulls[i] ? (Datum)0
+                            : parquetValueToDatum(state, tupdesc->attrs[i], i, tag, &p, rowEnd);
+    }
+
+    if (p != rowEnd) {
+        ereport(ERROR, (errcode(ERRCODE_DATA_CORRUPTED),
+                        errmsg("corrupted Parquet row, it has more than %d columns", ncolumns)));
+    }
+
+    MemoryContextSwitchTo(oldContext);
+
+    FORMATTER_SET_DATACURSOR(fcinfo, dataCur + rowLen);
+    HeapTuple tuple = heap_form_tuple(tupdesc, state->values, state->nulls);
+    FORMATTER_SET_TUPLE(fcinfo, tuple);
+    FORMATTER_RETURN_TUPLE(tuple);
+}
@@ -66,8 +66,15 @@ GPReader::GPReader(const S3Params& params)
 void GPReader::open(const S3Params& params) {
     this->s3InterfaceService.setRESTfulService(this->restfulServicePtr);
     this->bucketReader.setS3InterfaceService(&this->s3InterfaceService);
-    this->bucketReader.setUpstreamReader(&this->commonReader);
     this->commonReader.setS3InterfaceService(&this->s3InterfaceService);
+    this->parquetReader.setS3InterfaceService(&this->s3InterfaceService);
+
+    // Parquet keys are read with range GETs of the needed column chunks, not as a stream
+    if (isParquetFormat) {
+        this->bucketReader.setUpstreamReader(&this->parquetReader);
+    } else {
+        this->bucketReader.setUpstreamReader(&this->commonReader);
+    }
     this->bucketReader.open(this->params);
 }
 
@@ -83,7 +90,7 @@ void GPReader::close() {
 }
 
 // invoked by s3_import(), need to be exception safe
-GPReader* reader_init(const char* url_with_options) {
+GPReader* reader_init(const char* url_with_options, const ParquetScanSpec* parquetSpec) {
     GPReader* reader = NULL;
     s3extErrorMessage.clear();
 
@@ -106,6 +113,10 @@ GPReader* reader_init(const char* url_with_options) {
             return NULL;
         }
 
+        if (parquetSpec != NULL) {
+            reader->setParquetScanSpec(*parquetSpec);
+        }
+
         reader->open(params);
         return reader;
     } catch (S3Exception& e) {
@@ -0,0 +1,1604 @@
+#include "parquet_reader.h"
+
+#include <cmath>
+
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
+
+#include "s3log.h"
+#include "s3macros.h"
+
+#define PARQUET_MAGIC "PAR1"
+#define PARQUET_ENCRYPTED_MAGIC "PARE"
+#define PARQUET_MAGIC_LEN 4
+
+// "PAR1", the data, footer length and "PAR1" again
+#define PARQUET_MIN_FILE_SIZE (PARQUET_MAGIC_LEN + 4 + PARQUET_MAGIC_LEN)
+
+// Julian day of 1970-01-01, INT96 timestamps count days from the Julian epoch.
+#define PARQUET_UNIX_EPOCH_JULIAN_DAY 2440588
+#define PARQUET_USECS_PER_DAY INT64_C(86400000000)
+
+// Deeper structs than any in parquet.thrift mean the metadata is corrupted.
+#define THRIFT_MAX_DEPTH 32
+
+// Field types of the thrift compact protocol
+enum ThriftCompactType {
+    THRIFT_STOP = 0,
+    THRIFT_TRUE = 1,
+    THRIFT_FALSE = 2,
+    THRIFT_BYTE = 3,
+    THRIFT_I16 = 4,
+    THRIFT_I32 = 5,
+    THRIFT_I64 = 6,
+    THRIFT_DOUBLE = 7,
+    THRIFT_BINARY = 8,
+    THRIFT_LIST = 9,
+    THRIFT_SET = 10,
+    THRIFT_MAP = 11,
+    THRIFT_STRUCT = 12,
+};
+
+// The rest of the enums are from parquet.thrift, only with the values we handle.
+enum ParquetRepetition {
+    PARQUET_REQUIRED = 0,
+    PARQUET_OPTIONAL = 1,
+    PARQUET_REPEATED = 2,
+};
+
+enum ParquetConvertedType {
+    PARQUET_CONVERTED_UTF8 = 0,
+    PARQUET_CONVERTED_DECIMAL = 5,
+    PARQUET_CONVERTED_DATE = 6,
+    PARQUET_CONVERTED_TIMESTAMP_MILLIS = 9,
+    PARQUET_CONVERTED_TIMESTAMP_MICROS = 10,
+};
+
+enum ParquetCodec {
+    PARQUET_CODEC_UNCOMPRESSED = 0,
+    PARQUET_CODEC_SNAPPY = 1,
+    PARQUET_CODEC_GZIP = 2,
+    PARQUET_CODEC_ZSTD = 6,
+};
+
+enum ParquetEncoding {
+    PARQUET_ENCODING_PLAIN = 0,
+    PARQUET_ENCODING_PLAIN_DICTIONARY = 2,
+    PARQUET_ENCODING_RLE = 3,
+    PARQUET_ENCODING_RLE_DICTIONARY = 8,
+};
+
+enum ParquetPageType {
+    PARQUET_DATA_PAGE = 0,
+    PARQUET_INDEX_PAGE = 1,
+    PARQUET_DICTIONARY_PAGE = 2,
+    PARQUET_DATA_PAGE_V2 = 3,
+};
+
+static uint32_t ReadLE32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint64_t ReadLE64(const uint8_t* p) {
+    return (uint64_t)ReadLE32(p) | ((uint64_t)ReadLE32(p + 4) << 32);
+}
+
+// Decoder of the thrift compact protocol, which Parquet uses for its metadata.
+class ThriftCompactReader {
+   public:
+    ThriftCompactReader(const uint8_t* data, uint64_t len) : data(data), len(len), pos(0) {
+    }
+
+    uint64_t getPosition() const {
+        return pos;
+    }
+
+    uint8_t readByte() {
+        this->need(1);
+        return this->data[this->pos++];
+    }
+
+    uint64_t readVarint() {
+        uint64_t result = 0;
+        for (uint32_t shift = 0; shift < 64; shift += 7) {
+            uint8_t b = this->readByte();
+            result |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                return result;
+            }
+        }
+        S3_DIE(S3RuntimeError, "corrupted Parquet metadata, varint is too long");
+    }
+
+    int64_t readI64() {
+        uint64_t n = this->readVarint();
+        return (int64_t)(n >> 1) ^ -(int64_t)(n & 1);
+    }
+
+    int32_t readI32() {
+        return (int32_t)this->readI64();
+    }
+
+    string readBinary() {
+        uint64_t n = this->readVarint();
+        this->need(n);
+        string result((const char*)this->data + this->pos, n);
+        this->pos += n;
+        return result;
+    }
+
+    // Read the header of the next field in a struct, return false at the end of the struct.
+    // fieldId holds the id of the previous field, ids are delta encoded.
+    bool readFieldBegin(int16_t& fieldId, uint8_t& type) {
+        uint8_t b = this->readByte();
+        type = b & 0x0f;
+        if (type == THRIFT_STOP) {
+            return false;
+        }
+
+        int16_t delta = b >> 4;
+        fieldId = (delta != 0) ? fieldId + delta : (int16_t)this->readI64();
+        return true;
+    }
+
+    void readListBegin(uint8_t& elemType, uint64_t& size) {
+        uint8_t b = this->readByte();
+        elemType = b & 0x0f;
+        size = b >> 4;
+        if (size == 15) {
+            size = this->readVarint();
+        }
+    }
+
+    // Skip a struct field of the type. Bools in structs are in the field type, but take a byte
+    // in lists and maps, see skipElement().
+    void skip(uint8_t type, uint32_t depth = 0) {
+        S3_CHECK_OR_DIE(depth < THRIFT_MAX_DEPTH, S3RuntimeError,
+                        "corrupted Parquet metadata, nested too deep");
+
+        switch (type) {
+            case THRIFT_TRUE:
+            case THRIFT_FALSE:
+                break;
+            case THRIFT_BYTE:
+                this->readByte();
+                break;
+            case THRIFT_I16:
+            case THRIFT_I32:
+            case THRIFT_I64:
+                this->readVarint();
+                break;
+            case THRIFT_DOUBLE:
+                this->need(8);
+                this->pos += 8;
+                break;
+            case THRIFT_BINARY: {
+                uint64_t n = this->readVarint();
+                this->need(n);
+                this->pos += n;
+                break;
+            }
+            case THRIFT_LIST:
+            case THRIFT_SET: {
+                uint8_t elemType;
+                uint64_t size;
+                this->readListBegin(elemType, size);
+                for (uint64_t i = 0; i < size; i++) {
+                    this->skipElement(elemType, depth + 1);
+                }
+                break;
+            }
+            case THRIFT_MAP: {
+                uint64_t size = this->readVarint();
+                if (size == 0) {
+                    break;
+                }
+                uint8_t types = this->readByte();
+                for (uint64_t i = 0; i < size; i++) {
+                    this->skipElement(types >> 4, depth + 1);
+                    this->skipElement(types & 0x0f, depth + 1);
+                }
+                break;
+            }
+            case THRIFT_STRUCT: {
+                int16_t fieldId = 0;
+                uint8_t fieldType;
+                while (this->readFieldBegin(fieldId, fieldType)) {
+                    this->skip(fieldType, depth + 1);
+                }
+                break;
+            }
+            default:
+                S3_DIE(S3RuntimeError, "corrupted Parquet metadata, unknown thrift type " +
+                                           std::to_string((int)type));
+        }
+    }
+
+    void skipElement(uint8_t type, uint32_t depth) {
+        if (type == THRIFT_TRUE || type == THRIFT_FALSE) {
+            this->readByte();
+        } else {
+            this->skip(type, depth);
+        }
+    }
+
+   private:
+    const uint8_t* data;
+    uint64_t len;
+    uint64_t pos;
+
+    void need(uint64_t n) {
+        S3_CHECK_OR_DIE(n <= this->len - this->pos, S3RuntimeError,
+                        "corrupted Parquet metadata, unexpected end of data");
+    }
+};
+
+// SchemaElement of parquet.thrift, the schema is a depth first list of them.
+struct ParquetSchemaElement {
+    ParquetSchemaElement()
+        : hasType(false),
+          type(0),
+          typeLength(0),
+          repetition(PARQUET_REQUIRED),
+          numChildren(0),
+          convertedType(-1),
+          scale(0),
+          logicalType(PARQUET_LOGICAL_NONE) {
+    }
+
+    bool hasType;  // groups have no type
+    int32_t type;
+    int32_t typeLength;
+    int32_t repetition;
+    string name;
+    int32_t numChildren;
+    int32_t convertedType;
+    int32_t scale;
+    int32_t logicalType;  // from the LogicalType union, overrides convertedType
+};
+
+static void ParseTimeUnit(ThriftCompactReader& reader, ParquetSchemaElement& element) {
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 1) {
+            element.logicalType = PARQUET_LOGICAL_TIMESTAMP_MILLIS;
+        } else if (fieldId == 2) {
+            element.logicalType = PARQUET_LOGICAL_TIMESTAMP_MICROS;
+        } else if (fieldId == 3) {
+            element.logicalType = PARQUET_LOGICAL_TIMESTAMP_NANOS;
+        }
+        reader.skip(type);
+    }
+}
+
+static void ParseLogicalType(ThriftCompactReader& reader, ParquetSchemaElement& element) {
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 1 && type == THRIFT_STRUCT) {
+            element.logicalType = PARQUET_LOGICAL_STRING;
+            reader.skip(type);
+        } else if (fieldId == 5 && type == THRIFT_STRUCT) {
+            // DecimalType, the scale is in SchemaElement as well
+            element.logicalType = PARQUET_LOGICAL_DECIMAL;
+            reader.skip(type);
+        } else if (fieldId == 6 && type == THRIFT_STRUCT) {
+            element.logicalType = PARQUET_LOGICAL_DATE;
+            reader.skip(type);
+        } else if (fieldId == 8 && type == THRIFT_STRUCT) {
+            // TimestampType: 1: isAdjustedToUTC, 2: unit
+            int16_t tsFieldId = 0;
+            uint8_t tsType;
+            while (reader.readFieldBegin(tsFieldId, tsType)) {
+                if (tsFieldId == 2 && tsType == THRIFT_STRUCT) {
+                    ParseTimeUnit(reader, element);
+                } else {
+                    reader.skip(tsType);
+                }
+            }
+        } else {
+            reader.skip(type);
+        }
+    }
+}
+
+static void ParseSchemaElement(ThriftCompactReader& reader, ParquetSchemaElement& element) {
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 1 && type == THRIFT_I32) {
+            element.hasType = true;
+            element.type = reader.readI32();
+        } else if (fieldId == 2 && type == THRIFT_I32) {
+            element.typeLength = reader.readI32();
+        } else if (fieldId == 3 && type == THRIFT_I32) {
+            element.repetition = reader.readI32();
+        } else if (fieldId == 4 && type == THRIFT_BINARY) {
+            element.name = reader.readBinary();
+        } else if (fieldId == 5 && type == THRIFT_I32) {
+            element.numChildren = reader.readI32();
+        } else if (fieldId == 6 && type == THRIFT_I32) {
+            element.convertedType = reader.readI32();
+        } else if (fieldId == 7 && type == THRIFT_I32) {
+            element.scale = reader.readI32();
+        } else if (fieldId == 10 && type == THRIFT_STRUCT) {
+            ParseLogicalType(reader, element);
+        } else {
+            reader.skip(type);
+        }
+    }
+}
+
+static void ParseStatistics(ThriftCompactReader& reader, ParquetColumnChunk& chunk,
+                            string& legacyMin, string& legacyMax, bool& hasLegacyMinMax) {
+    bool hasMin = false, hasMax = false;
+    bool hasLegacyMin = false, hasLegacyMax = false;
+
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 1 && type == THRIFT_BINARY) {
+            legacyMax = reader.readBinary();
+            hasLegacyMax = true;
+        } else if (fieldId == 2 && type == THRIFT_BINARY) {
+            legacyMin = reader.readBinary();
+            hasLegacyMin = true;
+        } else if (fieldId == 3 && type == THRIFT_I64) {
+            chunk.nullCount = reader.readI64();
+            chunk.hasNullCount = true;
+        } else if (fieldId == 5 && type == THRIFT_BINARY) {
+            chunk.maxValue = reader.readBinary();
+            hasMax = true;
+        } else if (fieldId == 6 && type == THRIFT_BINARY) {
+            chunk.minValue = reader.readBinary();
+            hasMin = true;
+        } else {
+            reader.skip(type);
+        }
+    }
+
+    chunk.hasMinMax = hasMin && hasMax;
+    hasLegacyMinMax = hasLegacyMin && hasLegacyMax;
+}
+
+static void ParseColumnMetaData(ThriftCompactReader& reader, ParquetColumnChunk& chunk) {
+    int32_t physicalType = -1;
+    string legacyMin, legacyMax;
+    bool hasLegacyMinMax = false;
+
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 1 && type == THRIFT_I32) {
+            physicalType = reader.readI32();
+        } else if (fieldId == 4 && type == THRIFT_I32) {
+            chunk.codec = reader.readI32();
+        } else if (fieldId == 5 && type == THRIFT_I64) {
+            chunk.numValues = reader.readI64();
+        } else if (fieldId == 7 && type == THRIFT_I64) {
+            chunk.totalCompressedSize = reader.readI64();
+        } else if (fieldId == 9 && type == THRIFT_I64) {
+            chunk.dataPageOffset = reader.readI64();
+        } else if (fieldId == 11 && type == THRIFT_I64) {
+            chunk.dictionaryPageOffset = reader.readI64();
+        } else if (fieldId == 12 && type == THRIFT_STRUCT) {
+            ParseStatistics(reader, chunk, legacyMin, legacyMax, hasLegacyMinMax);
+        } else {
+            reader.skip(type);
+        }
+    }
+
+    // The deprecated min/max were compared as signed bytes, which is only right for numbers.
+    if (!chunk.hasMinMax && hasLegacyMinMax &&
+        (physicalType == PARQUET_INT32 || physicalType == PARQUET_INT64 ||
+         physicalType == PARQUET_FLOAT || physicalType == PARQUET_DOUBLE)) {
+        chunk.minValue = legacyMin;
+        chunk.maxValue = legacyMax;
+        chunk.hasMinMax = true;
+    }
+
+    S3_CHECK_OR_DIE(chunk.dataPageOffset >= 0 && chunk.dictionaryPageOffset >= 0 &&
+                        chunk.totalCompressedSize >= 0,
+                    S3RuntimeError, "corrupted Parquet metadata, invalid column chunk");
+}
+
+static void ParseColumnChunk(ThriftCompactReader& reader, ParquetColumnChunk& chunk) {
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 1 && type == THRIFT_BINARY) {
+            chunk.hasExternalData = !reader.readBinary().empty();
+        } else if (fieldId == 3 && type == THRIFT_STRUCT) {
+            ParseColumnMetaData(reader, chunk);
+        } else {
+            reader.skip(type);
+        }
+    }
+}
+
+static void ParseRowGroup(ThriftCompactReader& reader, ParquetRowGroup& rowGroup) {
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 1 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size;
+            reader.readListBegin(elemType, size);
+            for (uint64_t i = 0; i < size; i++) {
+                S3_CHECK_OR_DIE(elemType == THRIFT_STRUCT, S3RuntimeError,
+                                "corrupted Parquet metadata, invalid column chunk list");
+                rowGroup.columns.push_back(ParquetColumnChunk());
+                ParseColumnChunk(reader, rowGroup.columns.back());
+            }
+        } else if (fieldId == 3 && type == THRIFT_I64) {
+            rowGroup.numRows = reader.readI64();
+        } else {
+            reader.skip(type);
+        }
+    }
+}
+
+static int32_t ToLogicalType(const ParquetSchemaElement& element) {
+    if (element.logicalType != PARQUET_LOGICAL_NONE) {
+        return element.logicalType;
+    }
+
+    switch (element.convertedType) {
+        case PARQUET_CONVERTED_UTF8:
+            return PARQUET_LOGICAL_STRING;
+        case PARQUET_CONVERTED_DECIMAL:
+            return PARQUET_LOGICAL_DECIMAL;
+        case PARQUET_CONVERTED_DATE:
+            return PARQUET_LOGICAL_DATE;
+        case PARQUET_CONVERTED_TIMESTAMP_MILLIS:
+            return PARQUET_LOGICAL_TIMESTAMP_MILLIS;
+        case PARQUET_CONVERTED_TIMESTAMP_MICROS:
+            return PARQUET_LOGICAL_TIMESTAMP_MICROS;
+        default:
+            return PARQUET_LOGICAL_NONE;
+    }
+}
+
+// Skip the subtree of elements[index], return the number of leaves in it.
+static uint32_t SkipSchemaSubtree(const vector<ParquetSchemaElement>& elements, uint64_t& index,
+                                  uint32_t depth) {
+    S3_CHECK_OR_DIE(index < elements.size() && depth < THRIFT_MAX_DEPTH, S3RuntimeError,
+                    "corrupted Parquet metadata, invalid schema");
+
+    const ParquetSchemaElement& element = elements[index++];
+    if (element.numChildren <= 0) {
+        return 1;
+    }
+
+    uint32_t leaves = 0;
+    for (int32_t i = 0; i < element.numChildren; i++) {
+        leaves += SkipSchemaSubtree(elements, index, depth + 1);
+    }
+    return leaves;
+}
+
+// Top level fields of the schema, every leaf below them has a column chunk in each row group.
+static void BuildColumns(const vector<ParquetSchemaElement>& elements,
+                         ParquetFileMetadata& metadata) {
+    S3_CHECK_OR_DIE(!elements.empty(), S3RuntimeError, "corrupted Parquet metadata, empty schema");
+
+    uint64_t index = 1;
+    uint32_t leaves = 0;
+    for (int32_t i = 0; i < elements[0].numChildren; i++) {
+        S3_CHECK_OR_DIE(index < elements.size(), S3RuntimeError,
+                        "corrupted Parquet metadata, invalid schema");
+
+        const ParquetSchemaElement& element = elements[index];
+
+        ParquetColumnSchema column;
+        column.name = element.name;
+        column.physicalType = element.type;
+        column.logicalType = ToLogicalType(element);
+        column.typeLength = element.typeLength;
+        column.scale = element.scale;
+        column.optional = (element.repetition == PARQUET_OPTIONAL);
+        column.nested = (element.numChildren > 0) || !element.hasType ||
+                        (element.repetition == PARQUET_REPEATED);
+        column.leafIndex = leaves;
+
+        leaves += SkipSchemaSubtree(elements, index, 1);
+        metadata.columns.push_back(column);
+    }
+
+    metadata.numLeaves = leaves;
+}
+
+void ParseParquetMetadata(const uint8_t* data, uint64_t len, ParquetFileMetadata& metadata) {
+    ThriftCompactReader reader(data, len);
+    vector<ParquetSchemaElement> elements;
+
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 2 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size;
+            reader.readListBegin(elemType, size);
+            for (uint64_t i = 0; i < size; i++) {
+                S3_CHECK_OR_DIE(elemType == THRIFT_STRUCT, S3RuntimeError,
+                                "corrupted Parquet metadata, invalid schema list");
+                elements.push_back(ParquetSchemaElement());
+                ParseSchemaElement(reader, elements.back());
+            }
+        } else if (fieldId == 3 && type == THRIFT_I64) {
+            metadata.numRows = reader.readI64();
+        } else if (fieldId == 4 && type == THRIFT_LIST) {
+            uint8_t elemType;
+            uint64_t size;
+            reader.readListBegin(elemType, size);
+            for (uint64_t i = 0; i < size; i++) {
+                S3_CHECK_OR_DIE(elemType == THRIFT_STRUCT, S3RuntimeError,
+                                "corrupted Parquet metadata, invalid row group list");
+                metadata.rowGroups.push_back(ParquetRowGroup());
+                ParseRowGroup(reader, metadata.rowGroups.back());
+            }
+        } else {
+            reader.skip(type);
+        }
+    }
+
+    BuildColumns(elements, metadata);
+
+    for (size_t i = 0; i < metadata.rowGroups.size(); i++) {
+        S3_CHECK_OR_DIE(metadata.rowGroups[i].columns.size() == metadata.numLeaves,
+                        S3RuntimeError,
+                        "corrupted Parquet metadata, row group doesn't match the schema");
+    }
+}
+
+uint64_t ParquetRowGroup::getStart() const {
+    uint64_t start = UINT64_MAX;
+    for (size_t i = 0; i < this->columns.size(); i++) {
+        start = std::min(start, this->columns[i].getStart());
+    }
+    return this->columns.empty() ? 0 : start;
+}
+
+uint64_t ParquetRowGroup::getSize() const {
+    uint64_t size = 0;
+    for (size_t i = 0; i < this->columns.size(); i++) {
+        size += this->columns[i].totalCompressedSize;
+    }
+    return size;
+}
+
+// PageHeader of parquet.thrift, with the fields of its data, data v2 or dictionary page header.
+struct ParquetPageHeader {
+    ParquetPageHeader()
+        : type(-1),
+          uncompressedSize(0),
+          compressedSize(0),
+          numValues(0),
+          encoding(PARQUET_ENCODING_PLAIN),
+          definitionLevelEncoding(PARQUET_ENCODING_RLE),
+          definitionLevelsLength(0),
+          repetitionLevelsLength(0),
+          isCompressed(true) {
+    }
+
+    int32_t type;
+    int32_t uncompressedSize;
+    int32_t compressedSize;
+    int32_t numValues;
+    int32_t encoding;
+    int32_t definitionLevelEncoding;  // DATA_PAGE only
+    int32_t definitionLevelsLength;   // DATA_PAGE_V2 only
+    int32_t repetitionLevelsLength;   // DATA_PAGE_V2 only
+    bool isCompressed;                // DATA_PAGE_V2 only
+};
+
+static void ParsePageHeader(ThriftCompactReader& reader, ParquetPageHeader& header) {
+    int16_t fieldId = 0;
+    uint8_t type;
+    while (reader.readFieldBegin(fieldId, type)) {
+        if (fieldId == 1 && type == THRIFT_I32) {
+            header.type = reader.readI32();
+        } else if (fieldId == 2 && type == THRIFT_I32) {
+            header.uncompressedSize = reader.readI32();
+        } else if (fieldId == 3 && type == THRIFT_I32) {
+            header.compressedSize = reader.readI32();
+        } else if ((fieldId == 5 || fieldId == 7) && type == THRIFT_STRUCT) {
+            // DataPageHeader and DictionaryPageHeader start alike
+            int16_t subFieldId = 0;
+            uint8_t subType;
+            while (reader.readFieldBegin(subFieldId, subType)) {
+                if (subFieldId == 1 && subType == THRIFT_I32) {
+                    header.numValues = reader.readI32();
+                } else if (subFieldId == 2 && subType == THRIFT_I32) {
+                    header.encoding = reader.readI32();
+                } else if (fieldId == 5 && subFieldId == 3 && subType == THRIFT_I32) {
+                    header.definitionLevelEncoding = reader.readI32();
+                } else {
+                    reader.skip(subType);
+                }
+            }
+        } else if (fieldId == 8 && type == THRIFT_STRUCT) {
+            int16_t subFieldId = 0;
+            uint8_t subType;
+            while (reader.readFieldBegin(subFieldId, subType)) {
+                if (subFieldId == 1 && subType == THRIFT_I32) {
+                    header.numValues = reader.readI32();
+                } else if (subFieldId == 4 && subType == THRIFT_I32) {
+                    header.encoding = reader.readI32();
+                } else if (subFieldId == 5 && subType == THRIFT_I32) {
+                    header.definitionLevelsLength = reader.readI32();
+                } else if (subFieldId == 6 && subType == THRIFT_I32) {
+                    header.repetitionLevelsLength = reader.readI32();
+                } else if (subFieldId == 7 && (subType == THRIFT_TRUE || subType == THRIFT_FALSE)) {
+                    header.isCompressed = (subType == THRIFT_TRUE);
+                } else {
+                    reader.skip(subType);
+                }
+            }
+        } else {
+            reader.skip(type);
+        }
+    }
+
+    S3_CHECK_OR_DIE(header.uncompressedSize >= 0 && header.compressedSize >= 0 &&
+                        header.numValues >= 0 && header.definitionLevelsLength >= 0 &&
+                        header.repetitionLevelsLength >= 0,
+                    S3RuntimeError, "corrupted Parquet page header");
+}
+
+static void GzipUncompress(const uint8_t* src, uint64_t srcLen, uint8_t* dst, uint64_t dstLen) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    S3_CHECK_OR_DIE(inflateInit2(&zs, S3_INFLATE_WINDOWSBITS) == Z_OK, S3RuntimeError,
+                    "failed to initialize zlib library");
+
+    zs.next_in = (Bytef*)src;
+    zs.avail_in = srcLen;
+    zs.next_out = (Bytef*)dst;
+    zs.avail_out = dstLen;
+
+    int ret = inflate(&zs, Z_FINISH);
+    uint64_t produced = dstLen - zs.avail_out;
+    inflateEnd(&zs);
+
+    S3_CHECK_OR_DIE(ret == Z_STREAM_END && produced == dstLen, S3RuntimeError,
+                    "failed to decompress gzip compressed Parquet page");
+}
+
+// Return the uncompressed page, which is either src or in buffer.
+static const uint8_t* DecompressPage(int32_t codec, const uint8_t* src, uint64_t srcLen,
+                                     uint64_t dstLen, vector<uint8_t>& buffer) {
+    if (codec == PARQUET_CODEC_UNCOMPRESSED) {
+        S3_CHECK_OR_DIE(srcLen == dstLen, S3RuntimeError, "corrupted Parquet page");
+        return src;
+    }
+
+    buffer.resize(dstLen);
+
+    switch (codec) {
+        case PARQUET_CODEC_SNAPPY:
+            S3_DIE(S3RuntimeError,
+                   "gpcloud can't read SNAPPY compressed Parquet pages, write the data with "
+                   "GZIP, ZSTD or no compression instead");
+        case PARQUET_CODEC_GZIP:
+            GzipUncompress(src, srcLen, buffer.data(), dstLen);
+            break;
+        case PARQUET_CODEC_ZSTD: {
+#ifdef HAVE_LIBZSTD
+            size_t ret = ZSTD_decompress(buffer.data(), dstLen, src, srcLen);
+            S3_CHECK_OR_DIE(!ZSTD_isError(ret) && ret == dstLen, S3RuntimeError,
+                            "failed to decompress zstd compressed Parquet page");
+            break;
+#else
+            S3_DIE(S3RuntimeError,
+                   "gpcloud is built without zstd, can't read zstd compressed data");
+#endif
+        }
+        default:
+            S3_DIE(S3RuntimeError,
+                   "unsupported Parquet compression codec " + std::to_string(codec));
+    }
+
+    return buffer.data();
+}
+
+// The RLE/bit-packing hybrid encoding of definition levels, dictionary indices and booleans.
+class RleBitPackedDecoder {
+   public:
+    RleBitPackedDecoder(const uint8_t* data, uint64_t len, uint32_t bitWidth)
+        : data(data),
+          len(len),
+          pos(0),
+          bitWidth(bitWidth),
+          mask((uint32_t)((UINT64_C(1) << bitWidth) - 1)),
+          repeatCount(0),
+          repeatValue(0),
+          literalCount(0),
+          literals(NULL),
+          literalBitPos(0) {
+        S3_CHECK_OR_DIE(bitWidth <= 32, S3RuntimeError, "corrupted Parquet page, bit width " +
+                                                            std::to_string(bitWidth));
+    }
+
+    uint32_t next() {
+        if (this->repeatCount == 0 && this->literalCount == 0) {
+            this->nextRun();
+        }
+
+        if (this->repeatCount > 0) {
+            this->repeatCount--;
+            return this->repeatValue;
+        }
+
+        this->literalCount--;
+
+        uint64_t byteIndex = this->literalBitPos >> 3;
+        uint32_t shift = this->literalBitPos & 7;
+        uint32_t numBytes = (shift + this->bitWidth + 7) / 8;
+
+        uint64_t word = 0;
+        for (uint32_t i = 0; i < numBytes; i++) {
+            word |= (uint64_t)this->literals[byteIndex + i] << (8 * i);
+        }
+        this->literalBitPos += this->bitWidth;
+
+        return (uint32_t)(word >> shift) & this->mask;
+    }
+
+   private:
+    const uint8_t* data;
+    uint64_t len;
+    uint64_t pos;
+    uint32_t bitWidth;
+    uint32_t mask;
+
+    uint64_t repeatCount;
+    uint32_t repeatValue;
+
+    uint64_t literalCount;
+    const uint8_t* literals;
+    uint64_t literalBitPos;
+
+    void nextRun() {
+        uint64_t header = 0;
+        for (uint32_t shift = 0;; shift += 7) {
+            S3_CHECK_OR_DIE(this->pos < this->len && shift < 64, S3RuntimeError,
+                            "corrupted Parquet page, not enough encoded values");
+            uint8_t b = this->data[this->pos++];
+            header |= (uint64_t)(b & 0x7f) << shift;
+            if ((b & 0x80) == 0) {
+                break;
+            }
+        }
+
+        if (header & 1) {
+            // bit-packed groups of 8 values
+            uint64_t groups = header >> 1;
+            S3_CHECK_OR_DIE(groups <= (this->len - this->pos) / std::max(this->bitWidth, 1U),
+                            S3RuntimeError, "corrupted Parquet page, bit-packed run is too long");
+            this->literals = this->data + this->pos;
+            this->literalBitPos = 0;
+            this->literalCount = groups * 8;
+            this->pos += groups * this->bitWidth;
+        } else {
+            uint32_t numBytes = (this->bitWidth + 7) / 8;
+            S3_CHECK_OR_DIE(numBytes <= this->len - this->pos, S3RuntimeError,
+                            "corrupted Parquet page, RLE run is too long");
+            this->repeatCount = header >> 1;
+            this->repeatValue = 0;
+            for (uint32_t i = 0; i < numBytes; i++) {
+                this->repeatValue |= (uint32_t)this->data[this->pos + i] << (8 * i);
+            }
+            this->pos += numBytes;
+        }
+    }
+};
+
+// How values of the column are streamed to the formatter
+static ParquetValueTag ColumnValueTag(const ParquetColumnSchema& column) {
+    if (column.logicalType == PARQUET_LOGICAL_DECIMAL) {
+        return PARQUET_VALUE_BYTES;  // as text
+    }
+
+    switch (column.physicalType) {
+        case PARQUET_BOOLEAN:
+            return PARQUET_VALUE_BOOL;
+        case PARQUET_INT32:
+            return (column.logicalType == PARQUET_LOGICAL_DATE) ? PARQUET_VALUE_DATE
+                                                                : PARQUET_VALUE_INT32;
+        case PARQUET_INT64:
+            switch (column.logicalType) {
+                case PARQUET_LOGICAL_TIMESTAMP_MILLIS:
+                case PARQUET_LOGICAL_TIMESTAMP_MICROS:
+                case PARQUET_LOGICAL_TIMESTAMP_NANOS:
+                    return PARQUET_VALUE_TIMESTAMP;
+                default:
+                    return PARQUET_VALUE_INT64;
+            }
+        case PARQUET_INT96:
+            return PARQUET_VALUE_TIMESTAMP;
+        case PARQUET_FLOAT:
+            return PARQUET_VALUE_FLOAT;
+        case PARQUET_DOUBLE:
+            return PARQUET_VALUE_DOUBLE;
+        default:
+            return PARQUET_VALUE_BYTES;
+    }
+}
+
+// Timestamps are streamed in microseconds.
+static int64_t ToMicroseconds(const ParquetColumnSchema& column, int64_t value) {
+    switch (column.logicalType) {
+        case PARQUET_LOGICAL_TIMESTAMP_MILLIS:
+            return value * 1000;
+        case PARQUET_LOGICAL_TIMESTAMP_NANOS:
+            // round towards negative infinity, like the other units do
+            return (value >= 0) ? value / 1000 : -((-value + 999) / 1000);
+        default:
+            return value;
+    }
+}
+
+static string FormatDecimal(__int128 unscaled, int32_t scale) {
+    bool negative = unscaled < 0;
+    unsigned __int128 value = negative ? -(unsigned __int128)unscaled : unscaled;
+
+    // least significant digit first, at least one before the decimal point
+    string digits;
+    do {
+        digits.push_back('0' + (char)(value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    if (scale < 0) {
+        scale = 0;
+    }
+    while ((int32_t)digits.size() <= scale) {
+        digits.push_back('0');
+    }
+
+    string result = negative ? "-" : "";
+    for (size_t i = digits.size(); i > 0; i--) {
+        result.push_back(digits[i - 1]);
+        if ((int32_t)(i - 1) == scale && scale > 0) {
+            result.push_back('.');
+        }
+    }
+    return result;
+}
+
+static void AppendBytes(ParquetColumnValues& out, const char* data, uint64_t len) {
+    out.bytes.insert(out.bytes.end(), data, data + len);
+    out.offsets.push_back(out.bytes.size());
+}
+
+static void AppendDecimal(const ParquetColumnSchema& column, ParquetColumnValues& out,
+                          __int128 unscaled) {
+    string text = FormatDecimal(unscaled, column.scale);
+    AppendBytes(out, text.data(), text.size());
+}
+
+// DECIMAL in a byte array is a big-endian two's complement integer.
+static void AppendBigEndianDecimal(const ParquetColumnSchema& column, ParquetColumnValues& out,
+                                   const uint8_t* data, uint64_t len) {
+    S3_CHECK_OR_DIE(len <= sizeof(__int128), S3RuntimeError,
+                    "DECIMAL wider than 16 bytes is not supported, column " + column.name);
+
+    unsigned __int128 value = (len > 0 && (data[0] & 0x80)) ? ~(unsigned __int128)0 : 0;
+    for (uint64_t i = 0; i < len; i++) {
+        value = (value << 8) | data[i];
+    }
+    AppendDecimal(column, out, (__int128)value);
+}
+
+// Decode count plain encoded values of the column, append them to out.
+static void DecodePlain(const ParquetColumnSchema& column, const uint8_t* data, uint64_t len,
+                        uint64_t count, ParquetColumnValues& out) {
+    bool isDecimal = (column.logicalType == PARQUET_LOGICAL_DECIMAL);
+
+    switch (column.physicalType) {
+        case PARQUET_BOOLEAN:
+            S3_CHECK_OR_DIE((count + 7) / 8 <= len, S3RuntimeError, "corrupted Parquet page");
+            for (uint64_t i = 0; i < count; i++) {
+                out.ints.push_back((data[i >> 3] >> (i & 7)) & 1);
+            }
+            break;
+        case PARQUET_INT32:
+            S3_CHECK_OR_DIE(count <= len / 4, S3RuntimeError, "corrupted Parquet page");
+            for (uint64_t i = 0; i < count; i++) {
+                int32_t value = (int32_t)ReadLE32(data + i * 4);
+                if (isDecimal) {
+                    AppendDecimal(column, out, value);
+                } else {
+                    out.ints.push_back(value);
+                }
+            }
+            break;
+        case PARQUET_INT64:
+            S3_CHECK_OR_DIE(count <= len / 8, S3RuntimeError, "corrupted Parquet page");
+            for (uint64_t i = 0; i < count; i++) {
+                int64_t value = (int64_t)ReadLE64(data + i * 8);
+                if (isDecimal) {
+                    AppendDecimal(column, out, value);
+                } else {
+                    out.ints.push_back(ToMicroseconds(column, value));
+                }
+            }
+            break;
+        case PARQUET_INT96:
+            // nanoseconds of the day, then the Julian day
+            S3_CHECK_OR_DIE(count <= len / 12, S3RuntimeError, "corrupted Parquet page");
+            for (uint64_t i = 0; i < count; i++) {
+                int64_t nanos = (int64_t)ReadLE64(data + i * 12);
+                int64_t julianDay = (int32_t)ReadLE32(data + i * 12 + 8);
+                out.ints.push_back((julianDay - PARQUET_UNIX_EPOCH_JULIAN_DAY) *
+                                       PARQUET_USECS_PER_DAY +
+                                   nanos / 1000);
+            }
+            break;
+        case PARQUET_FLOAT:
+            S3_CHECK_OR_DIE(count <= len / 4, S3RuntimeError, "corrupted Parquet page");
+            for (uint64_t i = 0; i < count; i++) {
+                float value;
+                memcpy(&value, data + i * 4, sizeof(value));
+                out.doubles.push_back(value);
+            }
+            break;
+        case PARQUET_DOUBLE:
+            S3_CHECK_OR_DIE(count <= len / 8, S3RuntimeError, "corrupted Parquet page");
+            for (uint64_t i = 0; i < count; i++) {
+                double value;
+                memcpy(&value, data + i * 8, sizeof(value));
+                out.doubles.push_back(value);
+            }
+            break;
+        case PARQUET_BYTE_ARRAY: {
+            uint64_t pos = 0;
+            for (uint64_t i = 0; i < count; i++) {
+                S3_CHECK_OR_DIE(4 <= len - pos, S3RuntimeError, "corrupted Parquet page");
+                uint32_t valueLen = ReadLE32(data + pos);
+                pos += 4;
+                S3_CHECK_OR_DIE(valueLen <= len - pos, S3RuntimeError, "corrupted Parquet page");
+                if (isDecimal) {
+                    AppendBigEndianDecimal(column, out, data + pos, valueLen);
+                } else {
+                    AppendBytes(out, (const char*)data + pos, valueLen);
+                }
+                pos += valueLen;
+            }
+            break;
+        }
+        case PARQUET_FIXED_LEN_BYTE_ARRAY: {
+            uint64_t valueLen = column.typeLength;
+            S3_CHECK_OR_DIE(column.typeLength > 0 && count <= len / valueLen, S3RuntimeError,
+                            "corrupted Parquet page");
+            for (uint64_t i = 0; i < count; i++) {
+                if (isDecimal) {
+                    AppendBigEndianDecimal(column, out, data + i * valueLen, valueLen);
+                } else {
+                    AppendBytes(out, (const char*)data + i * valueLen, valueLen);
+                }
+            }
+            break;
+        }
+        default:
+            S3_DIE(S3RuntimeError, "unsupported Parquet type " +
+                                       std::to_string(column.physicalType) + " of column " +
+                                       column.name);
+    }
+}
+
+static void AppendFromDictionary(const ParquetColumnValues& dictionary, ParquetValueTag tag,
+                                 uint32_t index, ParquetColumnValues& out) {
+    switch (tag) {
+        case PARQUET_VALUE_FLOAT:
+        case PARQUET_VALUE_DOUBLE:
+            S3_CHECK_OR_DIE(index < dictionary.doubles.size(), S3RuntimeError,
+                            "corrupted Parquet page, dictionary index out of range");
+            out.doubles.push_back(dictionary.doubles[index]);
+            break;
+        case PARQUET_VALUE_BYTES: {
+            S3_CHECK_OR_DIE(index < dictionary.offsets.size(), S3RuntimeError,
+                            "corrupted Parquet page, dictionary index out of range");
+            uint64_t begin = (index == 0) ? 0 : dictionary.offsets[index - 1];
+            AppendBytes(out, dictionary.bytes.data() + begin, dictionary.offsets[index] - begin);
+            break;
+        }
+        default:
+            S3_CHECK_OR_DIE(index < dictionary.ints.size(), S3RuntimeError,
+                            "corrupted Parquet page, dictionary index out of range");
+            out.ints.push_back(dictionary.ints[index]);
+            break;
+    }
+}
+
+// Decode numRows rows of a column chunk, data holds the whole chunk.
+static void DecodeColumnChunk(const ParquetColumnSchema& column, const ParquetColumnChunk& chunk,
+                              const uint8_t* data, uint64_t len, uint64_t numRows,
+                              ParquetColumnValues& out) {
+    ParquetValueTag tag = ColumnValueTag(column);
+
+    ParquetColumnValues dictionary;
+    bool hasDictionary = false;
+    vector<uint8_t> pageBuffer;
+
+    out.clear();
+    out.defined.reserve(numRows);
+
+    uint64_t pos = 0;
+    while (out.defined.size() < numRows) {
+        S3_CHECK_OR_DIE(pos < len, S3RuntimeError,
+                        "Parquet column chunk of " + column.name + " ends early");
+
+        ThriftCompactReader reader(data + pos, len - pos);
+        ParquetPageHeader header;
+        ParsePageHeader(reader, header);
+        pos += reader.getPosition();
+
+        uint64_t pageLen = header.compressedSize;
+        S3_CHECK_OR_DIE(pageLen <= len - pos, S3RuntimeError, "corrupted Parquet page header");
+        const uint8_t* page = data + pos;
+        pos += pageLen;
+
+        if (header.type == PARQUET_DICTIONARY_PAGE) {
+            const uint8_t* plain = DecompressPage(chunk.codec, page, pageLen,
+                                                  header.uncompressedSize, pageBuffer);
+            dictionary.clear();
+            DecodePlain(column, plain, header.uncompressedSize, header.numValues, dictionary);
+            hasDictionary = true;
+            continue;
+        }
+
+        if (header.type != PARQUET_DATA_PAGE && header.type != PARQUET_DATA_PAGE_V2) {
+            continue;
+        }
+
+        uint64_t numValues = header.numValues;
+        S3_CHECK_OR_DIE(numValues <= numRows - out.defined.size(), S3RuntimeError,
+                        "Parquet column chunk of " + column.name + " has too many values");
+
+        const uint8_t* levels = NULL;
+        uint64_t levelsLen = 0;
+        const uint8_t* values = NULL;
+        uint64_t valuesLen = 0;
+
+        if (header.type == PARQUET_DATA_PAGE) {
+            const uint8_t* body = DecompressPage(chunk.codec, page, pageLen,
+                                                 header.uncompressedSize, pageBuffer);
+            uint64_t bodyLen = header.uncompressedSize;
+
+            values = body;
+            valuesLen = bodyLen;
+
+            if (column.optional) {
+                S3_CHECK_OR_DIE(header.definitionLevelEncoding == PARQUET_ENCODING_RLE,
+                                S3RuntimeError,
+                                "unsupported Parquet definition level encoding " +
+                                    std::to_string(header.definitionLevelEncoding));
+                S3_CHECK_OR_DIE(bodyLen >= 4, S3RuntimeError, "corrupted Parquet page");
+                levelsLen = ReadLE32(body);
+                S3_CHECK_OR_DIE(levelsLen <= bodyLen - 4, S3RuntimeError,
+                                "corrupted Parquet page");
+                levels = body + 4;
+                values = levels + levelsLen;
+                valuesLen = bodyLen - 4 - levelsLen;
+            }
+        } else {
+            // levels of a v2 page are never compressed
+            uint64_t levelsTotal =
+                (uint64_t)header.repetitionLevelsLength + header.definitionLevelsLength;
+            S3_CHECK_OR_DIE(
+                levelsTotal <= pageLen && levelsTotal <= (uint64_t)header.uncompressedSize,
+                S3RuntimeError, "corrupted Parquet page header");
+
+            levels = page + header.repetitionLevelsLength;
+            levelsLen = header.definitionLevelsLength;
+            valuesLen = header.uncompressedSize - levelsTotal;
+
+            if (header.isCompressed) {
+                values = DecompressPage(chunk.codec, page + levelsTotal, pageLen - levelsTotal,
+                                        valuesLen, pageBuffer);
+            } else {
+                S3_CHECK_OR_DIE(valuesLen == pageLen - levelsTotal, S3RuntimeError,
+                                "corrupted Parquet page header");
+                values = page + levelsTotal;
+            }
+        }
+
+        // definition levels tell which values are there, 1 for not NULL in a flat schema
+        size_t first = out.defined.size();
+        uint64_t numDefined = numValues;
+        if (column.optional) {
+            out.defined.resize(first + numValues);
+
+            RleBitPackedDecoder definitionLevels(levels, levelsLen, 1);
+            numDefined = 0;
+            for (uint64_t i = 0; i < numValues; i++) {
+                uint32_t level = definitionLevels.next();
+                out.defined[first + i] = level;
+                numDefined += level;
+            }
+        } else {
+            out.defined.resize(first + numValues, 1);
+        }
+
+        switch (header.encoding) {
+            case PARQUET_ENCODING_PLAIN:
+                DecodePlain(column, values, valuesLen, numDefined, out);
+                break;
+            case PARQUET_ENCODING_PLAIN_DICTIONARY:
+            case PARQUET_ENCODING_RLE_DICTIONARY: {
+                S3_CHECK_OR_DIE(hasDictionary && valuesLen >= 1, S3RuntimeError,
+                                "corrupted Parquet page, no dictionary");
+                RleBitPackedDecoder indices(values + 1, valuesLen - 1, values[0]);
+                for (uint64_t i = 0; i < numDefined; i++) {
+                    AppendFromDictionary(dictionary, tag, indices.next(), out);
+                }
+                break;
+            }
+            case PARQUET_ENCODING_RLE: {
+                S3_CHECK_OR_DIE(column.physicalType == PARQUET_BOOLEAN && valuesLen >= 4,
+                                S3RuntimeError, "corrupted Parquet page");
+                uint64_t encodedLen = ReadLE32(values);
+                S3_CHECK_OR_DIE(encodedLen <= valuesLen - 4, S3RuntimeError,
+                                "corrupted Parquet page");
+                RleBitPackedDecoder booleans(values + 4, encodedLen, 1);
+                for (uint64_t i = 0; i < numDefined; i++) {
+                    out.ints.push_back(booleans.next());
+                }
+                break;
+            }
+            default:
+                S3_DIE(S3RuntimeError, "unsupported Parquet encoding " +
+                                           std::to_string(header.encoding) + " of column " +
+                                           column.name);
+        }
+    }
+}
+
+// Compare a plain encoded statistic with the predicate value, return <0, 0 or >0. Set
+// comparable to false if they can't be compared.
+static int CompareStatistic(const ParquetColumnSchema& column, const string& statistic,
+                            const ParquetPredicate& predicate, bool& comparable) {
+    const uint8_t* data = (const uint8_t*)statistic.data();
+    ParquetValueTag tag = ColumnValueTag(column);
+
+    comparable = false;
+
+    if (tag == PARQUET_VALUE_INT32 || tag == PARQUET_VALUE_INT64 || tag == PARQUET_VALUE_DATE ||
+        (tag == PARQUET_VALUE_TIMESTAMP && column.physicalType == PARQUET_INT64)) {
+        int64_t value;
+        if (column.physicalType == PARQUET_INT32 && statistic.size() == 4) {
+            value = (int32_t)ReadLE32(data);
+        } else if (column.physicalType == PARQUET_INT64 && statistic.size() == 8) {
+            value = ToMicroseconds(column, (int64_t)ReadLE64(data));
+        } else {
+            return 0;
+        }
+
+        bool isInteger = (tag == PARQUET_VALUE_INT32 || tag == PARQUET_VALUE_INT64);
+
+        if ((isInteger && predicate.kind == ParquetPredicate::INT) ||
+            (tag == PARQUET_VALUE_DATE && predicate.kind == ParquetPredicate::DATE) ||
+            (tag == PARQUET_VALUE_TIMESTAMP && predicate.kind == ParquetPredicate::TIMESTAMP)) {
+            comparable = true;
+            return (value < predicate.intValue) ? -1 : (value > predicate.intValue);
+        }
+
+        if (isInteger && predicate.kind == ParquetPredicate::DOUBLE) {
+            comparable = true;
+            double target = predicate.doubleValue;
+            return ((double)value < target) ? -1 : ((double)value > target);
+        }
+
+        return 0;
+    }
+
+    if (tag == PARQUET_VALUE_FLOAT || tag == PARQUET_VALUE_DOUBLE) {
+        double value;
+        if (column.physicalType == PARQUET_FLOAT && statistic.size() == 4) {
+            float f;
+            memcpy(&f, data, sizeof(f));
+            value = f;
+        } else if (column.physicalType == PARQUET_DOUBLE && statistic.size() == 8) {
+            memcpy(&value, data, sizeof(value));
+        } else {
+            return 0;
+        }
+
+        // writers disagree on how NaN counts in min and max
+        if (std::isnan(value)) {
+            return 0;
+        }
+
+        double target;
+        if (predicate.kind == ParquetPredicate::DOUBLE) {
+            target = predicate.doubleValue;
+        } else if (predicate.kind == ParquetPredicate::INT) {
+            target = (double)predicate.intValue;
+        } else {
+            return 0;
+        }
+
+        comparable = true;
+        return (value < target) ? -1 : (value > target);
+    }
+
+    if (tag == PARQUET_VALUE_BYTES && column.physicalType == PARQUET_BYTE_ARRAY &&
+        column.logicalType != PARQUET_LOGICAL_DECIMAL &&
+        predicate.kind == ParquetPredicate::STRING) {
+        comparable = true;
+
+        // statistics of byte arrays are ordered as unsigned bytes
+        size_t n = std::min(statistic.size(), predicate.stringValue.size());
+        int result = memcmp(statistic.data(), predicate.stringValue.data(), n);
+        if (result != 0) {
+            return result;
+        }
+        return (statistic.size() < predicate.stringValue.size())
+                   ? -1
+                   : (statistic.size() > predicate.stringValue.size());
+    }
+
+    return 0;
+}
+
+ParquetReader::ParquetReader() : Reader() {
+    this->s3InterfaceService = NULL;
+    this->rowGroupIndex = 0;
+    this->rowsInGroup = 0;
+    this->nextRow = 0;
+    this->outPos = 0;
+    this->fetchedBytes = 0;
+}
+
+void ParquetReader::fetch(uint64_t offset, uint64_t len, S3VectorUInt8& data) {
+    S3_CHECK_OR_DIE(this->s3InterfaceService != NULL, S3RuntimeError, "s3Interface is NULL");
+
+    uint64_t readLen =
+        this->s3InterfaceService->fetchData(offset, data, len, this->params.getS3Url());
+    S3_CHECK_OR_DIE(readLen == len && data.size() == len, S3PartialResponseError, len, readLen);
+
+    this->fetchedBytes += len;
+}
+
+// Get the footer with the tail of the key, and fetch again only if the footer is longer.
+void ParquetReader::readMetadata(uint64_t keySize) {
+    const string& url = this->params.getS3Url().getFullUrlForCurl();
+
+    S3_CHECK_OR_DIE(keySize >= PARQUET_MIN_FILE_SIZE, S3RuntimeError,
+                    url + " is too small to be a Parquet file");
+
+    uint64_t tailLen = std::min(keySize, (uint64_t)S3_PARQUET_FOOTER_PREFETCH_SIZE);
+    S3VectorUInt8 tail;
+    this->fetch(keySize - tailLen, tailLen, tail);
+
+    const uint8_t* tailEnd = tail.data() + tailLen;
+    if (memcmp(tailEnd - PARQUET_MAGIC_LEN, PARQUET_ENCRYPTED_MAGIC, PARQUET_MAGIC_LEN) == 0) {
+        S3_DIE(S3RuntimeError, "encrypted Parquet file " + url + " is not supported");
+    }
+    S3_CHECK_OR_DIE(memcmp(tailEnd - PARQUET_MAGIC_LEN, PARQUET_MAGIC, PARQUET_MAGIC_LEN) == 0,
+                    S3RuntimeError, url + " is not a Parquet file");
+
+    uint64_t footerLen = ReadLE32(tailEnd - PARQUET_MAGIC_LEN - 4);
+    S3_CHECK_OR_DIE(footerLen <= keySize - PARQUET_MIN_FILE_SIZE, S3RuntimeError,
+                    "corrupted Parquet footer in " + url);
+
+    this->metadata = ParquetFileMetadata();
+
+    if (footerLen + PARQUET_MAGIC_LEN + 4 <= tailLen) {
+        ParseParquetMetadata(tailEnd - PARQUET_MAGIC_LEN - 4 - footerLen, footerLen,
+                             this->metadata);
+    } else {
+        S3VectorUInt8 footer;
+        this->fetch(keySize - PARQUET_MAGIC_LEN - 4 - footerLen, footerLen, footer);
+        ParseParquetMetadata(footer.data(), footerLen, this->metadata);
+    }
+}
+
+// Map table columns the query needs to Parquet columns by name, preferring exact matches.
+void ParquetReader::resolveColumns() {
+    size_t numColumns = this->spec.columns.size();
+    S3_CHECK_OR_DIE(this->spec.projected.size() == numColumns, S3RuntimeError,
+                    "invalid Parquet scan projection");
+
+    this->tableToSchema.assign(numColumns, -1);
+    this->columnTags.assign(numColumns, PARQUET_VALUE_NULL);
+
+    const vector<ParquetColumnSchema>& columns = this->metadata.columns;
+    for (size_t i = 0; i < numColumns; i++) {
+        if (!this->spec.projected[i]) {
+            continue;
+        }
+
+        const string& name = this->spec.columns[i];
+        int32_t found = -1;
+        for (size_t j = 0; j < columns.size() && found < 0; j++) {
+            if (columns[j].name == name) {
+                found = j;
+            }
+        }
+        for (size_t j = 0; j < columns.size() && found < 0; j++) {
+            if (strcasecmp(columns[j].name.c_str(), name.c_str()) == 0) {
+                found = j;
+            }
+        }
+
+        S3_CHECK_OR_DIE(found >= 0, S3RuntimeError,
+                        "column \"" + name + "\" is not found in Parquet file " +
+                            this->params.getS3Url().getFullUrlForCurl());
+        S3_CHECK_OR_DIE(!columns[found].nested, S3RuntimeError,
+                        "nested Parquet column \"" + name + "\" is not supported");
+
+        this->tableToSchema[i] = found;
+        this->columnTags[i] = ColumnValueTag(columns[found]);
+    }
+}
+
+// Whether some rows of the row group may satisfy all predicates, judged by its statistics.
+bool ParquetReader::rowGroupMayMatch(const ParquetRowGroup& rowGroup) const {
+    for (size_t i = 0; i < this->spec.predicates.size(); i++) {
+        const ParquetPredicate& predicate = this->spec.predicates[i];
+        if (predicate.column >= this->tableToSchema.size() ||
+            this->tableToSchema[predicate.column] < 0) {
+            continue;
+        }
+
+        const ParquetColumnSchema& column =
+            this->metadata.columns[this->tableToSchema[predicate.column]];
+        const ParquetColumnChunk& chunk = rowGroup.columns[column.leafIndex];
+
+        // comparisons with NULL are never true
+        if (chunk.hasNullCount && chunk.nullCount >= rowGroup.numRows) {
+            return false;
+        }
+
+        if (!chunk.hasMinMax) {
+            continue;
+        }
+
+        bool comparable = false;
+        int minCmp = CompareStatistic(column, chunk.minValue, predicate, comparable);
+        if (!comparable) {
+            continue;
+        }
+        int maxCmp = CompareStatistic(column, chunk.maxValue, predicate, comparable);
+        if (!comparable) {
+            continue;
+        }
+
+        switch (predicate.op) {
+            case PARQUET_OP_LT:
+                if (minCmp >= 0) return false;
+                break;
+            case PARQUET_OP_LE:
+                if (minCmp > 0) return false;
+                break;
+            case PARQUET_OP_EQ:
+                if (minCmp > 0 || maxCmp < 0) return false;
+                break;
+            case PARQUET_OP_GE:
+                if (maxCmp < 0) return false;
+                break;
+            case PARQUET_OP_GT:
+                if (maxCmp <= 0) return false;
+                break;
+        }
+    }
+
+    return true;
+}
+
+// A row group belongs to the key range holding its middle byte, like Hadoop input splits.
+void ParquetReader::selectRowGroups() {
+    uint64_t rangeStart = this->params.getKeyOffset();
+    uint64_t rangeLength = this->params.getKeyLength();
+
+    this->rowGroups.clear();
+    for (size_t i = 0; i < this->metadata.rowGroups.size(); i++) {
+        const ParquetRowGroup& rowGroup = this->metadata.rowGroups[i];
+
+        if (rangeLength != 0) {
+            uint64_t middle = rowGroup.getStart() + rowGroup.getSize() / 2;
+            if (middle < rangeStart || middle - rangeStart >= rangeLength) {
+                continue;
+            }
+        }
+
+        if (rowGroup.numRows <= 0) {
+            continue;
+        }
+
+        if (!this->rowGroupMayMatch(rowGroup)) {
+            S3DEBUG("Skip row group %zu of %s by statistics", i,
+                    this->params.getS3Url().getFullUrlForCurl().c_str());
+            continue;
+        }
+
+        this->rowGroups.push_back(i);
+    }
+}
+
+void ParquetReader::open(const S3Params& params) {
+    this->close();
+    this->params = params;
+
+    this->readMetadata(this->params.getKeySize());
+    this->resolveColumns();
+    this->selectRowGroups();
+
+    this->values.assign(this->spec.columns.size(), ParquetColumnValues());
+    this->valueCursors.assign(this->spec.columns.size(), 0);
+
+    S3DEBUG("Read %zu of %zu row groups from %s", this->rowGroups.size(),
+            this->metadata.rowGroups.size(), this->params.getS3Url().getFullUrlForCurl().c_str());
+}
+
+// Fetch the projected column chunks of the next row group and decode them.
+bool ParquetReader::loadNextRowGroup() {
+    if (this->rowGroupIndex >= this->rowGroups.size()) {
+        return false;
+    }
+
+    const ParquetRowGroup& rowGroup =
+        this->metadata.rowGroups[this->rowGroups[this->rowGroupIndex++]];
+    uint64_t keySize = this->params.getKeySize();
+
+    // byte ranges of the chunks, those close to each other are fetched in one request
+    typedef std::pair<uint64_t, uint64_t> ByteRange;  // [first, second)
+    vector<ByteRange> chunkRanges;
+    for (size_t i = 0; i < this->tableToSchema.size(); i++) {
+        if (this->tableToSchema[i] < 0) {
+            continue;
+        }
+
+        const ParquetColumnSchema& column = this->metadata.columns[this->tableToSchema[i]];
+        const ParquetColumnChunk& chunk = rowGroup.columns[column.leafIndex];
+
+        S3_CHECK_OR_DIE(!chunk.hasExternalData, S3RuntimeError,
+                        "Parquet column chunks in other files are not supported");
+
+        uint64_t start = chunk.getStart();
+        S3_CHECK_OR_DIE(start <= keySize && (uint64_t)chunk.totalCompressedSize <= keySize - start,
+                        S3RuntimeError, "corrupted Parquet metadata, column chunk out of file");
+        chunkRanges.push_back(ByteRange(start, start + chunk.totalCompressedSize));
+    }
+
+    std::sort(chunkRanges.begin(), chunkRanges.end());
+
+    vector<ByteRange> requests;
+    for (size_t i = 0; i < chunkRanges.size(); i++) {
+        if (!requests.empty() &&
+            chunkRanges[i].first <= requests.back().second + S3_PARQUET_COALESCE_GAP) {
+            requests.back().second = std::max(requests.back().second, chunkRanges[i].second);
+        } else {
+            requests.push_back(chunkRanges[i]);
+        }
+    }
+
+    vector<S3VectorUInt8> buffers(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        if (requests[i].second > requests[i].first) {
+            this->fetch(requests[i].first, requests[i].second - requests[i].first, buffers[i]);
+        }
+    }
+
+    for (size_t i = 0; i < this->tableToSchema.size(); i++) {
+        if (this->tableToSchema[i] < 0) {
+            this->values[i].clear();
+            continue;
+        }
+
+        const ParquetColumnSchema& column = this->metadata.columns[this->tableToSchema[i]];
+        const ParquetColumnChunk& chunk = rowGroup.columns[column.leafIndex];
+        uint64_t start = chunk.getStart();
+
+        size_t r = 0;
+        while (requests[r].second < start + chunk.totalCompressedSize) {
+            r++;
+        }
+
+        DecodeColumnChunk(column, chunk, buffers[r].data() + (start - requests[r].first),
+                          chunk.totalCompressedSize, rowGroup.numRows, this->values[i]);
+    }
+
+    this->valueCursors.assign(this->tableToSchema.size(), 0);
+    this->rowsInGroup = rowGroup.numRows;
+    this->nextRow = 0;
+    return true;
+}
+
+template <typename T>
+static void AppendValue(vector<char>& buf, T value) {
+    const char* p = (const char*)&value;
+    buf.insert(buf.end(), p, p + sizeof(T));
+}
+
+// Serialize rows of the current row group into outBuf, until it has at least count bytes.
+void ParquetReader::serializeRows(uint64_t count) {
+    this->outBuf.clear();
+    this->outPos = 0;
+
+    while (this->nextRow < this->rowsInGroup && this->outBuf.size() < count) {
+        size_t rowStart = this->outBuf.size();
+        AppendValue<uint32_t>(this->outBuf, 0);  // row length, filled in below
+
+        for (size_t i = 0; i < this->tableToSchema.size(); i++) {
+            const ParquetColumnValues& column = this->values[i];
+
+            if (this->tableToSchema[i] < 0 || !column.defined[this->nextRow]) {
+                this->outBuf.push_back(PARQUET_VALUE_NULL);
+                continue;
+            }
+
+            uint8_t tag = this->columnTags[i];
+            uint64_t k = this->valueCursors[i]++;
+
+            this->outBuf.push_back(tag);
+            switch (tag) {
+                case PARQUET_VALUE_BOOL:
+                    this->outBuf.push_back(column.ints[k] ? 1 : 0);
+                    break;
+                case PARQUET_VALUE_INT32:
+                case PARQUET_VALUE_DATE:
+                    AppendValue<int32_t>(this->outBuf, column.ints[k]);
+                    break;
+                case PARQUET_VALUE_INT64:
+                case PARQUET_VALUE_TIMESTAMP:
+                    AppendValue<int64_t>(this->outBuf, column.ints[k]);
+                    break;
+                case PARQUET_VALUE_FLOAT:
+                    AppendValue<float>(this->outBuf, column.doubles[k]);
+                    break;
+                case PARQUET_VALUE_DOUBLE:
+                    AppendValue<double>(this->outBuf, column.doubles[k]);
+                    break;
+                default: {
+                    uint64_t begin = (k == 0) ? 0 : column.offsets[k - 1];
+                    uint64_t end = column.offsets[k];
+                    AppendValue<uint32_t>(this->outBuf, end - begin);
+                    this->outBuf.insert(this->outBuf.end(), column.bytes.begin() + begin,
+                                        column.bytes.begin() + end);
+                    break;
+                }
+            }
+        }
+
+        uint32_t rowLen = this->outBuf.size() - rowStart;
+        memcpy(this->outBuf.data() + rowStart, &rowLen, sizeof(rowLen));
+
+        this->nextRow++;
+    }
+}
+
+// read() attempts to read up to count bytes into the buffer.
+// Return 0 if EOF. Throw exception if encounters errors.
+uint64_t ParquetReader::read(char* buf, uint64_t count) {
+    while (this->outPos == this->outBuf.size()) {
+        if (this->nextRow >= this->rowsInGroup && !this->loadNextRowGroup()) {
+            return 0;
+        }
+        this->serializeRows(count);
+    }
+
+    uint64_t readCount = std::min(count, (uint64_t)(this->outBuf.size() - this->outPos));
+    memcpy(buf, this->outBuf.data() + this->outPos, readCount);
+    this->outPos += readCount;
+
+    return readCount;
+}
+
+// This should be reentrant, has no side effects when called multiple times.
+void ParquetReader::close() {
+    this->rowGroups.clear();
+    this->rowGroupIndex = 0;
+    this->values.clear();
+    this->valueCursors.clear();
+    this->rowsInGroup = 0;
+    this->nextRow = 0;
+    this->outBuf.clear();
+    this->outPos = 0;
+}
@@ -1,13 +1,23 @@
 #include "s3bucket_reader.h"
 
+#include <queue>
+
 S3BucketReader::S3BucketReader() : Reader() {
-    this->keyIndex = 0;  // doesn't matter, be set in open()
+    this->pieceIndex = 0;
 
     this->s3Interface = NULL;
     this->upstreamReader = NULL;
 
     this->needNewReader = true;
     this->isFirstFile = true;
+
+    this->rangeState = RANGE_NONE;
+    this->rangeStart = 0;
+    this->rangeEnd = 0;
+    this->readEnd = 0;
+    this->curPos = 0;
+    this->eolMatched = 0;
+    this->rangeKey = NULL;
 }
 
 S3BucketReader::~S3BucketReader() {
@@ -17,8 +27,6 @@ S3BucketReader::~S3BucketReader() {
 void S3BucketReader::open(const S3Params& params) {
     this->params = params;
 
-    this->keyIndex = s3ext_segid;  // we may change it in unit tests
-
     S3_CHECK_OR_DIE(this->s3Interface != NULL, S3RuntimeError, "s3Interface is NULL");
 
     S3Url& s3Url = this->params.getS3Url();
@@ -27,15 +35,81 @@ void S3BucketReader::open(const S3Params& params) {
                     s3Url.getFullUrlForCurl());
 
     this->keyList = this->s3Interface->listBucket(s3Url);
+
+    this->scheduleKeyPieces();
+    this->pieceIndex = 0;
+}
+
+static bool CompareBySizeDesc(const KeyPiece& a, const KeyPiece& b) {
+    return a.length > b.length;
 }
 
-BucketContent& S3BucketReader::getNextKey() {
-    BucketContent& key = this->keyList.contents[this->keyIndex];
-    this->keyIndex += s3ext_segnum;
-    return key;
+static bool CompareByPosition(const KeyPiece& a, const KeyPiece& b) {
+    return (a.keyIndex < b.keyIndex) || (a.keyIndex == b.keyIndex && a.offset < b.offset);
 }
 
-S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
+// Longest-processing-time-first: pieces go in descending size order to the segment with the
+// fewest bytes so far, ties to the lower segment id. Every segment computes the same assignment
+// from the same listing, and reads its own pieces in listing order.
+void S3BucketReader::scheduleKeyPieces() {
+    uint64_t splitSize = this->params.getSplitSize();
+
+    // A range must not start with a header line or in the middle of a quoted CSV field. Parquet
+    // keys split on row groups instead, see ParquetReader.
+    bool canSplit = (splitSize != 0) && (s3ext_segnum > 1) &&
+                    ((isTextFormat && !hasHeader) || isParquetFormat);
+
+    vector<KeyPiece> pieces;
+    for (uint64_t i = 0; i < this->keyList.contents.size(); i++) {
+        uint64_t size = this->keyList.contents[i].getSize();
+
+        if (!canSplit || size <= splitSize) {
+            pieces.emplace_back(i, 0, size);
+            continue;
+        }
+
+        uint64_t numOfRanges = (size + splitSize - 1) / splitSize;
+        uint64_t rangeLen = (size + numOfRanges - 1) / numOfRanges;
+        for (uint64_t offset = 0; offset < size; offset += rangeLen) {
+            pieces.emplace_back(i, offset, std::min(rangeLen, size - offset));
+        }
+    }
+
+    // stable, so equal sizes keep listing order
+    std::stable_sort(pieces.begin(), pieces.end(), CompareBySizeDesc);
+
+    typedef std::pair<uint64_t, int32_t> SegmentLoad;  // (bytes, segid)
+    std::priority_queue<SegmentLoad, vector<SegmentLoad>, std::greater<SegmentLoad> > loads;
+    for (int32_t i = 0; i < s3ext_segnum; i++) {
+        loads.push(SegmentLoad(0, i));
+    }
+
+    this->keyPieces.clear();
+    for (vector<KeyPiece>::iterator it = pieces.begin(); it != pieces.end(); it++) {
+        SegmentLoad least = loads.top();
+        loads.pop();
+
+        if (least.second == s3ext_segid) {
+            this->keyPieces.push_back(*it);
+        }
+
+        // count empty keys too, opening one still costs requests
+        least.first += std::max(it->length, (uint64_t)1);
+        loads.push(least);
+    }
+
+    std::sort(this->keyPieces.begin(), this->keyPieces.end(), CompareByPosition);
+
+    S3DEBUG("Segment %d is assigned %zu of %zu pieces", s3ext_segid, this->keyPieces.size(),
+            pieces.size());
+}
+
+KeyPiece& S3BucketReader::getNextPiece() {
+    return this->keyPieces[this->pieceIndex++];
+}
+
+S3Params S3BucketReader::constructReaderParams(BucketContent& key, uint64_t offset,
+                                               uint64_t length) {
     // encode the key name but leave the "/"
     // "/encoded_path/encoded_name"
     string keyEncoded = UriEncode(key.getName());
@@ -44,12 +118,154 @@ S3Params S3BucketReader::constructReaderParams(BucketContent& key) {
     S3Params readerParams = this->params.setPrefix(keyEncoded);
 
     readerParams.setKeySize(key.getSize());
+    readerParams.setKeyRange(offset, length);
 
-    S3DEBUG("key: %s, size: %" PRIu64, readerParams.getS3Url().getFullUrlForCurl().c_str(),
-            readerParams.getKeySize());
+    S3DEBUG("key: %s, size: %" PRIu64 ", offset: %" PRIu64 ", length: %" PRIu64,
+            readerParams.getS3Url().getFullUrlForCurl().c_str(), readerParams.getKeySize(), offset,
+            length);
     return readerParams;
 }
 
+bool S3BucketReader::openPiece(const KeyPiece& piece) {
+    BucketContent& key = this->keyList.contents[piece.keyIndex];
+
+    this->rangeState = RANGE_NONE;
+
+    if (piece.length == key.getSize()) {
+        this->upstreamReader->open(constructReaderParams(key));
+        return true;
+    }
+
+    // ParquetReader reads the row groups of the range by itself.
+    if (isParquetFormat) {
+        this->upstreamReader->open(constructReaderParams(key, piece.offset, piece.length));
+        return true;
+    }
+
+    // Compressed data can't be read from the middle, so the segment holding the first range
+    // reads the whole key and the others skip it.
+    S3Params keyParams = constructReaderParams(key);
+    if (this->s3Interface->checkCompressionType(keyParams.getS3Url()) != S3_COMPRESSION_PLAIN) {
+        if (piece.offset != 0) {
+            return false;
+        }
+
+        this->upstreamReader->open(keyParams);
+        return true;
+    }
+
+    uint64_t eolLen = strlen(eolString);
+
+    this->rangeStart = piece.offset;
+    this->rangeEnd = piece.offset + piece.length;
+
+    // Back up by a line terminator to see whether the range starts right after one. Read a
+    // chunk past the end, which normally covers the rest of the last line.
+    uint64_t openOffset = (this->rangeStart > eolLen) ? this->rangeStart - eolLen : 0;
+    this->readEnd = std::min(key.getSize(), this->rangeEnd + this->params.getChunkSize());
+
+    this->rangeKey = &key;
+    this->curPos = openOffset;
+    this->eolMatched = 0;
+    this->rangeState = (this->rangeStart == 0) ? RANGE_EMIT : RANGE_SKIP;
+
+    this->upstreamReader->open(
+        constructReaderParams(key, openOffset, this->readEnd - openOffset));
+    return true;
+}
+
+// Find the first line terminator in buf whose last char is at or after key offset bound - 1,
+// buf starts at key offset pos. On success, *lineEnd is the index in buf right after it.
+// Matching state is kept in eolMatched, so a terminator may span two calls.
+bool S3BucketReader::findLineEnd(const char* buf, uint64_t len, uint64_t pos, uint64_t bound,
+                                 uint64_t* lineEnd) {
+    uint64_t eolLen = strlen(eolString);
+
+    // a terminator that starts earlier can't end late enough
+    uint64_t scanFrom = (bound > eolLen) ? bound - eolLen : 0;
+    uint64_t i = (scanFrom > pos) ? std::min(scanFrom - pos, len) : 0;
+
+    for (; i < len; i++) {
+        if (buf[i] != eolString[this->eolMatched]) {
+            this->eolMatched = 0;
+        }
+
+        if (buf[i] == eolString[this->eolMatched]) {
+            this->eolMatched++;
+
+            if (this->eolMatched == eolLen) {
+                this->eolMatched = 0;
+
+                if (pos + i + 1 >= bound) {
+                    *lineEnd = i + 1;
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+// A range owns the lines starting within it: it skips the line that started before
+// rangeStart, and reads past rangeEnd to finish its last line. Return 0 when done.
+uint64_t S3BucketReader::readRange(char* buf, uint64_t count) {
+    while (this->rangeState != RANGE_DONE) {
+        uint64_t readCount = this->upstreamReader->read(buf, count);
+        uint64_t pos = this->curPos;
+
+        if (readCount == 0) {
+            uint64_t keySize = this->rangeKey->getSize();
+
+            // the last line is longer than a chunk, read on to the end of the key
+            if (this->rangeState == RANGE_EMIT && this->readEnd < keySize) {
+                this->upstreamReader->close();
+                this->upstreamReader->open(constructReaderParams(*this->rangeKey, this->readEnd));
+                this->readEnd = keySize;
+                continue;
+            }
+
+            this->rangeState = RANGE_DONE;
+            break;
+        }
+
+        this->curPos += readCount;
+
+        if (this->rangeState == RANGE_SKIP) {
+            uint64_t lineStart = 0;
+            if (!this->findLineEnd(buf, readCount, pos, this->rangeStart, &lineStart)) {
+                continue;
+            }
+
+            if (pos + lineStart >= this->rangeEnd) {
+                this->rangeState = RANGE_DONE;
+                break;
+            }
+
+            this->rangeState = RANGE_EMIT;
+            this->eolMatched = 0;
+
+            readCount -= lineStart;
+            pos += lineStart;
+            memmove(buf, buf + lineStart, readCount);
+
+            if (readCount == 0) {
+                continue;
+            }
+        }
+
+        uint64_t lineEnd = 0;
+        if (this->findLineEnd(buf, readCount, pos, this->rangeEnd, &lineEnd)) {
+            this->rangeState = RANGE_DONE;
+            return lineEnd;
+        }
+
+        return readCount;
+    }
+
+    return 0;
+}
+
 uint64_t S3BucketReader::readWithoutHeaderLine(char* buf, uint64_t count) {
     char* current = NULL;
     char* end = NULL;
@@ -98,13 +314,15 @@ uint64_t S3BucketReader::read(char* buf, uint64_t count) {
     uint64_t readCount = 0;
     while (true) {
         if (this->needNewReader) {
-            if (this->keyIndex >= this->keyList.contents.size()) {
+            if (this->pieceIndex >= this->keyPieces.size()) {
                 S3DEBUG("Read finished for segment: %d", s3ext_segid);
                 return 0;
             }
-            BucketContent& key = this->getNextKey();
+            KeyPiece& piece = this->getNextPiece();
 
-            this->upstreamReader->open(constructReaderParams(key));
+            if (!this->openPiece(piece)) {
+                continue;
+            }
             this->needNewReader = false;
 
             // ignore header line if it is not the first file
@@ -116,7 +334,12 @@ uint64_t S3BucketReader::read(char* buf, uint64_t count) {
             }
         }
 
-        readCount = this->upstreamReader->read(buf, count);
+        if (this->rangeState == RANGE_NONE) {
+            readCount = this->upstreamReader->read(buf, count);
+        } else {
+            readCount = this->readRange(buf, count);
+        }
+
         if (readCount != 0) {
             return readCount;
         }
@@ -137,4 +360,7 @@ void S3BucketReader::close() {
     if (!this->keyList.contents.empty()) {
         this->keyList.contents.clear();
     }
-}
\ No newline at end of file
+
+    this->keyPieces.clear();
+    this->rangeKey = NULL;
+}
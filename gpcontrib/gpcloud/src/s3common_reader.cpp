@@ -7,8 +7,10 @@ void S3CommonReader::open(const S3Params &params) {
 
     switch (compressionType) {
         case S3_COMPRESSION_GZIP:
+        case S3_COMPRESSION_ZSTD:
             this->upstreamReader = &this->decompressReader;
             this->decompressReader.setReader(&this->keyReader);
+            this->decompressReader.setCompressionType(compressionType);
             break;
         case S3_COMPRESSION_PLAIN:
             this->upstreamReader = &this->keyReader;
@@ -100,6 +100,14 @@ S3Params InitConfig(const string& urlWithOptions) {
                                        8 * 1024 * 1024, 128 * 1024 * 1024);
     params.setChunkSize(chunkSize);
 
+    // a split smaller than a chunk would only add requests.
+    int64_t splitSize = s3Cfg.SafeScan("splitsize", configSection, 1024 * 1024 * 1024, 0,
+                                       (int64_t)1024 * 1024 * 1024 * 1024);
+    if (splitSize != 0 && splitSize < chunkSize) {
+        splitSize = chunkSize;
+    }
+    params.setSplitSize(splitSize);
+
     int64_t lowSpeedLimit = s3Cfg.SafeScan("low_speed_limit", configSection, 10240, 0, INT_MAX);
     params.setLowSpeedLimit(lowSpeedLimit);
 
@@ -110,8 +118,25 @@ S3Params InitConfig(const string& urlWithOptions) {
 
     params.setAutoCompress(s3Cfg.GetBool(configSection, "autocompress", "true"));
 
+    string compression_type = s3Cfg.Get(configSection, "compression_type", "gzip");
+    if (compression_type == "zstd") {
+        params.setCompressionType(S3_COMPRESSION_ZSTD);
+    } else {
+        params.setCompressionType(S3_COMPRESSION_GZIP);
+    }
+
     params.setVerifyCert(s3Cfg.GetBool(configSection, "verifycert", "true"));
 
+    params.setReuseConnection(s3Cfg.GetBool(configSection, "reuse_connection", "true"));
+
+    params.setUseHttp2(s3Cfg.GetBool(configSection, "http2", "false"));
+
+    params.setAutoTune(s3Cfg.GetBool(configSection, "autotune", "true"));
+
+    int64_t connectionsPerEndpoint =
+        s3Cfg.SafeScan("connections_per_endpoint", configSection, 16, 1, 1024);
+    params.setConnectionsPerEndpoint(connectionsPerEndpoint);
+
     string sse_type = s3Cfg.Get(configSection, "server_side_encryption", "");
     if (sse_type == "sse-s3") {
         params.setSSEType(SSE_S3);
@@ -7,6 +7,7 @@ Range OffsetMgr::getNextOffset() {
 
     pthread_mutex_lock(&this->offsetLock);
     ret.offset = std::min(this->curPos, this->keySize);
+    ret.seq = this->nextSeq++;
 
     if (this->curPos + this->chunkSize > this->keySize) {
         ret.length = this->keySize - this->curPos;
@@ -20,12 +21,166 @@ Range OffsetMgr::getNextOffset() {
     return ret;
 }
 
+ReadAheadTuner::ReadAheadTuner()
+    : enabled(false),
+      stopped(false),
+      maxChunkSize(0),
+      maxDepth(0),
+      chunkSize(0),
+      chunkSizeSettled(false),
+      prevThroughput(0),
+      sampleBytes(0),
+      sampleUsecs(0),
+      sampleCount(0),
+      depth(0),
+      consumedChunks(0),
+      readyStreak(0) {
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->turnCond, NULL);
+}
+
+ReadAheadTuner::~ReadAheadTuner() {
+    pthread_mutex_destroy(&this->mutex);
+    pthread_cond_destroy(&this->turnCond);
+}
+
+void ReadAheadTuner::configure(uint64_t maxChunkSize, uint64_t maxDepth, bool enabled) {
+    UniqueLock lock(&this->mutex);
+
+    if (this->maxChunkSize == maxChunkSize && this->maxDepth == maxDepth &&
+        this->enabled == enabled) {
+        return;
+    }
+
+    this->maxChunkSize = maxChunkSize;
+    this->maxDepth = maxDepth;
+    this->enabled = enabled;
+
+    this->chunkSizeSettled = !enabled;
+    this->prevThroughput = 0;
+    this->sampleBytes = 0;
+    this->sampleUsecs = 0;
+    this->sampleCount = 0;
+    this->readyStreak = 0;
+
+    if (enabled) {
+        this->chunkSize = std::max(maxChunkSize / S3_AUTOTUNE_START_DIVISOR,
+                                   std::min(maxChunkSize, (uint64_t)S3_AUTOTUNE_MIN_CHUNKSIZE));
+        this->depth = std::min(maxDepth, (uint64_t)2);
+    } else {
+        this->chunkSize = maxChunkSize;
+        this->depth = maxDepth;
+    }
+}
+
+void ReadAheadTuner::restart() {
+    UniqueLock lock(&this->mutex);
+    this->stopped = false;
+    this->consumedChunks = 0;
+}
+
+void ReadAheadTuner::stop() {
+    UniqueLock lock(&this->mutex);
+    this->stopped = true;
+    pthread_cond_broadcast(&this->turnCond);
+}
+
+void ReadAheadTuner::waitForTurn(uint64_t seq) {
+    if (!this->enabled) {
+        return;
+    }
+
+    UniqueLock lock(&this->mutex);
+    while (!this->stopped && seq >= this->consumedChunks + this->depth) {
+        pthread_cond_wait(&this->turnCond, &this->mutex);
+    }
+}
+
+void ReadAheadTuner::chunkFetched(uint64_t len, uint64_t usecs) {
+    if (!this->enabled) {
+        return;
+    }
+
+    UniqueLock lock(&this->mutex);
+
+    // chunks of an earlier size, and the short last chunk of a key, tell nothing about this size.
+    if (this->chunkSizeSettled || len != this->chunkSize) {
+        return;
+    }
+
+    this->sampleBytes += len;
+    this->sampleUsecs += usecs;
+    if (++this->sampleCount < S3_AUTOTUNE_SAMPLES) {
+        return;
+    }
+
+    double throughput =
+        (double)this->sampleBytes * 1000000 / std::max(this->sampleUsecs, (uint64_t)1);
+    this->sampleBytes = 0;
+    this->sampleUsecs = 0;
+    this->sampleCount = 0;
+
+    if (this->prevThroughput > 0 && throughput < this->prevThroughput * S3_AUTOTUNE_GAIN) {
+        // doubling didn't pay off, go back if it even hurt.
+        if (throughput < this->prevThroughput) {
+            this->chunkSize /= 2;
+        }
+        this->chunkSizeSettled = true;
+    } else if (this->chunkSize >= this->maxChunkSize) {
+        this->chunkSizeSettled = true;
+    } else {
+        this->prevThroughput = throughput;
+        this->chunkSize = std::min(this->chunkSize * 2, this->maxChunkSize);
+    }
+
+    S3DEBUG("Chunks of %" PRIu64 " bytes are fetched at %.0f bytes/s, next chunk size is %" PRIu64
+            "%s",
+            len, throughput, this->chunkSize, this->chunkSizeSettled ? " (settled)" : "");
+}
+
+void ReadAheadTuner::chunkConsumed(bool stalled) {
+    UniqueLock lock(&this->mutex);
+
+    this->consumedChunks++;
+
+    // the first chunk of a key is always waited for.
+    if (this->enabled && this->consumedChunks > 1) {
+        if (stalled) {
+            this->readyStreak = 0;
+            if (this->depth < this->maxDepth) {
+                this->depth++;
+                S3DEBUG("Read-ahead depth is raised to %" PRIu64, this->depth);
+            }
+        } else if (++this->readyStreak >= S3_AUTOTUNE_READY_STREAK) {
+            this->readyStreak = 0;
+            if (this->depth > std::min(this->maxDepth, (uint64_t)2)) {
+                this->depth--;
+                S3DEBUG("Read-ahead depth is lowered to %" PRIu64, this->depth);
+            }
+        }
+    }
+
+    pthread_cond_broadcast(&this->turnCond);
+}
+
+uint64_t ReadAheadTuner::getChunkSize() const {
+    UniqueLock lock(&this->mutex);
+    return this->chunkSize;
+}
+
+uint64_t ReadAheadTuner::getDepth() const {
+    UniqueLock lock(&this->mutex);
+    return this->depth;
+}
+
 ChunkBuffer::ChunkBuffer(const S3Url& s3Url, S3KeyReader& reader, const S3MemoryContext& context)
     : s3Url(s3Url), chunkData(context), offsetMgr(reader.getOffsetMgr()), sharedKeyReader(reader) {
     s3Interface = NULL;
     Range range = offsetMgr.getNextOffset();
     curFileOffset = range.offset;
     chunkDataSize = range.length;
+    chunkSeq = range.seq;
+    consumerWaited = false;
     status = ReadyToFill;
     eof = false;
     curChunkOffset = 0;
@@ -45,6 +200,8 @@ ChunkBuffer& ChunkBuffer::operator=(const ChunkBuffer& other) {
     this->curFileOffset = other.curFileOffset;
     this->curChunkOffset = other.curChunkOffset;
     this->chunkDataSize = other.chunkDataSize;
+    this->chunkSeq = other.chunkSeq;
+    this->consumerWaited = other.consumerWaited;
 
     return *this;
 }
@@ -59,6 +216,9 @@ uint64_t ChunkBuffer::read(char* buf, uint64_t len) {
     S3_CHECK_OR_DIE(!S3QueryIsAbortInProgress(), S3QueryAbort, "");
 
     UniqueLock statusLock(&this->statusMutex);
+    if (this->status != ReadyToRead) {
+        this->consumerWaited = true;
+    }
     while (this->status != ReadyToRead) {
         pthread_cond_wait(&this->statusCondVar, &this->statusMutex);
     }
@@ -86,9 +246,18 @@ uint64_t ChunkBuffer::read(char* buf, uint64_t len) {
 
             this->status = ReadyToFill;
 
+            ReadAheadTuner& tuner = this->sharedKeyReader.getTuner();
+            tuner.chunkConsumed(this->consumerWaited);
+            this->consumerWaited = false;
+
+            if (tuner.isEnabled()) {
+                this->offsetMgr.setChunkSize(tuner.getChunkSize());
+            }
+
             Range range = this->offsetMgr.getNextOffset();
             this->curFileOffset = range.offset;
             this->chunkDataSize = range.length;
+            this->chunkSeq = range.seq;
 
             pthread_cond_signal(&this->statusCondVar);
         }
@@ -105,6 +274,11 @@ uint64_t ChunkBuffer::fill() {
         pthread_cond_wait(&this->statusCondVar, &this->statusMutex);
     }
 
+    ReadAheadTuner& tuner = this->sharedKeyReader.getTuner();
+    if (this->chunkDataSize != 0) {
+        tuner.waitForTurn(this->chunkSeq);
+    }
+
     if (S3QueryIsAbortInProgress() || this->isError()) {
         this->setSharedError(true);
         this->status = ReadyToRead;
@@ -119,12 +293,14 @@ uint64_t ChunkBuffer::fill() {
 
     if (leftLen != 0) {
         try {
+            uint64_t startUsecs = GetMonotonicUsecs();
             readLen = this->s3Interface->fetchData(offset, this->chunkData, leftLen, this->s3Url);
             if (readLen != leftLen) {
                 S3DEBUG("Failed to fetch expected data from S3");
                 this->setSharedError(true, S3PartialResponseError(leftLen, readLen));
             } else {
                 S3DEBUG("Got %" PRIu64 " bytes from S3", readLen);
+                tuner.chunkFetched(readLen, GetMonotonicUsecs() - startUsecs);
             }
         } catch (S3Exception& e) {
             S3DEBUG("Failed to fetch expected data from S3");
@@ -189,12 +365,25 @@ void S3KeyReader::open(const S3Params& params) {
     this->numOfChunks = params.getNumOfChunks();
     S3_CHECK_OR_DIE(this->numOfChunks > 0, S3RuntimeError, "numOfChunks must not be zero");
 
-    this->offsetMgr.setKeySize(params.getKeySize());
-    this->offsetMgr.setChunkSize(params.getChunkSize());
+    uint64_t keySize = params.getKeySize();
+    uint64_t keyEnd = keySize;
+
+    this->keyOffset = std::min(params.getKeyOffset(), keySize);
+    if (params.getKeyLength() != 0) {
+        keyEnd = std::min(keySize, this->keyOffset + params.getKeyLength());
+    }
+    this->readToKeyEnd = (keyEnd == keySize);
 
     S3_CHECK_OR_DIE(params.getChunkSize() > 0, S3RuntimeError,
                     "chunk size must be greater than zero");
 
+    this->tuner.configure(params.getChunkSize(), this->numOfChunks, params.isAutoTune());
+    this->tuner.restart();
+
+    this->offsetMgr.setKeySize(keyEnd);
+    this->offsetMgr.setCurPos(this->keyOffset);
+    this->offsetMgr.setChunkSize(this->tuner.getChunkSize());
+
     this->chunkBuffers.reserve(this->numOfChunks);
 
     for (uint64_t i = 0; i < this->numOfChunks; i++) {
@@ -211,13 +400,13 @@ void S3KeyReader::open(const S3Params& params) {
 }
 
 uint64_t S3KeyReader::read(char* buf, uint64_t count) {
-    uint64_t fileLen = this->offsetMgr.getKeySize();
+    uint64_t fileLen = this->offsetMgr.getKeySize() - this->keyOffset;
     uint64_t readLen = 0;
 
     do {
         // confirm there is no more available data, done with this file
         if (this->transferredKeyLen >= fileLen) {
-            if (!this->hasEol && !this->eolAppended) {
+            if (this->readToKeyEnd && !this->hasEol && !this->eolAppended) {
                 uint64_t eolLen = strlen(eolString);
                 strncpy(buf, eolString, eolLen);
 
@@ -264,6 +453,8 @@ void S3KeyReader::reset() {
     this->sharedError = false;
     this->curReadingChunk = 0;
     this->transferredKeyLen = 0;
+    this->keyOffset = 0;
+    this->readToKeyEnd = true;
 
     this->offsetMgr.reset();
 
@@ -278,7 +469,9 @@ void S3KeyReader::close() {
     // to interupt downlading thread, we must: (check ChunkBuffer::fill())
     // 1. set condition to ReadyToFill and signal conditional_variable.
     // 2. set the shared error status to prevent download thread from continuing.
+    // 3. release threads waiting for their turn, they hold the lock of their ChunkBuffer.
     this->sharedError = true;
+    this->tuner.stop();
 
     for (uint64_t i = 0; i < this->chunkBuffers.size(); i++) {
         UniqueLock lock(this->chunkBuffers[i].getStatMutex());
@@ -1,12 +1,148 @@
 #include "s3restful_service.h"
 
+CURLHandlePool::CURLHandlePool() : maxHandlesPerEndpoint(0) {
+    // Pooled handles outlive every S3RESTfulService, keep libcurl initialized for them.
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    pthread_mutex_init(&this->mutex, NULL);
+    pthread_cond_init(&this->handleReleased, NULL);
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_init(&this->shareLocks[i], NULL);
+    }
+
+    this->share = curl_share_init();
+    curl_share_setopt(this->share, CURLSHOPT_LOCKFUNC, CURLHandlePool::lockShare);
+    curl_share_setopt(this->share, CURLSHOPT_UNLOCKFUNC, CURLHandlePool::unlockShare);
+    curl_share_setopt(this->share, CURLSHOPT_USERDATA, this);
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    curl_share_setopt(this->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+}
+
+CURLHandlePool::~CURLHandlePool() {
+    this->clear();
+
+    curl_share_cleanup(this->share);
+
+    for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+        pthread_mutex_destroy(&this->shareLocks[i]);
+    }
+
+    pthread_cond_destroy(&this->handleReleased);
+    pthread_mutex_destroy(&this->mutex);
+}
+
+// The pool is never destroyed, handles must not be cleaned up by exit handlers after the TLS
+// library has been torn down.
+CURLHandlePool &CURLHandlePool::getInstance() {
+    static CURLHandlePool *pool = new CURLHandlePool();
+    return *pool;
+}
+
+void CURLHandlePool::lockShare(CURL *curl, curl_lock_data data, curl_lock_access access,
+                               void *userp) {
+    CURLHandlePool *pool = static_cast<CURLHandlePool *>(userp);
+    pthread_mutex_lock(&pool->shareLocks[data]);
+}
+
+void CURLHandlePool::unlockShare(CURL *curl, curl_lock_data data, void *userp) {
+    CURLHandlePool *pool = static_cast<CURLHandlePool *>(userp);
+    pthread_mutex_unlock(&pool->shareLocks[data]);
+}
+
+// "https://bucket.s3.amazonaws.com/key?x" => "https://bucket.s3.amazonaws.com"
+static string GetEndpoint(const string &url) {
+    size_t hostBegin = url.find("://");
+    hostBegin = (hostBegin == string::npos) ? 0 : hostBegin + 3;
+
+    return url.substr(0, url.find_first_of("/?", hostBegin));
+}
+
+CURL *CURLHandlePool::acquire(const string &url) {
+    string endpoint = GetEndpoint(url);
+    CURL *curl = NULL;
+
+    UniqueLock lock(&this->mutex);
+
+    EndpointHandles &handles = this->endpoints[endpoint];
+    while (handles.idle.empty() && (this->maxHandlesPerEndpoint != 0) &&
+           (handles.inUse >= this->maxHandlesPerEndpoint)) {
+        S3_CHECK_OR_DIE(!S3QueryIsAbortInProgress(), S3QueryAbort, "");
+
+        // wake up now and then to check for query abort
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += 1;
+        pthread_cond_timedwait(&this->handleReleased, &this->mutex, &deadline);
+    }
+
+    if (!handles.idle.empty()) {
+        curl = handles.idle.back();
+        handles.idle.pop_back();
+    } else {
+        curl = curl_easy_init();
+        S3_CHECK_OR_DIE(curl != NULL, S3RuntimeError, "Failed to create curl handle");
+        curl_easy_setopt(curl, CURLOPT_SHARE, this->share);
+    }
+
+    handles.inUse++;
+
+    return curl;
+}
+
+void CURLHandlePool::release(const string &url, CURL *curl) {
+    // Forget options of the last request, but keep the connections.
+    curl_easy_reset(curl);
+    curl_easy_setopt(curl, CURLOPT_SHARE, this->share);
+
+    UniqueLock lock(&this->mutex);
+
+    EndpointHandles &handles = this->endpoints[GetEndpoint(url)];
+    handles.inUse--;
+
+    if ((this->maxHandlesPerEndpoint == 0) ||
+        (handles.idle.size() + handles.inUse < this->maxHandlesPerEndpoint)) {
+        handles.idle.push_back(curl);
+    } else {
+        curl_easy_cleanup(curl);
+    }
+
+    pthread_cond_broadcast(&this->handleReleased);
+}
+
+void CURLHandlePool::setMaxHandlesPerEndpoint(uint64_t maxHandles) {
+    UniqueLock lock(&this->mutex);
+    this->maxHandlesPerEndpoint = maxHandles;
+    pthread_cond_broadcast(&this->handleReleased);
+}
+
+uint64_t CURLHandlePool::getIdleHandles(const string &url) {
+    UniqueLock lock(&this->mutex);
+    return this->endpoints[GetEndpoint(url)].idle.size();
+}
+
+void CURLHandlePool::clear() {
+    UniqueLock lock(&this->mutex);
+
+    map<string, EndpointHandles>::iterator it;
+    for (it = this->endpoints.begin(); it != this->endpoints.end(); it++) {
+        for (uint64_t i = 0; i < it->second.idle.size(); i++) {
+            curl_easy_cleanup(it->second.idle[i]);
+        }
+        it->second.idle.clear();
+    }
+}
+
 S3RESTfulService::S3RESTfulService()
     : lowSpeedLimit(0),
       lowSpeedTime(0),
       proxy(""),
       debugCurl(false),
       verifyCert(true),
+      reuseConnection(true),
+      useHttp2(false),
       chunkBufferSize(64 * 1024) {
+    CURLHandlePool::getInstance();
 }
 
 S3RESTfulService::S3RESTfulService(const string &proxy)
@@ -15,7 +151,10 @@ S3RESTfulService::S3RESTfulService(const string &proxy)
       proxy(proxy),
       debugCurl(false),
       verifyCert(true),
+      reuseConnection(true),
+      useHttp2(false),
       chunkBufferSize(64 * 1024) {
+    CURLHandlePool::getInstance();
 }
 
 S3RESTfulService::S3RESTfulService(const S3Params &params)
@@ -30,6 +169,11 @@ S3RESTfulService::S3RESTfulService(const S3Params &params)
     this->chunkBufferSize = params.getChunkSize();
     this->verifyCert = params.isVerifyCert();
     this->proxy = params.getProxy();
+    this->reuseConnection = params.isReuseConnection();
+    this->useHttp2 = params.isUseHttp2();
+
+    // Same as curl_global_init(), create the pool before any thread uses it.
+    CURLHandlePool::getInstance().setMaxHandlesPerEndpoint(params.getConnectionsPerEndpoint());
 }
 
 S3RESTfulService::~S3RESTfulService() {
@@ -96,15 +240,28 @@ static size_t RESTfulServiceReadFuncCallback(char *ptr, size_t size, size_t nmem
 
 struct CURLWrapper {
     CURLWrapper(const string &url, curl_slist *headers, uint64_t lowSpeedLimit,
-                uint64_t lowSpeedTime, bool debugCurl, string proxy) {
-        curl = curl_easy_init();
+                uint64_t lowSpeedTime, bool debugCurl, string proxy, bool reuseConnection,
+                bool useHttp2)
+        : url(url), reuseConnection(reuseConnection) {
+        if (reuseConnection) {
+            curl = CURLHandlePool::getInstance().acquire(url);
+            curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        } else {
+            curl = curl_easy_init();
+            curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+        }
+
         curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
         curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
         curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, lowSpeedLimit);
         curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, lowSpeedTime);
 
+        if (useHttp2) {
+            // falls back to HTTP/1.1 if the server or libcurl doesn't support it
+            curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        }
+
         if (debugCurl) {
             curl_easy_setopt(curl, CURLOPT_VERBOSE, 1L);
         }
@@ -114,9 +271,15 @@ struct CURLWrapper {
         }
     }
     ~CURLWrapper() {
-        curl_easy_cleanup(curl);
+        if (reuseConnection) {
+            CURLHandlePool::getInstance().release(url, curl);
+        } else {
+            curl_easy_cleanup(curl);
+        }
     }
     CURL *curl;
+    string url;
+    bool reuseConnection;
 };
 
 void S3RESTfulService::performCurl(CURL *curl, Response &response) {
@@ -149,7 +312,7 @@ Response S3RESTfulService::get(const string &url, HTTPHeaders &headers) {
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->reuseConnection, this->useHttp2);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -182,7 +345,7 @@ Response S3RESTfulService::put(const string &url, HTTPHeaders &headers, const S3
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->reuseConnection, this->useHttp2);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -225,7 +388,7 @@ Response S3RESTfulService::post(const string &url, HTTPHeaders &headers,
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->reuseConnection, this->useHttp2);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
@@ -270,7 +433,7 @@ ResponseCode S3RESTfulService::head(const string &url, HTTPHeaders &headers) {
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->reuseConnection, this->useHttp2);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "HEAD");
@@ -303,7 +466,7 @@ Response S3RESTfulService::deleteRequest(const string &url, HTTPHeaders &headers
 
     headers.CreateList();
     CURLWrapper wrapper(url, headers.GetList(), this->lowSpeedLimit, this->lowSpeedTime,
-                        this->debugCurl, this->proxy);
+                        this->debugCurl, this->proxy, this->reuseConnection, this->useHttp2);
     CURL *curl = wrapper.curl;
 
     curl_easy_setopt(curl, CURLOPT_WRITEDATA, (void *)&response);
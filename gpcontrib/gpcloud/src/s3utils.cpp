@@ -434,3 +434,9 @@ string TruncateOptions(const string &urlWithOptions) {
         return urlWithOptions.substr(0, firstSpace);
     }
 }
+
+uint64_t GetMonotonicUsecs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
@@ -210,3 +210,78 @@ TEST_F(CompressWriterTest, CompressCompressedData) {
 
     EXPECT_TRUE(memcmp(compressedData.data(), result.get(), compressedData.size()) == 0);
 }
+
+#ifdef HAVE_LIBZSTD
+class ZstdCompressWriterTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        S3Params params("s3://abc/def/");
+        params.setCompressionType(S3_COMPRESSION_ZSTD);
+
+        compressWriter.setWriter(&writer);
+        compressWriter.open(params);
+    }
+
+    virtual void TearDown() {
+        compressWriter.close();
+    }
+
+    string uncompress() {
+        const char *data = writer.getRawData();
+
+        string result;
+        vector<char> out(ZSTD_DStreamOutSize());
+        ZSTD_DStream *stream = ZSTD_createDStream();
+        ZSTD_initDStream(stream);
+
+        ZSTD_inBuffer input = {data, writer.getDataSize(), 0};
+        while (input.pos < input.size) {
+            ZSTD_outBuffer output = {out.data(), out.size(), 0};
+            size_t ret = ZSTD_decompressStream(stream, &output, &input);
+            EXPECT_FALSE(ZSTD_isError(ret));
+            if (ZSTD_isError(ret)) {
+                break;
+            }
+            result.append(out.data(), output.pos);
+        }
+
+        ZSTD_freeDStream(stream);
+        return result;
+    }
+
+    CompressWriter compressWriter;
+    MockWriter writer;
+};
+
+TEST_F(ZstdCompressWriterTest, AbleToCompressAndCheckZstdMagic) {
+    char input[10] = {0};
+    compressWriter.write(input, sizeof(input));
+    compressWriter.close();
+
+    const char *header = writer.getRawData();
+    ASSERT_EQ(char(0x28), header[0]);
+    ASSERT_EQ(char(0xb5), header[1]);
+    ASSERT_EQ(char(0x2f), header[2]);
+    ASSERT_EQ(char(0xfd), header[3]);
+}
+
+TEST_F(ZstdCompressWriterTest, AbleToCompressEmptyData) {
+    compressWriter.close();
+
+    EXPECT_EQ("", this->uncompress());
+}
+
+TEST_F(ZstdCompressWriterTest, AbleToWriteLargerThanCompressChunkSize) {
+    const char pangram[] = "The quick brown fox jumps over the lazy dog";
+    uint64_t times = S3_ZIP_COMPRESS_CHUNKSIZE / (sizeof(pangram) - 1) + 1;
+
+    string input;
+    for (uint64_t i = 0; i < times; i++) input.append(pangram);
+
+    compressWriter.write(input.c_str(), input.length());
+    compressWriter.write(pangram, sizeof(pangram) - 1);
+    compressWriter.close();
+
+    EXPECT_EQ(input + pangram, this->uncompress());
+}
+#endif
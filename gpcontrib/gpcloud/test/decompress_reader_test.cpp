@@ -311,3 +311,108 @@ TEST_F(DecompressReaderTest, AbleToDecompressWithIncorrectEncodedStream) {
 
     EXPECT_THROW(decompressReader.read(outputBuffer, sizeof(outputBuffer)), S3RuntimeError);
 }
+
+#ifdef HAVE_LIBZSTD
+class ZstdDecompressReaderTest : public testing::Test {
+   protected:
+    virtual void SetUp() {
+        S3_ZIP_DECOMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
+
+        this->bufReader.setChunkSize(1024 * 1024 * 64);
+        decompressReader.setReader(&bufReader);
+        decompressReader.setCompressionType(S3_COMPRESSION_ZSTD);
+        decompressReader.open(S3Params("s3://abc/def"));
+    }
+
+    virtual void TearDown() {
+        decompressReader.close();
+
+        S3_ZIP_DECOMPRESS_CHUNKSIZE = S3_ZIP_DEFAULT_CHUNKSIZE;
+    }
+
+    // Compress each input as a separate frame, and concatenate the frames.
+    void setBufReaderByFrames(const vector<string> &inputs) {
+        vector<char> frames;
+
+        for (uint64_t i = 0; i < inputs.size(); i++) {
+            vector<char> frame(ZSTD_compressBound(inputs[i].size()));
+            size_t len = ZSTD_compress(frame.data(), frame.size(), inputs[i].data(),
+                                       inputs[i].size(), S3_ZSTD_COMPRESSION_LEVEL);
+            ASSERT_FALSE(ZSTD_isError(len));
+            frames.insert(frames.end(), frame.begin(), frame.begin() + len);
+        }
+
+        bufReader.setData(frames.data(), frames.size());
+    }
+
+    string readAll(uint64_t bufSize) {
+        string result;
+        vector<char> buf(bufSize);
+
+        uint64_t count;
+        while ((count = decompressReader.read(buf.data(), buf.size())) > 0) {
+            result.append(buf.data(), count);
+        }
+        return result;
+    }
+
+    DecompressReader decompressReader;
+    MockBufferReader bufReader;
+};
+
+TEST_F(ZstdDecompressReaderTest, AbleToDecompressEmptyData) {
+    bufReader.setData("", 0);
+
+    char buf[100];
+    EXPECT_EQ((uint64_t)0, decompressReader.read(buf, sizeof(buf)));
+}
+
+TEST_F(ZstdDecompressReaderTest, AbleToDecompressSmallCompressedData) {
+    string hello("The quick brown fox jumps over the lazy dog");
+    setBufReaderByFrames(vector<string>(1, hello));
+
+    EXPECT_EQ(hello, readAll(10000));
+}
+
+TEST_F(ZstdDecompressReaderTest, AbleToDecompressMultipleFrames) {
+    vector<string> inputs;
+    inputs.push_back(string(1000, 'a'));
+    inputs.push_back("The quick brown fox jumps over the lazy dog");
+    inputs.push_back(string(3000, 'b'));
+    setBufReaderByFrames(inputs);
+
+    EXPECT_EQ(inputs[0] + inputs[1] + inputs[2], readAll(77));
+}
+
+TEST_F(ZstdDecompressReaderTest, AbleToDecompressWithSmallInternalBuffer) {
+    // Output of a frame doesn't fit into 'out', and input is fed 7 bytes at a time.
+    S3_ZIP_DECOMPRESS_CHUNKSIZE = 16;
+    decompressReader.resizeDecompressReaderBuffer(S3_ZIP_DECOMPRESS_CHUNKSIZE);
+    bufReader.setChunkSize(7);
+
+    vector<string> inputs;
+    inputs.push_back(string(100, 'A'));
+    inputs.push_back("abcdefghijklmnopqrstuvwxyz");
+    setBufReaderByFrames(inputs);
+
+    EXPECT_EQ(inputs[0] + inputs[1], readAll(9));
+}
+
+TEST_F(ZstdDecompressReaderTest, AbleToDetectTruncatedFrame) {
+    string hello(1000, 'x');
+    vector<char> frame(ZSTD_compressBound(hello.size()));
+    size_t len = ZSTD_compress(frame.data(), frame.size(), hello.data(), hello.size(), 1);
+    bufReader.setData(frame.data(), len - 3);
+
+    char buf[10000];
+    EXPECT_THROW(decompressReader.read(buf, sizeof(buf)), S3RuntimeError);
+}
+
+TEST_F(ZstdDecompressReaderTest, AbleToDecompressWithIncorrectEncodedStream) {
+    const char hello[] = "The quick brown fox jumps over the lazy dog";
+    bufReader.setData(hello, sizeof(hello));
+
+    char buf[10000];
+    EXPECT_THROW(decompressReader.read(buf, sizeof(buf)), S3RuntimeError);
+}
+#endif
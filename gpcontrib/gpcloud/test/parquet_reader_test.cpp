@@ -0,0 +1,890 @@
+#include "parquet_reader.cpp"
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "mock_classes.h"
+
+using ::testing::_;
+using ::testing::Invoke;
+
+// Thrift compact protocol writer, to build Parquet footers and page headers.
+class ThriftCompactWriter {
+   public:
+    ThriftCompactWriter() {
+        lastFieldIds.push_back(0);
+    }
+
+    void field(int16_t id, uint8_t type) {
+        int16_t delta = id - lastFieldIds.back();
+        if (delta > 0 && delta <= 15) {
+            out.push_back((delta << 4) | type);
+        } else {
+            out.push_back(type);
+            writeVarint(((uint64_t)id << 1) ^ (uint64_t)(id >> 15));
+        }
+        lastFieldIds.back() = id;
+    }
+
+    void i32(int16_t id, int32_t value) {
+        field(id, THRIFT_I32);
+        writeZigzag(value);
+    }
+
+    void i64(int16_t id, int64_t value) {
+        field(id, THRIFT_I64);
+        writeZigzag(value);
+    }
+
+    void boolean(int16_t id, bool value) {
+        field(id, value ? THRIFT_TRUE : THRIFT_FALSE);
+    }
+
+    void binary(int16_t id, const string& value) {
+        field(id, THRIFT_BINARY);
+        writeBinary(value);
+    }
+
+    void structBegin(int16_t id) {
+        field(id, THRIFT_STRUCT);
+        lastFieldIds.push_back(0);
+    }
+
+    void listBegin(int16_t id, uint8_t elemType, uint32_t size) {
+        field(id, THRIFT_LIST);
+        if (size < 15) {
+            out.push_back((size << 4) | elemType);
+        } else {
+            out.push_back(0xf0 | elemType);
+            writeVarint(size);
+        }
+    }
+
+    // a struct element of a list
+    void elementBegin() {
+        lastFieldIds.push_back(0);
+    }
+
+    void structEnd() {
+        out.push_back(THRIFT_STOP);
+        lastFieldIds.pop_back();
+    }
+
+    void writeZigzag(int64_t value) {
+        writeVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+    }
+
+    void writeBinary(const string& value) {
+        writeVarint(value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    void writeVarint(uint64_t n) {
+        while (n >= 0x80) {
+            out.push_back((n & 0x7f) | 0x80);
+            n >>= 7;
+        }
+        out.push_back(n);
+    }
+
+    vector<uint8_t> out;
+
+   private:
+    vector<int16_t> lastFieldIds;
+};
+
+static string PlainInt64(int64_t value) {
+    return string((const char*)&value, sizeof(value));
+}
+
+static string PlainByteArray(const string& value) {
+    uint32_t len = value.size();
+    return string((const char*)&len, sizeof(len)) + value;
+}
+
+static string GzipCompress(const string& data) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, MAX_WBITS + 16, 8, Z_DEFAULT_STRATEGY);
+
+    string out(deflateBound(&zs, data.size()), '\0');
+    zs.next_in = (Bytef*)data.data();
+    zs.avail_in = data.size();
+    zs.next_out = (Bytef*)&out[0];
+    zs.avail_out = out.size();
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+struct TestColumn {
+    TestColumn(const string& name, int32_t type, int32_t convertedType = -1,
+               bool optional = false)
+        : name(name), type(type), convertedType(convertedType), optional(optional) {
+    }
+
+    string name;
+    int32_t type;
+    int32_t convertedType;
+    bool optional;
+};
+
+// Values of a column chunk, plain encoded one by one, empty for NULL.
+struct TestChunk {
+    TestChunk() : dictionary(false), hasMinMax(false) {
+    }
+
+    vector<string> values;
+    vector<bool> defined;
+    bool dictionary;  // dictionary encode the values
+    bool hasMinMax;
+    string minValue;
+    string maxValue;
+};
+
+// Builds Parquet files in memory.
+class TestParquetFile {
+   public:
+    TestParquetFile(const vector<TestColumn>& columns, int32_t codec = PARQUET_CODEC_UNCOMPRESSED)
+        : columns(columns), codec(codec) {
+        append(PARQUET_MAGIC);
+    }
+
+    // Append a row group with a chunk per column, return the start offsets of the chunks.
+    vector<uint64_t> addRowGroup(const vector<TestChunk>& chunks) {
+        RowGroupInfo rowGroup;
+        rowGroup.numRows = chunks[0].defined.size();
+
+        vector<uint64_t> starts;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            rowGroup.chunks.push_back(writeChunk(columns[i], chunks[i]));
+            starts.push_back(rowGroup.chunks.back().start);
+        }
+
+        rowGroups.push_back(rowGroup);
+        return starts;
+    }
+
+    string finish() {
+        ThriftCompactWriter w;
+        w.i32(1, 1);  // version
+        w.listBegin(2, THRIFT_STRUCT, columns.size() + 1);
+        w.elementBegin();
+        w.binary(4, "schema");
+        w.i32(5, columns.size());
+        w.structEnd();
+        for (size_t i = 0; i < columns.size(); i++) {
+            w.elementBegin();
+            w.i32(1, columns[i].type);
+            w.i32(3, columns[i].optional ? PARQUET_OPTIONAL : PARQUET_REQUIRED);
+            w.binary(4, columns[i].name);
+            if (columns[i].convertedType >= 0) {
+                w.i32(6, columns[i].convertedType);
+            }
+            w.structEnd();
+        }
+
+        int64_t numRows = 0;
+        for (size_t i = 0; i < rowGroups.size(); i++) {
+            numRows += rowGroups[i].numRows;
+        }
+        w.i64(3, numRows);
+
+        w.listBegin(4, THRIFT_STRUCT, rowGroups.size());
+        for (size_t i = 0; i < rowGroups.size(); i++) {
+            const RowGroupInfo& rowGroup = rowGroups[i];
+            w.elementBegin();
+            w.listBegin(1, THRIFT_STRUCT, rowGroup.chunks.size());
+            for (size_t j = 0; j < rowGroup.chunks.size(); j++) {
+                const ChunkInfo& chunk = rowGroup.chunks[j];
+                w.elementBegin();
+                w.i64(2, chunk.start);
+                w.structBegin(3);
+                w.i32(1, columns[j].type);
+                w.listBegin(2, THRIFT_I32, 1);
+                w.writeZigzag(PARQUET_ENCODING_PLAIN);
+                w.listBegin(3, THRIFT_BINARY, 1);
+                w.writeBinary(columns[j].name);
+                w.i32(4, codec);
+                w.i64(5, rowGroup.numRows);
+                w.i64(6, chunk.size);
+                w.i64(7, chunk.size);
+                w.i64(9, chunk.dataPageOffset);
+                if (chunk.dictionaryPageOffset > 0) {
+                    w.i64(11, chunk.dictionaryPageOffset);
+                }
+                w.structBegin(12);
+                w.i64(3, chunk.nullCount);
+                if (chunk.hasMinMax) {
+                    w.binary(5, chunk.maxValue);
+                    w.binary(6, chunk.minValue);
+                }
+                w.structEnd();
+                w.structEnd();
+                w.structEnd();
+            }
+            w.i64(2, 0);
+            w.i64(3, rowGroup.numRows);
+            w.structEnd();
+        }
+        w.structEnd();
+
+        uint32_t footerLen = w.out.size();
+        append(string(w.out.begin(), w.out.end()));
+        append(string((const char*)&footerLen, sizeof(footerLen)));
+        append(PARQUET_MAGIC);
+        return data;
+    }
+
+   private:
+    struct ChunkInfo {
+        uint64_t start;
+        uint64_t size;
+        uint64_t dataPageOffset;
+        uint64_t dictionaryPageOffset;
+        int64_t nullCount;
+        bool hasMinMax;
+        string minValue;
+        string maxValue;
+    };
+
+    struct RowGroupInfo {
+        int64_t numRows;
+        vector<ChunkInfo> chunks;
+    };
+
+    vector<TestColumn> columns;
+    int32_t codec;
+    vector<RowGroupInfo> rowGroups;
+    string data;
+
+    void append(const string& bytes) {
+        data += bytes;
+    }
+
+    string compress(const string& page) {
+        switch (codec) {
+            case PARQUET_CODEC_GZIP:
+                return GzipCompress(page);
+            default:
+                return page;
+        }
+    }
+
+    void writePage(int32_t type, const string& body, int32_t numValues, int32_t encoding) {
+        string compressed = compress(body);
+
+        ThriftCompactWriter w;
+        w.i32(1, type);
+        w.i32(2, body.size());
+        w.i32(3, compressed.size());
+        if (type == PARQUET_DICTIONARY_PAGE) {
+            w.structBegin(7);
+            w.i32(1, numValues);
+            w.i32(2, encoding);
+            w.structEnd();
+        } else {
+            w.structBegin(5);
+            w.i32(1, numValues);
+            w.i32(2, encoding);
+            w.i32(3, PARQUET_ENCODING_RLE);
+            w.i32(4, PARQUET_ENCODING_RLE);
+            w.structEnd();
+        }
+        w.structEnd();
+
+        append(string(w.out.begin(), w.out.end()));
+        append(compressed);
+    }
+
+    ChunkInfo writeChunk(const TestColumn& column, const TestChunk& chunk) {
+        ChunkInfo info;
+        info.start = data.size();
+        info.dictionaryPageOffset = 0;
+        info.nullCount = 0;
+        info.hasMinMax = chunk.hasMinMax;
+        info.minValue = chunk.minValue;
+        info.maxValue = chunk.maxValue;
+
+        string body;
+
+        // definition levels, bit-packed
+        if (column.optional) {
+            string levels;
+            ThriftCompactWriter header;
+            uint32_t groups = (chunk.defined.size() + 7) / 8;
+            header.writeVarint((groups << 1) | 1);
+            levels.assign(header.out.begin(), header.out.end());
+            string bits(groups, '\0');
+            for (size_t i = 0; i < chunk.defined.size(); i++) {
+                if (chunk.defined[i]) {
+                    bits[i / 8] |= 1 << (i % 8);
+                }
+            }
+            levels += bits;
+
+            uint32_t levelsLen = levels.size();
+            body.append((const char*)&levelsLen, sizeof(levelsLen));
+            body += levels;
+        }
+
+        vector<string> present;
+        for (size_t i = 0; i < chunk.defined.size(); i++) {
+            if (chunk.defined[i]) {
+                present.push_back(chunk.values[i]);
+            } else {
+                info.nullCount++;
+            }
+        }
+
+        int32_t encoding = PARQUET_ENCODING_PLAIN;
+        if (chunk.dictionary) {
+            vector<string> dictionary;
+            vector<uint32_t> indices;
+            for (size_t i = 0; i < present.size(); i++) {
+                size_t k = std::find(dictionary.begin(), dictionary.end(), present[i]) -
+                           dictionary.begin();
+                if (k == dictionary.size()) {
+                    dictionary.push_back(present[i]);
+                }
+                indices.push_back(k);
+            }
+
+            string dictionaryPage;
+            for (size_t i = 0; i < dictionary.size(); i++) {
+                dictionaryPage += dictionary[i];
+            }
+            info.dictionaryPageOffset = data.size();
+            writePage(PARQUET_DICTIONARY_PAGE, dictionaryPage, dictionary.size(),
+                      PARQUET_ENCODING_PLAIN);
+
+            // bit width 8, a RLE run per index
+            ThriftCompactWriter w;
+            w.out.push_back(8);
+            for (size_t i = 0; i < indices.size(); i++) {
+                w.writeVarint(1 << 1);
+                w.out.push_back(indices[i]);
+            }
+            body.append(w.out.begin(), w.out.end());
+            encoding = PARQUET_ENCODING_RLE_DICTIONARY;
+        } else {
+            for (size_t i = 0; i < present.size(); i++) {
+                body += present[i];
+            }
+        }
+
+        info.dataPageOffset = data.size();
+        writePage(PARQUET_DATA_PAGE, body, chunk.defined.size(), encoding);
+
+        info.size = data.size() - info.start;
+        return info;
+    }
+};
+
+static TestChunk Int64Chunk(int64_t first, int64_t count) {
+    TestChunk chunk;
+    for (int64_t i = first; i < first + count; i++) {
+        chunk.values.push_back(PlainInt64(i));
+        chunk.defined.push_back(true);
+    }
+    chunk.hasMinMax = true;
+    chunk.minValue = PlainInt64(first);
+    chunk.maxValue = PlainInt64(first + count - 1);
+    return chunk;
+}
+
+static TestChunk StringChunk(const vector<string>& values, const vector<bool>& defined) {
+    TestChunk chunk;
+    for (size_t i = 0; i < values.size(); i++) {
+        chunk.values.push_back(defined[i] ? PlainByteArray(values[i]) : "");
+    }
+    chunk.defined = defined;
+    return chunk;
+}
+
+// A decoded row of the stream the reader produces
+struct TestValue {
+    uint8_t tag;
+    int64_t intValue;
+    double doubleValue;
+    string bytesValue;
+};
+
+typedef vector<TestValue> TestRow;
+
+class ParquetReaderTest : public testing::Test, public ParquetReader {
+   protected:
+    virtual void SetUp() {
+        this->setS3InterfaceService(&s3Interface);
+    }
+
+    virtual void TearDown() {
+        this->close();
+    }
+
+    void setFile(const string& file) {
+        this->file = file;
+        EXPECT_CALL(s3Interface, fetchData(_, _, _, _))
+            .WillRepeatedly(Invoke(this, &ParquetReaderTest::fetchFromFile));
+    }
+
+    uint64_t fetchFromFile(uint64_t offset, S3VectorUInt8& data, uint64_t len, const S3Url& url) {
+        fetches.push_back(std::make_pair(offset, len));
+        data.clear();
+        data.insert(data.end(), file.begin() + offset, file.begin() + offset + len);
+        return len;
+    }
+
+    void setColumns(const vector<string>& columns) {
+        spec.columns = columns;
+        spec.projected.assign(columns.size(), true);
+    }
+
+    void openFile(uint64_t offset = 0, uint64_t length = 0) {
+        this->setScanSpec(spec);
+
+        S3Params params("s3://neverland.amazonaws.com/bucket/data.parquet");
+        params.setKeySize(file.size());
+        params.setKeyRange(offset, length);
+        this->open(params);
+    }
+
+    // read everything with small reads, and decode the rows
+    vector<TestRow> readRows() {
+        string stream;
+        char buf[100];
+        uint64_t n;
+        while ((n = this->read(buf, sizeof(buf))) > 0) {
+            stream.append(buf, n);
+        }
+
+        vector<TestRow> rows;
+        const char* p = stream.data();
+        const char* end = p + stream.size();
+        while (p < end) {
+            uint32_t rowLen;
+            memcpy(&rowLen, p, sizeof(rowLen));
+            const char* rowEnd = p + rowLen;
+            p += sizeof(rowLen);
+
+            TestRow row;
+            while (p < rowEnd) {
+                TestValue value;
+                value.tag = *p++;
+                value.intValue = 0;
+                value.doubleValue = 0;
+                switch (value.tag) {
+                    case PARQUET_VALUE_NULL:
+                        break;
+                    case PARQUET_VALUE_BOOL:
+                        value.intValue = *p++;
+                        break;
+                    case PARQUET_VALUE_INT32:
+                    case PARQUET_VALUE_DATE: {
+                        int32_t v;
+                        memcpy(&v, p, sizeof(v));
+                        value.intValue = v;
+                        p += sizeof(v);
+                        break;
+                    }
+                    case PARQUET_VALUE_INT64:
+                    case PARQUET_VALUE_TIMESTAMP:
+                        memcpy(&value.intValue, p, sizeof(int64_t));
+                        p += sizeof(int64_t);
+                        break;
+                    case PARQUET_VALUE_DOUBLE:
+                        memcpy(&value.doubleValue, p, sizeof(double));
+                        p += sizeof(double);
+                        break;
+                    default: {
+                        uint32_t len;
+                        memcpy(&len, p, sizeof(len));
+                        p += sizeof(len);
+                        value.bytesValue.assign(p, len);
+                        p += len;
+                        break;
+                    }
+                }
+                row.push_back(value);
+            }
+            EXPECT_EQ(rowEnd, p);
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    string file;
+    ParquetScanSpec spec;
+    vector<std::pair<uint64_t, uint64_t>> fetches;  // offset and length
+
+    MockS3Interface s3Interface;
+};
+
+TEST(ParquetMetadataTest, ThriftSkipsUnknownFields) {
+    ThriftCompactWriter w;
+    w.i32(3, 7);  // num_rows with the wrong type
+    w.structBegin(100);
+    w.listBegin(1, THRIFT_BINARY, 2);
+    w.writeBinary("a");
+    w.writeBinary("b");
+    w.boolean(2, true);
+    w.structEnd();
+    w.i64(3, 42);
+    w.listBegin(2, THRIFT_STRUCT, 1);
+    w.elementBegin();
+    w.binary(4, "schema");
+    w.structEnd();
+    w.structEnd();
+
+    ParquetFileMetadata metadata;
+    ParseParquetMetadata(w.out.data(), w.out.size(), metadata);
+    EXPECT_EQ(42, metadata.numRows);
+    EXPECT_EQ(0u, metadata.columns.size());
+}
+
+TEST(ParquetMetadataTest, TruncatedMetadataThrows) {
+    ThriftCompactWriter w;
+    w.binary(4, "a long enough string");
+
+    ParquetFileMetadata metadata;
+    EXPECT_THROW(ParseParquetMetadata(w.out.data(), w.out.size() - 3, metadata), S3RuntimeError);
+}
+
+TEST(ParquetCodecTest, FormatDecimal) {
+    EXPECT_EQ("123.45", FormatDecimal(12345, 2));
+    EXPECT_EQ("-0.05", FormatDecimal(-5, 2));
+    EXPECT_EQ("0", FormatDecimal(0, 0));
+    EXPECT_EQ("170141183460469231731687303715884105727",
+              FormatDecimal(~((unsigned __int128)1 << 127), 0));
+}
+
+TEST_F(ParquetReaderTest, ReadsAllColumns) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("id", PARQUET_INT64));
+    columns.push_back(TestColumn("name", PARQUET_BYTE_ARRAY, PARQUET_CONVERTED_UTF8, true));
+
+    const char* names[] = {"alpha", "", "gamma"};
+    bool defined[] = {true, false, true};
+
+    TestParquetFile builder(columns);
+    vector<TestChunk> chunks;
+    chunks.push_back(Int64Chunk(1, 3));
+    chunks.push_back(
+        StringChunk(vector<string>(names, names + 3), vector<bool>(defined, defined + 3)));
+    builder.addRowGroup(chunks);
+    setFile(builder.finish());
+
+    const char* tableColumns[] = {"id", "name"};
+    setColumns(vector<string>(tableColumns, tableColumns + 2));
+    openFile();
+
+    vector<TestRow> rows = readRows();
+    ASSERT_EQ(3u, rows.size());
+    for (size_t i = 0; i < rows.size(); i++) {
+        ASSERT_EQ(2u, rows[i].size());
+        EXPECT_EQ(PARQUET_VALUE_INT64, rows[i][0].tag);
+        EXPECT_EQ((int64_t)i + 1, rows[i][0].intValue);
+    }
+    EXPECT_EQ("alpha", rows[0][1].bytesValue);
+    EXPECT_EQ(PARQUET_VALUE_NULL, rows[1][1].tag);
+    EXPECT_EQ("gamma", rows[2][1].bytesValue);
+
+    EXPECT_EQ(0u, this->read(NULL, 100));
+}
+
+TEST_F(ParquetReaderTest, ColumnsAreMatchedByName) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("A", PARQUET_INT64));
+    columns.push_back(TestColumn("b", PARQUET_INT64));
+
+    TestParquetFile builder(columns);
+    vector<TestChunk> chunks;
+    chunks.push_back(Int64Chunk(1, 2));
+    chunks.push_back(Int64Chunk(100, 2));
+    builder.addRowGroup(chunks);
+    setFile(builder.finish());
+
+    const char* tableColumns[] = {"b", "a"};
+    setColumns(vector<string>(tableColumns, tableColumns + 2));
+    openFile();
+
+    vector<TestRow> rows = readRows();
+    ASSERT_EQ(2u, rows.size());
+    EXPECT_EQ(100, rows[0][0].intValue);
+    EXPECT_EQ(1, rows[0][1].intValue);
+}
+
+TEST_F(ParquetReaderTest, MissingColumnThrows) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("id", PARQUET_INT64));
+
+    TestParquetFile builder(columns);
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(1, 2)));
+    setFile(builder.finish());
+
+    const char* tableColumns[] = {"id", "price"};
+    setColumns(vector<string>(tableColumns, tableColumns + 2));
+    EXPECT_THROW(openFile(), S3RuntimeError);
+
+    // not projected, so not needed in the file
+    spec.projected[1] = false;
+    openFile();
+
+    vector<TestRow> rows = readRows();
+    ASSERT_EQ(2u, rows.size());
+    EXPECT_EQ(PARQUET_VALUE_NULL, rows[0][1].tag);
+}
+
+TEST_F(ParquetReaderTest, NotParquetThrows) {
+    setFile(string(100, 'x'));
+    setColumns(vector<string>(1, "id"));
+    EXPECT_THROW(openFile(), S3RuntimeError);
+
+    setFile("PAR1");
+    EXPECT_THROW(openFile(), S3RuntimeError);
+}
+
+TEST_F(ParquetReaderTest, FetchesOnlyProjectedColumns) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("big", PARQUET_INT64));
+    columns.push_back(TestColumn("small1", PARQUET_INT64));
+    columns.push_back(TestColumn("small2", PARQUET_INT64));
+
+    // the big column doesn't fit in the footer prefetch
+    const int64_t numRows = 10000;
+    TestParquetFile builder(columns);
+    vector<TestChunk> chunks;
+    chunks.push_back(Int64Chunk(0, numRows));
+    chunks.push_back(Int64Chunk(0, numRows));
+    chunks.push_back(Int64Chunk(0, numRows));
+    vector<uint64_t> starts = builder.addRowGroup(chunks);
+    string data = builder.finish();
+    setFile(data);
+
+    const char* tableColumns[] = {"big", "small1", "small2"};
+    setColumns(vector<string>(tableColumns, tableColumns + 3));
+    spec.projected[0] = false;
+    spec.projected[1] = false;
+    openFile();
+
+    ASSERT_EQ(1u, fetches.size());
+    EXPECT_EQ(data.size() - S3_PARQUET_FOOTER_PREFETCH_SIZE, fetches[0].first);
+
+    vector<TestRow> rows = readRows();
+    ASSERT_EQ((size_t)numRows, rows.size());
+    EXPECT_EQ(numRows - 1, rows.back()[2].intValue);
+
+    // one GET for the third column only
+    ASSERT_EQ(2u, fetches.size());
+    EXPECT_EQ(starts[2], fetches[1].first);
+    EXPECT_EQ(this->getMetadata().rowGroups[0].columns[2].totalCompressedSize,
+              (int64_t)fetches[1].second);
+
+    // adjacent column chunks are fetched together
+    fetches.clear();
+    spec.projected[1] = true;
+    openFile();
+    readRows();
+
+    ASSERT_EQ(2u, fetches.size());
+    EXPECT_EQ(starts[1], fetches[1].first);
+}
+
+TEST_F(ParquetReaderTest, NoProjectedColumnsReadsOnlyFooter) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("id", PARQUET_INT64));
+
+    TestParquetFile builder(columns);
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(0, 5)));
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(5, 7)));
+    setFile(builder.finish());
+
+    setColumns(vector<string>(1, "id"));
+    spec.projected[0] = false;
+    openFile();
+
+    EXPECT_EQ(12u, readRows().size());
+    EXPECT_EQ(1u, fetches.size());
+}
+
+TEST_F(ParquetReaderTest, SkipsRowGroupsByStatistics) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("id", PARQUET_INT64));
+
+    TestParquetFile builder(columns);
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(0, 10)));
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(10, 10)));
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(20, 10)));
+    setFile(builder.finish());
+
+    setColumns(vector<string>(1, "id"));
+
+    ParquetPredicate predicate;
+    predicate.column = 0;
+    predicate.op = PARQUET_OP_GE;
+    predicate.kind = ParquetPredicate::INT;
+    predicate.intValue = 15;
+    spec.predicates.push_back(predicate);
+
+    predicate.op = PARQUET_OP_LT;
+    predicate.kind = ParquetPredicate::DOUBLE;
+    predicate.doubleValue = 20;
+    spec.predicates.push_back(predicate);
+    openFile();
+
+    // the whole row group is read, the rows are filtered by the executor
+    vector<TestRow> rows = readRows();
+    ASSERT_EQ(10u, rows.size());
+    EXPECT_EQ(10, rows[0][0].intValue);
+    EXPECT_EQ(2u, fetches.size());
+
+    // nothing matches
+    spec.predicates.clear();
+    predicate.op = PARQUET_OP_EQ;
+    predicate.kind = ParquetPredicate::INT;
+    predicate.intValue = 100;
+    spec.predicates.push_back(predicate);
+    fetches.clear();
+    openFile();
+
+    EXPECT_EQ(0u, readRows().size());
+    EXPECT_EQ(1u, fetches.size());
+}
+
+TEST_F(ParquetReaderTest, SkipsRowGroupsByStringStatistics) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("name", PARQUET_BYTE_ARRAY, PARQUET_CONVERTED_UTF8));
+
+    const char* names[] = {"apple", "banana"};
+    bool defined[] = {true, true};
+
+    TestParquetFile builder(columns);
+    TestChunk chunk =
+        StringChunk(vector<string>(names, names + 2), vector<bool>(defined, defined + 2));
+    chunk.hasMinMax = true;
+    chunk.minValue = "apple";
+    chunk.maxValue = "banana";
+    builder.addRowGroup(vector<TestChunk>(1, chunk));
+    setFile(builder.finish());
+
+    setColumns(vector<string>(1, "name"));
+
+    ParquetPredicate predicate;
+    predicate.column = 0;
+    predicate.op = PARQUET_OP_EQ;
+    predicate.kind = ParquetPredicate::STRING;
+    predicate.stringValue = "cherry";
+    spec.predicates.push_back(predicate);
+    openFile();
+    EXPECT_EQ(0u, readRows().size());
+
+    spec.predicates[0].stringValue = "bad";
+    openFile();
+    EXPECT_EQ(2u, readRows().size());
+}
+
+TEST_F(ParquetReaderTest, SkipsAllNullRowGroups) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("name", PARQUET_BYTE_ARRAY, PARQUET_CONVERTED_UTF8, true));
+
+    TestParquetFile builder(columns);
+    builder.addRowGroup(
+        vector<TestChunk>(1, StringChunk(vector<string>(3, ""), vector<bool>(3, false))));
+    setFile(builder.finish());
+
+    setColumns(vector<string>(1, "name"));
+    openFile();
+    EXPECT_EQ(3u, readRows().size());
+
+    ParquetPredicate predicate;
+    predicate.column = 0;
+    predicate.op = PARQUET_OP_GT;
+    predicate.kind = ParquetPredicate::STRING;
+    spec.predicates.push_back(predicate);
+    openFile();
+    EXPECT_EQ(0u, readRows().size());
+}
+
+TEST_F(ParquetReaderTest, ReadsRowGroupsOfKeyRange) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("id", PARQUET_INT64));
+
+    TestParquetFile builder(columns);
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(0, 10)));
+    uint64_t second = builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(10, 10)))[0];
+    string data = builder.finish();
+    setFile(data);
+
+    setColumns(vector<string>(1, "id"));
+
+    openFile(0, second);
+    vector<TestRow> rows = readRows();
+    ASSERT_EQ(10u, rows.size());
+    EXPECT_EQ(0, rows[0][0].intValue);
+
+    openFile(second, data.size() - second);
+    rows = readRows();
+    ASSERT_EQ(10u, rows.size());
+    EXPECT_EQ(10, rows[0][0].intValue);
+}
+
+TEST_F(ParquetReaderTest, ReadsDictionaryEncodedGzipPages) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("city", PARQUET_BYTE_ARRAY, PARQUET_CONVERTED_UTF8, true));
+
+    vector<string> cities;
+    vector<bool> defined;
+    for (int i = 0; i < 100; i++) {
+        cities.push_back((i % 3 == 0) ? "Palo Alto" : "Beijing");
+        defined.push_back(i % 10 != 9);
+    }
+
+    TestParquetFile builder(columns, PARQUET_CODEC_GZIP);
+    TestChunk chunk = StringChunk(cities, defined);
+    chunk.dictionary = true;
+    builder.addRowGroup(vector<TestChunk>(1, chunk));
+    setFile(builder.finish());
+
+    setColumns(vector<string>(1, "city"));
+    openFile();
+
+    vector<TestRow> rows = readRows();
+    ASSERT_EQ(100u, rows.size());
+    for (int i = 0; i < 100; i++) {
+        if (defined[i]) {
+            EXPECT_EQ(cities[i], rows[i][0].bytesValue);
+        } else {
+            EXPECT_EQ(PARQUET_VALUE_NULL, rows[i][0].tag);
+        }
+    }
+}
+
+TEST_F(ParquetReaderTest, RejectsSnappyPages) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("id", PARQUET_INT64));
+
+    // the pages are left uncompressed, they must be rejected before being looked at
+    TestParquetFile builder(columns, PARQUET_CODEC_SNAPPY);
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(0, 10)));
+    setFile(builder.finish());
+
+    setColumns(vector<string>(1, "id"));
+    openFile();
+
+    EXPECT_THROW(readRows(), S3RuntimeError);
+}
+
+TEST_F(ParquetReaderTest, ReadsGzipPages) {
+    vector<TestColumn> columns;
+    columns.push_back(TestColumn("id", PARQUET_INT64));
+
+    TestParquetFile builder(columns, PARQUET_CODEC_GZIP);
+    builder.addRowGroup(vector<TestChunk>(1, Int64Chunk(0, 1000)));
+    setFile(builder.finish());
+
+    setColumns(vector<string>(1, "id"));
+    openFile();
+
+    vector<TestRow> rows = readRows();
+    ASSERT_EQ(1000u, rows.size());
+    EXPECT_EQ(999, rows[999][0].intValue);
+}
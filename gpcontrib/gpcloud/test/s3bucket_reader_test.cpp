@@ -285,3 +285,269 @@ TEST_F(S3BucketReaderTest, ReadBucketFileWithHeaderAndFuzyMatch) {
     eolString[0] = '\n';
     eolString[1] = '\0';
 }
+
+TEST_F(S3BucketReaderTest, ScheduleKeysBySize) {
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 100);
+    result.contents.emplace_back("bar", 60);
+    result.contents.emplace_back("baz", 50);
+    result.contents.emplace_back("qux", 30);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(2).WillRepeatedly(Return(result));
+
+    s3ext_segnum = 2;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+
+    s3ext_segid = 0;
+    bucketReader->open(params);
+    const vector<KeyPiece>& pieces = bucketReader->getKeyPieces();
+    ASSERT_EQ((uint64_t)2, pieces.size());
+    EXPECT_EQ((uint64_t)0, pieces[0].keyIndex);
+    EXPECT_EQ((uint64_t)3, pieces[1].keyIndex);
+
+    s3ext_segid = 1;
+    bucketReader->open(params);
+    ASSERT_EQ((uint64_t)2, pieces.size());
+    EXPECT_EQ((uint64_t)1, pieces[0].keyIndex);
+    EXPECT_EQ((uint64_t)2, pieces[1].keyIndex);
+}
+
+TEST_F(S3BucketReaderTest, ScheduleRangesOfLargeKey) {
+    isTextFormat = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 250);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(2).WillRepeatedly(Return(result));
+
+    s3ext_segnum = 2;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(100);
+
+    s3ext_segid = 0;
+    bucketReader->open(params);
+    const vector<KeyPiece>& pieces = bucketReader->getKeyPieces();
+    ASSERT_EQ((uint64_t)2, pieces.size());
+    EXPECT_EQ((uint64_t)0, pieces[0].offset);
+    EXPECT_EQ((uint64_t)84, pieces[0].length);
+    EXPECT_EQ((uint64_t)168, pieces[1].offset);
+    EXPECT_EQ((uint64_t)82, pieces[1].length);
+
+    s3ext_segid = 1;
+    bucketReader->open(params);
+    ASSERT_EQ((uint64_t)1, pieces.size());
+    EXPECT_EQ((uint64_t)84, pieces[0].offset);
+    EXPECT_EQ((uint64_t)84, pieces[0].length);
+
+    isTextFormat = false;
+}
+
+TEST_F(S3BucketReaderTest, NoRangesForCSVOrHeader) {
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 250);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(2).WillRepeatedly(Return(result));
+
+    s3ext_segnum = 2;
+    s3ext_segid = 0;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(100);
+
+    bucketReader->open(params);
+    EXPECT_EQ((uint64_t)1, bucketReader->getKeyPieces().size());
+
+    isTextFormat = true;
+    hasHeader = true;
+    bucketReader->open(params);
+    EXPECT_EQ((uint64_t)1, bucketReader->getKeyPieces().size());
+
+    isTextFormat = false;
+    hasHeader = false;
+}
+
+using ::testing::AllOf;
+using ::testing::Property;
+
+// "abc\n" at 0, "defghij\n" at 4, "klmnopq\n" at 12, split into [0, 10) and [10, 20).
+static const char* rangeKeyData = "abc\ndefghij\nklmnopq\n";
+
+TEST_F(S3BucketReaderTest, ReadFirstRangeThroughItsLastLine) {
+    isTextFormat = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 20);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+
+    EXPECT_CALL(s3Reader, open(Property(&S3Params::getKeyOffset, 0))).Times(1);
+
+    // the first range is read with one more chunk
+    string head(rangeKeyData, 15);
+    EXPECT_CALL(s3Reader, read(_, _))
+        .WillOnce(Invoke(MockRead(head.c_str())))
+        .WillRepeatedly(Return(0));
+
+    s3ext_segnum = 2;
+    s3ext_segid = 0;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(10);
+    params.setChunkSize(5);
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)12, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, strncmp(buf, "abc\ndefghij\n", 12));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    isTextFormat = false;
+}
+
+TEST_F(S3BucketReaderTest, ReadFirstRangeWithLineLongerThanChunk) {
+    isTextFormat = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 20);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+
+    EXPECT_CALL(s3Reader, open(Property(&S3Params::getKeyOffset, 0))).Times(1);
+    EXPECT_CALL(s3Reader, open(Property(&S3Params::getKeyOffset, 11))).Times(1);
+
+    string head(rangeKeyData, 11);
+    string tail(rangeKeyData + 11);
+    EXPECT_CALL(s3Reader, read(_, _))
+        .WillOnce(Invoke(MockRead(head.c_str())))
+        .WillOnce(Return(0))
+        .WillOnce(Invoke(MockRead(tail.c_str())))
+        .WillRepeatedly(Return(0));
+
+    s3ext_segnum = 2;
+    s3ext_segid = 0;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(10);
+    params.setChunkSize(1);
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)11, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, strncmp(buf, "abc\ndefghij", 11));
+    EXPECT_EQ((uint64_t)1, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ('\n', buf[0]);
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    isTextFormat = false;
+}
+
+TEST_F(S3BucketReaderTest, ReadSecondRangeSkipsPartialLine) {
+    isTextFormat = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 20);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+
+    // backs up by one char to see whether the range starts right after a newline
+    EXPECT_CALL(s3Reader, open(Property(&S3Params::getKeyOffset, 9))).Times(1);
+    EXPECT_CALL(s3Reader, read(_, _))
+        .WillOnce(Invoke(MockRead(rangeKeyData + 9)))
+        .WillRepeatedly(Return(0));
+
+    s3ext_segnum = 2;
+    s3ext_segid = 1;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(10);
+    params.setChunkSize(5);
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)8, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, strncmp(buf, "klmnopq\n", 8));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    isTextFormat = false;
+}
+
+TEST_F(S3BucketReaderTest, ReadRangeStartingRightAfterCRLF) {
+    isTextFormat = true;
+    eolString[0] = '\r';
+    eolString[1] = '\n';
+    eolString[2] = '\0';
+
+    // "abcdefgh\r\n" ends right before the second range [10, 19)
+    const char* data = "abcdefgh\r\nijklmno\r\n";
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 19);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_PLAIN));
+
+    EXPECT_CALL(s3Reader, open(Property(&S3Params::getKeyOffset, 8))).Times(1);
+    EXPECT_CALL(s3Reader, read(_, _))
+        .WillOnce(Invoke(MockRead(data + 8)))
+        .WillRepeatedly(Return(0));
+
+    s3ext_segnum = 2;
+    s3ext_segid = 1;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(10);
+    params.setChunkSize(5);
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)9, bucketReader->read(buf, sizeof(buf)));
+    EXPECT_EQ(0, strncmp(buf, "ijklmno\r\n", 9));
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    isTextFormat = false;
+}
+
+TEST_F(S3BucketReaderTest, SkipRangeOfCompressedKey) {
+    isTextFormat = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 20);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).WillOnce(Return(S3_COMPRESSION_GZIP));
+    EXPECT_CALL(s3Reader, open(_)).Times(0);
+
+    s3ext_segnum = 2;
+    s3ext_segid = 1;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(10);
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    isTextFormat = false;
+}
+
+TEST_F(S3BucketReaderTest, ParquetRangeIsPassedToUpstreamReader) {
+    isParquetFormat = true;
+
+    ListBucketResult result;
+    result.contents.emplace_back("foo", 20);
+
+    EXPECT_CALL(s3Interface, listBucket(_)).Times(1).WillOnce(Return(result));
+    EXPECT_CALL(s3Interface, checkCompressionType(_)).Times(0);
+    EXPECT_CALL(s3Reader, open(AllOf(Property(&S3Params::getKeyOffset, 10),
+                                     Property(&S3Params::getKeyLength, 10))))
+        .Times(1);
+    EXPECT_CALL(s3Reader, read(_, _)).WillOnce(Return(0));
+
+    s3ext_segnum = 2;
+    s3ext_segid = 1;
+    S3Params params("https://s3-us-east-2.amazonaws.com/s3test.pivotal.io/whatever");
+    params.setSplitSize(10);
+    bucketReader->open(params);
+    bucketReader->setUpstreamReader(&s3Reader);
+
+    EXPECT_EQ((uint64_t)0, bucketReader->read(buf, sizeof(buf)));
+
+    isParquetFormat = false;
+}
@@ -19,6 +19,7 @@ TEST(Config, Basic) {
 
     EXPECT_EQ((uint64_t)6, params.getNumOfChunks());
     EXPECT_EQ((uint64_t)(64 * 1024 * 1024 + 1), params.getChunkSize());
+    EXPECT_EQ((uint64_t)(1024 * 1024 * 1024), params.getSplitSize());
 
     EXPECT_EQ(EXT_INFO, s3ext_loglevel);
     EXPECT_EQ(STDERR_LOG, s3ext_logtype);
@@ -34,7 +35,12 @@ TEST(Config, Basic) {
     EXPECT_EQ("", params.getProxy());
 
     EXPECT_TRUE(params.isAutoCompress());
+    EXPECT_EQ(S3_COMPRESSION_GZIP, params.getCompressionType());
     EXPECT_TRUE(params.isVerifyCert());
+    EXPECT_TRUE(params.isReuseConnection());
+    EXPECT_FALSE(params.isUseHttp2());
+    EXPECT_TRUE(params.isAutoTune());
+    EXPECT_EQ((uint64_t)16, params.getConnectionsPerEndpoint());
 
     EXPECT_EQ(SSE_S3, params.getSSEType());
 
@@ -59,6 +65,7 @@ TEST(Config, SpecialSectionLowValues) {
 
     EXPECT_EQ((uint64_t)1, params.getNumOfChunks());
     EXPECT_EQ((uint64_t)(8 * 1024 * 1024), params.getChunkSize());
+    EXPECT_EQ((uint64_t)(8 * 1024 * 1024), params.getSplitSize());
 }
 
 TEST(Config, SpecialSectionWrongKeyName) {
@@ -73,6 +80,10 @@ TEST(Config, SpecialSwitches) {
 
     EXPECT_TRUE(params.isDebugCurl());
     EXPECT_FALSE(params.isAutoCompress());
+    EXPECT_EQ(S3_COMPRESSION_ZSTD, params.getCompressionType());
+    EXPECT_FALSE(params.isReuseConnection());
+    EXPECT_TRUE(params.isUseHttp2());
+    EXPECT_FALSE(params.isAutoTune());
 }
 
 TEST(Config, SectionExist) {
@@ -12,6 +12,10 @@ using ::testing::Throw;
 
 bool hasHeader = false;
 
+bool isTextFormat = false;
+
+bool isParquetFormat = false;
+
 char eolString[EOL_CHARS_MAX_LEN + 1] = "\n";  // LF by default
 
 string s3extErrorMessage;
@@ -417,6 +421,42 @@ TEST_F(S3KeyReaderTest, ReadWithSmallChunkDividedKeySize) {
     EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
 }
 
+TEST_F(S3KeyReaderTest, ReadRangeInTheMiddleOfKey) {
+    S3Params params("s3://abc/def");
+
+    params.setNumOfChunks(1);
+    params.setKeySize(256);
+    params.setChunkSize(64);
+    params.setKeyRange(100, 100);
+
+    EXPECT_CALL(s3Interface, fetchData(100, _, 64, _)).WillOnce(Invoke(MockFetchData(64, 64)));
+    EXPECT_CALL(s3Interface, fetchData(164, _, 36, _)).WillOnce(Invoke(MockFetchData(36, 36)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)64, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)36, this->read(buffer, 64));
+    // no EOL appended, the range ends before the key does
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
+}
+
+TEST_F(S3KeyReaderTest, ReadRangeToTheEndOfKey) {
+    S3Params params("s3://abc/def");
+
+    params.setNumOfChunks(1);
+    params.setKeySize(255);
+    params.setChunkSize(64);
+    params.setKeyRange(200, 0);
+
+    EXPECT_CALL(s3Interface, fetchData(200, _, 55, _)).WillOnce(Invoke(MockFetchData(55, 55)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)55, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)1, this->read(buffer, 64));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 64));
+}
+
 TEST_F(S3KeyReaderTest, ReadWithChunkLargerThanReadBufferAndKeySize) {
     S3Params params("s3://abc/def");
 
@@ -833,6 +873,176 @@ TEST_F(S3KeyReaderTest, MTReadWithHundredsOfThreadsAndSignalCancel) {
     EXPECT_THROW(this->read(buffer, 31), S3QueryAbort);
 }
 
+TEST_F(S3KeyReaderTest, MTReadWithAutoTune) {
+    S3Params params("s3://abc/def");
+
+    params.setNumOfChunks(4);
+    params.setAutoTune(true);
+
+    params.setKeySize(255);
+    params.setChunkSize(32);
+
+    EXPECT_CALL(s3Interface, fetchData(0, _, _, _)).WillOnce(Invoke(MockFetchData(32, 32)));
+    EXPECT_CALL(s3Interface, fetchData(32, _, _, _)).WillOnce(Invoke(MockFetchData(32, 32)));
+    EXPECT_CALL(s3Interface, fetchData(64, _, _, _)).WillOnce(Invoke(MockFetchData(32, 32)));
+    EXPECT_CALL(s3Interface, fetchData(96, _, _, _)).WillOnce(Invoke(MockFetchData(32, 32)));
+    EXPECT_CALL(s3Interface, fetchData(128, _, _, _)).WillOnce(Invoke(MockFetchData(32, 32)));
+    EXPECT_CALL(s3Interface, fetchData(160, _, _, _)).WillOnce(Invoke(MockFetchData(32, 32)));
+    EXPECT_CALL(s3Interface, fetchData(192, _, _, _)).WillOnce(Invoke(MockFetchData(32, 32)));
+    EXPECT_CALL(s3Interface, fetchData(224, _, _, _)).WillOnce(Invoke(MockFetchData(31, 31)));
+
+    this->open(params);
+
+    // chunk sizes under S3_AUTOTUNE_MIN_CHUNKSIZE are kept, the depth starts at 2.
+    EXPECT_EQ((uint64_t)32, this->getTuner().getChunkSize());
+    EXPECT_EQ((uint64_t)2, this->getTuner().getDepth());
+
+    for (int i = 0; i < 7; i++) {
+        EXPECT_EQ((uint64_t)32, this->read(buffer, 32));
+    }
+    EXPECT_EQ((uint64_t)31, this->read(buffer, 32));
+    EXPECT_EQ((uint64_t)1, this->read(buffer, 32));
+    EXPECT_EQ((uint64_t)0, this->read(buffer, 32));
+}
+
+TEST_F(S3KeyReaderTest, CloseReleasesThreadsWaitingForTheirTurn) {
+    S3Params params("s3://abc/def");
+
+    params.setNumOfChunks(8);
+    params.setAutoTune(true);
+
+    params.setKeySize(1024);
+    params.setChunkSize(64);
+
+    // only the chunks within the read-ahead depth are fetched
+    EXPECT_CALL(s3Interface, fetchData(0, _, _, _)).WillOnce(Invoke(MockFetchData(64, 64)));
+    EXPECT_CALL(s3Interface, fetchData(64, _, _, _)).WillOnce(Invoke(MockFetchData(64, 64)));
+
+    this->open(params);
+
+    EXPECT_EQ((uint64_t)32, this->read(buffer, 32));
+}
+
+TEST(ReadAheadTuner, DisabledUsesTheCeilings) {
+    ReadAheadTuner tuner;
+    tuner.configure(64 * 1024 * 1024, 4, false);
+    tuner.restart();
+
+    EXPECT_EQ((uint64_t)(64 * 1024 * 1024), tuner.getChunkSize());
+    EXPECT_EQ((uint64_t)4, tuner.getDepth());
+
+    tuner.chunkFetched(64 * 1024 * 1024, 1);
+    tuner.chunkFetched(64 * 1024 * 1024, 1);
+    tuner.chunkConsumed(true);
+    tuner.chunkConsumed(true);
+
+    EXPECT_EQ((uint64_t)(64 * 1024 * 1024), tuner.getChunkSize());
+    EXPECT_EQ((uint64_t)4, tuner.getDepth());
+}
+
+TEST(ReadAheadTuner, ChunkSizeGrowsWhileThroughputImproves) {
+    const uint64_t MB = 1024 * 1024;
+    ReadAheadTuner tuner;
+    tuner.configure(128 * MB, 4, true);
+
+    EXPECT_EQ(16 * MB, tuner.getChunkSize());
+
+    // 16MB/s
+    tuner.chunkFetched(16 * MB, 1000000);
+    EXPECT_EQ(16 * MB, tuner.getChunkSize());
+    tuner.chunkFetched(16 * MB, 1000000);
+    EXPECT_EQ(32 * MB, tuner.getChunkSize());
+
+    // a chunk of the earlier size is not a sample of this one
+    tuner.chunkFetched(16 * MB, 100);
+
+    // 32MB/s
+    tuner.chunkFetched(32 * MB, 1000000);
+    tuner.chunkFetched(32 * MB, 1000000);
+    EXPECT_EQ(64 * MB, tuner.getChunkSize());
+
+    // 34MB/s, less than 10% better
+    tuner.chunkFetched(64 * MB, 1882353);
+    tuner.chunkFetched(64 * MB, 1882353);
+    EXPECT_EQ(64 * MB, tuner.getChunkSize());
+
+    // settled
+    tuner.chunkFetched(64 * MB, 100);
+    tuner.chunkFetched(64 * MB, 100);
+    EXPECT_EQ(64 * MB, tuner.getChunkSize());
+
+    // the same ceilings keep what was learned
+    tuner.configure(128 * MB, 4, true);
+    EXPECT_EQ(64 * MB, tuner.getChunkSize());
+}
+
+TEST(ReadAheadTuner, ChunkSizeGoesBackIfBiggerIsSlower) {
+    const uint64_t MB = 1024 * 1024;
+    ReadAheadTuner tuner;
+    tuner.configure(64 * MB, 4, true);
+
+    EXPECT_EQ(8 * MB, tuner.getChunkSize());
+
+    tuner.chunkFetched(8 * MB, 1000000);
+    tuner.chunkFetched(8 * MB, 1000000);
+    EXPECT_EQ(16 * MB, tuner.getChunkSize());
+
+    tuner.chunkFetched(16 * MB, 4000000);
+    tuner.chunkFetched(16 * MB, 4000000);
+    EXPECT_EQ(8 * MB, tuner.getChunkSize());
+}
+
+TEST(ReadAheadTuner, DepthFollowsConsumerStalls) {
+    ReadAheadTuner tuner;
+    tuner.configure(64 * 1024 * 1024, 4, true);
+    tuner.restart();
+
+    EXPECT_EQ((uint64_t)2, tuner.getDepth());
+
+    // the first chunk of a key doesn't count
+    tuner.chunkConsumed(true);
+    EXPECT_EQ((uint64_t)2, tuner.getDepth());
+
+    tuner.chunkConsumed(true);
+    tuner.chunkConsumed(true);
+    tuner.chunkConsumed(true);
+    EXPECT_EQ((uint64_t)4, tuner.getDepth());
+
+    for (int i = 0; i < S3_AUTOTUNE_READY_STREAK; i++) {
+        tuner.chunkConsumed(false);
+    }
+    EXPECT_EQ((uint64_t)3, tuner.getDepth());
+
+    for (int i = 0; i < 4 * S3_AUTOTUNE_READY_STREAK; i++) {
+        tuner.chunkConsumed(false);
+    }
+    EXPECT_EQ((uint64_t)2, tuner.getDepth());
+}
+
+static void *ConsumeChunk(void *data) {
+    usleep(10000);
+    static_cast<ReadAheadTuner *>(data)->chunkConsumed(false);
+    return NULL;
+}
+
+TEST(ReadAheadTuner, WaitForTurn) {
+    ReadAheadTuner tuner;
+    tuner.configure(64 * 1024 * 1024, 4, true);
+    tuner.restart();
+
+    // within the depth of 2, doesn't block
+    tuner.waitForTurn(0);
+    tuner.waitForTurn(1);
+
+    pthread_t thread;
+    pthread_create(&thread, NULL, ConsumeChunk, &tuner);
+    tuner.waitForTurn(2);
+    pthread_join(thread, NULL);
+
+    tuner.stop();
+    tuner.waitForTurn(100);
+}
+
 TEST(ChunkBuffer, ChunkBufferOperatorEqual) {
     S3Url s3Url("s3://whatever");
     S3KeyReader reader;
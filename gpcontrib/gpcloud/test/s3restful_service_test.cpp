@@ -1,4 +1,8 @@
 #include "s3restful_service.cpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
 #include "gtest/gtest.h"
 
 TEST(S3RESTfulService, GetWithWrongHeader) {
@@ -338,3 +342,177 @@ TEST(S3RESTfulService, GetWithWrongProxyUrl) {
 
     EXPECT_THROW(service.get(url, headers), S3ResolveError);
 }
+
+// In-process HTTP/1.1 server on a loopback port. It answers every request on a kept-alive
+// connection and counts the connections it accepts.
+class LocalHTTPServer {
+   public:
+    LocalHTTPServer() : connections(0), stopped(false) {
+        listenFd = socket(AF_INET, SOCK_STREAM, 0);
+
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+        bind(listenFd, (struct sockaddr *)&addr, sizeof(addr));
+        listen(listenFd, 16);
+
+        socklen_t len = sizeof(addr);
+        getsockname(listenFd, (struct sockaddr *)&addr, &len);
+
+        std::stringstream ss;
+        ss << "http://127.0.0.1:" << ntohs(addr.sin_port) << "/bucket/key";
+        url = ss.str();
+
+        pthread_create(&thread, NULL, LocalHTTPServer::serve, this);
+    }
+
+    ~LocalHTTPServer() {
+        stopped = true;
+        pthread_join(thread, NULL);
+        ::close(listenFd);
+    }
+
+    const string &getUrl() const {
+        return url;
+    }
+
+    int getConnections() const {
+        return connections;
+    }
+
+   private:
+    static void *serve(void *arg) {
+        LocalHTTPServer *server = static_cast<LocalHTTPServer *>(arg);
+        map<int, string> requests;
+
+        while (!server->stopped) {
+            vector<struct pollfd> fds(1);
+            fds[0].fd = server->listenFd;
+            fds[0].events = POLLIN;
+            for (map<int, string>::iterator it = requests.begin(); it != requests.end(); it++) {
+                struct pollfd client = {it->first, POLLIN, 0};
+                fds.push_back(client);
+            }
+
+            if (poll(fds.data(), fds.size(), 50) <= 0) {
+                continue;
+            }
+
+            if (fds[0].revents & POLLIN) {
+                requests[accept(server->listenFd, NULL, NULL)] = "";
+                server->connections++;
+            }
+
+            for (uint64_t i = 1; i < fds.size(); i++) {
+                if (!(fds[i].revents & (POLLIN | POLLHUP))) {
+                    continue;
+                }
+
+                char buf[4096];
+                ssize_t len = recv(fds[i].fd, buf, sizeof(buf), 0);
+                if (len <= 0) {
+                    ::close(fds[i].fd);
+                    requests.erase(fds[i].fd);
+                    continue;
+                }
+
+                string &request = requests[fds[i].fd];
+                request.append(buf, len);
+
+                size_t end;
+                while ((end = request.find("\r\n\r\n")) != string::npos) {
+                    request.erase(0, end + 4);
+
+                    const char *response =
+                        "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\n"
+                        "Content-Length: 4\r\n\r\nPong";
+                    send(fds[i].fd, response, strlen(response), 0);
+                }
+            }
+        }
+
+        for (map<int, string>::iterator it = requests.begin(); it != requests.end(); it++) {
+            ::close(it->first);
+        }
+        return NULL;
+    }
+
+    int listenFd;
+    string url;
+    pthread_t thread;
+    volatile int connections;
+    volatile bool stopped;
+};
+
+TEST(S3RESTfulService, ReuseConnectionToLocalServer) {
+    LocalHTTPServer server;
+
+    S3Params params;
+    params.setReuseConnection(true);
+    params.setConnectionsPerEndpoint(4);
+    S3RESTfulService service(params);
+
+    for (int i = 0; i < 5; i++) {
+        HTTPHeaders headers;
+        Response resp = service.get(server.getUrl(), headers);
+        EXPECT_EQ(RESPONSE_OK, resp.getStatus());
+    }
+
+    EXPECT_EQ(1, server.getConnections());
+    EXPECT_EQ((uint64_t)1, CURLHandlePool::getInstance().getIdleHandles(server.getUrl()));
+
+    CURLHandlePool::getInstance().clear();
+    CURLHandlePool::getInstance().setMaxHandlesPerEndpoint(0);
+}
+
+TEST(S3RESTfulService, NoConnectionReuseToLocalServer) {
+    LocalHTTPServer server;
+
+    S3Params params;
+    params.setReuseConnection(false);
+    S3RESTfulService service(params);
+
+    for (int i = 0; i < 3; i++) {
+        HTTPHeaders headers;
+        Response resp = service.get(server.getUrl(), headers);
+        EXPECT_EQ(RESPONSE_OK, resp.getStatus());
+    }
+
+    EXPECT_EQ(3, server.getConnections());
+    EXPECT_EQ((uint64_t)0, CURLHandlePool::getInstance().getIdleHandles(server.getUrl()));
+}
+
+static void *AcquireHandle(void *arg) {
+    CURL *curl = CURLHandlePool::getInstance().acquire("http://127.0.0.1:1/a");
+    CURLHandlePool::getInstance().release("http://127.0.0.1:1/a", curl);
+    *static_cast<volatile bool *>(arg) = true;
+    return NULL;
+}
+
+TEST(CURLHandlePool, WaitForHandleOfSameEndpoint) {
+    CURLHandlePool &pool = CURLHandlePool::getInstance();
+    pool.setMaxHandlesPerEndpoint(1);
+
+    CURL *curl = pool.acquire("http://127.0.0.1:1/b");
+
+    // other endpoints don't count
+    CURL *other = pool.acquire("http://127.0.0.1:2/b");
+    pool.release("http://127.0.0.1:2/b", other);
+
+    volatile bool acquired = false;
+    pthread_t thread;
+    pthread_create(&thread, NULL, AcquireHandle, (void *)&acquired);
+
+    usleep(100 * 1000);
+    EXPECT_FALSE(acquired);
+
+    pool.release("http://127.0.0.1:1/b", curl);
+    pthread_join(thread, NULL);
+    EXPECT_TRUE(acquired);
+    EXPECT_EQ((uint64_t)1, pool.getIdleHandles("http://127.0.0.1:1/c"));
+
+    pool.clear();
+    pool.setMaxHandlesPerEndpoint(0);
+}
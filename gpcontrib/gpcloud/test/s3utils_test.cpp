@@ -262,3 +262,9 @@ TEST(Common, TruncateOptions) {
                                      "blah= accessid=\".\\!@#$%^&*()DFGHJK\" "
                                      "chunksize=3456789 testKey=testValue")));
 }
+
+TEST(Common, GetMonotonicUsecs) {
+    uint64_t start = GetMonotonicUsecs();
+    usleep(1000);
+    EXPECT_LE(start + 1000, GetMonotonicUsecs());
+}
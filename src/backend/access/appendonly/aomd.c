@@ -240,6 +240,13 @@ mdunlink_ao(const char *path, ForkNumber forkNumber)
 
     ao_foreach_extent_file(mdunlink_ao_perFile, &unlinkFiles);
 
+	/* and the samples kept by ANALYZE, if any */
+	strcpy(segPathSuffixPosition, AOSAMPLE_SUFFIX);
+	if (unlink(segPath) != 0 && errno != ENOENT)
+		ereport(WARNING,
+				(errcode_for_file_access(),
+				 errmsg("could not remove file \"%s\": %m", segPath)));
+
 	pfree(segPath);
 }
 
@@ -71,6 +71,28 @@ typedef struct AppendOnlyVisiMapDeleteData
 
 
 
+/*
+ * Entry of a visimap's cache of loaded visimap entries.
+ */
+typedef struct AppendOnlyVisimapCacheEntry
+{
+	/*
+	 * Key of the visimap entry
+	 */
+	AppendOnlyVisiMapDeleteKey key;
+
+	/*
+	 * Uncompressed bitmap of the hidden rows. NULL if all rows are visible.
+	 */
+	Bitmapset  *bitmap;
+
+	/*
+	 * Tuple id of the visimap entry. Invalid if the entry does not exist in
+	 * the visimap relation.
+	 */
+	ItemPointerData tupleTid;
+} AppendOnlyVisimapCacheEntry;
+
 static void AppendOnlyVisimap_Store(
 						AppendOnlyVisimap *visiMap);
 
@@ -78,6 +100,9 @@ static void AppendOnlyVisimap_Find(
 					   AppendOnlyVisimap *visiMap,
 					   AOTupleId *tupleId);
 
+static uint32 hash_delete_key(const void *key, Size keysize);
+static int hash_compare_keys(const void *key1, const void *key2, Size keysize);
+
 /*
  * Finishes the visimap operations.
  * No other function should be called with the given
@@ -96,8 +121,10 @@ AppendOnlyVisimap_Finish(
 	AppendOnlyVisimapStore_Finish(&visiMap->visimapStore, lockmode);
 	AppendOnlyVisimapEntry_Finish(&visiMap->visimapEntry);
 
+	/* the entry cache is allocated in the memory context */
 	MemoryContextDelete(visiMap->memoryContext);
 	visiMap->memoryContext = NULL;
+	visiMap->entryCache = NULL;
 }
 
 /*
@@ -140,7 +167,129 @@ AppendOnlyVisimap_Init(
 								appendOnlyMetaDataSnapshot,
 								visiMap->memoryContext);
 
+	visiMap->entryCache = NULL;
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * Makes the cached copy of the visimap entry with the given key, if there
+ * is one, the current entry.
+ *
+ * Returns false if the entry is not cached.
+ */
+static bool
+AppendOnlyVisimap_FindCached(
+							 AppendOnlyVisimap *visiMap,
+							 AppendOnlyVisiMapDeleteKey *key)
+{
+	AppendOnlyVisimapCacheEntry *cached;
+	AppendOnlyVisimapEntry *visimapEntry = &visiMap->visimapEntry;
+	MemoryContext oldContext;
+
+	if (visiMap->entryCache == NULL)
+		return false;
+
+	cached = hash_search(visiMap->entryCache, key, HASH_FIND, NULL);
+	if (cached == NULL)
+		return false;
+
+	elogif(Debug_appendonly_print_visimap, LOG,
+		   "Append-only visi map: Found cached entry "
+		   INT64_FORMAT "/" INT64_FORMAT,
+		   key->segno, key->firstRowNum);
+
+	Assert(!visimapEntry->dirty);
+
+	/* copy, as hiding tuples modifies the bitmap in place */
+	oldContext = MemoryContextSwitchTo(visimapEntry->memoryContext);
+	bms_free(visimapEntry->bitmap);
+	visimapEntry->bitmap = bms_copy(cached->bitmap);
+	MemoryContextSwitchTo(oldContext);
+
+	visimapEntry->segmentFileNum = (int32) key->segno;
+	visimapEntry->firstRowNum = (int64) key->firstRowNum;
+	memcpy(&visimapEntry->tupleTid, &cached->tupleTid, sizeof(ItemPointerData));
+
+	return true;
+}
+
+/*
+ * Adds the current visimap entry, just loaded from the visimap relation, to
+ * the entry cache.
+ *
+ * Entries are only cached for MVCC snapshots, under which the loaded
+ * version of an entry stays the visible one.  Once the cache is full, no
+ * more entries are added.
+ */
+static void
+AppendOnlyVisimap_CacheEntry(
+							 AppendOnlyVisimap *visiMap)
+{
+	AppendOnlyVisimapCacheEntry *cached;
+	AppendOnlyVisimapEntry *visimapEntry = &visiMap->visimapEntry;
+	AppendOnlyVisiMapDeleteKey key;
+	MemoryContext oldContext;
+	bool		found;
+
+	Assert(AppendOnlyVisimapEntry_IsValid(visimapEntry));
+	Assert(!visimapEntry->dirty);
+
+	if (!IsMVCCSnapshot(visiMap->visimapStore.snapshot))
+		return;
+
+	if (visiMap->entryCache == NULL)
+	{
+		HASHCTL		hash_ctl;
+
+		MemSet(&hash_ctl, 0, sizeof(hash_ctl));
+		hash_ctl.keysize = sizeof(AppendOnlyVisiMapDeleteKey);
+		hash_ctl.entrysize = sizeof(AppendOnlyVisimapCacheEntry);
+		hash_ctl.hash = hash_delete_key;
+		hash_ctl.match = hash_compare_keys;
+		hash_ctl.hcxt = visiMap->memoryContext;
+		visiMap->entryCache = hash_create("VisimapLoadedEntryCache",
+										  16, /* start small and extend */
+										  &hash_ctl,
+										  HASH_ELEM | HASH_FUNCTION | HASH_COMPARE | HASH_CONTEXT);
+	}
+	else if (hash_get_num_entries(visiMap->entryCache) >= APPENDONLY_VISIMAP_CACHE_SIZE)
+		return;
+
+	key.segno = visimapEntry->segmentFileNum;
+	key.firstRowNum = visimapEntry->firstRowNum;
+
+	cached = hash_search(visiMap->entryCache, &key, HASH_ENTER, &found);
+	if (found)
+		bms_free(cached->bitmap);
+
+	oldContext = MemoryContextSwitchTo(visiMap->memoryContext);
+	cached->bitmap = bms_copy(visimapEntry->bitmap);
 	MemoryContextSwitchTo(oldContext);
+
+	memcpy(&cached->tupleTid, &visimapEntry->tupleTid, sizeof(ItemPointerData));
+}
+
+/*
+ * Drops the cached copy of the current visimap entry, which is about to be
+ * changed in the visimap relation.
+ */
+static void
+AppendOnlyVisimap_UncacheEntry(
+							   AppendOnlyVisimap *visiMap)
+{
+	AppendOnlyVisimapCacheEntry *cached;
+	AppendOnlyVisiMapDeleteKey key;
+
+	if (visiMap->entryCache == NULL)
+		return;
+
+	key.segno = visiMap->visimapEntry.segmentFileNum;
+	key.firstRowNum = visiMap->visimapEntry.firstRowNum;
+
+	cached = hash_search(visiMap->entryCache, &key, HASH_REMOVE, NULL);
+	if (cached)
+		bms_free(cached->bitmap);
 }
 
 /*
@@ -158,6 +307,8 @@ AppendOnlyVisimap_Find(
 					   AppendOnlyVisimap *visiMap,
 					   AOTupleId *aoTupleId)
 {
+	AppendOnlyVisiMapDeleteKey key;
+
 	Assert(visiMap);
 	Assert(aoTupleId);
 
@@ -166,10 +317,16 @@ AppendOnlyVisimap_Find(
 		   "(tupleId) = %s",
 		   AOTupleIdToString(aoTupleId));
 
+	key.segno = AOTupleIdGet_segmentFileNum(aoTupleId);
+	key.firstRowNum = AppendOnlyVisimapEntry_GetFirstRowNum(
+															&visiMap->visimapEntry, aoTupleId);
+
+	if (AppendOnlyVisimap_FindCached(visiMap, &key))
+		return;
+
 	if (!AppendOnlyVisimapStore_Find(&visiMap->visimapStore,
-									 AOTupleIdGet_segmentFileNum(aoTupleId),
-									 AppendOnlyVisimapEntry_GetFirstRowNum(
-																		   &visiMap->visimapEntry, aoTupleId),
+									 (int32) key.segno,
+									 (int64) key.firstRowNum,
 									 &visiMap->visimapEntry))
 	{
 		/*
@@ -177,6 +334,8 @@ AppendOnlyVisimap_Find(
 		 */
 		AppendOnlyVisimapEntry_New(&visiMap->visimapEntry, aoTupleId);
 	}
+
+	AppendOnlyVisimap_CacheEntry(visiMap);
 }
 
 /*
@@ -215,6 +374,67 @@ AppendOnlyVisimap_IsVisible(
 											aoTupleId);
 }
 
+/*
+ * Finds the rows that the visibility map hides among the nrows rows of
+ * segment file segno starting at firstRowNum, so that a whole block can be
+ * checked at once instead of calling AppendOnlyVisimap_IsVisible() for
+ * every row.  hidden[i] is set to whether row firstRowNum + i is hidden,
+ * and the number of hidden rows is returned.
+ *
+ * Assumes that the visibility has been initialized and not finished.
+ */
+int
+AppendOnlyVisimap_GetHiddenRange(
+								 AppendOnlyVisimap *visiMap,
+								 int segno,
+								 int64 firstRowNum,
+								 int nrows,
+								 bool *hidden)
+{
+	int64		rowNum = firstRowNum;
+	int64		endRowNum = firstRowNum + nrows;
+	int			count = 0;
+
+	Assert(visiMap);
+	Assert(nrows >= 0);
+	Assert(hidden);
+
+	memset(hidden, 0, nrows * sizeof(bool));
+
+	while (rowNum < endRowNum)
+	{
+		AOTupleId	aoTupleId;
+		int64		entryEndRowNum;
+		int			n;
+
+		AOTupleIdInit(&aoTupleId, segno, rowNum);
+
+		if (!AppendOnlyVisimapEntry_CoversTuple(&visiMap->visimapEntry,
+												&aoTupleId))
+		{
+			/* if necessary persist the current entry before moving. */
+			if (AppendOnlyVisimapEntry_HasChanged(&visiMap->visimapEntry))
+			{
+				AppendOnlyVisimap_Store(visiMap);
+			}
+
+			AppendOnlyVisimap_Find(visiMap, &aoTupleId);
+		}
+
+		/* the rest of the range may span several visimap entries */
+		entryEndRowNum = visiMap->visimapEntry.firstRowNum +
+			APPENDONLY_VISIMAP_MAX_RANGE;
+		n = (int) (Min(endRowNum, entryEndRowNum) - rowNum);
+
+		count += AppendOnlyVisimapEntry_GetHiddenRange(&visiMap->visimapEntry,
+													   rowNum, n,
+													   hidden + (rowNum - firstRowNum));
+		rowNum += n;
+	}
+
+	return count;
+}
+
 /*
  * Stores the current visibility map entry information
  * in the relation either as update or delete.
@@ -233,6 +453,7 @@ AppendOnlyVisimap_Store(
 	Assert(visiMap);
 	Assert(AppendOnlyVisimapEntry_IsValid(&visiMap->visimapEntry));
 
+	AppendOnlyVisimap_UncacheEntry(visiMap);
 	AppendOnlyVisimapStore_Store(&visiMap->visimapStore, &visiMap->visimapEntry);
 
 }
@@ -252,6 +473,13 @@ AppendOnlyVisimap_DeleteSegmentFile(
 
 	AppendOnlyVisimapStore_DeleteSegmentFile(&visiMap->visimapStore,
 											 segno);
+
+	/* forget all cached entries rather than look for the segment's ones */
+	if (visiMap->entryCache)
+	{
+		hash_destroy(visiMap->entryCache);
+		visiMap->entryCache = NULL;
+	}
 }
 
 /*
@@ -579,17 +807,7 @@ AppendOnlyVisimapDelete_Find(
 	}
 	else
 	{
-		if (!AppendOnlyVisimapStore_Find(&visiMap->visimapStore,
-										 AOTupleIdGet_segmentFileNum(aoTupleId),
-										 AppendOnlyVisimapEntry_GetFirstRowNum(
-																			   &visiMap->visimapEntry, aoTupleId),
-										 &visiMap->visimapEntry))
-		{
-			/*
-			 * There is no entry that covers the given tuple id.
-			 */
-			AppendOnlyVisimapEntry_New(&visiMap->visimapEntry, aoTupleId);
-		}
+		AppendOnlyVisimap_Find(visiMap, aoTupleId);
 	}
 }
 
@@ -613,6 +831,9 @@ AppendOnlyVisimapDelete_Stash(
 	visiMap = visiMapDelete->visiMap;
 	Assert(visiMap);
 
+	/* the stashed version supersedes the cached one */
+	AppendOnlyVisimap_UncacheEntry(visiMap);
+
 	key.segno = visiMap->visimapEntry.segmentFileNum;
 	key.firstRowNum = visiMap->visimapEntry.firstRowNum;
 	found = false;
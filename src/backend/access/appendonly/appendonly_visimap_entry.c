@@ -480,6 +480,54 @@ AppendOnlyVisimapEntry_IsVisible(
 	return visibilityBit;
 }
 
+/*
+ * Sets hidden[i] for each row rowNum + i, for i < nrows, that the bitmap
+ * hides, and returns how many there are.  Entries of rows that are visible
+ * are left alone.
+ *
+ * Should only be called if the current entry covers all of the rows.
+ */
+int
+AppendOnlyVisimapEntry_GetHiddenRange(
+									  AppendOnlyVisimapEntry *visiMapEntry,
+									  int64 rowNum,
+									  int nrows,
+									  bool *hidden)
+{
+	int64		rowNumOffset;
+	int			offset;
+	int			count = 0;
+
+	Assert(visiMapEntry);
+	Assert(AppendOnlyVisimapEntry_IsValid(visiMapEntry));
+	Assert(rowNum >= visiMapEntry->firstRowNum);
+	Assert(rowNum + nrows <=
+		   visiMapEntry->firstRowNum + APPENDONLY_VISIMAP_MAX_RANGE);
+	Assert(hidden);
+
+	if (AppendOnlyVisimapEntry_AreAllVisible(visiMapEntry))
+		return 0;
+
+	rowNumOffset = 0;
+	AppendOnlyVisimapEntry_GetRownumOffset(visiMapEntry,
+										   rowNum, &rowNumOffset);
+
+	offset = bms_next_member(visiMapEntry->bitmap, rowNumOffset - 1);
+	while (offset >= 0 && offset < rowNumOffset + nrows)
+	{
+		hidden[offset - rowNumOffset] = true;
+		count++;
+		offset = bms_next_member(visiMapEntry->bitmap, offset);
+	}
+
+	elogif(Debug_appendonly_print_visimap, LOG,
+		   "Append-only visi map entry: (firstRowNum, rowNum, nrows, hidden) = "
+		   "(" INT64_FORMAT ", " INT64_FORMAT ", %d, %d)",
+		   visiMapEntry->firstRowNum, rowNum, nrows, count);
+
+	return count;
+}
+
 /*
  * The minimal size (in uint32's elements) the entry array needs to have to
  * cover the given offset
@@ -155,7 +155,8 @@ initscan(AppendOnlyScanDesc scan, ScanKey key)
 	scan->aos_segfiles_processed = 0;
 	scan->aos_need_new_segfile = true;	/* need to assign a file to be scanned */
 	scan->aos_done_all_segfiles = false;
-	scan->bufferDone = true;
+	scan->batch.nitems = 0;
+	scan->batch.nextitem = 0;
 
 	if (scan->initedStorageRoutines)
 		AppendOnlyExecutorReadBlock_ResetCounts(
@@ -239,7 +240,9 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 										 &scan->storageRead,
 										 scan->usableBlockSize);
 
-		scan->bufferDone = true;	/* so we read a new buffer right away */
+		/* so we read a new buffer right away */
+		scan->batch.nitems = 0;
+		scan->batch.nextitem = 0;
 
 		scan->initedStorageRoutines = true;
 	}
@@ -1042,122 +1045,6 @@ AppendOnlyExecutorReadBlock_ProcessTuple(AppendOnlyExecutorReadBlock *executorRe
 	return valid;
 }
 
-static bool
-AppendOnlyExecutorReadBlock_ScanNextTuple(AppendOnlyExecutorReadBlock *executorReadBlock,
-										  int nkeys,
-										  ScanKey key,
-										  TupleTableSlot *slot)
-{
-	MemTuple	tuple;
-
-	Assert(slot);
-
-	switch (executorReadBlock->executorBlockKind)
-	{
-		case AoExecutorBlockKind_VarBlock:
-
-			/*
-			 * get the next item (tuple) from the varblock
-			 */
-			while (true)
-			{
-				int			itemLen = 0;
-				uint8	   *itemPtr;
-				int64		rowNum;
-
-				itemPtr = VarBlockReaderGetNextItemPtr(
-													   &executorReadBlock->varBlockReader,
-													   &itemLen);
-
-				if (itemPtr == NULL)
-				{
-					/* no more items in the varblock, get new buffer */
-					AppendOnlyExecutionReadBlock_FinishedScanBlock(
-																   executorReadBlock);
-					return false;
-				}
-
-				executorReadBlock->currentItemCount++;
-
-				executorReadBlock->totalRowsScannned++;
-
-				if (itemLen > 0)
-				{
-					tuple = (MemTuple) itemPtr;
-
-					rowNum = executorReadBlock->blockFirstRowNum +
-						executorReadBlock->currentItemCount - INT64CONST(1);
-
-					if (AppendOnlyExecutorReadBlock_ProcessTuple(
-																 executorReadBlock,
-																 rowNum,
-																 tuple,
-																 itemLen,
-																 nkeys,
-																 key,
-																 slot))
-						return true;
-				}
-
-			}
-
-			/* varblock sanity check */
-			if (executorReadBlock->readerItemCount !=
-				executorReadBlock->currentItemCount)
-				elog(NOTICE, "Varblock mismatch: Reader count %d, found %d items\n",
-					 executorReadBlock->readerItemCount,
-					 executorReadBlock->currentItemCount);
-			break;
-
-		case AoExecutorBlockKind_SingleRow:
-			{
-				int32		singleRowLen;
-
-				if (executorReadBlock->singleRow == NULL)
-				{
-					AppendOnlyExecutionReadBlock_FinishedScanBlock(
-																   executorReadBlock);
-					return false;
-					/* Force fetching new block. */
-				}
-
-				Assert(executorReadBlock->singleRowLen != 0);
-
-				tuple = (MemTuple) executorReadBlock->singleRow;
-				singleRowLen = executorReadBlock->singleRowLen;
-
-				/*
-				 * Indicated used up for scan.
-				 */
-				executorReadBlock->singleRow = NULL;
-				executorReadBlock->singleRowLen = 0;
-
-				executorReadBlock->totalRowsScannned++;
-
-				if (AppendOnlyExecutorReadBlock_ProcessTuple(
-															 executorReadBlock,
-															 executorReadBlock->blockFirstRowNum,
-															 tuple,
-															 singleRowLen,
-															 nkeys,
-															 key,
-															 slot))
-					return true;
-			}
-			break;
-
-		default:
-			elog(ERROR, "Unrecognized append-only executor block kind: %d",
-				 executorReadBlock->executorBlockKind);
-			break;
-	}
-
-	AppendOnlyExecutionReadBlock_FinishedScanBlock(
-												   executorReadBlock);
-	return false;
-	/* No match. */
-}
-
 static bool
 AppendOnlyExecutorReadBlock_FetchTuple(AppendOnlyExecutorReadBlock *executorReadBlock,
 									   int64 rowNum,
@@ -1284,12 +1171,160 @@ getNextBlock(AppendOnlyScanDesc scan)
 	return true;
 }
 
+/*
+ * Collect the visible tuples of the block just read into the scan's batch.
+ *
+ * The visibility map is consulted once for all the rows of the block, and
+ * the items that it hides are skipped without being bound to a slot.
+ */
+static void
+fillScanBatch(AppendOnlyScanDesc scan)
+{
+	AppendOnlyExecutorReadBlock *executorReadBlock = &scan->executorReadBlock;
+	AppendOnlyScanBatch *batch = &scan->batch;
+	int			rowCount = executorReadBlock->rowCount;
+	int			nhidden = 0;
+	int			nitems = 0;
+
+	if (rowCount > batch->maxitems)
+	{
+		MemoryContext oldcontext;
+		int			maxitems = Max(batch->maxitems * 2, rowCount);
+
+		oldcontext = MemoryContextSwitchTo(scan->aoScanInitContext);
+		if (batch->maxitems > 0)
+		{
+			pfree(batch->tuples);
+			pfree(batch->tupleLens);
+			pfree(batch->rowNums);
+			pfree(batch->hidden);
+		}
+		batch->tuples = (MemTuple *) palloc(maxitems * sizeof(MemTuple));
+		batch->tupleLens = (int32 *) palloc(maxitems * sizeof(int32));
+		batch->rowNums = (int64 *) palloc(maxitems * sizeof(int64));
+		batch->hidden = (bool *) palloc(maxitems * sizeof(bool));
+		batch->maxitems = maxitems;
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	if (scan->snapshot != SnapshotAny)
+		nhidden = AppendOnlyVisimap_GetHiddenRange(&scan->visibilityMap,
+												   executorReadBlock->segmentFileNum,
+												   executorReadBlock->blockFirstRowNum,
+												   rowCount,
+												   batch->hidden);
+
+	switch (executorReadBlock->executorBlockKind)
+	{
+		case AoExecutorBlockKind_VarBlock:
+			while (true)
+			{
+				int			itemLen = 0;
+				uint8	   *itemPtr;
+				int			i;
+
+				itemPtr = VarBlockReaderGetNextItemPtr(
+													   &executorReadBlock->varBlockReader,
+													   &itemLen);
+
+				if (itemPtr == NULL)
+					break;
+
+				/*
+				 * The hidden flags and the batch only have room for rowCount
+				 * items, so don't trust the VarBlock beyond that.
+				 */
+				i = executorReadBlock->currentItemCount++;
+				if (i >= rowCount)
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_CORRUPTED),
+							 errmsg("VarBlock has more items than row count %d in append-only storage header",
+									rowCount),
+							 errdetail_appendonly_read_storage_content_header(executorReadBlock->storageRead),
+							 errcontext_appendonly_read_storage_block(executorReadBlock->storageRead)));
+
+				if (itemLen == 0 || (nhidden > 0 && batch->hidden[i]))
+					continue;
+
+				batch->tuples[nitems] = (MemTuple) itemPtr;
+				batch->tupleLens[nitems] = itemLen;
+				batch->rowNums[nitems] = executorReadBlock->blockFirstRowNum + i;
+				nitems++;
+			}
+
+			/* varblock sanity check */
+			if (executorReadBlock->readerItemCount !=
+				executorReadBlock->currentItemCount)
+				elog(NOTICE, "Varblock mismatch: Reader count %d, found %d items\n",
+					 executorReadBlock->readerItemCount,
+					 executorReadBlock->currentItemCount);
+			break;
+
+		case AoExecutorBlockKind_SingleRow:
+			Assert(executorReadBlock->singleRowLen != 0);
+
+			if (nhidden == 0)
+			{
+				batch->tuples[nitems] = (MemTuple) executorReadBlock->singleRow;
+				batch->tupleLens[nitems] = executorReadBlock->singleRowLen;
+				batch->rowNums[nitems] = executorReadBlock->blockFirstRowNum;
+				nitems++;
+			}
+
+			/*
+			 * Indicated used up for scan.
+			 */
+			executorReadBlock->singleRow = NULL;
+			executorReadBlock->singleRowLen = 0;
+			break;
+
+		default:
+			elog(ERROR, "Unrecognized append-only executor block kind: %d",
+				 executorReadBlock->executorBlockKind);
+			break;
+	}
+
+	executorReadBlock->totalRowsScannned += rowCount;
+
+	AppendOnlyExecutionReadBlock_FinishedScanBlock(executorReadBlock);
+
+	batch->nitems = nitems;
+	batch->nextitem = 0;
+}
+
+/*
+ * Read blocks until one with visible tuples is found, and collect them into
+ * the batch.  Returns false when all of the relation's data has been read.
+ */
+static bool
+getNextBatch(AppendOnlyScanDesc scan)
+{
+	do
+	{
+		/*
+		 * Get the next block. We call this function until we successfully
+		 * get a block to process, or finished reading all the data (all
+		 * 'segment' files) for this relation.
+		 */
+		while (!getNextBlock(scan))
+		{
+			/* have we read all this relation's data. done! */
+			if (scan->aos_done_all_segfiles)
+				return false;
+		}
+
+		fillScanBatch(scan);
+	} while (scan->batch.nitems == 0);
+
+	return true;
+}
+
 /* ----------------
  *		appendonlygettup - fetch next appendonly tuple
  *
  *		Initialize the scan if not already done; then advance to the next
- *		tuple in forward direction; return the next tuple in scan->aos_ctup,
- *		or set scan->aos_ctup.t_data = NULL if no more tuples.
+ *		visible tuple in forward direction and store it in the slot.  Returns
+ *		false if there are no more tuples.
  *
  * Note: the reason nkeys/key are passed separately, even though they are
  * kept in the scan descriptor, is that the caller may not want us to check
@@ -1305,59 +1340,30 @@ appendonlygettup(AppendOnlyScanDesc scan,
 {
 	Assert(ScanDirectionIsForward(dir));
 	Assert(scan->usableBlockSize > 0);
+	Assert(slot);
 
-	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
+	AppendOnlyScanBatch *batch = &scan->batch;
 
 	for (;;)
 	{
-		bool		found;
+		int			item;
 
-		if (scan->bufferDone)
+		if (batch->nextitem >= batch->nitems)
 		{
-			/*
-			 * Get the next block. We call this function until we successfully
-			 * get a block to process, or finished reading all the data (all
-			 * 'segment' files) for this relation.
-			 */
-			while (!getNextBlock(scan))
-			{
-				/* have we read all this relation's data. done! */
-				if (scan->aos_done_all_segfiles)
-					return false;
-			}
-
-			scan->bufferDone = false;
+			if (!getNextBatch(scan))
+				return false;
 		}
 
-		found = AppendOnlyExecutorReadBlock_ScanNextTuple(&scan->executorReadBlock,
-														  nkeys,
-														  key,
-														  slot);
-		if (found)
-		{
-
-			/*
-			 * Need to get the Block Directory entry that covers the TID.
-			 */
-			AOTupleId  *aoTupleId = (AOTupleId *) slot_get_ctid(slot);
+		item = batch->nextitem++;
 
-			if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
-			{
-				/*
-				 * The tuple is invisible.
-				 */
-			}
-			else
-			{
-				/* The tuple is visible */
-				return true;
-			}
-		}
-		else
-		{
-			/* no more items in the varblock, get new buffer */
-			scan->bufferDone = true;
-		}
+		if (AppendOnlyExecutorReadBlock_ProcessTuple(&scan->executorReadBlock,
+													 batch->rowNums[item],
+													 batch->tuples[item],
+													 batch->tupleLens[item],
+													 nkeys,
+													 key,
+													 slot))
+			return true;
 	}
 }
 
@@ -1773,6 +1779,15 @@ appendonly_endscan(AppendOnlyScanDesc scan)
 	AppendOnlyExecutorReadBlock_Finish(&scan->executorReadBlock);
 
 	AppendOnlyVisimap_Finish(&scan->visibilityMap, AccessShareLock);
+
+	if (scan->batch.maxitems > 0)
+	{
+		pfree(scan->batch.tuples);
+		pfree(scan->batch.tupleLens);
+		pfree(scan->batch.rowNums);
+		pfree(scan->batch.hidden);
+	}
+
 	pfree(scan->aos_filenamepath);
 
 	pfree(scan->title);
@@ -5,6 +5,7 @@
 
 #include "postgres.h"
 #include "utils/memutils.h"
+#include "access/aomd.h"
 #include "access/appendonlywriter.h"
 #include "catalog/pg_tablespace.h"
 
@@ -14,6 +15,7 @@
 static bool file_present[MAX_SEGNO_FILES];
 static int num_unlink_called = 0;
 static bool unlink_passing = true;
+static bool aosample_present = false;
 
 static void
 setup_test_structures()
@@ -21,6 +23,7 @@ setup_test_structures()
 	num_unlink_called = 0;
 	memset(file_present, false, sizeof(file_present));
 	unlink_passing = true;
+	aosample_present = false;
 }
 
 /*
@@ -37,6 +40,17 @@ mock_unlink(const char *path)
 	int ec = 0;
 	u_int segfile = 0; /* parse the path */
 	const char *tmp_path = path + strlen(PATH_TO_DATA_FILE) + 1;
+
+	if (strcmp(path, PATH_TO_DATA_FILE AOSAMPLE_SUFFIX) == 0)
+	{
+		if (!aosample_present)
+		{
+			errno = ENOENT;
+			return -1;
+		}
+		aosample_present = false;
+		return 0;
+	}
 	if (strcmp(tmp_path, "") != 0)
 	{
 		segfile = atoi(tmp_path);
@@ -267,6 +281,20 @@ test_mdunlink_co_one_columns_full_concurrency(void **state)
 	return;
 }
 
+static void
+test_mdunlink_ao_removes_sample_file(void **state)
+{
+	setup_test_structures();
+
+	file_present[1] = true;
+	aosample_present = true;
+
+	mdunlink_ao(PATH_TO_DATA_FILE, MAIN_FORKNUM);
+	assert_true(num_unlink_called == 1);
+	assert_false(aosample_present);
+	return;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -282,7 +310,8 @@ main(int argc, char *argv[])
 		unit_test(test_mdunlink_co_3_columns_2_concurrency),
 		unit_test(test_mdunlink_co_4_columns_1_concurrency),
 		unit_test(test_mdunlink_does_not_unlink_for_init_fork),
-		unit_test(test_mdunlink_co_no_file_exists)
+		unit_test(test_mdunlink_co_no_file_exists),
+		unit_test(test_mdunlink_ao_removes_sample_file)
 	};
 
 	MemoryContextInit();
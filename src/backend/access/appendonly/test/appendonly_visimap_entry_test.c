@@ -71,6 +71,41 @@ test__AppendOnlyVisimapEntry_CoversTuple(void **state)
 }
 
 
+static void
+test__AppendOnlyVisimapEntry_GetHiddenRange(void **state)
+{
+	int			result;
+	bool		hidden[50];
+	AppendOnlyVisimapEntry *visiMapEntry = palloc0(sizeof(AppendOnlyVisimapEntry));
+
+	visiMapEntry->segmentFileNum = 1;
+	visiMapEntry->firstRowNum = 32768;
+
+	/* Nothing is hidden by an empty bitmap. */
+	memset(hidden, 0, sizeof(hidden));
+	result = AppendOnlyVisimapEntry_GetHiddenRange(visiMapEntry, 32868, 50, hidden);
+	assert_int_equal(result, 0);
+	assert_false(hidden[0]);
+
+	/* Only the rows of the range are reported, at their range offset. */
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 5);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 99);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 100);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 120);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 149);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 150);
+	visiMapEntry->bitmap = bms_add_member(visiMapEntry->bitmap, 3000);
+
+	memset(hidden, 0, sizeof(hidden));
+	result = AppendOnlyVisimapEntry_GetHiddenRange(visiMapEntry, 32868, 50, hidden);
+	assert_int_equal(result, 3);
+	assert_true(hidden[0]);
+	assert_false(hidden[1]);
+	assert_true(hidden[20]);
+	assert_true(hidden[49]);
+}
+
+
 int
 main(int argc, char *argv[])
 {
@@ -78,7 +113,8 @@ main(int argc, char *argv[])
 
 	const		UnitTest tests[] = {
 		unit_test(test__AppendOnlyVisimapEntry_GetFirstRowNum),
-		unit_test(test__AppendOnlyVisimapEntry_CoversTuple)
+		unit_test(test__AppendOnlyVisimapEntry_CoversTuple),
+		unit_test(test__AppendOnlyVisimapEntry_GetHiddenRange)
 	};
 
 	MemoryContextInit();
@@ -22,6 +22,7 @@ test__AppendOnlyVisimapDelete_Finish_outoforder(void **state)
 	visiMap.visimapEntry.segmentFileNum = 2;
 	visiMap.visimapEntry.firstRowNum = 32768;
 	visiMap.visimapEntry.dirty = true;
+	visiMap.entryCache = NULL;
 	key.segno = 2;
 	key.firstRowNum = 32768;
 	/* should be changed by AppendOnlyVisimapDelete_Finish() */
@@ -65,13 +66,102 @@ test__AppendOnlyVisimapDelete_Finish_outoforder(void **state)
 }
 
 
+/*
+ * A visimap entry is looked up in the visimap relation only the first time
+ * it is needed.  Moving back to it uses the cached copy.
+ */
+static void
+test__AppendOnlyVisimap_Find_cached(void **state)
+{
+	AppendOnlyVisimap visiMap;
+	AppendOnlyVisimapCacheEntry cached;
+	SnapshotData snapshot;
+	AOTupleId	tupleId;
+	int			fake_htab;
+
+	memset(&visiMap, 0, sizeof(visiMap));
+	memset(&cached, 0, sizeof(cached));
+	memset(&snapshot, 0, sizeof(snapshot));
+	snapshot.satisfies = HeapTupleSatisfiesMVCC;
+	visiMap.memoryContext = CurrentMemoryContext;
+	visiMap.visimapEntry.memoryContext = CurrentMemoryContext;
+	visiMap.visimapStore.snapshot = &snapshot;
+	AOTupleIdInit(&tupleId, 2, 40000);
+
+	/* what the visimap relation returns for the entry */
+	visiMap.visimapEntry.segmentFileNum = 2;
+	visiMap.visimapEntry.firstRowNum = 32768;
+	visiMap.visimapEntry.bitmap = bms_make_singleton(7);
+
+	expect_value(AppendOnlyVisimapEntry_GetFirstRowNum, visiMapEntry,
+				 &visiMap.visimapEntry);
+	expect_value(AppendOnlyVisimapEntry_GetFirstRowNum, tupleId, &tupleId);
+	will_return(AppendOnlyVisimapEntry_GetFirstRowNum, 32768);
+
+	expect_value(AppendOnlyVisimapStore_Find, visiMapStore,
+				 &visiMap.visimapStore);
+	expect_value(AppendOnlyVisimapStore_Find, segmentFileNum, 2);
+	expect_value(AppendOnlyVisimapStore_Find, firstRowNum, 32768);
+	expect_value(AppendOnlyVisimapStore_Find, visiMapEntry,
+				 &visiMap.visimapEntry);
+	will_return(AppendOnlyVisimapStore_Find, true);
+
+#ifdef USE_ASSERT_CHECKING
+	expect_any(AppendOnlyVisimapEntry_IsValid, visiMapEntry);
+	will_return(AppendOnlyVisimapEntry_IsValid, true);
+#endif
+
+	expect_any(hash_create, tabname);
+	expect_any(hash_create, nelem);
+	expect_any(hash_create, info);
+	expect_any(hash_create, flags);
+	will_return(hash_create, &fake_htab);
+
+	expect_value(hash_search, hashp, &fake_htab);
+	expect_any(hash_search, keyPtr);
+	expect_value(hash_search, action, HASH_ENTER);
+	expect_any(hash_search, foundPtr);
+	will_assign_value(hash_search, foundPtr, false);
+	will_return(hash_search, &cached);
+
+	AppendOnlyVisimap_Find(&visiMap, &tupleId);
+	assert_true(visiMap.entryCache == (HTAB *) &fake_htab);
+	assert_true(bms_is_member(7, cached.bitmap));
+
+	/* move away, and back */
+	bms_free(visiMap.visimapEntry.bitmap);
+	visiMap.visimapEntry.bitmap = NULL;
+	visiMap.visimapEntry.segmentFileNum = -1;
+	visiMap.visimapEntry.firstRowNum = -1;
+
+	expect_value(AppendOnlyVisimapEntry_GetFirstRowNum, visiMapEntry,
+				 &visiMap.visimapEntry);
+	expect_value(AppendOnlyVisimapEntry_GetFirstRowNum, tupleId, &tupleId);
+	will_return(AppendOnlyVisimapEntry_GetFirstRowNum, 32768);
+
+	expect_value(hash_search, hashp, &fake_htab);
+	expect_any(hash_search, keyPtr);
+	expect_value(hash_search, action, HASH_FIND);
+	expect_any(hash_search, foundPtr);
+	will_return(hash_search, &cached);
+
+	AppendOnlyVisimap_Find(&visiMap, &tupleId);
+	assert_int_equal(visiMap.visimapEntry.segmentFileNum, 2);
+	assert_true(visiMap.visimapEntry.firstRowNum == 32768);
+	assert_true(bms_is_member(7, visiMap.visimapEntry.bitmap));
+	/* a copy, which hiding tuples can modify */
+	assert_true(visiMap.visimapEntry.bitmap != cached.bitmap);
+}
+
+
 int
 main(int argc, char *argv[])
 {
 	cmockery_parse_arguments(argc, argv);
 
 	const		UnitTest tests[] = {
-		unit_test(test__AppendOnlyVisimapDelete_Finish_outoforder)
+		unit_test(test__AppendOnlyVisimapDelete_Finish_outoforder),
+		unit_test(test__AppendOnlyVisimap_Find_cached)
 	};
 
 	MemoryContextInit();
@@ -81,12 +81,16 @@ void destroy_memtuple_binding(MemTupleBinding *pbind)
 		pfree(pbind->bind.null_saves_aligned);
 	if(pbind->bind.bindings)
 		pfree(pbind->bind.bindings);
+	if(pbind->bind.physical_order)
+		pfree(pbind->bind.physical_order);
 	if(pbind->large_bind.null_saves)
 		pfree(pbind->large_bind.null_saves);
 	if(pbind->large_bind.null_saves_aligned)
 		pfree(pbind->large_bind.null_saves_aligned);
 	if(pbind->large_bind.bindings)
 		pfree(pbind->large_bind.bindings);
+	if(pbind->large_bind.physical_order)
+		pfree(pbind->large_bind.physical_order);
 	pfree(pbind);
 }
 
@@ -215,6 +219,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 
 	/* alloc bindings, no need to zero because we will fill them out  */
 	colbind->bindings = (MemTupleAttrBinding *) palloc(sizeof(MemTupleAttrBinding) * tupdesc->natts);
+	colbind->physical_order = (int *) palloc(sizeof(int) * Max(tupdesc->natts, 1));
 	
 	/*
 	 * The length of each binding is determined according to the alignment
@@ -262,6 +267,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 				bind->null_byte = physical_col >> 3;
 				bind->null_mask = 1 << (physical_col-(bind->null_byte << 3));
 
+				colbind->physical_order[physical_col] = i;
 				physical_col += 1;
 				cur_offset = bind->offset + bind->len;
 				previous_bind = bind;
@@ -300,6 +306,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 				bind->null_byte = physical_col >> 3;
 				bind->null_mask = 1 << (physical_col-(bind->null_byte << 3));
 
+				colbind->physical_order[physical_col] = i;
 				physical_col += 1;
 				cur_offset = bind->offset + bind->len;
 				previous_bind = bind;
@@ -338,6 +345,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 				bind->null_byte = physical_col >> 3;
 				bind->null_mask = 1 << (physical_col-(bind->null_byte << 3));
 
+				colbind->physical_order[physical_col] = i;
 				physical_col += 1;
 				cur_offset = bind->offset + bind->len;
 				previous_bind = bind;
@@ -379,6 +387,7 @@ static void create_col_bind(MemTupleBindingCols *colbind, bool islarge, TupleDes
 				bind->null_byte = physical_col >> 3;
 				bind->null_mask = 1 << (physical_col-(bind->null_byte << 3));
 
+				colbind->physical_order[physical_col] = i;
 				physical_col += 1;
 				cur_offset = bind->offset + bind->len;
 				previous_bind = bind;
@@ -968,9 +977,84 @@ static void memtuple_get_values(MemTuple mtup, MemTupleBinding *pbind, Datum *da
 		datum[i] = memtuple_getattr_by_alignment(mtup, pbind, i+1, &isnull[i], use_null_saves_aligned);
 }
 
+/*
+ * Extract the first natts attributes of a memtuple.
+ *
+ * Unlike calling memtuple_getattr() for each attribute, which adds up the
+ * space saved by the nulls physically preceding the attribute from the null
+ * bitmap each time, this walks the attributes once in physical order and
+ * keeps a running total.  Without nulls, every attribute is at the offset
+ * given by the binding.
+ */
+void memtuple_getsomeattrs(MemTuple mtup, MemTupleBinding *pbind, int natts, Datum *datum, bool *isnull)
+{
+	MemTupleBindingCols *colbind = memtuple_get_islarge(mtup) ? &pbind->large_bind : &pbind->bind;
+	Form_pg_attribute *attrs = pbind->tupdesc->attrs;
+	char *start = (char *) mtup;
+	unsigned char *nullp;
+	int saved = 0;
+	int remaining;
+	int i;
+
+	Assert(natts >= 0 && natts <= pbind->tupdesc->natts);
+
+	if(!memtuple_get_hasnull(mtup))
+	{
+		for(i=0; i<natts; ++i)
+		{
+			MemTupleAttrBinding *bind = &colbind->bindings[i];
+			char *p = start + bind->offset;
+
+			if(bind->flag == MTB_ByVal_Native)
+				datum[i] = fetch_att(p, true, bind->len);
+			else
+			{
+				if(bind->flag != MTB_ByVal_Ptr)
+					p = start + (bind->len == 2 ? *(uint16 *) p : *(uint32 *) p);
+				datum[i] = PointerGetDatum(p);
+			}
+			isnull[i] = false;
+		}
+		return;
+	}
+
+	nullp = memtuple_get_nullp(mtup, pbind);
+	start += pbind->null_bitmap_extra_size;
+
+	remaining = natts;
+	for(i=0; remaining > 0; ++i)
+	{
+		int attno = colbind->physical_order[i];
+		MemTupleAttrBinding *bind = &colbind->bindings[attno];
+		char *p;
+
+		if(nullp[bind->null_byte] & bind->null_mask)
+		{
+			saved += bind->len_aligned;
+			if(attno < natts)
+			{
+				datum[attno] = 0;
+				isnull[attno] = true;
+				--remaining;
+			}
+			continue;
+		}
+
+		if(attno >= natts)
+			continue;
+
+		p = start + bind->offset - saved;
+		if(bind->flag == MTB_ByRef || bind->flag == MTB_ByRef_CStr)
+			p = start + (bind->len == 2 ? *(uint16 *) p : *(uint32 *) p);
+		datum[attno] = fetchatt(attrs[attno], p);
+		isnull[attno] = false;
+		--remaining;
+	}
+}
+
 void memtuple_deform(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull)
 {
-	memtuple_get_values(mtup, pbind, datum, isnull, true /* aligned */);
+	memtuple_getsomeattrs(mtup, pbind, pbind->tupdesc->natts, datum, isnull);
 }
 
 
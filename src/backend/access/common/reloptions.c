@@ -26,6 +26,7 @@
 #include "cdb/cdbvars.h"
 #include "commands/defrem.h"
 #include "commands/tablespace.h"
+#include "commands/vacuum.h"
 #include "commands/view.h"
 #include "nodes/makefuncs.h"
 #include "postmaster/postmaster.h"
@@ -380,6 +381,18 @@ static relopt_string stringRelOpts[] =
 		validateWithCheckOption,
 		NULL
 	},
+	{
+		{
+			"statistics_group",
+			"Other columns correlated with this one, for ANALYZE to collect multi-column statistics on.",
+			RELOPT_KIND_ATTRIBUTE,
+			AccessExclusiveLock
+		},
+		0,
+		true,
+		validateStatisticsGroupOption,
+		NULL
+	},
 	/* list terminator */
 	{{NULL}}
 };
@@ -1458,7 +1471,8 @@ attribute_reloptions(Datum reloptions, bool validate)
 	int			numoptions;
 	static const relopt_parse_elt tab[] = {
 		{"n_distinct", RELOPT_TYPE_REAL, offsetof(AttributeOpts, n_distinct)},
-		{"n_distinct_inherited", RELOPT_TYPE_REAL, offsetof(AttributeOpts, n_distinct_inherited)}
+		{"n_distinct_inherited", RELOPT_TYPE_REAL, offsetof(AttributeOpts, n_distinct_inherited)},
+		{"statistics_group", RELOPT_TYPE_STRING, offsetof(AttributeOpts, statistics_group_offset)}
 	};
 
 	options = parseRelOptions(reloptions, validate, RELOPT_KIND_ATTRIBUTE,
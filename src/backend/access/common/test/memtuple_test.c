@@ -0,0 +1,310 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "postgres.h"
+#include "access/memtup.h"
+#include "catalog/pg_type.h"
+#include "portability/instr_time.h"
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/memutils.h"
+
+/*
+ * Build a tuple descriptor with a mix of the layouts a memtuple binding
+ * distinguishes: 8, 4, 2 and 1 byte aligned by-value types, a fixed length
+ * by-reference type and varlenas.  Filled in by hand, as there is no
+ * catalog to look the types up in.
+ */
+static void
+init_attr(TupleDesc tupdesc, int attnum, Oid typid, int16 typlen,
+		  bool typbyval, char typalign, char typstorage)
+{
+	Form_pg_attribute attr = tupdesc->attrs[attnum - 1];
+
+	memset(attr, 0, ATTRIBUTE_FIXED_PART_SIZE);
+	snprintf(NameStr(attr->attname), NAMEDATALEN, "a%d", attnum);
+	attr->attnum = attnum;
+	attr->atttypid = typid;
+	attr->atttypmod = -1;
+	attr->attlen = typlen;
+	attr->attbyval = typbyval;
+	attr->attalign = typalign;
+	attr->attstorage = typstorage;
+	attr->attndims = 0;
+	attr->attisdropped = false;
+}
+
+static TupleDesc
+make_tupdesc(int natts)
+{
+	TupleDesc	tupdesc = CreateTemplateTupleDesc(natts, false);
+	int			i;
+
+	for (i = 1; i <= natts; i++)
+	{
+		switch (i % 7)
+		{
+			case 1:
+				init_attr(tupdesc, i, INT4OID, 4, true, 'i', 'p');
+				break;
+			case 2:
+				init_attr(tupdesc, i, TEXTOID, -1, false, 'i', 'x');
+				break;
+			case 3:
+				init_attr(tupdesc, i, INT8OID, 8, FLOAT8PASSBYVAL, 'd', 'p');
+				break;
+			case 4:
+				init_attr(tupdesc, i, BOOLOID, 1, true, 'c', 'p');
+				break;
+			case 5:
+				init_attr(tupdesc, i, INT2OID, 2, true, 's', 'p');
+				break;
+			case 6:
+				init_attr(tupdesc, i, NAMEOID, NAMEDATALEN, false, 'c', 'p');
+				break;
+			case 0:
+				init_attr(tupdesc, i, FLOAT8OID, 8, FLOAT8PASSBYVAL, 'd', 'p');
+				break;
+		}
+	}
+
+	return tupdesc;
+}
+
+static Datum
+make_value(Form_pg_attribute attr, int row, int textlen)
+{
+	switch (attr->atttypid)
+	{
+		case INT4OID:
+			return Int32GetDatum(row * 31 + attr->attnum);
+		case TEXTOID:
+			{
+				char	   *str = palloc(textlen + 1);
+
+				memset(str, 'a' + (row + attr->attnum) % 26, textlen);
+				str[textlen] = '\0';
+				return PointerGetDatum(cstring_to_text(str));
+			}
+		case INT8OID:
+			return Int64GetDatum((int64) row << 33 | attr->attnum);
+		case BOOLOID:
+			return BoolGetDatum((row + attr->attnum) % 2 == 0);
+		case INT2OID:
+			return Int16GetDatum(row - attr->attnum);
+		case NAMEOID:
+			{
+				Name		name = (Name) palloc0(NAMEDATALEN);
+
+				snprintf(NameStr(*name), NAMEDATALEN, "name %d %d", row, attr->attnum);
+				return NameGetDatum(name);
+			}
+		case FLOAT8OID:
+			return Float8GetDatum(row / 7.0 + attr->attnum);
+	}
+	return (Datum) 0;
+}
+
+/*
+ * Check that memtuple_deform() and memtuple_getsomeattrs() agree with
+ * memtuple_getattr() on every attribute of mtup.
+ */
+static void
+check_deform(MemTuple mtup, MemTupleBinding *pbind,
+			 Datum *values, bool *isnull)
+{
+	TupleDesc	tupdesc = pbind->tupdesc;
+	int			natts = tupdesc->natts;
+	Datum	   *dvalues = palloc(natts * sizeof(Datum));
+	bool	   *disnull = palloc(natts * sizeof(bool));
+	int			nsome;
+	int			i;
+
+	memtuple_deform(mtup, pbind, dvalues, disnull);
+
+	for (i = 0; i < natts; i++)
+	{
+		Form_pg_attribute attr = tupdesc->attrs[i];
+		bool		gisnull;
+		Datum		gvalue = memtuple_getattr(mtup, pbind, i + 1, &gisnull);
+
+		assert_int_equal(disnull[i], gisnull);
+		assert_int_equal(disnull[i], isnull[i]);
+		if (!gisnull)
+		{
+			assert_true(datumIsEqual(dvalues[i], gvalue, attr->attbyval, attr->attlen));
+			if (attr->attlen == -1)
+				assert_int_equal(VARSIZE_ANY_EXHDR(DatumGetPointer(gvalue)),
+								 VARSIZE_ANY_EXHDR(DatumGetPointer(values[i])));
+			else
+				assert_true(datumIsEqual(gvalue, values[i], attr->attbyval, attr->attlen));
+		}
+	}
+
+	/* Extracting a prefix must not touch the attributes after it */
+	for (nsome = 0; nsome < natts; nsome += 3)
+	{
+		for (i = 0; i < natts; i++)
+		{
+			dvalues[i] = (Datum) 0x7f7f7f7f;
+			disnull[i] = true;
+		}
+		memtuple_getsomeattrs(mtup, pbind, nsome, dvalues, disnull);
+		for (i = 0; i < natts; i++)
+		{
+			if (i < nsome)
+				assert_int_equal(disnull[i], isnull[i]);
+			else
+			{
+				assert_true(disnull[i]);
+				assert_true(dvalues[i] == (Datum) 0x7f7f7f7f);
+			}
+		}
+	}
+
+	pfree(dvalues);
+	pfree(disnull);
+}
+
+static void
+test__memtuple_deform__null_patterns(void **state)
+{
+	int			natts = 9;
+	TupleDesc	tupdesc = make_tupdesc(natts);
+	MemTupleBinding *pbind = create_memtuple_binding(tupdesc);
+	Datum	   *values = palloc(natts * sizeof(Datum));
+	bool	   *isnull = palloc(natts * sizeof(bool));
+	int			pattern;
+	int			i;
+
+	/* every combination of nulls */
+	for (pattern = 0; pattern < (1 << natts); pattern++)
+	{
+		MemTuple	mtup;
+
+		for (i = 0; i < natts; i++)
+		{
+			isnull[i] = (pattern & (1 << i)) != 0;
+			values[i] = isnull[i] ? (Datum) 0 :
+				make_value(tupdesc->attrs[i], pattern, 1 + pattern % 200);
+		}
+
+		mtup = memtuple_form_to(pbind, values, isnull, NULL, NULL, false);
+		assert_false(memtuple_get_islarge(mtup));
+		check_deform(mtup, pbind, values, isnull);
+		pfree(mtup);
+	}
+}
+
+static void
+test__memtuple_deform__large_tuple(void **state)
+{
+	int			natts = 30;
+	TupleDesc	tupdesc = make_tupdesc(natts);
+	MemTupleBinding *pbind = create_memtuple_binding(tupdesc);
+	Datum	   *values = palloc(natts * sizeof(Datum));
+	bool	   *isnull = palloc(natts * sizeof(bool));
+	int			row;
+	int			i;
+
+	/* text values long enough to need 4 byte offsets */
+	for (row = 0; row < 4; row++)
+	{
+		MemTuple	mtup;
+
+		for (i = 0; i < natts; i++)
+		{
+			isnull[i] = (row > 0 && i % (row + 1) == 0);
+			values[i] = isnull[i] ? (Datum) 0 :
+				make_value(tupdesc->attrs[i], row, 30000);
+		}
+
+		mtup = memtuple_form_to(pbind, values, isnull, NULL, NULL, false);
+		assert_true(memtuple_get_islarge(mtup));
+		check_deform(mtup, pbind, values, isnull);
+		pfree(mtup);
+	}
+}
+
+/*
+ * Not a test as such: times deforming a tuple with memtuple_deform() against
+ * extracting its attributes one by one, which is what the deform used to do.
+ * It is disabled, so that the unit test runs don't print timings; run
+ * "./memtuple.t --cmockery_run_disabled_tests" to see them.
+ */
+static void
+test__memtuple_deform__benchmark(void **state)
+{
+	int			natts = 40;
+	int			loops = 20000;
+	TupleDesc	tupdesc;
+	MemTupleBinding *pbind;
+	Datum	   *values;
+	bool	   *isnull;
+	int			withnulls;
+
+	disable_unit_test();
+
+	tupdesc = make_tupdesc(natts);
+	pbind = create_memtuple_binding(tupdesc);
+	values = palloc(natts * sizeof(Datum));
+	isnull = palloc(natts * sizeof(bool));
+
+	for (withnulls = 0; withnulls <= 1; withnulls++)
+	{
+		MemTuple	mtup;
+		instr_time	start;
+		instr_time	by_attr;
+		instr_time	by_deform;
+		int			loop;
+		int			i;
+
+		for (i = 0; i < natts; i++)
+		{
+			isnull[i] = withnulls && i % 3 == 0;
+			values[i] = isnull[i] ? (Datum) 0 :
+				make_value(tupdesc->attrs[i], i, 10);
+		}
+		mtup = memtuple_form_to(pbind, values, isnull, NULL, NULL, false);
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (loop = 0; loop < loops; loop++)
+		{
+			for (i = 0; i < natts; i++)
+				values[i] = memtuple_getattr(mtup, pbind, i + 1, &isnull[i]);
+		}
+		INSTR_TIME_SET_CURRENT(by_attr);
+		INSTR_TIME_SUBTRACT(by_attr, start);
+
+		INSTR_TIME_SET_CURRENT(start);
+		for (loop = 0; loop < loops; loop++)
+			memtuple_deform(mtup, pbind, values, isnull);
+		INSTR_TIME_SET_CURRENT(by_deform);
+		INSTR_TIME_SUBTRACT(by_deform, start);
+
+		printf("%d attributes%s, %d times: memtuple_getattr %.3f ms, memtuple_deform %.3f ms\n",
+			   natts, withnulls ? " with nulls" : "", loops,
+			   INSTR_TIME_GET_MILLISEC(by_attr),
+			   INSTR_TIME_GET_MILLISEC(by_deform));
+
+		pfree(mtup);
+	}
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__memtuple_deform__null_patterns),
+		unit_test(test__memtuple_deform__large_tuple),
+		unit_test(test__memtuple_deform__benchmark)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -25,7 +25,9 @@
 #include "cdb/cdbsreh.h"
 #include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
+#include "fstream/gpfdist_zstd.h"
 #include "miscadmin.h"
+#include "storage/gp_compress.h"
 #include "utils/guc.h"
 #include "utils/resowner.h"
 #include "utils/uri.h"
@@ -92,8 +94,22 @@ typedef struct
 	struct
 	{
 		int			datalen;	/* remaining datablock length */
+		bool		decompressed;	/* the data is in zbuf, not in 'in' */
 	} block;
 
+	bool		zstd;			/* gpfdist agreed to zstd compressed data */
+#ifdef HAVE_LIBZSTD
+	zstd_context *zstd_context;
+
+	/* a decompressed 'Z' block when reading, a compressed POST when writing */
+	struct
+	{
+		char	   *ptr;		/* palloc-ed buffer */
+		int			max;
+		int			bot;
+	} zbuf;
+#endif
+
 } URL_CURL_FILE;
 
 
@@ -264,6 +280,49 @@ url_curl_abort_callback(ResourceReleasePhase phase,
 	}
 }
 
+/*
+ * get_header_value
+ *
+ * If the HTTP header line in ptr is the header 'name', copy its value to buf
+ * and return true.
+ */
+static bool
+get_header_value(char *ptr, int len, const char *name, char *buf, int bufsz)
+{
+	int			namelen = strlen(name);
+	int			i;
+
+	if (len <= namelen || *ptr != *name || 0 != strncmp(name, ptr, namelen))
+		return false;
+
+	ptr += namelen;
+	len -= namelen;
+
+	while (len > 0 && (*ptr == ' ' || *ptr == '\t'))
+	{
+		ptr++;
+		len--;
+	}
+
+	if (len <= 0 || *ptr != ':')
+		return false;
+
+	ptr++;
+	len--;
+
+	while (len > 0 && (*ptr == ' ' || *ptr == '\t'))
+	{
+		ptr++;
+		len--;
+	}
+
+	for (i = 0; i < bufsz - 1 && i < len; i++)
+		buf[i] = ptr[i];
+
+	buf[i] = 0;
+	return true;
+}
+
 /*
  * header_callback
  *
@@ -278,7 +337,6 @@ header_callback(void *ptr_, size_t size, size_t nmemb, void *userp)
     URL_CURL_FILE *url = (URL_CURL_FILE *) userp;
 	char*		ptr = ptr_;
 	int 		len = size * nmemb;
-	int 		i;
 	char 		buf[20];
 
 	Assert(size == 1);
@@ -314,35 +372,17 @@ header_callback(void *ptr_, size_t size, size_t nmemb, void *userp)
 	/*
 	 * extract the GP-PROTO value from the HTTP header.
 	 */
-	if (len > 10 && *ptr == 'X' && 0 == strncmp("X-GP-PROTO", ptr, 10))
-	{
-		ptr += 10;
-		len -= 10;
-
-		while (len > 0 && (*ptr == ' ' || *ptr == '\t'))
-		{
-			ptr++;
-			len--;
-		}
-
-		if (len > 0 && *ptr == ':')
-		{
-			ptr++;
-			len--;
-
-			while (len > 0 && (*ptr == ' ' || *ptr == '\t'))
-			{
-				ptr++;
-				len--;
-			}
-
-			for (i = 0; i < sizeof(buf) - 1 && i < len; i++)
-				buf[i] = ptr[i];
+	if (get_header_value(ptr, len, "X-GP-PROTO", buf, sizeof(buf)))
+		url->gp_proto = strtol(buf, 0, 0);
 
-			buf[i] = 0;
-			url->gp_proto = strtol(buf, 0, 0);
-		}
-	}
+#ifdef HAVE_LIBZSTD
+	/*
+	 * gpfdist compresses the data it sends, or accepts compressed data, if
+	 * we asked for it.
+	 */
+	if (url->zstd_context && get_header_value(ptr, len, "X-GP-ZSTD", buf, sizeof(buf)))
+		url->zstd = (strtol(buf, 0, 0) == 1);
+#endif
 
 	return size * nmemb;
 }
@@ -1170,6 +1210,18 @@ url_curl_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
 	set_httpheader(file, "X-GP-LINE-DELIM-STR", ev->GP_LINE_DELIM_STR);
 	set_httpheader(file, "X-GP-LINE-DELIM-LENGTH", ev->GP_LINE_DELIM_LENGTH);
 
+#ifdef HAVE_LIBZSTD
+	/*
+	 * Offer to exchange zstd compressed data. gpfdist answers with the same
+	 * header if it can, see header_callback().
+	 */
+	if (gpfdist_compression)
+	{
+		file->zstd_context = zstd_alloc_context();
+		set_httpheader(file, "X-GP-ZSTD", "1");
+	}
+#endif
+
 	if (forwrite)
 	{
 		// TIMEOUT for POST only, GET is single HTTP request,
@@ -1399,6 +1451,20 @@ url_curl_fclose(URL_FILE *fileg, bool failOnError, const char *relname)
 	destroy_curlhandle(file->curl);
 	file->curl = NULL;
 
+#ifdef HAVE_LIBZSTD
+	if (file->zstd_context)
+	{
+		zstd_free_context(file->zstd_context);
+		file->zstd_context = NULL;
+	}
+
+	if (file->zbuf.ptr)
+	{
+		pfree(file->zbuf.ptr);
+		file->zbuf.ptr = NULL;
+	}
+#endif
+
 	/* free any allocated buffer space */
 	if (file->in.ptr)
 	{
@@ -1476,12 +1542,56 @@ gp_proto0_read(char *buf, int bufsz, URL_CURL_FILE *file)
 	return n;
 }
 
+/*
+ * gp_proto1_decompress
+ *
+ * Decompress the 'Z' block of 'len' bytes at the start of the input buffer
+ * into zbuf, and return the length of the data.
+ */
+static int
+gp_proto1_decompress(URL_CURL_FILE *file, int len)
+{
+#ifdef HAVE_LIBZSTD
+	unsigned long long datalen;
+	size_t		ret;
+
+	datalen = ZSTD_getFrameContentSize(file->in.ptr + file->in.bot, len);
+	if (datalen == ZSTD_CONTENTSIZE_UNKNOWN || datalen == ZSTD_CONTENTSIZE_ERROR ||
+		datalen > MaxAllocSize)
+		elog(ERROR, "gpfdist error: bad compressed data block");
+
+	if (file->zbuf.max < datalen)
+	{
+		if (file->zbuf.ptr)
+			pfree(file->zbuf.ptr);
+		file->zbuf.ptr = palloc(datalen);
+		file->zbuf.max = datalen;
+	}
+
+	if (!file->zstd_context->dctx)
+		file->zstd_context->dctx = ZSTD_createDCtx();
+
+	ret = ZSTD_decompressDCtx(file->zstd_context->dctx, file->zbuf.ptr, datalen,
+							  file->in.ptr + file->in.bot, len);
+	if (ZSTD_isError(ret) || ret != datalen)
+		elog(ERROR, "gpfdist error: could not decompress data block: %s",
+			 ZSTD_isError(ret) ? ZSTD_getErrorName(ret) : "length mismatch");
+
+	file->zbuf.bot = 0;
+	return datalen;
+#else
+	elog(ERROR, "gpfdist error: compressed data is not supported by this build");
+	return 0;					/* keep compiler quiet */
+#endif
+}
+
 /*
  * gp_proto1_read
  *
  * get data from the server and handle it according to PROTO 1. In this protocol
  * each data block is tagged by meta info like this:
- * byte 0: type (can be 'F'ilename, 'O'ffset, 'D'ata, 'E'rror, 'L'inenumber)
+ * byte 0: type (can be 'F'ilename, 'O'ffset, 'D'ata, 'E'rror, 'L'inenumber,
+ *         or 'Z' for data compressed with zstd, if we asked for it)
  * byte 1-4: length. # bytes of following data block. in network-order.
  * byte 5-X: the block itself.
  */
@@ -1628,10 +1738,29 @@ gp_proto1_read(char *buf, int bufsz, URL_CURL_FILE *file, CopyState pstate, char
 		if (type == 'D')
 		{
 			file->block.datalen = len;
+			file->block.decompressed = false;
 			file->eof = (len == 0);
 			break;
 		}
 
+		/* Compressed data, a zstd frame */
+		if (type == 'Z')
+		{
+			if (!file->zstd)
+				elog(ERROR, "gpfdist error: unexpected compressed data");
+
+			if (-1 == fill_buffer(file, len) || file->in.top - file->in.bot < len)
+				elog(ERROR, "gpfdist error: stream ends suddenly");
+
+			file->block.datalen = gp_proto1_decompress(file, len);
+			file->block.decompressed = true;
+			file->in.bot += len;
+			Assert(file->in.bot <= file->in.top);
+			if (file->block.datalen == 0)
+				continue;
+			break;
+		}
+
 		elog(ERROR, "gpfdist error: unknown meta type %d", type);
 	}
 
@@ -1639,6 +1768,16 @@ gp_proto1_read(char *buf, int bufsz, URL_CURL_FILE *file, CopyState pstate, char
 	if (bufsz > file->block.datalen)
 		bufsz = file->block.datalen;
 
+#ifdef HAVE_LIBZSTD
+	if (file->block.decompressed)
+	{
+		memcpy(buf, file->zbuf.ptr + file->zbuf.bot, bufsz);
+		file->zbuf.bot += bufsz;
+		file->block.datalen -= bufsz;
+		return bufsz;
+	}
+#endif
+
 	fill_buffer(file, bufsz);
 	n = file->in.top - file->in.bot;
 
@@ -1680,6 +1819,37 @@ gp_proto0_write(URL_CURL_FILE *file, CopyState pstate)
 
 	if (nbytes == 0)
 		return;
+
+#ifdef HAVE_LIBZSTD
+	/* gpfdist decompresses the body if it has a "Content-Encoding: zstd" header */
+	if (file->zstd)
+	{
+		size_t		bound = ZSTD_compressBound(nbytes);
+		size_t		ret;
+
+		if (!file->zstd_context->cctx)
+		{
+			file->zstd_context->cctx = ZSTD_createCCtx();
+			set_httpheader(file, "Content-Encoding", "zstd");
+		}
+
+		if (file->zbuf.max < bound)
+		{
+			if (file->zbuf.ptr)
+				pfree(file->zbuf.ptr);
+			file->zbuf.ptr = palloc(bound);
+			file->zbuf.max = bound;
+		}
+
+		ret = ZSTD_compressCCtx(file->zstd_context->cctx, file->zbuf.ptr, bound,
+								buf, nbytes, GPFDIST_ZSTD_COMPRESSION_LEVEL);
+		if (ZSTD_isError(ret))
+			elog(ERROR, "could not compress data for gpfdist: %s", ZSTD_getErrorName(ret));
+
+		buf = file->zbuf.ptr;
+		nbytes = ret;
+	}
+#endif
 	
 	/* post binary data */
 	CURL_EASY_SETOPT(file->curl->handle, CURLOPT_POSTFIELDS, buf);
@@ -40,6 +40,7 @@ url_file_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
 	struct fstream_options fo;
 	int			response_code;
 	const char *response_string;
+	char		response_buf[256];
 
 	if (forwrite)
 		elog(ERROR, "cannot change a readable external table \"%s\"", pstate->cur_relname);
@@ -68,7 +69,8 @@ url_file_fopen(char *url, bool forwrite, extvar_t *ev, CopyState pstate)
 	 * wildcard or directory is used). In addition we check ahead of time
 	 * that all the involved files exists and have proper read permissions.
 	 */
-	file->fp = fstream_open(path, &fo, &response_code, &response_string);
+	file->fp = fstream_open(path, &fo, &response_code, &response_string,
+							response_buf, sizeof(response_buf));
 
 	/* Couldn't open local file. Report error. */
 	if (!file->fp)
@@ -31,11 +31,17 @@
 #include "access/distributedlog.h"
 #include "access/slru.h"
 #include "access/transam.h"
+#include "catalog/pg_type.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
+#include "funcapi.h"
+#include "port/atomics.h"
+#include "storage/ipc.h"
 #include "storage/shmem.h"
+#include "utils/builtins.h"
 #include "utils/faultinjector.h"
 #include "utils/guc.h"
+#include "utils/tuplestore.h"
 #include "miscadmin.h"
 #include "libpq/libpq-be.h" /* struct Port */
 
@@ -73,10 +79,58 @@ AdvanceTransactionIdToNextPage(TransactionId xid)
 
 /*
  * Link to shared-memory data structures for DistributedLog control
+ *
+ * The buffers are split into banks. Each bank is an SLRU of its own, with
+ * its own control lock, so that backends looking up pages in different banks
+ * don't queue up behind each other. A page always lives in the same bank, and
+ * all the banks share the pg_distributedlog directory.
+ */
+static SlruCtlData DistributedLogCtlData[MAX_DISTRIBUTEDLOG_BANKS];
+static int	DistributedLogNumBanks = 1;
+
+#define DistributedLogCtl (&DistributedLogCtlData[0])
+
+#define PageToBank(page) ((page) % DistributedLogNumBanks)
+#define DistributedLogBankCtl(page) (&DistributedLogCtlData[PageToBank(page)])
+
+/*
+ * Control lock of a bank, and how often it was taken and had to be waited
+ * for, as shown by gp_distributedlog_stats().  The counts are kept by each
+ * backend, and added here by DistributedLog_FlushBankStats().
  */
-static SlruCtlData DistributedLogCtlData;
+typedef struct DistributedLogBank
+{
+	LWLock		lock;
+	pg_atomic_uint64 acquires;
+	pg_atomic_uint64 waits;
+} DistributedLogBank;
+
+/* Padded to a full cache line, so that banks don't share one */
+typedef union DistributedLogBankPadded
+{
+	DistributedLogBank bank;
+	char		pad[PG_CACHE_LINE_SIZE];
+} DistributedLogBankPadded;
+
+static DistributedLogBankPadded *DistributedLogBanks = NULL;
+
+/*
+ * How often this backend took and waited for the lock of each bank, since it
+ * last added them to the shared counts.  Adding to those on every acquire
+ * would make every backend write to the cache line of the bank, which is
+ * what the banks are meant to avoid, so it's only done every
+ * DISTRIBUTEDLOG_STATS_FLUSH acquires of a bank, and at backend exit.
+ */
+#define DISTRIBUTEDLOG_STATS_FLUSH	64
+
+typedef struct DistributedLogBankStats
+{
+	uint32		acquires;
+	uint32		waits;
+} DistributedLogBankStats;
 
-#define DistributedLogCtl (&DistributedLogCtlData)
+static DistributedLogBankStats DistributedLogLocalStats[MAX_DISTRIBUTEDLOG_BANKS];
+static bool DistributedLogExitRegistered = false;
 
 typedef struct DistributedLogShmem
 {
@@ -87,9 +141,19 @@ typedef struct DistributedLogShmem
 	 * postmaster startup, and advanced whenever we receive a new
 	 * distributed snapshot from the QD (or in the QD itself, whenever
 	 * we compute a new snapshot).
+	 *
+	 * Changed while holding DistributedLogControlLock.
 	 */
 	TransactionId	oldestXmin;
 
+	LWLockTranche	bankLockTranche;
+
+	/*
+	 * Tranche of the buffer locks of each bank.  Every bank's SLRU has its
+	 * own array of buffer locks, so each needs a tranche of its own.
+	 */
+	int				bufferTrancheIds[MAX_DISTRIBUTEDLOG_BANKS];
+
 } DistributedLogShmem;
 
 static DistributedLogShmem *DistributedLogShared = NULL;
@@ -99,6 +163,80 @@ static bool DistributedLog_PagePrecedes(int page1, int page2);
 static void DistributedLog_WriteZeroPageXlogRec(int page);
 static void DistributedLog_WriteTruncateXlogRec(int page);
 static void DistributedLog_Truncate(TransactionId oldestXmin);
+static void DistributedLog_FlushBankStats(int bank);
+static void AtProcExit_DistributedLog(int code, Datum arg);
+
+/*
+ * Acquire the control lock of a bank, counting whether we had to wait for it.
+ */
+static LWLock *
+DistributedLog_LockBank(int bank, LWLockMode mode)
+{
+	DistributedLogBank *b = &DistributedLogBanks[bank].bank;
+	DistributedLogBankStats *stats = &DistributedLogLocalStats[bank];
+
+	if (!DistributedLogExitRegistered)
+	{
+		before_shmem_exit(AtProcExit_DistributedLog, 0);
+		DistributedLogExitRegistered = true;
+	}
+
+	stats->acquires++;
+	if (!LWLockConditionalAcquire(&b->lock, mode))
+	{
+		stats->waits++;
+		LWLockAcquire(&b->lock, mode);
+	}
+
+	if (stats->acquires >= DISTRIBUTEDLOG_STATS_FLUSH)
+		DistributedLog_FlushBankStats(bank);
+
+	return &b->lock;
+}
+
+/*
+ * Add the lock counts of this backend for a bank to the shared counts.
+ */
+static void
+DistributedLog_FlushBankStats(int bank)
+{
+	DistributedLogBank *b = &DistributedLogBanks[bank].bank;
+	DistributedLogBankStats *stats = &DistributedLogLocalStats[bank];
+
+	if (stats->acquires > 0)
+		pg_atomic_fetch_add_u64(&b->acquires, stats->acquires);
+	if (stats->waits > 0)
+		pg_atomic_fetch_add_u64(&b->waits, stats->waits);
+	stats->acquires = 0;
+	stats->waits = 0;
+}
+
+/*
+ * Don't lose the lock counts of this backend that are not flushed yet.
+ */
+static void
+AtProcExit_DistributedLog(int code, Datum arg)
+{
+	int			bank;
+
+	for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		DistributedLog_FlushBankStats(bank);
+}
+
+/*
+ * Every bank must know the latest page, for the wraparound check in
+ * SimpleLruTruncate(). Pages are only zeroed by one process at a time
+ * (under XidGenLock, or by the startup process), so it's OK to update the
+ * banks other than the page's own without their locks.
+ */
+static void
+DistributedLog_SetLatestPage(int page)
+{
+	int			bank;
+
+	for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		DistributedLogCtlData[bank].shared->latest_page_number = page;
+}
 
 /*
  * Initialize the value for oldest local XID that might still be visible
@@ -177,6 +315,7 @@ DistributedLog_AdvanceOldestXmin(TransactionId oldestLocalXmin,
 	TransactionId oldOldestXmin;
 	int			currPage;
 	int			slotno;
+	LWLock	   *bankLock = NULL;
 	DistributedLogEntry *entries = NULL;
 
 	Assert(!IS_QUERY_DISPATCHER());
@@ -214,9 +353,14 @@ DistributedLog_AdvanceOldestXmin(TransactionId oldestLocalXmin,
 
 		if (page != currPage)
 		{
-			slotno = SimpleLruReadPage(DistributedLogCtl, page, true, oldestXmin);
+			SlruCtl		ctl = DistributedLogBankCtl(page);
+
+			if (bankLock)
+				LWLockRelease(bankLock);
+			bankLock = DistributedLog_LockBank(PageToBank(page), LW_SHARED);
+			slotno = SimpleLruReadPage_ReadOnlyLocked(ctl, page, oldestXmin);
 			currPage = page;
-			entries = (DistributedLogEntry *) DistributedLogCtl->shared->page_buffer[slotno];
+			entries = (DistributedLogEntry *) ctl->shared->page_buffer[slotno];
 		}
 
 		ptr = &entries[entryno];
@@ -234,6 +378,9 @@ DistributedLog_AdvanceOldestXmin(TransactionId oldestLocalXmin,
 		TransactionIdAdvance(oldestXmin);
 	}
 
+	if (bankLock)
+		LWLockRelease(bankLock);
+
 	DistributedLogShared->oldestXmin = oldestXmin;
 	LWLockRelease(DistributedLogControlLock);
 	LWLockRelease(DistributedLogTruncateLock);
@@ -282,6 +429,8 @@ DistributedLog_SetCommittedWithinAPage(
 {
 	int page;
 	int slotno;
+	SlruCtl ctl;
+	LWLock *bankLock;
 	DistributedLogEntry *ptr;
 
 	Assert(!IS_QUERY_DISPATCHER());
@@ -290,15 +439,16 @@ DistributedLog_SetCommittedWithinAPage(
 	Assert(TransactionIdIsValid(localXid[0]));
 
 	page = TransactionIdToPage(localXid[0]);
+	ctl = DistributedLogBankCtl(page);
 
-	LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
+	bankLock = DistributedLog_LockBank(PageToBank(page), LW_EXCLUSIVE);
 
 	if (isRedo)
 	{
 		elog((Debug_print_full_dtm ? LOG : DEBUG5),
 			 "DistributedLog_SetCommitted check if page %d is present",
 			 page);
-		if (!SimpleLruDoesPhysicalPageExist(DistributedLogCtl, page))
+		if (!SimpleLruDoesPhysicalPageExist(ctl, page))
 		{
 			DistributedLog_ZeroPage(page, /* writeXLog */ false);
 			elog((Debug_print_full_dtm ? LOG : DEBUG5),
@@ -307,8 +457,8 @@ DistributedLog_SetCommittedWithinAPage(
 		}
 	}
 
-	slotno = SimpleLruReadPage(DistributedLogCtl, page, true, localXid[0]);
-	ptr = (DistributedLogEntry *) DistributedLogCtl->shared->page_buffer[slotno];
+	slotno = SimpleLruReadPage(ctl, page, true, localXid[0]);
+	ptr = (DistributedLogEntry *) ctl->shared->page_buffer[slotno];
 
 	for (int i = 0; i < numLocIds; i++)
 	{
@@ -338,7 +488,7 @@ DistributedLog_SetCommittedWithinAPage(
 			ptr[entryno].distribTimeStamp = distribTimeStamp;
 			ptr[entryno].distribXid = distribXid;
 
-			DistributedLogCtl->shared->page_dirty[slotno] = true;
+			ctl->shared->page_dirty[slotno] = true;
 		}
 
 		elog((Debug_print_full_dtm ? LOG : DEBUG5),
@@ -347,7 +497,7 @@ DistributedLog_SetCommittedWithinAPage(
 			 (alreadyThere ? "already there" : "set"));
 	}
 
-	LWLockRelease(DistributedLogControlLock);
+	LWLockRelease(bankLock);
 }
 
 /*
@@ -419,17 +569,23 @@ DistributedLog_CommittedCheck(
 
 	DistributedLogEntry *ptr;
 	TransactionId oldestXmin;
+	SlruCtl		ctl;
+	LWLock	   *bankLock;
 
 	LWLockAcquire(DistributedLogTruncateLock, LW_SHARED);
-	LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
 
+	/*
+	 * No need for DistributedLogControlLock to read oldestXmin. It only moves
+	 * forward, and segments are only removed below it while holding the
+	 * truncate lock exclusively, so the page we want can't go away under us
+	 * even if the value we see is a little stale.
+	 */
 	oldestXmin = DistributedLogShared->oldestXmin;
 	if (oldestXmin == InvalidTransactionId)
 		elog(PANIC, "DistributedLog's OldestXmin not initialized yet");
 
 	if (TransactionIdPrecedes(localXid, oldestXmin))
 	{
-		LWLockRelease(DistributedLogControlLock);
 		LWLockRelease(DistributedLogTruncateLock);
 
 		*distribTimeStamp = 0;	// Set it to something.
@@ -437,13 +593,15 @@ DistributedLog_CommittedCheck(
 		return false;
 	}
 
-	slotno = SimpleLruReadPage(DistributedLogCtl, page, true, localXid);
-	ptr = (DistributedLogEntry *) DistributedLogCtl->shared->page_buffer[slotno];
+	ctl = DistributedLogBankCtl(page);
+	bankLock = DistributedLog_LockBank(PageToBank(page), LW_SHARED);
+	slotno = SimpleLruReadPage_ReadOnlyLocked(ctl, page, localXid);
+	ptr = (DistributedLogEntry *) ctl->shared->page_buffer[slotno];
 	ptr += entryno;
 	*distribTimeStamp = ptr->distribTimeStamp;
 	*distribXid = ptr->distribXid;
 	ptr = NULL;
-	LWLockRelease(DistributedLogControlLock);
+	LWLockRelease(bankLock);
 	LWLockRelease(DistributedLogTruncateLock);
 
 	if (*distribTimeStamp != 0 && *distribXid != 0)
@@ -483,6 +641,8 @@ DistributedLog_ScanForPrevCommitted(
 	TransactionId lowXid;
 	int slotno;
 	TransactionId xid;
+	SlruCtl ctl;
+	LWLock *bankLock;
 
 	*distribTimeStamp = 0;	// Set it to something.
 	*distribXid = 0;
@@ -504,14 +664,15 @@ DistributedLog_ScanForPrevCommitted(
 		if (lowXid == InvalidTransactionId)
 			lowXid = FirstNormalTransactionId;
 
-		LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
+		ctl = DistributedLogBankCtl(pageno);
+		bankLock = DistributedLog_LockBank(PageToBank(pageno), LW_SHARED);
 
 		/*
 		 * Peek to see if page exists.
 		 */
-		if (!SimpleLruDoesPhysicalPageExist(DistributedLogCtl, pageno))
+		if (!SimpleLruDoesPhysicalPageExist(ctl, pageno))
 		{
-			LWLockRelease(DistributedLogControlLock);
+			LWLockRelease(bankLock);
 
 			*indexXid = InvalidTransactionId;
 			*distribTimeStamp = 0;	// Set it to something.
@@ -519,14 +680,14 @@ DistributedLog_ScanForPrevCommitted(
 			return false;
 		}
 
-		slotno = SimpleLruReadPage(DistributedLogCtl, pageno, true, highXid);
+		slotno = SimpleLruReadPage_ReadOnlyLocked(ctl, pageno, highXid);
 
 		for (xid = highXid; xid >= lowXid; xid--)
 		{
 			int						entryno = TransactionIdToEntry(xid);
 			DistributedLogEntry 	*ptr;
 
-			ptr = (DistributedLogEntry *) DistributedLogCtl->shared->page_buffer[slotno];
+			ptr = (DistributedLogEntry *) ctl->shared->page_buffer[slotno];
 			ptr += entryno;
 
 			if (ptr->distribTimeStamp != 0 && ptr->distribXid != 0)
@@ -534,13 +695,13 @@ DistributedLog_ScanForPrevCommitted(
 				*indexXid = xid;
 				*distribTimeStamp = ptr->distribTimeStamp;
 				*distribXid = ptr->distribXid;
-				LWLockRelease(DistributedLogControlLock);
+				LWLockRelease(bankLock);
 
 				return true;
 			}
 		}
 
-		LWLockRelease(DistributedLogControlLock);
+		LWLockRelease(bankLock);
 
 		if (lowXid == FirstNormalTransactionId)
 		{
@@ -562,6 +723,25 @@ DistributedLog_SharedShmemSize(void)
 	return MAXALIGN(sizeof(DistributedLogShmem));
 }
 
+static int
+DistributedLog_ConfiguredBanks(void)
+{
+	int			nbanks;
+
+	nbanks = (gp_distributedlog_buffers + DISTRIBUTEDLOG_BANK_BUFFERS - 1) /
+		DISTRIBUTEDLOG_BANK_BUFFERS;
+
+	return Min(Max(nbanks, 1), MAX_DISTRIBUTEDLOG_BANKS);
+}
+
+/* Room for the bank locks, plus slop to align them to a cache line */
+static Size
+DistributedLog_BanksShmemSize(int nbanks)
+{
+	return add_size(mul_size(nbanks, sizeof(DistributedLogBankPadded)),
+					PG_CACHE_LINE_SIZE);
+}
+
 /*
  * Initialization of shared memory for the distributed log.
  */
@@ -576,8 +756,11 @@ DistributedLog_ShmemSize(void)
 	}
 	else
 	{
-		size = SimpleLruShmemSize(NUM_DISTRIBUTEDLOG_BUFFERS, 0);
-		size += DistributedLog_SharedShmemSize();
+		int			nbanks = DistributedLog_ConfiguredBanks();
+
+		size = mul_size(nbanks, SimpleLruShmemSize(DISTRIBUTEDLOG_BANK_BUFFERS, 0));
+		size = add_size(size, DistributedLog_SharedShmemSize());
+		size = add_size(size, DistributedLog_BanksShmemSize(nbanks));
 	}
 
 	return size;
@@ -587,15 +770,14 @@ void
 DistributedLog_ShmemInit(void)
 {
 	bool		found;
+	bool		foundBanks;
+	char	   *banks;
+	int			bank;
 
 	if (IS_QUERY_DISPATCHER())
 		return;
 
-	/* Set up SLRU for the distributed log. */
-	DistributedLogCtl->PagePrecedes = DistributedLog_PagePrecedes;
-	SimpleLruInit(DistributedLogCtl, "DistributedLogCtl", NUM_DISTRIBUTEDLOG_BUFFERS, 0,
-				  DistributedLogControlLock, "pg_distributedlog",
-				  LWTRANCHE_DISTRIBUTEDLOG_BUFFERS);
+	DistributedLogNumBanks = DistributedLog_ConfiguredBanks();
 
 	/* Create or attach to the shared structure */
 	DistributedLogShared =
@@ -606,9 +788,52 @@ DistributedLog_ShmemInit(void)
 	if (!DistributedLogShared)
 		elog(FATAL, "could not initialize Distributed Log shared memory");
 
+	banks = (char *) ShmemInitStruct("DistributedLogBanks",
+									 DistributedLog_BanksShmemSize(DistributedLogNumBanks),
+									 &foundBanks);
+	banks += PG_CACHE_LINE_SIZE - ((uintptr_t) banks) % PG_CACHE_LINE_SIZE;
+	DistributedLogBanks = (DistributedLogBankPadded *) banks;
+
 	if (!found)
 	{
 		DistributedLogShared->oldestXmin = InvalidTransactionId;
+
+		DistributedLogShared->bankLockTranche.name = "DistributedLogBank";
+		DistributedLogShared->bankLockTranche.array_base = DistributedLogBanks;
+		DistributedLogShared->bankLockTranche.array_stride = sizeof(DistributedLogBankPadded);
+
+		for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		{
+			DistributedLogBank *b = &DistributedLogBanks[bank].bank;
+
+			LWLockInitialize(&b->lock, LWTRANCHE_DISTRIBUTEDLOG_BANKS);
+			pg_atomic_init_u64(&b->acquires, 0);
+			pg_atomic_init_u64(&b->waits, 0);
+
+			if (bank == 0)
+				DistributedLogShared->bufferTrancheIds[bank] = LWTRANCHE_DISTRIBUTEDLOG_BUFFERS;
+			else
+				DistributedLogShared->bufferTrancheIds[bank] = LWLockNewTrancheId();
+		}
+	}
+	LWLockRegisterTranche(LWTRANCHE_DISTRIBUTEDLOG_BANKS,
+						  &DistributedLogShared->bankLockTranche);
+
+	/* Set up an SLRU for each bank of the distributed log. */
+	for (bank = 0; bank < DistributedLogNumBanks; bank++)
+	{
+		SlruCtl		ctl = &DistributedLogCtlData[bank];
+		char		name[SLRU_MAX_NAME_LENGTH];
+
+		if (bank == 0)
+			strlcpy(name, "DistributedLogCtl", sizeof(name));
+		else
+			snprintf(name, sizeof(name), "DistributedLogCtl %d", bank);
+
+		ctl->PagePrecedes = DistributedLog_PagePrecedes;
+		SimpleLruInit(ctl, name, DISTRIBUTEDLOG_BANK_BUFFERS, 0,
+					  &DistributedLogBanks[bank].bank.lock, "pg_distributedlog",
+					  DistributedLogShared->bufferTrancheIds[bank]);
 	}
 }
 
@@ -622,20 +847,21 @@ void
 DistributedLog_BootStrap(void)
 {
 	int			slotno;
+	LWLock	   *bankLock;
 
 	if (IS_QUERY_DISPATCHER())
 		return;
 
-	LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
+	bankLock = DistributedLog_LockBank(PageToBank(0), LW_EXCLUSIVE);
 
 	/* Create and zero the first page of the commit log */
 	slotno = DistributedLog_ZeroPage(0, false);
 
 	/* Make sure it's written out */
-	SimpleLruWritePage(DistributedLogCtl, slotno);
-	Assert(!DistributedLogCtl->shared->page_dirty[slotno]);
+	SimpleLruWritePage(DistributedLogBankCtl(0), slotno);
+	Assert(!DistributedLogBankCtl(0)->shared->page_dirty[slotno]);
 
-	LWLockRelease(DistributedLogControlLock);
+	LWLockRelease(bankLock);
 }
 
 /*
@@ -645,7 +871,8 @@ DistributedLog_BootStrap(void)
  * The page is not actually written, just set up in shared memory.
  * The slot number of the new page is returned.
  *
- * Control lock must be held at entry, and will be held at exit.
+ * Control lock of the page's bank must be held at entry, and will be held
+ * at exit.
  */
 static int
 DistributedLog_ZeroPage(int page, bool writeXlog)
@@ -657,7 +884,8 @@ DistributedLog_ZeroPage(int page, bool writeXlog)
 	elog((Debug_print_full_dtm ? LOG : DEBUG5),
 		 "DistributedLog_ZeroPage zero page %d",
 		 page);
-	slotno = SimpleLruZeroPage(DistributedLogCtl, page);
+	slotno = SimpleLruZeroPage(DistributedLogBankCtl(page), page);
+	DistributedLog_SetLatestPage(page);
 
 	if (writeXlog)
 		DistributedLog_WriteZeroPageXlogRec(page);
@@ -675,6 +903,7 @@ DistributedLog_Startup(TransactionId oldestActiveXid,
 {
 	int			startPage;
 	int			endPage;
+	int			bank;
 
 	if (IS_QUERY_DISPATCHER())
 		return;
@@ -688,6 +917,8 @@ DistributedLog_Startup(TransactionId oldestActiveXid,
 	endPage = TransactionIdToPage(nextXid);
 
 	LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
+	for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		DistributedLog_LockBank(bank, LW_EXCLUSIVE);
 
 	elog((Debug_print_full_dtm ? LOG : DEBUG5),
 		 "DistributedLog_Startup startPage %d, endPage %d",
@@ -696,7 +927,7 @@ DistributedLog_Startup(TransactionId oldestActiveXid,
 	/*
 	 * Initialize our idea of the latest page number.
 	 */
-	DistributedLogCtl->shared->latest_page_number = endPage;
+	DistributedLog_SetLatestPage(endPage);
 
 	/*
 	 * In situations where new segments' data directories are copied from the
@@ -723,7 +954,8 @@ DistributedLog_Startup(TransactionId oldestActiveXid,
 		/*
 		 * Clean the pg_distributedlog directory
 		 */
-		SimpleLruTruncateWithLock(DistributedLogCtl, currentPage);
+		for (bank = 0; bank < DistributedLogNumBanks; bank++)
+			SimpleLruTruncateWithLock(&DistributedLogCtlData[bank], currentPage);
 
 		do
 		{
@@ -751,22 +983,25 @@ DistributedLog_Startup(TransactionId oldestActiveXid,
 	{
 		int			entryno = TransactionIdToEntry(nextXid);
 		int			slotno;
+		SlruCtl		ctl = DistributedLogBankCtl(endPage);
 		DistributedLogEntry *ptr;
 		int			remainingEntries;
 
-		slotno = SimpleLruReadPage(DistributedLogCtl, endPage, true, nextXid);
-		ptr = (DistributedLogEntry *) DistributedLogCtl->shared->page_buffer[slotno];
+		slotno = SimpleLruReadPage(ctl, endPage, true, nextXid);
+		ptr = (DistributedLogEntry *) ctl->shared->page_buffer[slotno];
 		ptr += entryno;
 
 		/* Zero the rest of the page */
 		remainingEntries = ENTRIES_PER_PAGE - entryno;
 		MemSet(ptr, 0, remainingEntries * sizeof(DistributedLogEntry));
 
-		DistributedLogCtl->shared->page_dirty[slotno] = true;
+		ctl->shared->page_dirty[slotno] = true;
 	}
 
 	DistributedLog_InitOldestXmin();
 
+	for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		LWLockRelease(&DistributedLogBanks[bank].bank.lock);
 	LWLockRelease(DistributedLogControlLock);
 }
 
@@ -776,6 +1011,8 @@ DistributedLog_Startup(TransactionId oldestActiveXid,
 void
 DistributedLog_Shutdown(void)
 {
+	int			bank;
+
 	if (IS_QUERY_DISPATCHER())
 		return;
 
@@ -783,7 +1020,8 @@ DistributedLog_Shutdown(void)
 		 "DistributedLog_Shutdown");
 
 	/* Flush dirty DistributedLog pages to disk */
-	SimpleLruFlush(DistributedLogCtl, false);
+	for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		SimpleLruFlush(&DistributedLogCtlData[bank], false);
 }
 
 /*
@@ -792,6 +1030,8 @@ DistributedLog_Shutdown(void)
 void
 DistributedLog_CheckPoint(void)
 {
+	int			bank;
+
 	if (IS_QUERY_DISPATCHER())
 		return;
 
@@ -799,7 +1039,8 @@ DistributedLog_CheckPoint(void)
 		 "DistributedLog_CheckPoint");
 
 	/* Flush dirty DistributedLog pages to disk */
-	SimpleLruFlush(DistributedLogCtl, true);
+	for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		SimpleLruFlush(&DistributedLogCtlData[bank], true);
 }
 
 
@@ -815,6 +1056,7 @@ void
 DistributedLog_Extend(TransactionId newestXact)
 {
 	int			page;
+	LWLock	   *bankLock;
 
 	if (IS_QUERY_DISPATCHER())
 		return;
@@ -833,12 +1075,12 @@ DistributedLog_Extend(TransactionId newestXact)
 		 "DistributedLog_Extend page %d",
 		 page);
 
-	LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
+	bankLock = DistributedLog_LockBank(PageToBank(page), LW_EXCLUSIVE);
 
 	/* Zero the page and make an XLOG entry about it */
 	DistributedLog_ZeroPage(page, true);
 
-	LWLockRelease(DistributedLogControlLock);
+	LWLockRelease(bankLock);
 
 	elog((Debug_print_full_dtm ? LOG : DEBUG5),
 		 "DistributedLog_Extend with newest local xid = %d to page = %d",
@@ -873,6 +1115,7 @@ static void
 DistributedLog_Truncate(TransactionId oldestXmin)
 {
 	int			cutoffPage;
+	int			bank;
 
 	Assert(!IS_QUERY_DISPATCHER());
 
@@ -897,8 +1140,14 @@ DistributedLog_Truncate(TransactionId oldestXmin)
 	/* Write XLOG record and flush XLOG to disk */
 	DistributedLog_WriteTruncateXlogRec(cutoffPage);
 
-	/* Now we can remove the old DistributedLog segment(s) */
-	SimpleLruTruncate(DistributedLogCtl, cutoffPage);
+	/*
+	 * Now we can remove the old DistributedLog segment(s). Each bank drops
+	 * its own buffers of the old pages and then removes the old segments, so
+	 * one that a later bank writes back out on the way is removed again by
+	 * that bank.
+	 */
+	for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		SimpleLruTruncate(&DistributedLogCtlData[bank], cutoffPage);
 	LWLockRelease(DistributedLogTruncateLock);
 }
 
@@ -975,6 +1224,7 @@ DistributedLog_redo(XLogReaderState *record)
 	{
 		int			page;
 		int			slotno;
+		LWLock	   *bankLock;
 
 		memcpy(&page, XLogRecGetData(record), sizeof(int));
 
@@ -982,13 +1232,13 @@ DistributedLog_redo(XLogReaderState *record)
 			 "Redo DISTRIBUTEDLOG_ZEROPAGE page %d",
 			 page);
 
-		LWLockAcquire(DistributedLogControlLock, LW_EXCLUSIVE);
+		bankLock = DistributedLog_LockBank(PageToBank(page), LW_EXCLUSIVE);
 
 		slotno = DistributedLog_ZeroPage(page, false);
-		SimpleLruWritePage(DistributedLogCtl, slotno);
-		Assert(!DistributedLogCtl->shared->page_dirty[slotno]);
+		SimpleLruWritePage(DistributedLogBankCtl(page), slotno);
+		Assert(!DistributedLogBankCtl(page)->shared->page_dirty[slotno]);
 
-		LWLockRelease(DistributedLogControlLock);
+		LWLockRelease(bankLock);
 
 		elog((Debug_print_full_dtm ? LOG : DEBUG5),
 			 "DistributedLog_redo zero page = %d",
@@ -997,6 +1247,7 @@ DistributedLog_redo(XLogReaderState *record)
 	else if (info == DISTRIBUTEDLOG_TRUNCATE)
 	{
 		int			page;
+		int			bank;
 
 		memcpy(&page, XLogRecGetData(record), sizeof(int));
 
@@ -1008,9 +1259,10 @@ DistributedLog_redo(XLogReaderState *record)
 		 * During XLOG replay, latest_page_number isn't set up yet; insert
 		 * a suitable value to bypass the sanity test in SimpleLruTruncate.
 		 */
-		DistributedLogCtl->shared->latest_page_number = page;
+		DistributedLog_SetLatestPage(page);
 
-		SimpleLruTruncate(DistributedLogCtl, page);
+		for (bank = 0; bank < DistributedLogNumBanks; bank++)
+			SimpleLruTruncate(&DistributedLogCtlData[bank], page);
 
 		elog((Debug_print_full_dtm ? LOG : DEBUG5),
 			 "DistributedLog_redo truncate to cutoff page = %d",
@@ -1019,3 +1271,90 @@ DistributedLog_redo(XLogReaderState *record)
 	else
 		elog(PANIC, "DistributedLog_redo: unknown op code %u", info);
 }
+
+/*
+ * How often the lock of each bank of the distributed log was taken, and how
+ * often it had to be waited for. Returns no rows on the QD, which has no
+ * distributed log.
+ */
+Datum
+gp_distributedlog_stats(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* need to build tuplestore in query context */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/*
+	 * build tupdesc for result tuples. This must match the definition of the
+	 * gp_stat_distributedlog view in system_views.sql
+	 */
+	tupdesc = CreateTemplateTupleDesc(4, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "segid",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "bank",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "lock_acquires",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "lock_waits",
+					   INT8OID, -1, 0);
+
+	tupstore =
+		tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random,
+							  false, work_mem);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (!IS_QUERY_DISPATCHER())
+	{
+		int			bank;
+
+		/*
+		 * The counts of other backends are only seen once they flush them,
+		 * but at least include our own.
+		 */
+		for (bank = 0; bank < DistributedLogNumBanks; bank++)
+			DistributedLog_FlushBankStats(bank);
+
+		for (bank = 0; bank < DistributedLogNumBanks; bank++)
+		{
+			DistributedLogBank *b = &DistributedLogBanks[bank].bank;
+			Datum		values[4];
+			bool		nulls[4];
+
+			MemSet(nulls, 0, sizeof(nulls));
+
+			values[0] = Int32GetDatum(GpIdentity.segindex);
+			values[1] = Int32GetDatum(bank);
+			values[2] = Int64GetDatum((int64) pg_atomic_read_u64(&b->acquires));
+			values[3] = Int64GetDatum((int64) pg_atomic_read_u64(&b->waits));
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
@@ -462,13 +462,24 @@ SimpleLruReadPage(SlruCtl ctl, int pageno, bool write_ok,
  */
 int
 SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
+{
+	/* Try to find the page while holding only shared lock */
+	LWLockAcquire(ctl->shared->ControlLock, LW_SHARED);
+
+	return SimpleLruReadPage_ReadOnlyLocked(ctl, pageno, xid);
+}
+
+/*
+ * Like SimpleLruReadPage_ReadOnly, but the caller has already acquired the
+ * control lock in shared mode, so that it can keep track of how it got it.
+ * The lock is still held at exit, in shared or exclusive mode.
+ */
+int
+SimpleLruReadPage_ReadOnlyLocked(SlruCtl ctl, int pageno, TransactionId xid)
 {
 	SlruShared	shared = ctl->shared;
 	int			slotno;
 
-	/* Try to find the page while holding only shared lock */
-	LWLockAcquire(shared->ControlLock, LW_SHARED);
-
 	/* See if page is already in a buffer */
 	for (slotno = 0; slotno < shared->num_slots; slotno++)
 	{
@@ -18,6 +18,29 @@
 #define PageEntryToTransactionId(page, entry) \
 	((page) * (TransactionId) ENTRIES_PER_PAGE + (TransactionId) (entry))
 
+/* The tests run with a single bank */
+static DistributedLogBankPadded bank0;
+
+static void
+expect_lock_startup(void)
+{
+	DistributedLogBanks = &bank0;
+	DistributedLogExitRegistered = true;
+
+	expect_value(LWLockAcquire, lock, DistributedLogControlLock);
+	expect_value(LWLockAcquire, mode, LW_EXCLUSIVE);
+	will_return(LWLockAcquire, true);
+
+	expect_value(LWLockConditionalAcquire, lock, &bank0.bank.lock);
+	expect_value(LWLockConditionalAcquire, mode, LW_EXCLUSIVE);
+	will_return(LWLockConditionalAcquire, true);
+
+	expect_value(LWLockRelease, lock, &bank0.bank.lock);
+	will_be_called(LWLockRelease);
+	expect_value(LWLockRelease, lock, DistributedLogControlLock);
+	will_be_called(LWLockRelease);
+}
+
 /*
  * A bug found in MPP-20426 was we were overrunnig to the next page
  * of DistributedLog.  The intention of the memset with zeors is to
@@ -54,9 +77,7 @@ MPP_20426(void **state, TransactionId nextXid)
 	memset(pages, 0x7f, sizeof(pages));
 	memset(zeros, 0, sizeof(zeros));
 
-	expect_value(LWLockAcquire, lock, DistributedLogControlLock);
-	expect_value(LWLockAcquire, mode, LW_EXCLUSIVE);
-	will_return(LWLockAcquire, true);
+	expect_lock_startup();
 
 	/* This test is only for the case xid is not on the boundary. */
 	expect_value(SimpleLruDoesPhysicalPageExist, ctl, DistributedLogCtl);
@@ -69,9 +90,6 @@ MPP_20426(void **state, TransactionId nextXid)
 	expect_value(SimpleLruReadPage, xid, nextXid);
 	will_return(SimpleLruReadPage, 0);
 
-	expect_value(LWLockRelease, lock, DistributedLogControlLock);
-	will_be_called(LWLockRelease);
-
 	/* Run the function. */
 	DistributedLog_Startup(nextXid, nextXid);
 
@@ -110,9 +128,7 @@ setup(TransactionId nextXid)
 	DistributedLogCtl->shared->page_buffer[0] = &pages[0];
 	memset(pages, 0x7f, sizeof(char) * BLCKSZ);
 
-	expect_value(LWLockAcquire, lock, DistributedLogControlLock);
-	expect_value(LWLockAcquire, mode, LW_EXCLUSIVE);
-	will_be_called(LWLockAcquire);
+	expect_lock_startup();
 
 	/*
 	 * Map every page to buffer 0; we're only testing that the correct calls are
@@ -127,9 +143,6 @@ setup(TransactionId nextXid)
 	expect_any(SimpleLruReadPage, write_ok);
 	expect_value(SimpleLruReadPage, xid, nextXid);
 	will_return(SimpleLruReadPage, 0);
-
-	expect_value(LWLockRelease, lock, DistributedLogControlLock);
-	will_be_called(LWLockRelease);
 }
 
 static void
@@ -300,6 +313,103 @@ test_ConvertMasterDataDirToSegmentZeroesOutDistributedLogWithTransactionIdWrapar
 	ConvertMasterDataDirToSegment = false;
 }
 
+/*
+ * With more than one bank, a page is looked up in the SLRU of its own bank,
+ * under the lock of that bank, and the lock counts go to that bank.
+ */
+static void
+expect_committed_check(int bank, int page, TransactionId xid, bool wait)
+{
+	DistributedLogBank *b = &DistributedLogBanks[bank].bank;
+
+	expect_value(LWLockAcquire, lock, DistributedLogTruncateLock);
+	expect_value(LWLockAcquire, mode, LW_SHARED);
+	will_return(LWLockAcquire, true);
+
+	expect_value(LWLockConditionalAcquire, lock, &b->lock);
+	expect_value(LWLockConditionalAcquire, mode, LW_SHARED);
+	will_return(LWLockConditionalAcquire, !wait);
+	if (wait)
+	{
+		expect_value(LWLockAcquire, lock, &b->lock);
+		expect_value(LWLockAcquire, mode, LW_SHARED);
+		will_return(LWLockAcquire, true);
+	}
+
+	expect_value(SimpleLruReadPage_ReadOnlyLocked, ctl, &DistributedLogCtlData[bank]);
+	expect_value(SimpleLruReadPage_ReadOnlyLocked, pageno, page);
+	expect_value(SimpleLruReadPage_ReadOnlyLocked, xid, xid);
+	will_return(SimpleLruReadPage_ReadOnlyLocked, 0);
+
+	expect_value(LWLockRelease, lock, &b->lock);
+	will_be_called(LWLockRelease);
+	expect_value(LWLockRelease, lock, DistributedLogTruncateLock);
+	will_be_called(LWLockRelease);
+}
+
+static void
+test_DistributedLog_EachBankHasItsOwnLock(void **state)
+{
+	DistributedLogBankPadded banks[3];
+	SlruSharedData shared[3];
+	char		pages[3][BLCKSZ];
+	char	   *page_buffers[3];
+	DistributedLogShmem dls;
+	DistributedTransactionTimeStamp distribTimeStamp;
+	DistributedTransactionId distribXid;
+	int			saved_segindex;
+	int			page;
+	int			bank;
+
+	memset(banks, 0, sizeof(banks));
+	memset(pages, 0, sizeof(pages));
+	for (bank = 0; bank < 3; bank++)
+	{
+		pg_atomic_init_u64(&banks[bank].bank.acquires, 0);
+		pg_atomic_init_u64(&banks[bank].bank.waits, 0);
+		page_buffers[bank] = pages[bank];
+		shared[bank].page_buffer = &page_buffers[bank];
+		DistributedLogCtlData[bank].shared = &shared[bank];
+	}
+	DistributedLogBanks = banks;
+	DistributedLogNumBanks = 3;
+	DistributedLogExitRegistered = true;
+	MemSet(DistributedLogLocalStats, 0, sizeof(DistributedLogLocalStats));
+
+	dls.oldestXmin = FirstNormalTransactionId;
+	DistributedLogShared = &dls;
+	saved_segindex = GpIdentity.segindex;
+	GpIdentity.segindex = 0;
+
+	/* pages 1 to 4 are in banks 1, 2, 0 and 1 */
+	for (page = 1; page <= 4; page++)
+	{
+		TransactionId xid = PageEntryToTransactionId(page, 1);
+
+		expect_committed_check(page % 3, page, xid, page == 4);
+		DistributedLog_CommittedCheck(xid, &distribTimeStamp, &distribXid);
+	}
+
+	assert_int_equal(DistributedLogLocalStats[0].acquires, 1);
+	assert_int_equal(DistributedLogLocalStats[1].acquires, 2);
+	assert_int_equal(DistributedLogLocalStats[2].acquires, 1);
+	assert_int_equal(DistributedLogLocalStats[0].waits, 0);
+	assert_int_equal(DistributedLogLocalStats[1].waits, 1);
+	assert_int_equal(DistributedLogLocalStats[2].waits, 0);
+
+	/* the shared counts of each bank only change when they're flushed */
+	assert_int_equal(pg_atomic_read_u64(&banks[1].bank.acquires), 0);
+	AtProcExit_DistributedLog(0, (Datum) 0);
+	assert_int_equal(pg_atomic_read_u64(&banks[0].bank.acquires), 1);
+	assert_int_equal(pg_atomic_read_u64(&banks[1].bank.acquires), 2);
+	assert_int_equal(pg_atomic_read_u64(&banks[1].bank.waits), 1);
+	assert_int_equal(pg_atomic_read_u64(&banks[2].bank.acquires), 1);
+	assert_int_equal(DistributedLogLocalStats[1].acquires, 0);
+
+	DistributedLogNumBanks = 1;
+	GpIdentity.segindex = saved_segindex;
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -312,7 +422,8 @@ main(int argc, char* argv[])
 		unit_test(test_BinaryUpgradeZeroesOutDistributedLogFittingOnSinglePage),
 		unit_test(test_ConvertMasterDataDirToSegmentZeroesOutDistributedLogWithTransactionIdWraparound),
 		unit_test(test_ConvertMasterDataDirToSegmentZeroesOutDistributedLogFittingOnThreePages),
-		unit_test(test_ConvertMasterDataDirToSegmentZeroesOutDistributedLogFittingOnSinglePage)
+		unit_test(test_ConvertMasterDataDirToSegmentZeroesOutDistributedLogFittingOnSinglePage),
+		unit_test(test_DistributedLog_EachBankHasItsOwnLock)
 	};
 	return run_tests(tests);
 }
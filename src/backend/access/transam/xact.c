@@ -451,18 +451,28 @@ IsAbortedTransactionBlockState(void)
 	return false;
 }
 
+/*
+ * Did the transaction write anything, at any nesting level?  A QE reports
+ * this to the QD after each command, to decide whether it must take part in
+ * two-phase commit.  Any write assigns an xid to the top transaction, even
+ * to a temporary or unlogged table that doesn't write WAL, and such writes
+ * must commit atomically with the rest of the distributed transaction too.
+ */
 bool
 TransactionDidWriteXLog(void)
 {
-	TransactionState s = CurrentTransactionState;
-	return s->didLogXid;
+	return TransactionIdIsValid(TopTransactionStateData.transactionId);
 }
 
+/*
+ * Did any QE write WAL in the transaction, at any nesting level?  Kept in
+ * the top transaction state, so that a write done in a subtransaction on
+ * the QD still counts at commit.
+ */
 bool
 ExecutorDidWriteXLog(void)
 {
-	TransactionState s = CurrentTransactionState;
-	return s->executorDidWriteXLog;
+	return TopTransactionStateData.executorDidWriteXLog;
 }
 
 void
@@ -548,9 +558,9 @@ MarkCurrentTransactionIdLoggedIfAny(void)
 }
 
 void
-MarkCurrentTransactionWriteXLogOnExecutor(void)
+MarkTopTransactionWriteXLogOnExecutor(void)
 {
-	CurrentTransactionState->executorDidWriteXLog = true;
+	TopTransactionStateData.executorDidWriteXLog = true;
 }
 
 /*
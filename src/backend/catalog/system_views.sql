@@ -1289,6 +1289,62 @@ CREATE VIEW pg_stat_bgwriter AS
         pg_stat_get_buf_alloc() AS buffers_alloc,
         pg_stat_get_bgwriter_stat_reset_time() AS stats_reset;
 
+CREATE VIEW gp_stat_optimizer_mdcache AS
+    SELECT
+        s.entries,
+        s.hits,
+        s.fetches,
+        s.evictions,
+        s.resets
+    FROM gp_optimizer_mdcache_stats() s;
+
+CREATE VIEW gp_stat_optimizer_mdcache_shared AS
+    SELECT
+        s.entries,
+        s.size,
+        s.used,
+        s.hits,
+        s.misses,
+        s.inserts,
+        s.rejects
+    FROM gp_optimizer_mdcache_shared_stats() s;
+
+CREATE VIEW gp_stat_optimizer_profile AS
+    SELECT
+        s.optimizations,
+        s.total_time,
+        s.query_to_dxl_time,
+        s.search_time,
+        s.dxl_to_plstmt_time,
+        s.md_fetch_time,
+        s.object_fetches,
+        s.relstats_fetches,
+        s.colstats_fetches,
+        s.cast_fetches,
+        s.comparison_fetches,
+        s.shared_md_hits,
+        s.allocations,
+        s.bytes_allocated
+    FROM gp_optimizer_profile_stats() s;
+
+CREATE VIEW gp_stat_optimizer_plan_cache AS
+    SELECT
+        s.name,
+        s.lookups,
+        s.hits,
+        s.cached_plans,
+        s.planning_time,
+        s.saved_time
+    FROM gp_optimizer_plan_cache_stats() s;
+
+CREATE VIEW gp_stat_distributedlog AS
+    SELECT
+        s.segid,
+        s.bank,
+        s.lock_acquires,
+        s.lock_waits
+    FROM gp_distributedlog_stats() s;
+
 CREATE VIEW pg_stat_progress_vacuum AS
 	SELECT
 		S.pid AS pid, S.datid AS datid, D.datname AS datname,
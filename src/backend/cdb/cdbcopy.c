@@ -38,6 +38,10 @@
  *
  * cdbCopyGetData() and cdbCopySendData() call libpq's PQgetCopyData() and
  * PQputCopyData(), respectively. If an error occurs, it is thrown with ereport().
+ * cdbCopySendData() collects the rows for each segment into chunks of
+ * COPYIN_CHUNK_SIZE bytes, so that the QD makes one libpq call, and the QE
+ * reads one message, per chunk rather than per row. cdbCopyEnd() sends what
+ * is left.
  *
  * When you're done, call cdbCopyEnd().
  *
@@ -53,6 +57,7 @@
 
 #include "postgres.h"
 #include "miscadmin.h"
+#include "access/xact.h"
 #include "libpq-fe.h"
 #include "libpq-int.h"
 #include "cdb/cdbconn.h"
@@ -77,6 +82,9 @@
 static void cdbCopyEndInternal(CdbCopy *c, char *abort_msg,
 				   int64 *total_rows_completed_p,
 				   int64 *total_rows_rejected_p);
+static void cdbCopyPutData(CdbCopy *c, int target_seg, const char *buffer,
+			   int nbytes);
+static void cdbCopyFlushData(CdbCopy *c);
 
 static Gang *
 getCdbCopyPrimaryGang(CdbCopy *c)
@@ -107,6 +115,7 @@ makeCdbCopy(CopyState cstate, bool is_copy_in)
 	c->copy_in = is_copy_in;
 	c->seglist = NIL;
 	c->dispatcherState = NULL;
+	c->copy_in_bufs = NULL;
 	initStringInfo(&(c->copy_out_buf));
 
 	/* init total_segs */
@@ -131,6 +140,15 @@ makeCdbCopy(CopyState cstate, bool is_copy_in)
 			c->seglist = lappend_int(c->seglist, i);
 	}
 
+	if (is_copy_in)
+	{
+		int			i;
+
+		c->copy_in_bufs = palloc(c->total_segs * sizeof(StringInfoData));
+		for (i = 0; i < c->total_segs; i++)
+			initStringInfo(&c->copy_in_bufs[i]);
+	}
+
 	cstate->cdbCopy = c;
 
 	return c;
@@ -233,10 +251,58 @@ cdbCopySendDataToAll(CdbCopy *c, const char *buffer, int nbytes)
 /*
  * sends data to a copy command on a specific segment (usually
  * the hash result of the data value).
+ *
+ * The data is only queued up here; it goes out once a chunk's worth has
+ * been queued for the segment, or at cdbCopyEnd().
  */
 void
 cdbCopySendData(CdbCopy *c, int target_seg, const char *buffer,
 				int nbytes)
+{
+	StringInfo	buf;
+
+	Assert(target_seg >= 0 && target_seg < c->total_segs);
+	buf = &c->copy_in_bufs[target_seg];
+
+	if (buf->len > 0 && buf->len + nbytes > COPYIN_CHUNK_SIZE)
+	{
+		cdbCopyPutData(c, target_seg, buf->data, buf->len);
+		resetStringInfo(buf);
+	}
+
+	/* a big row wouldn't fit in a chunk anyway */
+	if (nbytes >= COPYIN_CHUNK_SIZE)
+		cdbCopyPutData(c, target_seg, buffer, nbytes);
+	else
+		appendBinaryStringInfo(buf, buffer, nbytes);
+}
+
+/*
+ * send the data queued up for each segment
+ */
+static void
+cdbCopyFlushData(CdbCopy *c)
+{
+	int			seg;
+
+	if (!c->copy_in_bufs)
+		return;
+
+	for (seg = 0; seg < c->total_segs; seg++)
+	{
+		StringInfo	buf = &c->copy_in_bufs[seg];
+
+		if (buf->len > 0)
+		{
+			cdbCopyPutData(c, seg, buf->data, buf->len);
+			resetStringInfo(buf);
+		}
+	}
+}
+
+static void
+cdbCopyPutData(CdbCopy *c, int target_seg, const char *buffer,
+			   int nbytes)
 {
 	SegmentDatabaseDescriptor *q;
 	Gang	   *gp;
@@ -425,6 +491,9 @@ cdbCopyEnd(CdbCopy *c,
 {
 	CHECK_FOR_INTERRUPTS();
 
+	if (getCdbCopyPrimaryGang(c))
+		cdbCopyFlushData(c);
+
 	cdbCopyEndInternal(c, NULL,
 					   total_rows_completed_p,
 					   total_rows_rejected_p);
@@ -643,6 +712,13 @@ cdbCopyEndInternal(CdbCopy *c, char *abort_msg,
 		}
 		RESUME_INTERRUPTS();
 
+		/* Remember whether the segment wrote WAL, for the commit protocol */
+		if (PQstatus(q->conn) != CONNECTION_BAD && q->conn->wrote_xlog)
+		{
+			MarkTopTransactionWriteXLogOnExecutor();
+			markGxactSegmentWroteXLog(q->segindex);
+		}
+
 		/*
 		 * add up the number of rows completed and rejected from this segment
 		 * to the totals. Only count from primary segs.
@@ -23,11 +23,84 @@
 #include "utils/snapmgr.h"
 #include "storage/procarray.h"
 
+#define DSLM_MEMO_SLOT(localXid) ((localXid) & (DSLM_RESULT_MEMO_SIZE - 1))
+
+static DistributedSnapshotCommitted DistributedSnapshotWithLocalMapping_Evaluate(
+												  DistributedSnapshotWithLocalMapping *dslm,
+												  TransactionId localXid,
+												  bool isVacuumCheck);
+
+/*
+ * Binary search the sorted local xid cache. Returns the index of localXid,
+ * or, if it isn't there, ~ the index where it would be inserted.
+ */
+static int
+FindCachedLocalXid(DistributedSnapshotWithLocalMapping *dslm,
+				   TransactionId localXid)
+{
+	int			low = 0;
+	int			high = dslm->currentLocalXidsCount - 1;
+
+	while (low <= high)
+	{
+		int			mid = (low + high) / 2;
+		TransactionId midXid = dslm->inProgressMappedLocalXids[mid];
+
+		if (TransactionIdEquals(localXid, midXid))
+			return mid;
+		if (TransactionIdPrecedes(localXid, midXid))
+			high = mid - 1;
+		else
+			low = mid + 1;
+	}
+
+	return ~low;
+}
+
+/*
+ * Binary search ds->inProgressXidArray, which CreateDistributedSnapshot()
+ * sorts in ascending order.
+ */
+static bool
+DistributedXidIsInProgress(DistributedSnapshot *ds,
+						   DistributedTransactionId distribXid)
+{
+	int			low = 0;
+	int			high = ds->count - 1;
+
+	while (low <= high)
+	{
+		int			mid = (low + high) / 2;
+
+		if (distribXid == ds->inProgressXidArray[mid])
+			return true;
+		if (distribXid < ds->inProgressXidArray[mid])
+			high = mid - 1;
+		else
+			low = mid + 1;
+	}
+
+	return false;
+}
+
+/*
+ * Forget the memoized results, when the distributed snapshot changes.
+ */
+void
+DistributedSnapshotWithLocalMapping_ResetMemo(DistributedSnapshotWithLocalMapping *dslm)
+{
+	MemSet(dslm->memoLocalXids, 0, sizeof(dslm->memoLocalXids));
+}
+
 /*
  * DistributedSnapshotWithLocalMapping_CommittedTest
  *		Is the given XID still-in-progress according to the
  *      distributed snapshot?  Or, is the transaction strictly local
  *      and needs to be tested with the local snapshot?
+ *
+ * The answer for a given XID doesn't change for the life of the snapshot,
+ * unless the distributed log doesn't know the XID yet, so it is memoized.
+ * Vacuum checks see a different answer and bypass the memo.
  */
 DistributedSnapshotCommitted
 DistributedSnapshotWithLocalMapping_CommittedTest(
@@ -35,9 +108,8 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 												  TransactionId localXid,
 												  bool isVacuumCheck)
 {
-	DistributedSnapshot *ds = &dslm->ds;
-	uint32		i;
-	DistributedTransactionId distribXid = InvalidDistributedTransactionId;
+	DistributedSnapshotCommitted result;
+	int			slot;
 
 	Assert(!IS_QUERY_DISPATCHER());
 
@@ -48,10 +120,37 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 	if (!TransactionIdIsNormal(localXid))
 		return DISTRIBUTEDSNAPSHOT_COMMITTED_IGNORE;
 
+	if (isVacuumCheck)
+		return DistributedSnapshotWithLocalMapping_Evaluate(dslm, localXid, true);
+
+	slot = DSLM_MEMO_SLOT(localXid);
+	if (TransactionIdEquals(dslm->memoLocalXids[slot], localXid))
+		return (DistributedSnapshotCommitted) dslm->memoResults[slot];
+
+	result = DistributedSnapshotWithLocalMapping_Evaluate(dslm, localXid, false);
+
+	if (result != DISTRIBUTEDSNAPSHOT_COMMITTED_UNKNOWN)
+	{
+		dslm->memoLocalXids[slot] = localXid;
+		dslm->memoResults[slot] = (uint8) result;
+	}
+
+	return result;
+}
+
+static DistributedSnapshotCommitted
+DistributedSnapshotWithLocalMapping_Evaluate(
+											 DistributedSnapshotWithLocalMapping *dslm,
+											 TransactionId localXid,
+											 bool isVacuumCheck)
+{
+	DistributedSnapshot *ds = &dslm->ds;
+	DistributedTransactionId distribXid = InvalidDistributedTransactionId;
+
 	/*
-	 * Checking the distributed committed log can be expensive, so make a scan
-	 * through our cache in distributed snapshot looking for a possible
-	 * corresponding local xid only if it has value in checking.
+	 * Checking the distributed committed log can be expensive, so search
+	 * our cache in distributed snapshot for a possible corresponding local
+	 * xid only if it has value in checking.
 	 */
 	if (dslm->currentLocalXidsCount > 0)
 	{
@@ -65,16 +164,10 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		}
 
 		if (TransactionIdFollows(localXid, dslm->minCachedLocalXid) &&
-			TransactionIdPrecedes(localXid, dslm->maxCachedLocalXid))
+			TransactionIdPrecedes(localXid, dslm->maxCachedLocalXid) &&
+			FindCachedLocalXid(dslm, localXid) >= 0)
 		{
-			for (i = 0; i < dslm->currentLocalXidsCount; i++)
-			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
-				Assert(TransactionIdIsValid(dslm->inProgressMappedLocalXids[i]));
-
-				if (TransactionIdEquals(localXid, dslm->inProgressMappedLocalXids[i]))
-					return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
-			}
+			return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 		}
 	}
 
@@ -181,45 +274,34 @@ DistributedSnapshotWithLocalMapping_CommittedTest(
 		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
-	for (i = 0; i < ds->count; i++)
+	if (DistributedXidIsInProgress(ds, distribXid))
 	{
-		if (distribXid == ds->inProgressXidArray[i])
+		/*
+		 * Save the relationship to the local xid so we may avoid checking
+		 * the distributed committed log in a subsequent check. We can only
+		 * record local xids till cache size permits.
+		 */
+		if (dslm->currentLocalXidsCount < ds->count)
 		{
-			/*
-			 * Save the relationship to the local xid so we may avoid checking
-			 * the distributed committed log in a subsequent check. We can
-			 * only record local xids till cache size permits.
-			 */
-			if (dslm->currentLocalXidsCount < ds->count)
+			int			pos = FindCachedLocalXid(dslm, localXid);
+
+			Assert(dslm->inProgressMappedLocalXids != NULL);
+			if (pos < 0)
 			{
-				Assert(dslm->inProgressMappedLocalXids != NULL);
-				dslm->inProgressMappedLocalXids[dslm->currentLocalXidsCount++] =
-					localXid;
-
-				if (!TransactionIdIsValid(dslm->minCachedLocalXid) ||
-					TransactionIdPrecedes(localXid, dslm->minCachedLocalXid))
-				{
-					dslm->minCachedLocalXid = localXid;
-				}
-
-				if (!TransactionIdIsValid(dslm->maxCachedLocalXid) ||
-					TransactionIdFollows(localXid, dslm->maxCachedLocalXid))
-				{
-					dslm->maxCachedLocalXid = localXid;
-				}
+				pos = ~pos;
+				memmove(&dslm->inProgressMappedLocalXids[pos + 1],
+						&dslm->inProgressMappedLocalXids[pos],
+						(dslm->currentLocalXidsCount - pos) * sizeof(TransactionId));
+				dslm->inProgressMappedLocalXids[pos] = localXid;
+				dslm->currentLocalXidsCount++;
 			}
 
-			return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
+			dslm->minCachedLocalXid = dslm->inProgressMappedLocalXids[0];
+			dslm->maxCachedLocalXid =
+				dslm->inProgressMappedLocalXids[dslm->currentLocalXidsCount - 1];
 		}
 
-		/*
-		 * Leverage the fact that ds->inProgressXidArray is sorted in
-		 * ascending order based on distribXid while creating the snapshot in
-		 * CreateDistributedSnapshot(). So, can fail fast once known are
-		 * lower than rest of them.
-		 */
-		if (distribXid < ds->inProgressXidArray[i])
-			break;
+		return DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS;
 	}
 
 	/*
@@ -76,7 +76,7 @@ doNotifyCommittedInDoubt(char *gid)
 	succeeded = doDispatchDtxProtocolCommand(DTX_PROTOCOL_COMMAND_RECOVERY_COMMIT_PREPARED,
 											 gid,
 											 NULL, /* raiseError */ false,
-											 cdbcomponent_getCdbComponentsList(), NULL, 0);
+											 cdbcomponent_getCdbComponentsList(), NIL, NULL, 0);
 	if (!succeeded)
 		elog(FATAL, "Crash recovery broadcast of the distributed transaction "
 			 		"'Commit Prepared' broadcast failed to one or more segments for gid = %s.", gid);
@@ -96,7 +96,7 @@ doAbortInDoubt(char *gid)
 	succeeded = doDispatchDtxProtocolCommand(DTX_PROTOCOL_COMMAND_RECOVERY_ABORT_PREPARED,
 											 gid,
 											 NULL, /* raiseError */ false,
-											 cdbcomponent_getCdbComponentsList(), NULL, 0);
+											 cdbcomponent_getCdbComponentsList(), NIL, NULL, 0);
 	if (!succeeded)
 		elog(FATAL, "Crash recovery retry of the distributed transaction "
 			 		"'Abort Prepared' broadcast failed to one or more segments "
@@ -112,6 +112,7 @@ int	max_tm_gxacts = 100;
  */
 static void clearAndResetGxact(void);
 static void doPrepareTransaction(void);
+static int	numGxactWriterSegments(void);
 static void doInsertForgetCommitted(void);
 static void doNotifyingOnePhaseCommit(void);
 static void doNotifyingCommitPrepared(void);
@@ -405,7 +406,7 @@ doDispatchSubtransactionInternalCmd(DtxProtocolCommand cmdType)
 	succeeded = doDispatchDtxProtocolCommand(cmdType,
 											 gid,
 											 NULL, /* raiseError */ true,
-											 cdbcomponent_getCdbComponentsList(),
+											 cdbcomponent_getCdbComponentsList(), NIL,
 											 serializedDtxContextInfo, serializedDtxContextInfoLen);
 
 	/* send a DTM command to others to tell them about the transaction */
@@ -422,6 +423,11 @@ static void
 doPrepareTransaction(void)
 {
 	bool		succeeded;
+	char		gid[TMGIDSIZE];
+	List	   *writerSegments = NIL;
+	List	   *readOnlySegments = NIL;
+	MemoryContext oldContext;
+	ListCell   *lc;
 
 	CHECK_FOR_INTERRUPTS();
 
@@ -439,8 +445,32 @@ doPrepareTransaction(void)
 
 	elog(DTM_DEBUG5, "doPrepareTransaction moved to state = %s", DtxStateToString(MyTmGxactLocal->state));
 
+	/*
+	 * A segment whose QE didn't write, that is, never assigned an xid, has
+	 * nothing to prepare. Tell it to commit right away instead, in the same
+	 * round trip, so that it can be left out of the second phase.
+	 */
 	Assert(MyTmGxactLocal->twophaseSegments != NIL);
-	succeeded = currentDtxDispatchProtocolCommand(DTX_PROTOCOL_COMMAND_PREPARE, true);
+	oldContext = MemoryContextSwitchTo(TopTransactionContext);
+	foreach(lc, MyTmGxactLocal->twophaseSegments)
+	{
+		int			segindex = lfirst_int(lc);
+
+		if (!gp_dtx_skip_readonly_segments ||
+			bms_is_member(segindex, MyTmGxactLocal->xlogSegmentsMap))
+			writerSegments = lappend_int(writerSegments, segindex);
+		else
+			readOnlySegments = lappend_int(readOnlySegments, segindex);
+	}
+	MemoryContextSwitchTo(oldContext);
+	Assert(writerSegments != NIL);
+
+	dtxFormGID(gid, getDistributedTransactionTimestamp(), getDistributedTransactionId());
+	succeeded = doDispatchDtxProtocolCommand(DTX_PROTOCOL_COMMAND_PREPARE, gid,
+											 &MyTmGxactLocal->badPrepareGangs,
+											 /* raiseError */ true,
+											 MyTmGxactLocal->twophaseSegments,
+											 readOnlySegments, NULL, 0);
 
 	/*
 	 * Now we've cleaned up our dispatched statement, cancels are allowed
@@ -448,6 +478,10 @@ doPrepareTransaction(void)
 	 */
 	RESUME_INTERRUPTS();
 
+	/*
+	 * On failure, keep every segment in the list: the abort must reach the
+	 * writers, and the read-only ones that already committed ignore it.
+	 */
 	if (!succeeded)
 	{
 		elog(DTM_DEBUG5, "doPrepareTransaction error finds badPrimaryGangs = %s",
@@ -461,6 +495,9 @@ doPrepareTransaction(void)
 			(errmsg("The distributed transaction 'Prepare' broadcast succeeded to the segments"),
 			TM_ERRDETAIL));
 
+	/* Only the segments that prepared take part in the second phase. */
+	MyTmGxactLocal->twophaseSegments = writerSegments;
+
 	Assert(MyTmGxactLocal->state == DTX_STATE_PREPARING);
 	setCurrentDtxState(DTX_STATE_PREPARED);
 
@@ -867,6 +904,7 @@ prepareDtxTransaction(void)
 {
 	TransactionId xid = GetTopTransactionIdIfAny();
 	bool		markXidCommitted = TransactionIdIsValid(xid);
+	int			nwriters;
 
 	if (DistributedTransactionContext != DTX_CONTEXT_QD_DISTRIBUTED_CAPABLE)
 	{
@@ -885,13 +923,17 @@ prepareDtxTransaction(void)
 	}
 
 	/*
-	 * If only one segment was involved in the transaction, and no local XID
+	 * If at most one segment wrote in the transaction, and no local XID
 	 * has been assigned on the QD either, we can perform one-phase commit
-	 * on that one segment. Otherwise, broadcast PREPARE TRANSACTION to the
+	 * on the segments. Otherwise, broadcast PREPARE TRANSACTION to the
 	 * segments.
 	 */
-	if (!ExecutorDidWriteXLog() ||
-	    (!markXidCommitted && list_length(MyTmGxactLocal->twophaseSegments) < 2))
+	if (gp_dtx_skip_readonly_segments)
+		nwriters = numGxactWriterSegments();
+	else
+		nwriters = list_length(MyTmGxactLocal->twophaseSegments);
+	if (!ExecutorDidWriteXLog() || nwriters == 0 ||
+	    (!markXidCommitted && nwriters < 2))
 	{
 		setCurrentDtxState(DTX_STATE_ONE_PHASE_COMMIT);
 		return;
@@ -1216,7 +1258,7 @@ currentDtxDispatchProtocolCommand(DtxProtocolCommand dtxProtocolCommand, bool ra
 
 	dtxFormGID(gid, getDistributedTransactionTimestamp(), getDistributedTransactionId());
 	return doDispatchDtxProtocolCommand(dtxProtocolCommand, gid, badgang, raiseError,
-										MyTmGxactLocal->twophaseSegments, NULL, 0);
+										MyTmGxactLocal->twophaseSegments, NIL, NULL, 0);
 }
 
 bool
@@ -1224,6 +1266,7 @@ doDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 							 char *gid,
 							 bool *badGangs, bool raiseError,
 							 List *twophaseSegments,
+							 List *readOnlySegments,
 							 char *serializedDtxContextInfo,
 							 int serializedDtxContextInfoLen)
 {
@@ -1255,6 +1298,7 @@ doDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 											dtxProtocolCommandStr,
 											gid,
 											&qeError, &resultCount, badGangs, twophaseSegments,
+											readOnlySegments,
 											serializedDtxContextInfo, serializedDtxContextInfoLen);
 
 	if (qeError)
@@ -1406,6 +1450,7 @@ resetGxact()
 	MyTmGxactLocal->writerGangLost = false;
 	MyTmGxactLocal->twophaseSegmentsMap = NULL;
 	MyTmGxactLocal->twophaseSegments = NIL;
+	MyTmGxactLocal->xlogSegmentsMap = NULL;
 	MyTmGxactLocal->isOnePhaseCommit = false;
 	setCurrentDtxState(DTX_STATE_NONE);
 }
@@ -2363,3 +2408,47 @@ addToGxactTwophaseSegments(Gang *gang)
 	}
 	MemoryContextSwitchTo(oldContext);
 }
+
+/*
+ * Record that the QE on a segment reported writing in the current
+ * transaction, i.e. that it has an xid. Segments that didn't are committed
+ * without preparing.
+ */
+void
+markGxactSegmentWroteXLog(int segindex)
+{
+	MemoryContext oldContext;
+
+	if (!isCurrentDtxTwoPhaseActivated())
+		return;
+
+	/* entry db is just a reader */
+	if (segindex == -1)
+		return;
+
+	if (bms_is_member(segindex, MyTmGxactLocal->xlogSegmentsMap))
+		return;
+
+	oldContext = MemoryContextSwitchTo(TopTransactionContext);
+	MyTmGxactLocal->xlogSegmentsMap =
+		bms_add_member(MyTmGxactLocal->xlogSegmentsMap, segindex);
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * Number of segments in the two phase commit that wrote.
+ */
+static int
+numGxactWriterSegments(void)
+{
+	ListCell   *lc;
+	int			count = 0;
+
+	foreach(lc, MyTmGxactLocal->twophaseSegments)
+	{
+		if (bms_is_member(lfirst_int(lc), MyTmGxactLocal->xlogSegmentsMap))
+			count++;
+	}
+
+	return count;
+}
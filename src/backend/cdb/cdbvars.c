@@ -81,6 +81,8 @@ bool		gp_external_enable_exec = true; /* allow ext tables with EXECUTE */
 
 bool		verify_gpfdists_cert; /* verifies gpfdist's certificate */
 
+bool		gpfdist_compression;	/* compress data exchanged with gpfdist */
+
 int			gp_external_max_segs;	/* max segdbs per gpfdist/gpfdists URI */
 
 int			gp_safefswritesize; /* set for safe AO writes in non-mature fs */
@@ -33,6 +33,7 @@
 #include "libpq-int.h"
 #include "cdb/cdbfts.h"
 #include "cdb/cdbgang.h"
+#include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
 #include "cdb/cdbpq.h"
 #include "miscadmin.h"
@@ -892,6 +893,16 @@ processResults(CdbDispatchResult *dispatchResult)
 		ELOG_DISPATCHER_DEBUG("PQgetResult");
 		pRes = PQgetResult(segdbDesc->conn);
 
+		/*
+		 * The QE reports whether it wrote anything right before ReadyForQuery,
+		 * which may arrive after the last result, so check again at the end.
+		 */
+		if (segdbDesc->conn->wrote_xlog)
+		{
+			MarkTopTransactionWriteXLogOnExecutor();
+			markGxactSegmentWroteXLog(segdbDesc->segindex);
+		}
+
 		/*
 		 * Command is complete when PGgetResult() returns NULL. It is critical
 		 * that for any connection that had an asynchronous command sent thru
@@ -906,9 +917,6 @@ processResults(CdbDispatchResult *dispatchResult)
 			return true;
 		}
 
-		if (segdbDesc->conn->wrote_xlog)
-			MarkCurrentTransactionWriteXLogOnExecutor();
-
 		/*
 		 * Attach the PGresult object to the CdbDispatchResult object.
 		 */
@@ -40,6 +40,7 @@ typedef struct DispatchCommandDtxProtocolParms
 	char		gid[TMGIDSIZE];
 	char	   *serializedDtxContextInfo;
 	int			serializedDtxContextInfoLen;
+	List	   *readOnlySegments;
 } DispatchCommandDtxProtocolParms;
 
 /*
@@ -57,6 +58,9 @@ static char *buildGpDtxProtocolCommand(DispatchCommandDtxProtocolParms *pDtxProt
  * CdbDispatchDtxProtocolCommand:
  * Sends a non-cancelable command to all segment dbs
  *
+ * For PREPARE, readOnlySegments lists the segments that did not write WAL;
+ * they commit in one phase instead of preparing.
+ *
  * Returns a malloc'ed array containing the PGresult objects thus
  * produced; the caller must PQclear() them and free() the array.
  * A NULL entry follows the last used entry in the array.
@@ -72,6 +76,7 @@ CdbDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 							  int *numresults,
 							  bool *badGangs,
 							  List *twophaseSegments,
+							  List *readOnlySegments,
 							  char *serializedDtxContextInfo,
 							  int serializedDtxContextInfoLen)
 {
@@ -94,6 +99,7 @@ CdbDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 	memcpy(dtxProtocolParms.gid, gid, TMGIDSIZE);
 	dtxProtocolParms.serializedDtxContextInfo = serializedDtxContextInfo;
 	dtxProtocolParms.serializedDtxContextInfoLen = serializedDtxContextInfoLen;
+	dtxProtocolParms.readOnlySegments = readOnlySegments;
 
 	/*
 	 * Dispatch the command.
@@ -230,6 +236,9 @@ buildGpDtxProtocolCommand(DispatchCommandDtxProtocolParms *pDtxProtocolParms,
 	char	   *gid = pDtxProtocolParms->gid;
 	char	   *serializedDtxContextInfo = pDtxProtocolParms->serializedDtxContextInfo;
 	int			serializedDtxContextInfoLen = pDtxProtocolParms->serializedDtxContextInfoLen;
+	List	   *readOnlySegments = pDtxProtocolParms->readOnlySegments;
+	int			numReadOnlySegments = list_length(readOnlySegments);
+	ListCell   *lc;
 	int			tmp = 0;
 	int			len = 0;
 
@@ -243,7 +252,9 @@ buildGpDtxProtocolCommand(DispatchCommandDtxProtocolParms *pDtxProtocolParms,
 	sizeof(gidLen) +
 	gidLen +
 	sizeof(serializedDtxContextInfoLen) +
-	serializedDtxContextInfoLen;
+	serializedDtxContextInfoLen +
+	sizeof(numReadOnlySegments) +
+	numReadOnlySegments * sizeof(int32);
 
 	char	   *shared_query = NULL;
 	char	   *pos = NULL;
@@ -286,6 +297,17 @@ buildGpDtxProtocolCommand(DispatchCommandDtxProtocolParms *pDtxProtocolParms,
 		pos += serializedDtxContextInfoLen;
 	}
 
+	tmp = htonl(numReadOnlySegments);
+	memcpy(pos, &tmp, sizeof(tmp));
+	pos += sizeof(tmp);
+
+	foreach(lc, readOnlySegments)
+	{
+		tmp = htonl(lfirst_int(lc));
+		memcpy(pos, &tmp, sizeof(tmp));
+		pos += sizeof(tmp);
+	}
+
 	len = pos - shared_query - 1;
 
 	/*
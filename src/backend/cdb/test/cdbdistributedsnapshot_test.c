@@ -4,6 +4,7 @@
 #include "cmockery.h"
 
 #include "postgres.h"
+#include "portability/instr_time.h"
 #include "utils/memutils.h"
 
 #include "../cdbdistributedsnapshot.c"
@@ -23,6 +24,7 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 		dslm.minCachedLocalXid = InvalidTransactionId;
 		dslm.maxCachedLocalXid = InvalidTransactionId;
 		dslm.currentLocalXidsCount = 0;
+		DistributedSnapshotWithLocalMapping_ResetMemo(&dslm);
 
 		dslm.inProgressMappedLocalXids =
 			(TransactionId*)malloc(5 * sizeof(TransactionId));
@@ -86,6 +88,9 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 		ds->inProgressXidArray[0] = 50;
 		ds->inProgressXidArray[1] = 100;
 		ds->inProgressXidArray[2] = 200;
+
+		/* the snapshot changed, so the results memoized above are stale */
+		DistributedSnapshotWithLocalMapping_ResetMemo(&dslm);
 	}
 
 	/* First time the local xid cache should get populated */
@@ -129,23 +134,25 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
 
 	/*
 	 * Lets revalidate that local cache is working and
 	 * DistributedSnapshotWithLocalMapping_CommittedTest() returns result
 	 * based on local cache when more than one element is present in cache.
+	 * Forget the memoized results first, so that the cache is searched.
 	 */
+	DistributedSnapshotWithLocalMapping_ResetMemo(&dslm);
 	retval = DistributedSnapshotWithLocalMapping_CommittedTest(&dslm, 20, false);
 	assert_true(retval == DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS);
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
 
 	/*
 	 * Test where local cache should not be touched, if distributedXid is not
@@ -156,9 +163,126 @@ test__DistributedSnapshotWithLocalMapping_CommittedTest(void **state)
 	assert_true(dslm.currentLocalXidsCount == 3);
 	assert_true(dslm.minCachedLocalXid == 5);
 	assert_true(dslm.maxCachedLocalXid == 20);
-	assert_true(dslm.inProgressMappedLocalXids[0] == 10);
-	assert_true(dslm.inProgressMappedLocalXids[1] == 20);
-	assert_true(dslm.inProgressMappedLocalXids[2] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[0] == 5);
+	assert_true(dslm.inProgressMappedLocalXids[1] == 10);
+	assert_true(dslm.inProgressMappedLocalXids[2] == 20);
+
+	/*
+	 * The result for 15 is memoized, so asking again must not consult the
+	 * distributed log, which is expected to be called only once for it.
+	 */
+	assert_true(dslm.memoLocalXids[15 % DSLM_RESULT_MEMO_SIZE] == 15);
+	retval = DistributedSnapshotWithLocalMapping_CommittedTest(&dslm, 15, false);
+	assert_true(retval == DISTRIBUTEDSNAPSHOT_COMMITTED_VISIBLE);
+
+	free(ds->inProgressXidArray);
+	free(dslm.inProgressMappedLocalXids);
+}
+
+/*
+ * Time the checks a scan makes against a snapshot with many in-progress
+ * distributed transactions, all of them already in the local xid cache.
+ * Not run by default; pass --cmockery_run_disabled_tests to run it.
+ */
+static void
+test__DistributedSnapshotWithLocalMapping_CommittedTest__benchmark(void **state)
+{
+	int			nxids = 500;
+	int			loops = 2000;
+	TransactionId firstXid = 100;
+	DistributedSnapshotWithLocalMapping dslm;
+	DistributedSnapshot *ds = &dslm.ds;
+	instr_time	start;
+	instr_time	by_linear;
+	instr_time	by_cache;
+	instr_time	by_memo;
+	int			found = 0;
+	int			loop;
+	int			i;
+
+	disable_unit_test();
+
+	dslm.inProgressMappedLocalXids =
+		(TransactionId *) malloc(nxids * sizeof(TransactionId));
+	ds->inProgressXidArray =
+		(DistributedTransactionId *) malloc(nxids * sizeof(DistributedTransactionId));
+
+	ds->distribSnapshotId = 12345;
+	ds->distribTransactionTimeStamp = time(NULL);
+	ds->xminAllDistributedSnapshots = 3;
+	ds->xmin = 3;
+	ds->xmax = 10 * (firstXid + nxids);
+	ds->count = nxids;
+	for (i = 0; i < nxids; i++)
+	{
+		ds->inProgressXidArray[i] = 10 * (firstXid + i);
+		dslm.inProgressMappedLocalXids[i] = firstXid + i;
+	}
+	dslm.currentLocalXidsCount = nxids;
+	dslm.minCachedLocalXid = firstXid;
+	dslm.maxCachedLocalXid = firstXid + nxids - 1;
+	DistributedSnapshotWithLocalMapping_ResetMemo(&dslm);
+
+	/* The local xid cache searched one entry at a time, for comparison */
+	INSTR_TIME_SET_CURRENT(start);
+	for (loop = 0; loop < loops; loop++)
+	{
+		for (i = 0; i < nxids; i++)
+		{
+			int			j;
+
+			for (j = 0; j < dslm.currentLocalXidsCount; j++)
+			{
+				if (dslm.inProgressMappedLocalXids[j] == firstXid + i)
+				{
+					found++;
+					break;
+				}
+			}
+		}
+	}
+	INSTR_TIME_SET_CURRENT(by_linear);
+	INSTR_TIME_SUBTRACT(by_linear, start);
+	assert_int_equal(found, loops * nxids);
+
+	/*
+	 * Cycling through more xids than the memo holds evicts each one before
+	 * it is asked for again, so every check searches the local xid cache.
+	 */
+	INSTR_TIME_SET_CURRENT(start);
+	for (loop = 0; loop < loops; loop++)
+	{
+		for (i = 0; i < nxids; i++)
+		{
+			if (DistributedSnapshotWithLocalMapping_CommittedTest(&dslm, firstXid + i, false) ==
+				DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS)
+				found++;
+		}
+	}
+	INSTR_TIME_SET_CURRENT(by_cache);
+	INSTR_TIME_SUBTRACT(by_cache, start);
+	assert_int_equal(found, 2 * loops * nxids);
+
+	/* The same number of checks of as many xids as the memo holds */
+	INSTR_TIME_SET_CURRENT(start);
+	for (loop = 0; loop < loops; loop++)
+	{
+		for (i = 0; i < nxids; i++)
+		{
+			if (DistributedSnapshotWithLocalMapping_CommittedTest(&dslm, firstXid + i % DSLM_RESULT_MEMO_SIZE, false) ==
+				DISTRIBUTEDSNAPSHOT_COMMITTED_INPROGRESS)
+				found++;
+		}
+	}
+	INSTR_TIME_SET_CURRENT(by_memo);
+	INSTR_TIME_SUBTRACT(by_memo, start);
+	assert_int_equal(found, 3 * loops * nxids);
+
+	printf("%d in-progress xids, %d checks: linear search %.3f ms, local xid cache %.3f ms, memo %.3f ms\n",
+		   nxids, loops * nxids,
+		   INSTR_TIME_GET_MILLISEC(by_linear),
+		   INSTR_TIME_GET_MILLISEC(by_cache),
+		   INSTR_TIME_GET_MILLISEC(by_memo));
 
 	free(ds->inProgressXidArray);
 	free(dslm.inProgressMappedLocalXids);
@@ -171,7 +295,8 @@ main(int argc, char* argv[])
 
 	const UnitTest tests[] =
 	{
-		unit_test(test__DistributedSnapshotWithLocalMapping_CommittedTest)
+		unit_test(test__DistributedSnapshotWithLocalMapping_CommittedTest),
+		unit_test(test__DistributedSnapshotWithLocalMapping_CommittedTest__benchmark)
 	};
 
 	MemoryContextInit();
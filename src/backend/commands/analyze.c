@@ -16,7 +16,9 @@
  * function has been renamed to acquire_sample_rows_heap(), and
  * acquire_sample_rows() is now a wrapper that calls either
  * acquire_sample_rows_heap() or acquire_sample_rows_ao(), depending on
- * the table type.
+ * the table type. acquire_sample_rows_ao() samples each segment file
+ * separately, and keeps the samples in the segment's data directory, so
+ * that the next ANALYZE only needs to scan the files that have changed.
  *
  * Dispatching
  * -----------
@@ -45,6 +47,13 @@
  * cluster. gp_acquire_sample_rows() in turn calls acquire_sample_rows(), to
  * collect the sample on the segment.
  *
+ * Each segment may hold a different share of the rows, so the merge takes
+ * from each segment a number of sample rows proportional to its row count.
+ * A segment holding far more than its even share of the rows is asked
+ * again for a bigger sample. The segments also report the table size along
+ * with their sample, so a plain table is otherwise sampled and sized in a
+ * single dispatch.
+ *
  * One complication with collecting the sample is the way that very
  * large datums are handled. We don't want to transfer multi-gigabyte
  * tuples from each segment. That would slow things down, and risk
@@ -116,6 +125,7 @@
 #include "utils/syscache.h"
 #include "utils/timestamp.h"
 #include "utils/tqual.h"
+#include "utils/typcache.h"
 
 #include "catalog/heap.h"
 #include "cdb/cdbappendonlyam.h"
@@ -161,6 +171,27 @@ static BufferAccessStrategy vac_strategy;
 
 Bitmapset	**acquire_func_colLargeRowIndexes;
 
+/*
+ * Table size that the segments reported along with the sample, or
+ * InvalidBlockNumber. Set by acquire_sample_rows_dispatcher().
+ */
+static BlockNumber acquire_func_relpages = InvalidBlockNumber;
+
+/*
+ * Each segment is asked for this many times its even share of the sample,
+ * so that segments holding more than their share of the rows can still
+ * contribute in proportion.
+ */
+#define SEGMENT_SAMPLE_OVERSAMPLING	2
+
+/*
+ * An append-only segment file's sample holds this many times its share of
+ * the rows, going by the counts in pg_aoseg and the visibility map. The
+ * slack covers counts that are a little off, and lets a kept sample be
+ * reused when the file's share grows a little.
+ */
+#define AOSEGFILE_SAMPLE_SLACK		1.1
+
 
 static void do_analyze_rel(Relation onerel, int options,
 			   VacuumParams *params, List *va_cols,
@@ -170,6 +201,11 @@ static void compute_index_stats(Relation onerel, double totalrows,
 					AnlIndexData *indexdata, int nindexes,
 					HeapTuple *rows, int numrows,
 					MemoryContext col_context);
+static void compute_column_group_stats(Relation onerel,
+						   VacAttrStats **vacattrstats, int attr_cnt,
+						   HeapTuple *rows, int numrows, double totalrows,
+						   Bitmapset **colLargeRowIndexes,
+						   MemoryContext col_context);
 static VacAttrStats *examine_attribute(Relation onerel, int attnum,
 				  Node *index_expr, int elevel);
 static int acquire_sample_rows_dispatcher(Relation onerel, bool inh, int elevel,
@@ -331,8 +367,15 @@ analyze_rel_internal(Oid relid, RangeVar *relation, int options,
 		/* Regular table, so we'll use the regular row acquisition function */
 		acquirefunc = acquire_sample_rows;
 
-		/* Also get regular table's size */
-		relpages = acquire_number_of_blocks(onerel);
+		/*
+		 * Also get regular table's size. In the dispatcher, the segments
+		 * report it along with the sample, so leave it to do_analyze_rel().
+		 */
+		if (Gp_role == GP_ROLE_DISPATCH &&
+			onerel->rd_cdbpolicy && !GpPolicyIsEntry(onerel->rd_cdbpolicy))
+			relpages = InvalidBlockNumber;
+		else
+			relpages = acquire_number_of_blocks(onerel);
 	}
 	else if (onerel->rd_rel->relkind == RELKIND_FOREIGN_TABLE &&
 			 !RelationIsExternal(onerel))
@@ -666,6 +709,7 @@ do_analyze_rel(Relation onerel, int options, VacuumParams *params,
 		 * to avoid changing the function signature from upstream's.
 		 */
 		acquire_func_colLargeRowIndexes = colLargeRowIndexes;
+		acquire_func_relpages = InvalidBlockNumber;
 		if (inh)
 			numrows = acquire_inherited_sample_rows(onerel, elevel,
 													rows, targrows,
@@ -685,6 +729,15 @@ do_analyze_rel(Relation onerel, int options, VacuumParams *params,
 		rows = NULL;
 	}
 
+	/* Get the table size now, if the caller left it to us */
+	if (relpages == InvalidBlockNumber && !inh)
+	{
+		if (sample_needed && acquire_func_relpages != InvalidBlockNumber)
+			relpages = acquire_func_relpages;
+		else
+			relpages = acquire_number_of_blocks(onerel);
+	}
+
 	/*
 	 * Compute the statistics.  Temporary results during the calculations for
 	 * each column are stored in a child context.  The calc routines are
@@ -830,6 +883,11 @@ do_analyze_rel(Relation onerel, int options, VacuumParams *params,
 			MemoryContextResetAndDeleteChildren(col_context);
 		}
 
+		if (sample_needed)
+			compute_column_group_stats(onerel, vacattrstats, attr_cnt,
+									   rows, numrows, totalrows,
+									   colLargeRowIndexes, col_context);
+
 		/*
 		 * Datums exceeding WIDTH_THRESHOLD are masked as NULL in the sample, and
 		 * are used as is to evaluate index statistics. It is less likely to have
@@ -1181,6 +1239,384 @@ compute_index_stats(Relation onerel, double totalrows,
 	MemoryContextDelete(ind_context);
 }
 
+/*
+ * Validator for the "statistics_group" column option, a comma-separated list
+ * of other columns of the table.  Whether they exist is only checked by
+ * ANALYZE.
+ */
+void
+validateStatisticsGroupOption(char *value)
+{
+	char	   *rawstring;
+	List	   *namelist;
+
+	rawstring = value ? pstrdup(value) : NULL;
+	if (rawstring == NULL ||
+		!SplitIdentifierString(rawstring, ',', &namelist) ||
+		namelist == NIL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("invalid value for \"statistics_group\" option"),
+				 errdetail("Valid values are comma-separated lists of column names.")));
+	if (list_length(namelist) >= STATISTIC_GROUP_MAX_COLUMNS)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("too many columns in \"statistics_group\" option"),
+				 errdetail("At most %d other columns can be listed.",
+						   STATISTIC_GROUP_MAX_COLUMNS - 1)));
+
+	list_free(namelist);
+	pfree(rawstring);
+}
+
+/*
+ * Look up the columns of the statistics group of the column described by
+ * stats, that column first.  Returns the number of columns, or 0 if the
+ * group can't be used.
+ */
+static int
+get_statistics_group(Relation onerel, VacAttrStats *stats, const char *group,
+					 AttrNumber *attnums)
+{
+	char	   *rawstring = pstrdup(group);
+	List	   *namelist;
+	ListCell   *lc;
+	int			ncolumns = 0;
+
+	attnums[ncolumns++] = stats->attr->attnum;
+
+	if (!SplitIdentifierString(rawstring, ',', &namelist))
+		return 0;				/* can't happen, the option was validated */
+
+	foreach(lc, namelist)
+	{
+		char	   *colname = (char *) lfirst(lc);
+		AttrNumber	attnum = attnameAttNum(onerel, colname, false);
+		int			j;
+
+		if (attnum <= 0)
+		{
+			ereport(WARNING,
+					(errcode(ERRCODE_UNDEFINED_COLUMN),
+					 errmsg("column \"%s\" in statistics_group of column \"%s\" of relation \"%s\" does not exist",
+							colname, NameStr(stats->attr->attname),
+							RelationGetRelationName(onerel))));
+			return 0;
+		}
+		for (j = 0; j < ncolumns; j++)
+		{
+			if (attnums[j] == attnum)
+				break;
+		}
+		if (j < ncolumns)
+			continue;			/* listed twice, or the column itself */
+		if (ncolumns == STATISTIC_GROUP_MAX_COLUMNS)
+			return 0;			/* can't happen, the option was validated */
+		attnums[ncolumns++] = attnum;
+	}
+
+	return ncolumns;
+}
+
+typedef struct
+{
+	int			ncolumns;		/* number of values of each sample row */
+	Datum	   *values;			/* ncolumns values per sample row */
+	SortSupport ssup;			/* per column */
+	int			nkeys;			/* sort by the first nkeys columns of keys */
+	int			keys[STATISTIC_GROUP_MAX_COLUMNS];
+} CompareGroupRowsContext;
+
+static int
+compare_group_keys(CompareGroupRowsContext *cxt, int ra, int rb)
+{
+	int			k;
+
+	for (k = 0; k < cxt->nkeys; k++)
+	{
+		int			col = cxt->keys[k];
+		int			compare;
+
+		compare = ApplySortComparator(cxt->values[ra * cxt->ncolumns + col], false,
+									  cxt->values[rb * cxt->ncolumns + col], false,
+									  &cxt->ssup[col]);
+		if (compare != 0)
+			return compare;
+	}
+	return 0;
+}
+
+/*
+ * qsort_arg comparator for sorting sample row numbers by the values of some
+ * columns of a statistics group
+ */
+static int
+compare_group_rows(const void *a, const void *b, void *arg)
+{
+	int			ra = *(const int *) a;
+	int			rb = *(const int *) b;
+	int			compare;
+
+	compare = compare_group_keys((CompareGroupRowsContext *) arg, ra, rb);
+	if (compare != 0)
+		return compare;
+	return ra - rb;
+}
+
+/*
+ * Compute multi-column statistics for column groups
+ *
+ * A column's "statistics_group" option lists other columns of the table
+ * whose values are correlated with its own, like country and city for
+ * region.  For each such group we estimate from the sample the number of
+ * distinct combinations of the group's values, and, for each pair of its
+ * columns a and b, the degree of the functional dependency a => b: the
+ * fraction of rows whose value of a is only seen with one value of b.  The
+ * results go into a STATISTIC_KIND_COLUMN_GROUP slot of the column that has
+ * the option, where estimate_num_groups() and clauselist_selectivity() find
+ * them.
+ *
+ * Rows where any column of the group is NULL, or too wide to be in the
+ * sample, are left out.
+ */
+static void
+compute_column_group_stats(Relation onerel,
+						   VacAttrStats **vacattrstats, int attr_cnt,
+						   HeapTuple *rows, int numrows, double totalrows,
+						   Bitmapset **colLargeRowIndexes,
+						   MemoryContext col_context)
+{
+	TupleDesc	tupdesc = RelationGetDescr(onerel);
+	int			i;
+
+	for (i = 0; i < attr_cnt; i++)
+	{
+		VacAttrStats *stats = vacattrstats[i];
+		AttributeOpts *aopt;
+		AttrNumber	attnums[STATISTIC_GROUP_MAX_COLUMNS];
+		int			ncolumns;
+		int			slot_idx;
+		CompareGroupRowsContext cxt;
+		Datum	   *values;
+		int		   *rowidx;
+		int			nonnull_cnt;
+		int			ndistinct;
+		int			nmultiple;
+		int			dupcnt;
+		double		grp_distinct;
+		float4	   *numbers;
+		Datum	   *attnum_datums;
+		MemoryContext old_context;
+		int			rownum;
+		int			a,
+					b,
+					j;
+
+		if (!stats->stats_valid || stats->merge_stats)
+			continue;
+
+		aopt = get_attribute_options(onerel->rd_id, stats->attr->attnum);
+		if (aopt == NULL || aopt->statistics_group_offset == 0)
+			continue;
+
+		/* The last slot is kept for the hyperloglog counter */
+		for (slot_idx = 0; slot_idx < STATISTIC_NUM_SLOTS - 1; slot_idx++)
+		{
+			if (stats->stakind[slot_idx] == 0)
+				break;
+		}
+		if (slot_idx == STATISTIC_NUM_SLOTS - 1)
+			continue;
+
+		ncolumns = get_statistics_group(onerel, stats,
+										(char *) aopt + aopt->statistics_group_offset,
+										attnums);
+		if (ncolumns < 2)
+			continue;
+
+		cxt.ncolumns = ncolumns;
+		cxt.ssup = (SortSupport) palloc0(ncolumns * sizeof(SortSupportData));
+		for (j = 0; j < ncolumns; j++)
+		{
+			Form_pg_attribute attr = tupdesc->attrs[attnums[j] - 1];
+			TypeCacheEntry *typentry;
+
+			typentry = lookup_type_cache(attr->atttypid, TYPECACHE_LT_OPR);
+			if (!OidIsValid(typentry->lt_opr))
+			{
+				ereport(WARNING,
+						(errcode(ERRCODE_UNDEFINED_FUNCTION),
+						 errmsg("column \"%s\" in statistics_group of column \"%s\" of relation \"%s\" has no ordering operator",
+								NameStr(attr->attname), NameStr(stats->attr->attname),
+								RelationGetRelationName(onerel))));
+				break;
+			}
+			cxt.ssup[j].ssup_cxt = CurrentMemoryContext;
+			cxt.ssup[j].ssup_collation = attr->attcollation;
+			cxt.ssup[j].ssup_nulls_first = false;
+			cxt.ssup[j].abbreviate = false;
+			PrepareSortSupportFromOrderingOp(typentry->lt_opr, &cxt.ssup[j]);
+		}
+		if (j < ncolumns)
+		{
+			MemoryContextResetAndDeleteChildren(col_context);
+			continue;
+		}
+
+		/* Collect the rows where every column of the group has a value */
+		values = (Datum *) palloc(numrows * ncolumns * sizeof(Datum));
+		nonnull_cnt = 0;
+		for (rownum = 0; rownum < numrows; rownum++)
+		{
+			Datum	   *rowvalues = &values[nonnull_cnt * ncolumns];
+
+			for (j = 0; j < ncolumns; j++)
+			{
+				bool		isnull;
+
+				if (bms_is_member(rownum, colLargeRowIndexes[attnums[j] - 1]))
+					break;
+				rowvalues[j] = heap_getattr(rows[rownum], attnums[j], tupdesc,
+											&isnull);
+				if (isnull)
+					break;
+			}
+			if (j == ncolumns)
+				nonnull_cnt++;
+		}
+		if (nonnull_cnt < 2)
+		{
+			MemoryContextResetAndDeleteChildren(col_context);
+			continue;
+		}
+		cxt.values = values;
+
+		rowidx = (int *) palloc(nonnull_cnt * sizeof(int));
+		for (rownum = 0; rownum < nonnull_cnt; rownum++)
+			rowidx[rownum] = rownum;
+
+		/*
+		 * Count the distinct combinations in the sample, and estimate their
+		 * number in the table the same way compute_scalar_stats() does for a
+		 * single column.
+		 */
+		cxt.nkeys = ncolumns;
+		for (j = 0; j < ncolumns; j++)
+			cxt.keys[j] = j;
+		qsort_arg(rowidx, nonnull_cnt, sizeof(int), compare_group_rows, &cxt);
+
+		ndistinct = 0;
+		nmultiple = 0;
+		dupcnt = 1;
+		for (rownum = 1; rownum <= nonnull_cnt; rownum++)
+		{
+			if (rownum < nonnull_cnt &&
+				compare_group_keys(&cxt, rowidx[rownum - 1], rowidx[rownum]) == 0)
+			{
+				dupcnt++;
+				continue;
+			}
+			ndistinct++;
+			if (dupcnt > 1)
+				nmultiple++;
+			dupcnt = 1;
+		}
+
+		if (nmultiple == 0)
+			grp_distinct = -1.0 * nonnull_cnt / numrows;
+		else if (nmultiple == ndistinct)
+			grp_distinct = ndistinct;
+		else
+		{
+			int			f1 = ndistinct - nmultiple;
+			int			d = ndistinct;
+			double		n = nonnull_cnt;
+			double		N = totalrows * nonnull_cnt / numrows;
+
+			if (N > 0)
+				grp_distinct = (n * d) / ((n - f1) + f1 * n / N);
+			else
+				grp_distinct = 0;
+			if (grp_distinct < d)
+				grp_distinct = d;
+			if (grp_distinct > N)
+				grp_distinct = N;
+			grp_distinct = floor(grp_distinct + 0.5);
+		}
+		if (grp_distinct > 0.1 * totalrows)
+			grp_distinct = -(grp_distinct / totalrows);
+
+		old_context = MemoryContextSwitchTo(stats->anl_context);
+		numbers = (float4 *) palloc((1 + ncolumns * ncolumns) * sizeof(float4));
+		attnum_datums = (Datum *) palloc(ncolumns * sizeof(Datum));
+		MemoryContextSwitchTo(old_context);
+
+		numbers[0] = grp_distinct;
+		for (j = 0; j < ncolumns; j++)
+			attnum_datums[j] = Int16GetDatum(attnums[j]);
+
+		/*
+		 * For each column a, sort the rows by a, and find the groups of rows
+		 * with the same value of a in which every other column b has a single
+		 * value too.
+		 */
+		cxt.nkeys = 1;
+		for (a = 0; a < ncolumns; a++)
+		{
+			int			supporting[STATISTIC_GROUP_MAX_COLUMNS];
+			int			start = 0;
+
+			memset(supporting, 0, sizeof(supporting));
+			cxt.keys[0] = a;
+			qsort_arg(rowidx, nonnull_cnt, sizeof(int), compare_group_rows, &cxt);
+
+			for (rownum = 1; rownum <= nonnull_cnt; rownum++)
+			{
+				if (rownum < nonnull_cnt &&
+					compare_group_keys(&cxt, rowidx[start], rowidx[rownum]) == 0)
+					continue;
+
+				/* rows start .. rownum - 1 have the same value of a */
+				for (b = 0; b < ncolumns; b++)
+				{
+					Datum		first = values[rowidx[start] * ncolumns + b];
+					int			r;
+
+					if (b == a)
+						continue;
+					for (r = start + 1; r < rownum; r++)
+					{
+						if (ApplySortComparator(first, false,
+												values[rowidx[r] * ncolumns + b], false,
+												&cxt.ssup[b]) != 0)
+							break;
+					}
+					if (r == rownum)
+						supporting[b] += rownum - start;
+				}
+				start = rownum;
+			}
+
+			for (b = 0; b < ncolumns; b++)
+				numbers[1 + a * ncolumns + b] =
+					(b == a) ? 1.0 : (double) supporting[b] / nonnull_cnt;
+		}
+
+		stats->stakind[slot_idx] = STATISTIC_KIND_COLUMN_GROUP;
+		stats->staop[slot_idx] = InvalidOid;
+		stats->stanumbers[slot_idx] = numbers;
+		stats->numnumbers[slot_idx] = 1 + ncolumns * ncolumns;
+		stats->stavalues[slot_idx] = attnum_datums;
+		stats->numvalues[slot_idx] = ncolumns;
+		stats->statypid[slot_idx] = INT2OID;
+		stats->statyplen[slot_idx] = sizeof(int16);
+		stats->statypbyval[slot_idx] = true;
+		stats->statypalign[slot_idx] = 's';
+
+		MemoryContextResetAndDeleteChildren(col_context);
+	}
+}
+
 /*
  * examine_attribute -- pre-analysis of a single column
  *
@@ -1571,38 +2007,29 @@ acquire_sample_rows_heap(Relation onerel, int elevel,
 }
 
 /*
- * Collect a sample of rows from an AO or AOCS table.
- *
- * The block-sampling method used for heap tables doesn't work with
- * append-only tables. We could build a reasonably efficient block-sampling
- * method for AO tables, too, using the block directory, if it's available.
- * But for now, this scans the whole table.
+ * Collect a sample of the live rows of one segment file of an AO or AOCS
+ * table, into sample->rows. The whole file is scanned, with Vitter's
+ * reservoir algorithm, like in acquire_sample_rows_heap().
  */
-static int
-acquire_sample_rows_ao(Relation onerel, int elevel,
-					   HeapTuple *rows, int targrows,
-					   double *totalrows, double *totaldeadrows)
+static void
+acquire_segfile_sample_ao(Relation onerel, Snapshot appendOnlyMetaDataSnapshot,
+						  AOSegfileSample *sample, int targrows)
 {
 	AppendOnlyScanDesc aoScanDesc = NULL;
 	AOCSScanDesc aocsScanDesc = NULL;
-	Snapshot	appendOnlyMetaDataSnapshot;
 	double		rstate;
 	TupleTableSlot *slot;
+	HeapTuple  *rows;
 	int			numrows = 0;	/* # rows now in reservoir */
 	double		samplerows = 0; /* total # rows collected */
 	double		rowstoskip = -1;	/* -1 means not set yet */
 
-	/*
-	 * the append-only meta data should never be fetched with
-	 * SnapshotAny as bogus results are returned.
-	 */
-	appendOnlyMetaDataSnapshot = GetTransactionSnapshot();
-
 	if (RelationIsAoRows(onerel))
-		aoScanDesc = appendonly_beginscan(onerel,
-										  SnapshotSelf,
-										  appendOnlyMetaDataSnapshot,
-										  0, NULL);
+		aoScanDesc = appendonly_beginrangescan(onerel,
+											   SnapshotSelf,
+											   appendOnlyMetaDataSnapshot,
+											   &sample->segno, 1,
+											   0, NULL);
 	else
 	{
 		int			natts = RelationGetNumberOfAttributes(onerel);
@@ -1613,12 +2040,14 @@ acquire_sample_rows_ao(Relation onerel, int elevel,
 			proj[i] = true;
 
 		Assert(RelationIsAoCols(onerel));
-		aocsScanDesc = aocs_beginscan(onerel,
-									  SnapshotSelf,
-									  appendOnlyMetaDataSnapshot,
-									  RelationGetDescr(onerel), proj);
+		aocsScanDesc = aocs_beginrangescan(onerel,
+										   SnapshotSelf,
+										   appendOnlyMetaDataSnapshot,
+										   &sample->segno, 1,
+										   RelationGetDescr(onerel), proj);
 	}
 	slot = MakeSingleTupleTableSlot(RelationGetDescr(onerel));
+	rows = (HeapTuple *) palloc(targrows * sizeof(HeapTuple));
 
 	/* Prepare for sampling rows */
 	rstate = anl_init_selection_state(targrows);
@@ -1633,9 +2062,7 @@ acquire_sample_rows_ao(Relation onerel, int elevel,
 		if (TupIsNull(slot))
 			break;
 
-		if (rowstoskip < 0)
-			rowstoskip = anl_get_next_S(samplerows, targrows,
-										&rstate);
+		vacuum_delay_point();
 
 		/* XXX: this is copied from acquire_sample_rows_heap */
 
@@ -1684,21 +2111,268 @@ acquire_sample_rows_ao(Relation onerel, int elevel,
 		samplerows += 1;
 	}
 
-	/* Get the total tuple count in the table */
-	FileSegTotals *fstotal;
-	int64		hidden_tupcount = 0;
-
+	ExecDropSingleTupleTableSlot(slot);
 	if (aoScanDesc)
+		appendonly_endscan(aoScanDesc);
+	if (aocsScanDesc)
+		aocs_endscan(aocsScanDesc);
+
+	sample->rows = rows;
+	sample->numrows = numrows;
+	sample->liverows = samplerows;
+}
+
+/*
+ * Collect a sample of rows from an AO or AOCS table.
+ *
+ * The block-sampling method used for heap tables doesn't work with
+ * append-only tables. We could build a reasonably efficient block-sampling
+ * method for AO tables, too, using the block directory, if it's available.
+ * But for now, this scans the whole table.
+ *
+ * Each segment file is sampled on its own, keeping a little more than its
+ * share of the rows, and the samples are combined in proportion to the
+ * files' live rows. Append-only tables mostly grow by
+ * appending to some of their segment files, so with gp_analyze_cache_ao_samples
+ * we keep the samples, and only scan again the files whose pg_aoseg modcount,
+ * tuple count or visimap hidden count have changed since.
+ */
+static int
+acquire_sample_rows_ao(Relation onerel, int elevel,
+					   HeapTuple *rows, int targrows,
+					   double *totalrows, double *totaldeadrows)
+{
+	Snapshot	appendOnlyMetaDataSnapshot;
+	AppendOnlyVisimap visimap;
+	AOSegfileSample *samples;
+	AOSegfileSample *cached = NULL;
+	int			nsamples = 0;
+	int			ncached = 0;
+	int			nscanned = 0;
+	int			ntrimmed = 0;
+	int		   *quotas;
+	double		estrows = 0;
+	double		liverows = 0;
+	int			numrows = 0;
+	int			remaining;
+	int			i;
+
+	/*
+	 * the append-only meta data should never be fetched with
+	 * SnapshotAny as bogus results are returned.
+	 */
+	appendOnlyMetaDataSnapshot = GetTransactionSnapshot();
+
+	/* Get the segment files to sample, skipping the ones about to be dropped */
+	if (RelationIsAoRows(onerel))
 	{
-		fstotal = GetSegFilesTotals(onerel, SnapshotSelf);
-		hidden_tupcount = AppendOnlyVisimap_GetRelationHiddenTupleCount(&aoScanDesc->visibilityMap);
+		FileSegInfo **segfiles;
+		int			nsegfiles;
+
+		segfiles = GetAllFileSegInfo(onerel, appendOnlyMetaDataSnapshot, &nsegfiles);
+		samples = palloc0(Max(nsegfiles, 1) * sizeof(AOSegfileSample));
+		for (i = 0; i < nsegfiles; i++)
+		{
+			if (segfiles[i]->state == AOSEG_STATE_AWAITING_DROP)
+				continue;
+			samples[nsamples].segno = segfiles[i]->segno;
+			samples[nsamples].modcount = segfiles[i]->modcount;
+			samples[nsamples].tupcount = segfiles[i]->total_tupcount;
+			nsamples++;
+		}
+		if (segfiles)
+			FreeAllSegFileInfo(segfiles, nsegfiles);
 	}
 	else
 	{
-		fstotal = GetAOCSSSegFilesTotals(onerel, SnapshotSelf);
-		hidden_tupcount = AppendOnlyVisimap_GetRelationHiddenTupleCount(&aocsScanDesc->visibilityMap);
+		AOCSFileSegInfo **segfiles;
+		int			nsegfiles;
+
+		Assert(RelationIsAoCols(onerel));
+		segfiles = GetAllAOCSFileSegInfo(onerel, appendOnlyMetaDataSnapshot, &nsegfiles);
+		samples = palloc0(Max(nsegfiles, 1) * sizeof(AOSegfileSample));
+		for (i = 0; i < nsegfiles; i++)
+		{
+			if (segfiles[i]->state == AOSEG_STATE_AWAITING_DROP)
+				continue;
+			samples[nsamples].segno = segfiles[i]->segno;
+			samples[nsamples].modcount = segfiles[i]->modcount;
+			samples[nsamples].tupcount = segfiles[i]->total_tupcount;
+			nsamples++;
+		}
+		if (segfiles)
+			FreeAllAOCSSegFileInfo(segfiles, nsegfiles);
+	}
+
+	AppendOnlyVisimap_Init(&visimap,
+						   onerel->rd_appendonly->visimaprelid,
+						   onerel->rd_appendonly->visimapidxid,
+						   AccessShareLock,
+						   appendOnlyMetaDataSnapshot);
+	for (i = 0; i < nsamples; i++)
+		samples[i].hiddencount =
+			AppendOnlyVisimap_GetSegmentFileHiddenTupleCount(&visimap, samples[i].segno);
+	AppendOnlyVisimap_Finish(&visimap, AccessShareLock);
+
+	for (i = 0; i < nsamples; i++)
+		estrows += Max(samples[i].tupcount - samples[i].hiddencount, 0);
+
+	if (gp_analyze_cache_ao_samples)
+		cached = readAOSegfileSamples(onerel, &ncached);
+
+	for (i = 0; i < nsamples; i++)
+	{
+		AOSegfileSample *sample = &samples[i];
+		int			samplerows = targrows;
+		int			j;
+
+		/*
+		 * Only keep as many rows from each file as its share of the merged
+		 * sample needs, so that the memory used stays bounded by about
+		 * targrows however many files there are.
+		 */
+		if (estrows > 0)
+		{
+			double		share = Max(sample->tupcount - sample->hiddencount, 0) / estrows;
+
+			samplerows = (int) ceil(targrows * share * AOSEGFILE_SAMPLE_SLACK);
+			samplerows = Max(Min(samplerows, targrows), 1);
+		}
+
+		/*
+		 * Reuse the old sample of an unchanged file, if it is big enough.
+		 * Sampling a sample at random is still a random sample.
+		 */
+		for (j = 0; j < ncached; j++)
+		{
+			AOSegfileSample *old = &cached[j];
+
+			if (old->rows != NULL &&
+				old->segno == sample->segno &&
+				old->modcount == sample->modcount &&
+				old->tupcount == sample->tupcount &&
+				old->hiddencount == sample->hiddencount &&
+				old->numrows >= Min(old->liverows, samplerows))
+			{
+				sample->liverows = old->liverows;
+				sample->numrows = old->numrows;
+				sample->rows = old->rows;
+				old->rows = NULL;
+				break;
+			}
+		}
+
+		if (j == ncached)
+		{
+			acquire_segfile_sample_ao(onerel, appendOnlyMetaDataSnapshot,
+									  sample, samplerows);
+			nscanned++;
+		}
+		else if (sample->numrows > samplerows)
+		{
+			/* The file's share has shrunk; drop the rows it no longer needs */
+			int			needed = samplerows;
+			int			left = sample->numrows;
+			int			nkept = 0;
+
+			for (j = 0; j < sample->numrows; j++)
+			{
+				if (needed > 0 && anl_random_fract() * left-- < needed)
+				{
+					sample->rows[nkept++] = sample->rows[j];
+					needed--;
+				}
+				else
+					heap_freetuple(sample->rows[j]);
+			}
+			sample->numrows = nkept;
+			ntrimmed++;
+		}
+		liverows += sample->liverows;
+	}
+
+	/* Forget the samples of files that have changed or are gone */
+	for (i = 0; i < ncached; i++)
+	{
+		int			j;
+
+		if (cached[i].rows == NULL)
+			continue;
+		for (j = 0; j < cached[i].numrows; j++)
+			heap_freetuple(cached[i].rows[j]);
+		pfree(cached[i].rows);
+	}
+	if (cached)
+		pfree(cached);
+
+	/*
+	 * Keep the samples for the next time, unless this transaction has
+	 * modified the data: the counts it sees could then be rolled back, and
+	 * later be reached again with different rows.
+	 */
+	if (gp_analyze_cache_ao_samples &&
+		(nscanned > 0 || ntrimmed > 0 || ncached != nsamples) &&
+		!TransactionIdIsValid(GetTopTransactionIdIfAny()))
+		writeAOSegfileSamples(onerel, samples, nsamples);
+
+	/*
+	 * Give each file a share of the sample in proportion to its live rows.
+	 * Rounding down leaves a few rows over, which go one at a time to the
+	 * files with sampled rows to spare.
+	 */
+	quotas = palloc0(Max(nsamples, 1) * sizeof(int));
+	remaining = targrows;
+	for (i = 0; i < nsamples; i++)
+	{
+		if (liverows > 0)
+			quotas[i] = Min((int) floor(targrows * (samples[i].liverows / liverows)),
+							samples[i].numrows);
+		remaining -= quotas[i];
+	}
+	while (remaining > 0)
+	{
+		bool		found = false;
+
+		for (i = 0; i < nsamples && remaining > 0; i++)
+		{
+			if (quotas[i] < samples[i].numrows)
+			{
+				quotas[i]++;
+				remaining--;
+				found = true;
+			}
+		}
+		if (!found)
+			break;
 	}
-	*totalrows = (double) fstotal->totaltuples - hidden_tupcount;
+
+	/* Pick each file's share of rows at random from its sample */
+	for (i = 0; i < nsamples; i++)
+	{
+		AOSegfileSample *sample = &samples[i];
+		int			needed = quotas[i];
+		int			left = sample->numrows;
+		int			j;
+
+		for (j = 0; j < sample->numrows; j++)
+		{
+			if (needed > 0 && anl_random_fract() * left-- < needed)
+			{
+				rows[numrows++] = sample->rows[j];
+				needed--;
+			}
+			else
+				heap_freetuple(sample->rows[j]);
+		}
+		if (sample->rows)
+			pfree(sample->rows);
+	}
+
+	/* Get the total tuple count in the table */
+	*totalrows = 0;
+	for (i = 0; i < nsamples; i++)
+		*totalrows += (double) (samples[i].tupcount - samples[i].hiddencount);
+
 	/*
 	 * Currently, we always report 0 dead rows on an AO table. We could
 	 * perhaps get a better estimate using the AO visibility map. But this
@@ -1706,11 +2380,16 @@ acquire_sample_rows_ao(Relation onerel, int elevel,
 	 */
 	*totaldeadrows = 0;
 
-	ExecDropSingleTupleTableSlot(slot);
-	if (aoScanDesc)
-		appendonly_endscan(aoScanDesc);
-	if (aocsScanDesc)
-		aocs_endscan(aocsScanDesc);
+	ereport(elevel,
+			(errmsg("\"%s\": scanned %d of %d segment files, "
+					"containing %.0f live rows; "
+					"%d rows in sample, %.0f total rows",
+					RelationGetRelationName(onerel),
+					nscanned, nsamples, liverows,
+					numrows, *totalrows)));
+
+	pfree(quotas);
+	pfree(samples);
 
 	return numrows;
 }
@@ -2132,16 +2811,23 @@ acquire_number_of_blocks(Relation onerel)
 		/* NOTE: This covers indexes, too */
 		return RelationGetNumberOfBlocks(onerel);
 	}
+	else
+		return RelationGuessNumberOfBlocks(acquire_local_relation_size(onerel));
+}
+
+/*
+ * Size of the table on this server, in bytes, like pg_relation_size(). The
+ * segments return it along with their sample.
+ */
+int64
+acquire_local_relation_size(Relation onerel)
+{
+	if (RelationIsHeap(onerel))
+		return (int64) RelationGetNumberOfBlocks(onerel) * BLCKSZ;
 	else if (RelationIsAoRows(onerel))
-	{
-		totalbytes = GetAOTotalBytes(onerel, GetActiveSnapshot());
-		return RelationGuessNumberOfBlocks(totalbytes);
-	}
+		return GetAOTotalBytes(onerel, GetActiveSnapshot());
 	else if (RelationIsAoCols(onerel))
-	{
-		totalbytes = GetAOCSTotalBytes(onerel, GetActiveSnapshot(), true);
-		return RelationGuessNumberOfBlocks(totalbytes);
-	}
+		return GetAOCSTotalBytes(onerel, GetActiveSnapshot(), true);
 	else
 		elog(ERROR, "unsupported table type");
 }
@@ -2209,31 +2895,42 @@ acquire_sample_rows_dispatcher(Relation onerel, bool inh, int elevel,
 	TupleDesc	newDesc;
 	AttInMetadata *attinmeta;
 	StringInfoData str;
+	StringInfoData coldefs;
 	int			sampleTuples;	/* 32 bit - assume that number of tuples will not > 2B */
 	char	  **values;
 	int			numLiveColumns;
 	int			perseg_targrows;
 	CdbPgResults cdb_pgresults = {NULL, 0};
+	int			numResults;
+	double	   *seg_totalrows;
+	int		   *seg_numrows;
+	int		   *seg_quota;
+	double		totalweight;
+	double		scale;
+	int			quota_sum;
+	double		totalbytes;
+	bool		got_totalbytes;
 	int			i;
 
 	Assert(targrows > 0.0);
 
 	/*
-	 * Acquire an evenly-sized sample from each segment.
-	 *
-	 * XXX: If there's a significant bias between the segments, i.e. some
-	 * segments have a lot more rows than others, the sample will biased, too.
-	 * Would be nice to improve that, but it's not clear how. We could issue
-	 * another query to get the table size from each segment first, and use
-	 * those to weigh the sample size to get from each segment. But that'd
-	 * require an extra round-trip, which is also not good. The caller
-	 * actually already did that, to get the total relation size, but it
-	 * doesn't pass that down to us, let alone the per-segment sizes.
+	 * Acquire a sample from each segment. A segment's share of the merged
+	 * sample should be proportional to its share of the rows, but we only
+	 * learn the row counts along with the samples. So ask each segment for
+	 * twice its even share, and take fewer rows from the smaller segments
+	 * below. If one segment holds even more than that, it is asked again
+	 * for as many rows as its share needs.
 	 */
 	if (GpPolicyIsReplicated(onerel->rd_cdbpolicy))
 		perseg_targrows = targrows;
 	else if (GpPolicyIsPartitioned(onerel->rd_cdbpolicy))
+	{
 		perseg_targrows = targrows / onerel->rd_cdbpolicy->numsegments;
+		perseg_targrows = Max(perseg_targrows, 1);
+		perseg_targrows = Min(perseg_targrows * SEGMENT_SAMPLE_OVERSAMPLING,
+							  targrows);
+	}
 	else
 		elog(ERROR, "acquire_sample_rows_dispatcher() cannot be used on a non-distributed table");
 
@@ -2253,19 +2950,17 @@ acquire_sample_rows_dispatcher(Relation onerel, bool inh, int elevel,
 	}
 
 	/*
-	 * Construct SQL command to dispatch to segments.
+	 * Construct SQL command to dispatch to segments. The column definition
+	 * list is kept separately, in case we need to ask some segments again.
 	 */
-	initStringInfo(&str);
-	appendStringInfo(&str, "select * from pg_catalog.gp_acquire_sample_rows(%u, %d, '%s')",
-					 RelationGetRelid(onerel),
-					 perseg_targrows,
-					 inh ? "t" : "f");
+	initStringInfo(&coldefs);
 
 	/* special columns */
-	appendStringInfoString(&str, " as (");
-	appendStringInfoString(&str, "totalrows pg_catalog.float8, ");
-	appendStringInfoString(&str, "totaldeadrows pg_catalog.float8, ");
-	appendStringInfoString(&str, "oversized_cols_bitmap pg_catalog.text");
+	appendStringInfoString(&coldefs, " as (");
+	appendStringInfoString(&coldefs, "totalrows pg_catalog.float8, ");
+	appendStringInfoString(&coldefs, "totaldeadrows pg_catalog.float8, ");
+	appendStringInfoString(&coldefs, "totalbytes pg_catalog.float8, ");
+	appendStringInfoString(&coldefs, "oversized_cols_bitmap pg_catalog.text");
 
 	/* table columns */
 	for (i = 0; i < relDesc->natts; i++)
@@ -2276,12 +2971,19 @@ acquire_sample_rows_dispatcher(Relation onerel, bool inh, int elevel,
 		if (attr->attisdropped)
 			continue;
 
-		appendStringInfo(&str, ", %s %s",
+		appendStringInfo(&coldefs, ", %s %s",
 						 quote_identifier(NameStr(attr->attname)),
 						 format_type_be(typid));
 	}
 
-	appendStringInfoString(&str, ")");
+	appendStringInfoString(&coldefs, ")");
+
+	initStringInfo(&str);
+	appendStringInfo(&str, "select * from pg_catalog.gp_acquire_sample_rows(%u, %d, '%s')%s",
+					 RelationGetRelid(onerel),
+					 perseg_targrows,
+					 inh ? "t" : "f",
+					 coldefs.data);
 
 	/*
 	 * Execute it.
@@ -2306,14 +3008,19 @@ acquire_sample_rows_dispatcher(Relation onerel, bool inh, int elevel,
 	attinmeta = TupleDescGetAttInMetadata(newDesc);
 
 	/*
-	 * Read the result set from each segment. Gather the sample rows *rows,
-	 * and sum up the summary rows for grand 'totalrows' and 'totaldeadrows'.
+	 * Read the summary row from each segment, and count its sample rows. Sum
+	 * up the summary rows for grand 'totalrows', 'totaldeadrows' and
+	 * 'totalbytes'.
 	 */
-	values = (char **) palloc0(relDesc->natts * sizeof(char *));
-	sampleTuples = 0;
+	numResults = cdb_pgresults.numResults;
+	seg_totalrows = (double *) palloc0(numResults * sizeof(double));
+	seg_numrows = (int *) palloc0(numResults * sizeof(int));
+	seg_quota = (int *) palloc0(numResults * sizeof(int));
 	*totalrows = 0;
 	*totaldeadrows = 0;
-	for (int resultno = 0; resultno < cdb_pgresults.numResults; resultno++)
+	totalbytes = 0;
+	got_totalbytes = true;
+	for (int resultno = 0; resultno < numResults; resultno++)
 	{
 		struct pg_result *pgresult = cdb_pgresults.pg_results[resultno];
 		bool		got_summary = false;
@@ -2353,40 +3060,209 @@ acquire_sample_rows_dispatcher(Relation onerel, bool inh, int elevel,
 																	CStringGetDatum(PQgetvalue(pgresult, rowno, 0))));
 				this_totaldeadrows = DatumGetFloat8(DirectFunctionCall1(float8in,
 																		CStringGetDatum(PQgetvalue(pgresult, rowno, 1))));
+				if (PQgetisnull(pgresult, rowno, 2))
+					got_totalbytes = false;
+				else
+					totalbytes += DatumGetFloat8(DirectFunctionCall1(float8in,
+																	 CStringGetDatum(PQgetvalue(pgresult, rowno, 2))));
 				got_summary = true;
 			}
 			else
-			{
-				/* This is a sample row. */
-				int			index;
+				seg_numrows[resultno]++;
+		}
+
+		if (!got_summary)
+			elog(ERROR, "did not get summary row from gp_acquire_sample_rows");
+
+		if (resultno >= onerel->rd_cdbpolicy->numsegments)
+		{
+			/*
+			 * This result is for a segment that's not holding any data for this
+			 * table. Should get 0 rows.
+			 */
+			if (this_totalrows != 0 || this_totalrows != 0)
+				elog(WARNING, "table \"%s\" contains rows in segment %d, which is outside the # of segments for the table's policy (%d segments)",
+					 RelationGetRelationName(onerel), resultno, onerel->rd_cdbpolicy->numsegments);
+		}
+
+		seg_totalrows[resultno] = this_totalrows;
+		(*totalrows) += this_totalrows;
+		(*totaldeadrows) += this_totaldeadrows;
+	}
+
+	if (!inh && got_totalbytes)
+		acquire_func_relpages = RelationGuessNumberOfBlocks(totalbytes);
 
-				if (sampleTuples >= targrows)
-					elog(ERROR, "too many sample rows received from gp_acquire_sample_rows");
+	/*
+	 * A segment that returned a full sample, but holds so many of the rows
+	 * that its share of the merged sample is bigger than that, would limit
+	 * the size of the whole merged sample below. Ask those segments again,
+	 * for as many rows as the largest of their shares. The new sample
+	 * replaces the old one; the row counts from the first round are kept,
+	 * so that the weights stay consistent.
+	 */
+	if (GpPolicyIsPartitioned(onerel->rd_cdbpolicy) && *totalrows > 0)
+	{
+		List	   *short_segments = NIL;
+		int			resample_targrows = 0;
+
+		for (int resultno = 0; resultno < numResults; resultno++)
+		{
+			int			share;
+
+			if (seg_numrows[resultno] < perseg_targrows)
+				continue;		/* the segment returned all its rows */
+
+			share = (int) ceil(targrows * seg_totalrows[resultno] / *totalrows);
+			share = Min(share, targrows);
+			if (share > seg_numrows[resultno])
+			{
+				short_segments = lappend_int(short_segments, resultno);
+				resample_targrows = Max(resample_targrows, share);
+			}
+		}
 
-				/* Read the 'toolarge' bitmap, if any */
-				if (colLargeRowIndexes && !PQgetisnull(pgresult, rowno, 2))
+		if (short_segments != NIL)
+		{
+			CdbPgResults resample_pgresults = {NULL, 0};
+			ListCell   *lc;
+			int			n;
+
+			resetStringInfo(&str);
+			appendStringInfo(&str, "select * from pg_catalog.gp_acquire_sample_rows(%u, %d, '%s')%s",
+							 RelationGetRelid(onerel),
+							 resample_targrows,
+							 inh ? "t" : "f",
+							 coldefs.data);
+
+			elog(elevel, "Executing SQL on %d segments: %s",
+				 list_length(short_segments), str.data);
+			CdbDispatchCommandToSegments(str.data, DF_WITH_SNAPSHOT,
+										 short_segments, &resample_pgresults);
+
+			if (resample_pgresults.numResults != list_length(short_segments))
+			{
+				cdbdisp_clearCdbPgResults(&resample_pgresults);
+				cdbdisp_clearCdbPgResults(&cdb_pgresults);
+				elog(ERROR, "expected %d results from gp_acquire_sample_rows, got %d",
+					 list_length(short_segments), resample_pgresults.numResults);
+			}
+			for (n = 0; n < resample_pgresults.numResults; n++)
+			{
+				if (PQresultStatus(resample_pgresults.pg_results[n]) != PGRES_TUPLES_OK)
 				{
-					char	   *toolarge;
+					ExecStatusType status = PQresultStatus(resample_pgresults.pg_results[n]);
 
-					toolarge = PQgetvalue(pgresult, rowno, 2);
-					if (strlen(toolarge) != numLiveColumns)
-						elog(ERROR, "'toolarge' bitmap has incorrect length");
+					cdbdisp_clearCdbPgResults(&resample_pgresults);
+					cdbdisp_clearCdbPgResults(&cdb_pgresults);
+					ereport(ERROR,
+							(errmsg("unexpected result from segment: %d", status)));
+				}
+			}
 
-					index = 0;
-					for (i = 0; i < relDesc->natts; i++)
-					{
-						Form_pg_attribute attr = relDesc->attrs[i];
+			/* Swap in the new samples, and count their rows */
+			n = 0;
+			foreach(lc, short_segments)
+			{
+				int			resultno = lfirst_int(lc);
+				struct pg_result *pgresult = resample_pgresults.pg_results[n++];
 
-						if (attr->attisdropped)
-							continue;
+				PQclear(cdb_pgresults.pg_results[resultno]);
+				cdb_pgresults.pg_results[resultno] = pgresult;
 
-						if (toolarge[index] == '1')
-							colLargeRowIndexes[i] = bms_add_member(colLargeRowIndexes[i], sampleTuples);
-						index++;
-					}
+				seg_numrows[resultno] = 0;
+				for (int rowno = 0; rowno < PQntuples(pgresult); rowno++)
+				{
+					if (PQgetisnull(pgresult, rowno, 0))
+						seg_numrows[resultno]++;
 				}
+			}
+			/* the results are owned by cdb_pgresults now */
+			resample_pgresults.numResults = 0;
+			list_free(short_segments);
+		}
+	}
+
+	/*
+	 * Decide how many of its sample rows to take from each segment. Each
+	 * segment is weighed by its estimated row count, or by the number of
+	 * sample rows it returned, if none of them has an estimate. The merged
+	 * sample has 'scale' rows, so a segment contributes
+	 * scale * weight / totalweight of them, which can't be more than it
+	 * returned.
+	 */
+	totalweight = 0;
+	for (int resultno = 0; resultno < numResults; resultno++)
+	{
+		if (*totalrows <= 0)
+			seg_totalrows[resultno] = seg_numrows[resultno];
+		totalweight += seg_totalrows[resultno];
+	}
+
+	scale = targrows;
+	for (int resultno = 0; resultno < numResults; resultno++)
+	{
+		if (seg_totalrows[resultno] > 0)
+			scale = Min(scale, seg_numrows[resultno] * totalweight / seg_totalrows[resultno]);
+	}
+
+	quota_sum = 0;
+	for (int resultno = 0; resultno < numResults; resultno++)
+	{
+		if (totalweight > 0)
+			seg_quota[resultno] = Min(seg_numrows[resultno],
+									  (int) floor(scale * seg_totalrows[resultno] / totalweight));
+		quota_sum += seg_quota[resultno];
+	}
+
+	/* Hand out the rows lost to rounding down to segments that have spare */
+	for (int resultno = 0; resultno < numResults && quota_sum < (int) scale; resultno++)
+	{
+		if (seg_quota[resultno] < seg_numrows[resultno] && seg_totalrows[resultno] > 0)
+		{
+			seg_quota[resultno]++;
+			quota_sum++;
+		}
+	}
+
+	/*
+	 * Gather the sample rows into *rows. Each segment's sample is a random
+	 * sample of its rows, so a random subset of it is too. Pick each row
+	 * with probability needed / remaining (Knuth's Algorithm S), and only
+	 * build the tuples we keep.
+	 */
+	values = (char **) palloc0(relDesc->natts * sizeof(char *));
+	sampleTuples = 0;
+	for (int resultno = 0; resultno < numResults; resultno++)
+	{
+		struct pg_result *pgresult = cdb_pgresults.pg_results[resultno];
+		int			needed = seg_quota[resultno];
+		int			remaining = seg_numrows[resultno];
+
+		for (int rowno = 0; rowno < PQntuples(pgresult) && needed > 0; rowno++)
+		{
+			int			index;
+
+			/* Skip the summary row */
+			if (!PQgetisnull(pgresult, rowno, 0))
+				continue;
+
+			if (anl_random_fract() * remaining-- >= needed)
+				continue;
+			needed--;
+
+			if (sampleTuples >= targrows)
+				elog(ERROR, "too many sample rows received from gp_acquire_sample_rows");
+
+			/* Read the 'toolarge' bitmap, if any */
+			if (colLargeRowIndexes && !PQgetisnull(pgresult, rowno, 3))
+			{
+				char	   *toolarge;
+
+				toolarge = PQgetvalue(pgresult, rowno, 3);
+				if (strlen(toolarge) != numLiveColumns)
+					elog(ERROR, "'toolarge' bitmap has incorrect length");
 
-				/* Process the columns */
 				index = 0;
 				for (i = 0; i < relDesc->natts; i++)
 				{
@@ -2395,39 +3271,36 @@ acquire_sample_rows_dispatcher(Relation onerel, bool inh, int elevel,
 					if (attr->attisdropped)
 						continue;
 
-					if (PQgetisnull(pgresult, rowno, 3 + index))
-						values[i] = NULL;
-					else
-						values[i] = PQgetvalue(pgresult, rowno, 3 + index);
-					index++; /* Move index to the next result set attribute */
+					if (toolarge[index] == '1')
+						colLargeRowIndexes[i] = bms_add_member(colLargeRowIndexes[i], sampleTuples);
+					index++;
 				}
+			}
 
-				rows[sampleTuples] = BuildTupleFromCStrings(attinmeta, values);
-				sampleTuples++;
+			/* Process the columns */
+			index = 0;
+			for (i = 0; i < relDesc->natts; i++)
+			{
+				Form_pg_attribute attr = relDesc->attrs[i];
 
-				/*
-				 * note: we don't set the OIDs in the sample. ANALYZE doesn't
-				 * collect stats for them
-				 */
+				if (attr->attisdropped)
+					continue;
+
+				if (PQgetisnull(pgresult, rowno, NUM_SAMPLE_SPECIAL_COLS + index))
+					values[i] = NULL;
+				else
+					values[i] = PQgetvalue(pgresult, rowno, NUM_SAMPLE_SPECIAL_COLS + index);
+				index++; /* Move index to the next result set attribute */
 			}
-		}
 
-		if (!got_summary)
-			elog(ERROR, "did not get summary row from gp_acquire_sample_rows");
+			rows[sampleTuples] = BuildTupleFromCStrings(attinmeta, values);
+			sampleTuples++;
 
-		if (resultno >= onerel->rd_cdbpolicy->numsegments)
-		{
 			/*
-			 * This result is for a segment that's not holding any data for this
-			 * table. Should get 0 rows.
+			 * note: we don't set the OIDs in the sample. ANALYZE doesn't
+			 * collect stats for them
 			 */
-			if (this_totalrows != 0 || this_totalrows != 0)
-				elog(WARNING, "table \"%s\" contains rows in segment %d, which is outside the # of segments for the table's policy (%d segments)",
-					 RelationGetRelationName(onerel), resultno, onerel->rd_cdbpolicy->numsegments);
 		}
-
-		(*totalrows) += this_totalrows;
-		(*totaldeadrows) += this_totaldeadrows;
 	}
 
 	cdbdisp_clearCdbPgResults(&cdb_pgresults);
@@ -4082,11 +4955,8 @@ merge_leaf_stats(VacAttrStatsP stats,
 					}
 					else
 					{
-						GpHLLCounter hllcounter_temp1 = gp_hll_copy(hllcounters_copy[i - 1]);
-						GpHLLCounter hllcounter_temp2 = gp_hll_copy(hllcounters_left[i - 1]);
-						hllcounters_left[i] = gp_hyperloglog_merge_counters(hllcounter_temp1, hllcounter_temp2);
-						pfree(hllcounter_temp1);
-						pfree(hllcounter_temp2);
+						hllcounters_left[i] = gp_hyperloglog_merge_counters(hllcounters_copy[i - 1],
+																			hllcounters_left[i - 1]);
 					}
 
 					/* populate right array */
@@ -4096,11 +4966,8 @@ merge_leaf_stats(VacAttrStatsP stats,
 					}
 					else
 					{
-						GpHLLCounter hllcounter_temp1 = gp_hll_copy(hllcounters_copy[numPartitions - i]);
-						GpHLLCounter hllcounter_temp2 = gp_hll_copy(hllcounters_right[numPartitions - i]);
-						hllcounters_right[numPartitions - i - 1] = gp_hyperloglog_merge_counters(hllcounter_temp1, hllcounter_temp2);
-						pfree(hllcounter_temp1);
-						pfree(hllcounter_temp2);
+						hllcounters_right[numPartitions - i - 1] = gp_hyperloglog_merge_counters(hllcounters_copy[numPartitions - i],
+																								 hllcounters_right[numPartitions - i]);
 					}
 				}
 
@@ -4111,13 +4978,9 @@ merge_leaf_stats(VacAttrStatsP stats,
 					if (nDistincts[i] == 0)
 						continue;
 
-					GpHLLCounter hllcounter_temp1 = gp_hll_copy(hllcounters_left[i]);
-					GpHLLCounter hllcounter_temp2 = gp_hll_copy(hllcounters_right[i]);
+					/* merging leaves both counters as they are */
 					GpHLLCounter final = NULL;
-					final = gp_hyperloglog_merge_counters(hllcounter_temp1, hllcounter_temp2);
-
-					pfree(hllcounter_temp1);
-					pfree(hllcounter_temp2);
+					final = gp_hyperloglog_merge_counters(hllcounters_left[i], hllcounters_right[i]);
 
 					if (final != NULL)
 					{
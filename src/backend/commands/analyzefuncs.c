@@ -32,6 +32,7 @@ typedef struct
 	HeapTuple  *rows;
 	double		totalrows;
 	double		totaldeadrows;
+	int64		totalbytes;
 	TupleDesc	outDesc;
 	int			natts;
 
@@ -53,9 +54,10 @@ typedef struct
  * is a set-returning function, and returns the sample rows, as you might
  * expect. But to return the extra 'totalrows' and 'totaldeadrows' values,
  * it always also returns one extra row, the "summary row". The summary row
- * is all NULLs for the actual table columns, but contains two other columns
- * instead, "totalrows" and "totaldeadrows". Those columns are NULL in all
- * the actual sample rows.
+ * is all NULLs for the actual table columns, but contains three other columns
+ * instead, "totalrows", "totaldeadrows" and "totalbytes", the size of the
+ * table on the segment. That saves the dispatcher a separate round trip to
+ * get the table size. Those columns are NULL in all the actual sample rows.
  *
  * To make things even more complicated, each sample row contains one extra
  * column too: oversized_cols_bitmap. It's a bitmap indicating which attributes
@@ -70,20 +72,21 @@ typedef struct
  *     -- special columns
  *     totalrows pg_catalog.float8,
  *     totaldeadrows pg_catalog.float8,
+ *     totalbytes pg_catalog.float8,
  *     oversized_cols_bitmap pg_catalog.text,
  *     -- columns matching the table
  *     id int4,
  *     t text
  *  );
- *  totalrows | totaldeadrows | oversized_cols_bitmap | id  |    t    
- * -----------+---------------+-----------------------+-----+---------
- *            |               |                       |   1 | foo
- *            |               |                       |   2 | bar
- *            |               | 01                    |  50 | 
- *            |               |                       | 100 | foo 100
- *          2 |             0 |                       |     | 
- *          1 |             0 |                       |     | 
- *          1 |             0 |                       |     | 
+ *  totalrows | totaldeadrows | totalbytes | oversized_cols_bitmap | id  |    t    
+ * -----------+---------------+------------+-----------------------+-----+---------
+ *            |               |            |                       |   1 | foo
+ *            |               |            |                       |   2 | bar
+ *            |               |            | 01                    |  50 | 
+ *            |               |            |                       | 100 | foo 100
+ *          2 |             0 |      32768 |                       |     | 
+ *          1 |             0 |      32768 |                       |     | 
+ *          1 |             0 |      32768 |                       |     | 
  * (7 rows)
  *
  * The first four columns form the actual sample. One of the columns contained
@@ -111,6 +114,7 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 	{
 		double		totalrows;
 		double		totaldeadrows;
+		int64		totalbytes;
 		Relation	onerel;
 		int			attno;
 		int			numrows;
@@ -142,7 +146,7 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 			natts++;
 		}
 
-		outDesc = CreateTemplateTupleDesc(3 + natts, false);
+		outDesc = CreateTemplateTupleDesc(NUM_SAMPLE_SPECIAL_COLS + natts, false);
 
 		/* First, some special cols: */
 
@@ -159,16 +163,22 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 						   FLOAT8OID,
 						   -1,
 						   0);
+		TupleDescInitEntry(outDesc,
+						   3,
+						   "totalbytes",
+						   FLOAT8OID,
+						   -1,
+						   0);
 
 		/* extra column to indicate oversize cols */
 		TupleDescInitEntry(outDesc,
-						   3,
+						   4,
 						   "oversized_cols_bitmap",
 						   TEXTOID,
 						   -1,
 						   0);
 
-		outattno = 4;
+		outattno = NUM_SAMPLE_SPECIAL_COLS + 1;
 		for (attno = 1; attno <= relDesc->natts; attno++)
 		{
 			Form_pg_attribute relatt = (Form_pg_attribute) relDesc->attrs[attno - 1];
@@ -206,6 +216,7 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 			numrows = fdwroutine->AcquireSampleRowsOnSegment(onerel, DEBUG1,
 			                                                 rows, targrows,
 			                                                 &totalrows, &totaldeadrows);
+			totalbytes = -1;
 
 		}
 		else if (inherited)
@@ -213,11 +224,13 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 			numrows = acquire_inherited_sample_rows(onerel, DEBUG1,
 													rows, targrows,
 													&totalrows, &totaldeadrows);
+			totalbytes = -1;
 		}
 		else
 		{
 			numrows = acquire_sample_rows(onerel, DEBUG1, rows, targrows,
 										  &totalrows, &totaldeadrows);
+			totalbytes = acquire_local_relation_size(onerel);
 		}
 
 		/* Construct the context to keep across calls. */
@@ -230,6 +243,7 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 		ctx->rows = rows;
 		ctx->totalrows = totalrows;
 		ctx->totaldeadrows = totaldeadrows;
+		ctx->totalbytes = totalbytes;
 
 		ctx->index = 0;
 		ctx->summary_sent = false;
@@ -260,7 +274,7 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 
 		heap_deform_tuple(relTuple, relDesc, relvalues, relnulls);
 
-		outattno = 4;
+		outattno = NUM_SAMPLE_SPECIAL_COLS + 1;
 		for (attno = 1; attno <= relDesc->natts; attno++)
 		{
 			Form_pg_attribute relatt = (Form_pg_attribute) relDesc->attrs[attno - 1];
@@ -280,7 +294,7 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 
 				if (toasted_size > WIDTH_THRESHOLD)
 				{
-					toolarge = bms_add_member(toolarge, outattno - 3);
+					toolarge = bms_add_member(toolarge, outattno - NUM_SAMPLE_SPECIAL_COLS);
 					is_toolarge = true;
 					relvalue = (Datum) 0;
 					relnull = true;
@@ -313,18 +327,20 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 			}
 			toolarge_str[i] = '\0';
 
-			outvalues[2] = CStringGetTextDatum(toolarge_str);
-			outnulls[2] = false;
+			outvalues[3] = CStringGetTextDatum(toolarge_str);
+			outnulls[3] = false;
 		}
 		else
 		{
-			outvalues[2] = (Datum) 0;
-			outnulls[2] = true;
+			outvalues[3] = (Datum) 0;
+			outnulls[3] = true;
 		}
 		outvalues[0] = (Datum) 0;
 		outnulls[0] = true;
 		outvalues[1] = (Datum) 0;
 		outnulls[1] = true;
+		outvalues[2] = (Datum) 0;
+		outnulls[2] = true;
 
 		res = heap_form_tuple(outDesc, outvalues, outnulls);
 
@@ -339,18 +355,28 @@ gp_acquire_sample_rows(PG_FUNCTION_ARGS)
 
 		for (outattno = 1; outattno <= natts; outattno++)
 		{
-			outvalues[3 + outattno - 1] = (Datum) 0;
-			outnulls[3 + outattno - 1] = true;
+			outvalues[NUM_SAMPLE_SPECIAL_COLS + outattno - 1] = (Datum) 0;
+			outnulls[NUM_SAMPLE_SPECIAL_COLS + outattno - 1] = true;
 		}
 
 		outvalues[0] = Float8GetDatum(ctx->totalrows);
 		outnulls[0] = false;
 		outvalues[1] = Float8GetDatum(ctx->totaldeadrows);
 		outnulls[1] = false;
+		if (ctx->totalbytes >= 0)
+		{
+			outvalues[2] = Float8GetDatum((double) ctx->totalbytes);
+			outnulls[2] = false;
+		}
+		else
+		{
+			outvalues[2] = (Datum) 0;
+			outnulls[2] = true;
+		}
 
-		outvalues[2] = (Datum) 0;
-		outnulls[2] = true;
-		for (outattno = 3; outattno < outDesc->natts; outattno++)
+		outvalues[3] = (Datum) 0;
+		outnulls[3] = true;
+		for (outattno = NUM_SAMPLE_SPECIAL_COLS; outattno < outDesc->natts; outattno++)
 		{
 			outvalues[outattno] = (Datum) 0;
 			outnulls[outattno] = true;
@@ -10,19 +10,28 @@
  */
 #include "postgres.h"
 
+#include <unistd.h>
+
+#include "access/aomd.h"
+#include "access/appendonlytid.h"
+#include "access/hash.h"
 #include "access/heapam.h"
+#include "access/htup_details.h"
 #include "catalog/pg_collation.h"
 #include "catalog/pg_statistic.h"
 #include "cdb/cdbhash.h"
 #include "cdb/cdbpartition.h"
+#include "common/relpath.h"
 #include "commands/analyzeutils.h"
 #include "commands/vacuum.h"
 #include "lib/binaryheap.h"
 #include "miscadmin.h"
 #include "parser/parse_oper.h"
+#include "storage/fd.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/syscache.h"
 #include "utils/hsearch.h"
 
@@ -51,6 +60,7 @@ static void addLeafPartitionMCVsToHashTable(HTAB *datumHash, HeapTuple heaptuple
 );
 static void addMCVToHashTable(HTAB *datumHash, MCVFreqPair *mcvFreqPair);
 static int	mcvpair_cmp(const void *a, const void *b);
+static uint32 AOSegfileSampleSignature(Relation rel);
 
 static void initTypInfo(TypInfo *typInfo, Oid typOid);
 static int	DatumHeapComparator(Datum lhs, Datum rhs, void *context);
@@ -1128,3 +1138,264 @@ leaf_parts_analyzed(Oid attrelid, Oid relid_exclude, List *va_cols, int elevel)
 
 	return !all_parts_empty;
 }
+
+/*
+ * Samples of the segment files of append-only tables, kept by ANALYZE
+ * between runs. There is one file per relation, next to its data files and
+ * named after them, so it is removed along with them by DROP, TRUNCATE,
+ * table rewrites and DROP DATABASE (see mdunlink_ao()). The files are only
+ * a cache: one that is missing, unreadable or doesn't match the relation is
+ * ignored, and they are not WAL-logged.
+ */
+#define AOSAMPLE_FORMAT_ID		0x414F5301
+
+static void
+AOSegfileSamplePath(Relation rel, char *path, size_t len)
+{
+	char	   *relpath = relpathbackend(rel->rd_node, rel->rd_backend, MAIN_FORKNUM);
+
+	snprintf(path, len, "%s" AOSAMPLE_SUFFIX, relpath);
+	pfree(relpath);
+}
+
+/*
+ * The stored rows are only usable with the row type they were formed with,
+ * which ALTER TABLE can change without a new relfilenode.
+ */
+static uint32
+AOSegfileSampleSignature(Relation rel)
+{
+	TupleDesc	tupdesc = RelationGetDescr(rel);
+	int32	   *attrs;
+	uint32		result;
+	int			i;
+
+	attrs = palloc((tupdesc->natts * 3 + 2) * sizeof(int32));
+	attrs[0] = RelationGetRelid(rel);
+	attrs[1] = tupdesc->natts;
+	for (i = 0; i < tupdesc->natts; i++)
+	{
+		attrs[i * 3 + 2] = tupdesc->attrs[i]->atttypid;
+		attrs[i * 3 + 3] = tupdesc->attrs[i]->atttypmod;
+		attrs[i * 3 + 4] = tupdesc->attrs[i]->attisdropped;
+	}
+	result = DatumGetUInt32(hash_any((unsigned char *) attrs,
+									 (tupdesc->natts * 3 + 2) * sizeof(int32)));
+	pfree(attrs);
+
+	return result;
+}
+
+/*
+ * Read the segment file samples kept for a relation by
+ * writeAOSegfileSamples(). Returns NULL if there are none.
+ */
+AOSegfileSample *
+readAOSegfileSamples(Relation rel, int *nsamples)
+{
+	char		path[MAXPGPATH];
+	FILE	   *fp;
+	int32		format_id;
+	uint32		signature;
+	int32		nentries;
+	AOSegfileSample *samples = NULL;
+	int			nread = 0;
+	bool		ok = false;
+
+	*nsamples = 0;
+
+	AOSegfileSamplePath(rel, path, sizeof(path));
+	fp = AllocateFile(path, PG_BINARY_R);
+	if (fp == NULL)
+		return NULL;
+
+	if (fread(&format_id, sizeof(format_id), 1, fp) != 1 ||
+		format_id != AOSAMPLE_FORMAT_ID ||
+		fread(&signature, sizeof(signature), 1, fp) != 1 ||
+		signature != AOSegfileSampleSignature(rel) ||
+		fread(&nentries, sizeof(nentries), 1, fp) != 1 ||
+		nentries < 0 || nentries > AOTupleId_MaxSegmentFileNum + 1)
+		goto done;
+
+	samples = palloc0(Max(nentries, 1) * sizeof(AOSegfileSample));
+	for (nread = 0; nread < nentries; nread++)
+	{
+		AOSegfileSample *sample = &samples[nread];
+		int			i;
+
+		if (fread(&sample->segno, sizeof(sample->segno), 1, fp) != 1 ||
+			fread(&sample->modcount, sizeof(sample->modcount), 1, fp) != 1 ||
+			fread(&sample->tupcount, sizeof(sample->tupcount), 1, fp) != 1 ||
+			fread(&sample->hiddencount, sizeof(sample->hiddencount), 1, fp) != 1 ||
+			fread(&sample->liverows, sizeof(sample->liverows), 1, fp) != 1 ||
+			fread(&sample->numrows, sizeof(sample->numrows), 1, fp) != 1 ||
+			sample->numrows < 0 ||
+			sample->numrows > MaxAllocSize / sizeof(HeapTuple))
+			goto done;
+
+		sample->rows = palloc(Max(sample->numrows, 1) * sizeof(HeapTuple));
+		for (i = 0; i < sample->numrows; i++)
+		{
+			HeapTuple	tuple;
+			uint32		len;
+
+			if (fread(&len, sizeof(len), 1, fp) != 1 ||
+				len < offsetof(HeapTupleHeaderData, t_bits) ||
+				len > MaxAllocSize - HEAPTUPLESIZE)
+				break;
+			tuple = (HeapTuple) palloc(HEAPTUPLESIZE + len);
+			tuple->t_len = len;
+			tuple->t_data = (HeapTupleHeader) ((char *) tuple + HEAPTUPLESIZE);
+			if (fread(&tuple->t_self, sizeof(ItemPointerData), 1, fp) != 1 ||
+				fread(tuple->t_data, len, 1, fp) != 1)
+			{
+				pfree(tuple);
+				break;
+			}
+			sample->rows[i] = tuple;
+		}
+		if (i < sample->numrows)
+		{
+			sample->numrows = i;
+			nread++;
+			goto done;
+		}
+	}
+
+	/* the format id is repeated at the end, to catch a truncated file */
+	ok = (fread(&format_id, sizeof(format_id), 1, fp) == 1 &&
+		  format_id == AOSAMPLE_FORMAT_ID);
+
+done:
+	FreeFile(fp);
+
+	if (!ok)
+	{
+		int			i;
+
+		elog(DEBUG1, "ignoring invalid append-only sample file \"%s\"", path);
+		for (i = 0; i < nread; i++)
+		{
+			int			j;
+
+			for (j = 0; j < samples[i].numrows; j++)
+				heap_freetuple(samples[i].rows[j]);
+			pfree(samples[i].rows);
+		}
+		if (samples)
+			pfree(samples);
+		return NULL;
+	}
+
+	*nsamples = nentries;
+	return samples;
+}
+
+/*
+ * Keep the segment file samples of a relation for the next ANALYZE.
+ *
+ * Samples with toasted values are left out, because the toast pointers may
+ * outlive the values they point to. Failing to write the file is not an
+ * error: the next ANALYZE will just scan everything again.
+ */
+void
+writeAOSegfileSamples(Relation rel, AOSegfileSample *samples, int nsamples)
+{
+	char		path[MAXPGPATH];
+	char		tmppath[MAXPGPATH];
+	FILE	   *fp;
+	int32		format_id = AOSAMPLE_FORMAT_ID;
+	uint32		signature = AOSegfileSampleSignature(rel);
+	bool	   *keep;
+	int32		nentries = 0;
+	int			i;
+
+	keep = palloc(Max(nsamples, 1) * sizeof(bool));
+	for (i = 0; i < nsamples; i++)
+	{
+		int			j;
+
+		keep[i] = true;
+		for (j = 0; j < samples[i].numrows; j++)
+		{
+			if (HeapTupleHasExternal(samples[i].rows[j]))
+			{
+				keep[i] = false;
+				break;
+			}
+		}
+		if (keep[i])
+			nentries++;
+	}
+
+	AOSegfileSamplePath(rel, path, sizeof(path));
+	/* two backends may analyze the same table at once */
+	snprintf(tmppath, sizeof(tmppath), "%s.%d.tmp", path, MyProcPid);
+
+	fp = AllocateFile(tmppath, PG_BINARY_W);
+	if (fp == NULL)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", tmppath)));
+		pfree(keep);
+		return;
+	}
+
+	fwrite(&format_id, sizeof(format_id), 1, fp);
+	fwrite(&signature, sizeof(signature), 1, fp);
+	fwrite(&nentries, sizeof(nentries), 1, fp);
+	for (i = 0; i < nsamples; i++)
+	{
+		AOSegfileSample *sample = &samples[i];
+		int			j;
+
+		if (!keep[i])
+			continue;
+
+		fwrite(&sample->segno, sizeof(sample->segno), 1, fp);
+		fwrite(&sample->modcount, sizeof(sample->modcount), 1, fp);
+		fwrite(&sample->tupcount, sizeof(sample->tupcount), 1, fp);
+		fwrite(&sample->hiddencount, sizeof(sample->hiddencount), 1, fp);
+		fwrite(&sample->liverows, sizeof(sample->liverows), 1, fp);
+		fwrite(&sample->numrows, sizeof(sample->numrows), 1, fp);
+		for (j = 0; j < sample->numrows; j++)
+		{
+			HeapTuple	tuple = sample->rows[j];
+			uint32		len = tuple->t_len;
+
+			fwrite(&len, sizeof(len), 1, fp);
+			fwrite(&tuple->t_self, sizeof(ItemPointerData), 1, fp);
+			fwrite(tuple->t_data, len, 1, fp);
+		}
+	}
+	fwrite(&format_id, sizeof(format_id), 1, fp);
+
+	pfree(keep);
+
+	if (ferror(fp))
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not write file \"%s\": %m", tmppath)));
+		FreeFile(fp);
+		unlink(tmppath);
+		return;
+	}
+	if (FreeFile(fp) < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not close file \"%s\": %m", tmppath)));
+		unlink(tmppath);
+		return;
+	}
+	if (rename(tmppath, path) < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not rename file \"%s\" to \"%s\": %m",
+						tmppath, path)));
+		unlink(tmppath);
+	}
+}
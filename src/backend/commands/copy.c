@@ -42,6 +42,7 @@
 #include "optimizer/clauses.h"
 #include "optimizer/planner.h"
 #include "nodes/makefuncs.h"
+#include "port/pg_bytescan.h"
 #include "rewrite/rewriteHandler.h"
 #include "storage/fd.h"
 #include "tcop/tcopprot.h"
@@ -6152,6 +6153,7 @@ CopyReadLineText(CopyState cstate)
 	bool		hit_eof = false;
 	bool		result = false;
 	char		mblen_str[2];
+	ByteScanSet special;
 
 	/* CSV variables */
 	bool		first_char_in_line = true;
@@ -6171,6 +6173,21 @@ CopyReadLineText(CopyState cstate)
 
 	mblen_str[1] = '\0';
 
+	/*
+	 * The characters the loop below acts on.  Anything else is just part of
+	 * the line, so runs of it are skipped with bytescan_find().
+	 */
+	bytescan_init(&special, cstate->encoding_embeds_ascii);
+	bytescan_add(&special, '\r');
+	bytescan_add(&special, '\n');
+	bytescan_add(&special, '\\');
+	if (cstate->csv_mode)
+	{
+		bytescan_add(&special, quotec);
+		if (escapec != '\0')
+			bytescan_add(&special, escapec);
+	}
+
 	/*
 	 * The objective of this loop is to transfer the entire next input line
 	 * into line_buf.  Hence, we only care for detecting newlines (\r and/or
@@ -6236,6 +6253,21 @@ CopyReadLineText(CopyState cstate)
 			need_data = false;
 		}
 
+		/*
+		 * Skip ordinary characters.  None of them is the escape character,
+		 * and none can be the first character of the line any more.
+		 */
+		prev_raw_ptr = raw_buf_ptr;
+		raw_buf_ptr = bytescan_find(&special, copy_raw_buf + raw_buf_ptr,
+									copy_raw_buf + copy_buf_len) - copy_raw_buf;
+		if (raw_buf_ptr > prev_raw_ptr)
+		{
+			first_char_in_line = false;
+			last_was_esc = false;
+			if (raw_buf_ptr >= copy_buf_len)
+				continue;
+		}
+
 		/* OK to fetch a character */
 		prev_raw_ptr = raw_buf_ptr;
 		c = copy_raw_buf[raw_buf_ptr++];
@@ -6575,6 +6607,7 @@ CopyReadAttributesText(CopyState cstate, int stop_processing_at_field)
 	char	   *output_ptr;
 	char	   *cur_ptr;
 	char	   *line_end_ptr;
+	ByteScanSet special;
 
 	/*
 	 * We need a special case for zero-column tables: check that the input
@@ -6606,6 +6639,10 @@ CopyReadAttributesText(CopyState cstate, int stop_processing_at_field)
 	cur_ptr = cstate->line_buf.data + cstate->line_buf.cursor;
 	line_end_ptr = cstate->line_buf.data + cstate->line_buf.len;
 
+	bytescan_init(&special, false);
+	bytescan_add(&special, delimc);
+	bytescan_add(&special, escapec);
+
 	/* Outer loop iterates over fields */
 	fieldno = 0;
 	for (;;)
@@ -6651,6 +6688,16 @@ CopyReadAttributesText(CopyState cstate, int stop_processing_at_field)
 		for (;;)
 		{
 			char		c;
+			char	   *run_end_ptr;
+
+			/* Copy data up to the next delimiter or escape as is */
+			run_end_ptr = (char *) bytescan_find(&special, cur_ptr, line_end_ptr);
+			if (run_end_ptr > cur_ptr)
+			{
+				memcpy(output_ptr, cur_ptr, run_end_ptr - cur_ptr);
+				output_ptr += run_end_ptr - cur_ptr;
+				cur_ptr = run_end_ptr;
+			}
 
 			end_ptr = cur_ptr;
 			if (cur_ptr >= line_end_ptr)
@@ -6823,6 +6870,8 @@ CopyReadAttributesCSV(CopyState cstate, int stop_processing_at_field)
 	char	   *output_ptr;
 	char	   *cur_ptr;
 	char	   *line_end_ptr;
+	ByteScanSet unquoted_special;
+	ByteScanSet quoted_special;
 
 	/*
 	 * We need a special case for zero-column tables: check that the input
@@ -6854,6 +6903,13 @@ CopyReadAttributesCSV(CopyState cstate, int stop_processing_at_field)
 	cur_ptr = cstate->line_buf.data + cstate->line_buf.cursor;
 	line_end_ptr = cstate->line_buf.data + cstate->line_buf.len;
 
+	bytescan_init(&unquoted_special, false);
+	bytescan_add(&unquoted_special, delimc);
+	bytescan_add(&unquoted_special, quotec);
+	bytescan_init(&quoted_special, false);
+	bytescan_add(&quoted_special, quotec);
+	bytescan_add(&quoted_special, escapec);
+
 	/* Outer loop iterates over fields */
 	fieldno = 0;
 	for (;;)
@@ -6895,10 +6951,21 @@ CopyReadAttributesCSV(CopyState cstate, int stop_processing_at_field)
 		for (;;)
 		{
 			char		c;
+			char	   *run_end_ptr;
 
 			/* Not in quote */
 			for (;;)
 			{
+				/* Copy data up to the next delimiter or quote as is */
+				run_end_ptr = (char *) bytescan_find(&unquoted_special,
+													 cur_ptr, line_end_ptr);
+				if (run_end_ptr > cur_ptr)
+				{
+					memcpy(output_ptr, cur_ptr, run_end_ptr - cur_ptr);
+					output_ptr += run_end_ptr - cur_ptr;
+					cur_ptr = run_end_ptr;
+				}
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					goto endfield;
@@ -6922,6 +6989,16 @@ CopyReadAttributesCSV(CopyState cstate, int stop_processing_at_field)
 			/* In quote */
 			for (;;)
 			{
+				/* Copy data up to the next quote or escape as is */
+				run_end_ptr = (char *) bytescan_find(&quoted_special,
+													 cur_ptr, line_end_ptr);
+				if (run_end_ptr > cur_ptr)
+				{
+					memcpy(output_ptr, cur_ptr, run_end_ptr - cur_ptr);
+					output_ptr += run_end_ptr - cur_ptr;
+					cur_ptr = run_end_ptr;
+				}
+
 				end_ptr = cur_ptr;
 				if (cur_ptr >= line_end_ptr)
 					ereport(ERROR,
@@ -49,6 +49,8 @@
 #include "executor/execDynamicScan.h"
 
 #ifdef USE_ORCA
+#include "optimizer/orca.h"
+
 extern char *SerializeDXLPlan(Query *parse);
 extern const char *OptVersion();
 #endif
@@ -76,6 +78,7 @@ static void report_triggers(ResultRelInfo *rInfo, bool show_relname,
 static void ExplainDXL(Query *query, ExplainState *es,
 							const char *queryString,
 							ParamListInfo params);
+static void ExplainOptimizerProfile(ExplainState *es);
 #endif
 static double elapsed_time(instr_time *starttime);
 static bool ExplainPreScanNode(PlanState *planstate, Bitmapset **rels_used);
@@ -207,6 +210,8 @@ ExplainQuery(ExplainStmt *stmt, const char *queryString,
 		}
 		else if (strcmp(opt->defname, "dxl") == 0)
 			es->dxl = defGetBoolean(opt);
+		else if (strcmp(opt->defname, "optimizer_profile") == 0)
+			es->optimizer_profile = defGetBoolean(opt);
 		else
 			ereport(ERROR,
 					(errcode(ERRCODE_SYNTAX_ERROR),
@@ -381,6 +386,60 @@ ExplainDXL(Query *query, ExplainState *es, const char *queryString,
 	/* Free the memory we used. */
 	MemoryContextSwitchTo(oldcxt);
 }
+
+/*
+ * ExplainOptimizerProfile -
+ *	  print out where the time and memory of the GPORCA optimization of
+ *	  the plan went, from the profile it left behind
+ */
+static void
+ExplainOptimizerProfile(ExplainState *es)
+{
+	OptimizerProfile *profile = &optimizer_last_profile;
+
+	ExplainOpenGroup("Optimizer Profile", "Optimizer Profile", true, es);
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+	{
+		appendStringInfoString(es->str, "Optimizer Profile:\n");
+		es->indent++;
+	}
+
+	ExplainPropertyFloat("Query to DXL Time", profile->query_to_dxl_time, 3, es);
+	ExplainPropertyFloat("Search Time", profile->search_time, 3, es);
+	ExplainPropertyInteger("Search Stages", profile->search_stages, es);
+	ExplainPropertyFloat("DXL to PlannedStmt Time", profile->dxl_to_plstmt_time, 3, es);
+	ExplainPropertyFloat("Metadata Fetch Time", profile->md_fetch_time, 3, es);
+	ExplainPropertyFloat("Total Time", profile->total_time, 3, es);
+
+	ExplainPropertyLong("Object Fetches",
+						profile->md_fetches[MDCACHE_ENTRY_OBJECT], es);
+	ExplainPropertyLong("Relation Stats Fetches",
+						profile->md_fetches[MDCACHE_ENTRY_RELSTATS], es);
+	ExplainPropertyLong("Column Stats Fetches",
+						profile->md_fetches[MDCACHE_ENTRY_COLSTATS], es);
+	ExplainPropertyLong("Cast Fetches",
+						profile->md_fetches[MDCACHE_ENTRY_CAST], es);
+	ExplainPropertyLong("Comparison Fetches",
+						profile->md_fetches[MDCACHE_ENTRY_SCCMP], es);
+	if (OptMDCacheSharedEnabled())
+	{
+		long		shared_hits = 0;
+		int			i;
+
+		for (i = 0; i < MDCACHE_NUM_ENTRY_KINDS; i++)
+			shared_hits += profile->md_shared_hits[i];
+		ExplainPropertyLong("Shared Metadata Hits", shared_hits, es);
+	}
+
+	ExplainPropertyLong("Allocations", profile->allocations, es);
+	ExplainPropertyLong("Bytes Allocated", profile->bytes_allocated, es);
+
+	if (es->format == EXPLAIN_FORMAT_TEXT)
+		es->indent--;
+
+	ExplainCloseGroup("Optimizer Profile", "Optimizer Profile", true, es);
+}
 #endif
 
 /*
@@ -416,6 +475,9 @@ ExplainOneQuery(Query *query, IntoClause *into, ExplainState *es,
 		PlannedStmt *plan;
 		instr_time	planstart,
 					planduration;
+#ifdef USE_ORCA
+		int64		profile_count = optimizer_profile_count;
+#endif
 
 		INSTR_TIME_SET_CURRENT(planstart);
 
@@ -425,6 +487,11 @@ ExplainOneQuery(Query *query, IntoClause *into, ExplainState *es,
 		INSTR_TIME_SET_CURRENT(planduration);
 		INSTR_TIME_SUBTRACT(planduration, planstart);
 
+#ifdef USE_ORCA
+		/* GPORCA left a profile behind, if it optimized the query */
+		es->optimizer_profiled = (optimizer_profile_count != profile_count);
+#endif
+
 		/*
 		 * GPDB_92_MERGE_FIXME: it really should be an optimizer's responsibility
 		 * to correctly set the into-clause and into-policy of the PlannedStmt.
@@ -676,6 +743,12 @@ ExplainOnePlan(PlannedStmt *plannedstmt, IntoClause *into, ExplainState *es,
 
 	ExplainCloseGroup("Settings", "Settings", true, es);
 
+#ifdef USE_ORCA
+	if (es->optimizer_profile && es->optimizer_profiled &&
+		queryDesc->plannedstmt->planGen == PLANGEN_OPTIMIZER)
+		ExplainOptimizerProfile(es);
+#endif
+
 	/*
 	 * Close down the query and free resources.  Include time for this in the
 	 * total execution time (although it should be pretty minimal).
@@ -34,6 +34,10 @@
 #include "utils/snapmgr.h"
 #include "utils/timestamp.h"
 
+#ifdef USE_ORCA
+#include "optimizer/orca.h"
+#endif
+
 
 /*
  * The hash table in which prepared queries are stored. This is
@@ -651,6 +655,9 @@ ExplainExecuteQuery(ExecuteStmt *execstmt, IntoClause *into, ExplainState *es,
 	ListCell   *p;
 	ParamListInfo paramLI = NULL;
 	EState	   *estate = NULL;
+#ifdef USE_ORCA
+	int64		profile_count;
+#endif
 
 	/* Look it up in the hash table */
 	entry = FetchPreparedStatement(execstmt->name, true);
@@ -696,10 +703,19 @@ ExplainExecuteQuery(ExecuteStmt *execstmt, IntoClause *into, ExplainState *es,
 	}
 
 	/* Replan if needed, and acquire a transient refcount */
+#ifdef USE_ORCA
+	profile_count = optimizer_profile_count;
+#endif
 	cplan = GetCachedPlan(entry->plansource, paramLI, true, into);
 
 	plan_list = cplan->stmt_list;
 
+#ifdef USE_ORCA
+	/* The profile GPORCA left behind only covers the last statement */
+	es->optimizer_profiled = (optimizer_profile_count != profile_count &&
+							  list_length(plan_list) == 1);
+#endif
+
 	/* Explain each query */
 	foreach(p, plan_list)
 	{
@@ -813,6 +829,106 @@ pg_prepared_statement(PG_FUNCTION_ARGS)
 	return (Datum) 0;
 }
 
+/*
+ * This set returning function reads how well the GPORCA custom plans kept
+ * by each prepared statement of this session are being reused (see
+ * optimizer_plan_cache_size).  Times are in milliseconds; planning_time is
+ * what it took to build the plans currently kept.
+ */
+Datum
+gp_optimizer_plan_cache_stats(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* need to build tuplestore in query context */
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	/*
+	 * build tupdesc for result tuples. This must match the definition of the
+	 * gp_stat_optimizer_plan_cache view in system_views.sql
+	 */
+	tupdesc = CreateTemplateTupleDesc(6, false);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 1, "name",
+					   TEXTOID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 2, "lookups",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 3, "hits",
+					   INT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 4, "cached_plans",
+					   INT4OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 5, "planning_time",
+					   FLOAT8OID, -1, 0);
+	TupleDescInitEntry(tupdesc, (AttrNumber) 6, "saved_time",
+					   FLOAT8OID, -1, 0);
+
+	tupstore =
+		tuplestore_begin_heap(rsinfo->allowedModes & SFRM_Materialize_Random,
+							  false, work_mem);
+
+	/* generate junk in short-term context */
+	MemoryContextSwitchTo(oldcontext);
+
+	/* hash table might be uninitialized */
+	if (prepared_queries)
+	{
+		HASH_SEQ_STATUS hash_seq;
+		PreparedStatement *prep_stmt;
+
+		hash_seq_init(&hash_seq, prepared_queries);
+		while ((prep_stmt = hash_seq_search(&hash_seq)) != NULL)
+		{
+			CachedPlanSource *plansource = prep_stmt->plansource;
+			Datum		values[6];
+			bool		nulls[6];
+			double		planning_time = 0;
+			ListCell   *lc;
+
+			/* Only report the statements that GPORCA plans were looked up for */
+			if (plansource->num_orca_lookups == 0)
+				continue;
+
+			foreach(lc, plansource->orca_plans)
+				planning_time += ((CachedPlan *) lfirst(lc))->planning_time;
+
+			MemSet(nulls, 0, sizeof(nulls));
+
+			values[0] = CStringGetTextDatum(prep_stmt->stmt_name);
+			values[1] = Int64GetDatum(plansource->num_orca_lookups);
+			values[2] = Int64GetDatum(plansource->num_orca_hits);
+			values[3] = Int32GetDatum(list_length(plansource->orca_plans));
+			values[4] = Float8GetDatum(planning_time);
+			values[5] = Float8GetDatum(plansource->orca_saved_time);
+
+			tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+		}
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	return (Datum) 0;
+}
+
 /*
  * This utility function takes a C array of Oids, and returns a Datum
  * pointing to a one-dimensional Postgres array of regtypes. An empty
@@ -31,6 +31,9 @@
 #include "gpopt/gpdbwrappers.h"
 #include "catalog/pg_collation.h"
 extern "C" {
+	#include "access/xact.h"
+	#include "utils/guc.h"
+	#include "utils/hsearch.h"
 	#include "utils/memutils.h"
 	#include "parser/parse_agg.h"
 }
@@ -3078,16 +3081,38 @@ gpdb::CountLeafPartTables
 }
 
 /*
- * To detect changes to catalog tables that require resetting the Metadata
+ * To detect changes to catalog tables that require invalidating the Metadata
  * Cache, we use the normal PostgreSQL catalog cache invalidation mechanism.
  * We register a callback to a cache on all the catalog tables that contain
  * information that's contained in the ORCA metadata cache.
-
- * There is no fine-grained mechanism in the metadata cache for invalidating
- * individual entries ATM, so we just blow the whole cache whenever anything
- * changes. The callback simply increments a counter. Whenever we start
- * planning a query, we check the counter to see if it has changed since the
- * last planned query, and reset the whole cache if it has.
+ *
+ * Every object that the relcache metadata provider hands over to the
+ * metadata cache is recorded in a registry, keyed by the identity of its
+ * metadata id (see MDCacheRegisterEntry()). The callbacks just remember which
+ * relations and syscache entries were invalidated. Whenever we start planning
+ * a query, the pending invalidations are matched against the registry, and
+ * only the affected entries are evicted from the cache (see
+ * MDCacheGetInvalidatedEntries()). A syscache invalidation only carries the
+ * hash value of the invalidated entry's key, so an entry is considered
+ * invalidated if the hash of its own key is the same. A hash collision merely
+ * evicts an entry that didn't need to be.
+ *
+ * Invalidations that cannot be mapped back to individual entries, like a
+ * full relcache or catcache reset, changes to the partitioning catalogs or
+ * to operator families, or an overflow of the pending lists, still blow the
+ * whole cache (see MDCacheNeedsReset()).
+ *
+ * Types, operators, functions and aggregates are not tied to a relation,
+ * and their metadata objects also describe the objects they refer to: a
+ * type includes its comparison operators and array type, an operator its
+ * function and argument types, and so on. Rather than track all of those,
+ * any change to pg_type, pg_operator, pg_proc or pg_aggregate evicts all
+ * of them. Relations and their statistics, which are the expensive ones to
+ * translate, stay cached.
+ *
+ * The metadata store that is shared by all backends doesn't depend on these
+ * callbacks. Its entries are invalidated by the backend that sends the
+ * invalidation messages (see utils/cache/optmdcache.c).
  *
  * To make sure we've covered all catalog tables that contain information
  * that's stored in the metadata cache, there are "catalog tables: xxx"
@@ -3096,20 +3121,86 @@ gpdb::CountLeafPartTables
  * anything fetched via the wrapper functions in this file can end up in the
  * metadata cache and hence need to have an invalidation callback registered.
  */
-static bool mdcache_invalidation_counter_registered = false;
-static int64 mdcache_invalidation_counter = 0;
-static int64 last_mdcache_invalidation_counter = 0;
+#define MDCACHE_MAX_PENDING_INVALS		256
+#define MDCACHE_MAX_TRACKED_ENTRIES		65536
+
+typedef struct MDCacheSyscacheInval
+{
+	int			cacheid;
+	uint32		hashvalue;
+} MDCacheSyscacheInval;
+
+typedef struct MDCacheTrackedEntry
+{
+	MDCacheEntryKey key;		/* hash key, must be first */
+	Oid			relid;			/* relation the entry depends on, if any */
+	AttrNumber	attno;			/* attribute number, for column statistics */
+	uint64		fetched_in;		/* optimization that translated it */
+} MDCacheTrackedEntry;
+
+static bool mdcache_invalidation_callbacks_registered = false;
+static bool mdcache_reset_pending = false;
+
+static Oid mdcache_inval_relids[MDCACHE_MAX_PENDING_INVALS];
+static int mdcache_num_inval_relids = 0;
+static MDCacheSyscacheInval mdcache_inval_syscache[MDCACHE_MAX_PENDING_INVALS];
+static int mdcache_num_inval_syscache = 0;
+
+static HTAB *mdcache_tracked_entries = NULL;
+static MDCacheStats mdcache_stats;
+
+/* counts the optimizations, to tell which entries each one translated */
+static uint64 mdcache_optimization_count = 0;
 
 static void
-mdsyscache_invalidation_counter_callback(Datum arg, int cacheid, uint32 hashvalue)
+mdsyscache_invalidation_callback(Datum arg, int cacheid, uint32 hashvalue)
 {
-	mdcache_invalidation_counter++;
+	if (mdcache_reset_pending)
+		return;
+
+	/*
+	 * A zero hash value means that the whole catcache was flushed. Operator
+	 * families and the partitioning catalogs feed into too many different
+	 * metadata objects to track them individually.
+	 */
+	if (hashvalue == 0 ||
+		cacheid == AMOPOPID ||
+		cacheid == OPFAMILYOID ||
+		cacheid == PARTOID ||
+		cacheid == PARTRULEOID ||
+		mdcache_num_inval_syscache >= MDCACHE_MAX_PENDING_INVALS)
+	{
+		mdcache_reset_pending = true;
+		return;
+	}
+
+	mdcache_inval_syscache[mdcache_num_inval_syscache].cacheid = cacheid;
+	mdcache_inval_syscache[mdcache_num_inval_syscache].hashvalue = hashvalue;
+	mdcache_num_inval_syscache++;
 }
 
 static void
-mdrelcache_invalidation_counter_callback(Datum arg, Oid relid)
+mdrelcache_invalidation_callback(Datum arg, Oid relid)
 {
-	mdcache_invalidation_counter++;
+	int			i;
+
+	if (mdcache_reset_pending)
+		return;
+
+	/* InvalidOid means that the whole relcache was flushed */
+	if (!OidIsValid(relid) ||
+		mdcache_num_inval_relids >= MDCACHE_MAX_PENDING_INVALS)
+	{
+		mdcache_reset_pending = true;
+		return;
+	}
+
+	for (i = 0; i < mdcache_num_inval_relids; i++)
+	{
+		if (mdcache_inval_relids[i] == relid)
+			return;
+	}
+	mdcache_inval_relids[mdcache_num_inval_relids++] = relid;
 }
 
 static void
@@ -3171,16 +3262,169 @@ register_mdcache_invalidation_callbacks(void)
 	for (i = 0; i < lengthof(metadata_caches); i++)
 	{
 		CacheRegisterSyscacheCallback(metadata_caches[i],
-									  &mdsyscache_invalidation_counter_callback,
+									  &mdsyscache_invalidation_callback,
 									  (Datum) 0);
 	}
 
 	/* also register the relcache callback */
-	CacheRegisterRelcacheCallback(&mdrelcache_invalidation_counter_callback,
+	CacheRegisterRelcacheCallback(&mdrelcache_invalidation_callback,
 								  (Datum) 0);
 }
 
-// Has there been any catalog changes since last call?
+/*
+ * The size and statistics of a partitioned table are derived from its
+ * partitions, so a change to a partition invalidates all its ancestors, too.
+ * Add the ancestors of the given relations to the list.
+ */
+static List *
+mdcache_add_partition_ancestors(List *relids)
+{
+	ListCell   *lc;
+
+	/* The list grows while we walk it, so that we climb all the way up */
+	foreach(lc, relids)
+	{
+		/* catalog tables: pg_inherits */
+		Oid			parent = rel_partition_get_root(lfirst_oid(lc));
+
+		if (OidIsValid(parent) && !list_member_oid(relids, parent))
+		{
+			relids = lappend_oid(relids, parent);
+		}
+	}
+
+	return relids;
+}
+
+/*
+ * Forget about all tracked entries and pending invalidations, after the
+ * whole metadata cache has been reset.
+ */
+static void
+mdcache_forget_all_entries(void)
+{
+	if (mdcache_tracked_entries != NULL)
+	{
+		hash_destroy(mdcache_tracked_entries);
+		mdcache_tracked_entries = NULL;
+	}
+	mdcache_num_inval_relids = 0;
+	mdcache_num_inval_syscache = 0;
+	mdcache_reset_pending = false;
+}
+
+/*
+ * Does a pending syscache invalidation match the given key?
+ */
+static bool
+mdcache_syscache_inval_matches(const MDCacheSyscacheInval *invals, int ninvals,
+							   int cacheid, Datum key1, Datum key2, Datum key3)
+{
+	uint32		hashvalue = 0;
+	bool		computed = false;
+	int			i;
+
+	for (i = 0; i < ninvals; i++)
+	{
+		if (invals[i].cacheid != cacheid)
+			continue;
+
+		if (!computed)
+		{
+			hashvalue = GetSysCacheHashValue(cacheid, key1, key2, key3, 0);
+			computed = true;
+		}
+		if (invals[i].hashvalue == hashvalue)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Is a pending syscache invalidation on the given cache?
+ */
+static bool
+mdcache_syscache_inval_exists(const MDCacheSyscacheInval *invals, int ninvals,
+							  int cacheid)
+{
+	int			i;
+
+	for (i = 0; i < ninvals; i++)
+	{
+		if (invals[i].cacheid == cacheid)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Has the given tracked entry been invalidated by any of the pending
+ * invalidations?
+ */
+static bool
+mdcache_entry_is_invalidated(const MDCacheTrackedEntry *entry, List *relids,
+							 const MDCacheSyscacheInval *invals, int ninvals)
+{
+	const MDCacheEntryKey *key = &entry->key;
+	Datum		oid = ObjectIdGetDatum(key->oid);
+
+	if (OidIsValid(entry->relid) && list_member_oid(relids, entry->relid))
+		return true;
+
+	if (ninvals == 0)
+		return false;
+
+	switch (key->kind)
+	{
+		case MDCACHE_ENTRY_OBJECT:
+			/* types, operators, functions and aggregates */
+			if (!OidIsValid(entry->relid))
+				return mdcache_syscache_inval_exists(invals, ninvals, TYPEOID) ||
+					mdcache_syscache_inval_exists(invals, ninvals, OPEROID) ||
+					mdcache_syscache_inval_exists(invals, ninvals, PROCOID) ||
+					mdcache_syscache_inval_exists(invals, ninvals, AGGFNOID);
+
+			/* relations, indexes and triggers are covered above */
+			return mdcache_syscache_inval_matches(invals, ninvals, CONSTROID, oid, 0, 0);
+
+		case MDCACHE_ENTRY_RELSTATS:
+			/* comes from pg_class only, covered by the relcache check above */
+			return false;
+
+		case MDCACHE_ENTRY_COLSTATS:
+			return mdcache_syscache_inval_matches(invals, ninvals, STATRELATTINH,
+												  oid,
+												  Int16GetDatum(entry->attno),
+												  BoolGetDatum(false)) ||
+				mdcache_syscache_inval_matches(invals, ninvals, STATRELATTINH,
+											   oid,
+											   Int16GetDatum(entry->attno),
+											   BoolGetDatum(true));
+
+		case MDCACHE_ENTRY_CAST:
+			/* the cast entry also names the cast function and the types */
+			return mdcache_syscache_inval_matches(invals, ninvals, CASTSOURCETARGET,
+												  oid,
+												  ObjectIdGetDatum(key->oid2),
+												  0) ||
+				mdcache_syscache_inval_exists(invals, ninvals, TYPEOID) ||
+				mdcache_syscache_inval_exists(invals, ninvals, PROCOID);
+
+		case MDCACHE_ENTRY_SCCMP:
+			/* comparison operators are looked up through the types and casts */
+			return mdcache_syscache_inval_exists(invals, ninvals, TYPEOID) ||
+				mdcache_syscache_inval_exists(invals, ninvals, OPEROID) ||
+				mdcache_syscache_inval_exists(invals, ninvals, CASTSOURCETARGET);
+
+		default:
+			return true;
+	}
+}
+
+// Has there been any catalog changes since last call, that require the
+// whole metadata cache to be reset?
 bool
 gpdb::MDCacheNeedsReset
 		(
@@ -3189,16 +3433,21 @@ gpdb::MDCacheNeedsReset
 {
 	GP_WRAP_START;
 	{
-		if (!mdcache_invalidation_counter_registered)
+		if (!mdcache_invalidation_callbacks_registered)
 		{
 			register_mdcache_invalidation_callbacks();
-			mdcache_invalidation_counter_registered = true;
+			mdcache_invalidation_callbacks_registered = true;
 		}
-		if (last_mdcache_invalidation_counter == mdcache_invalidation_counter)
+
+		/* this is called once at the start of every optimization */
+		mdcache_optimization_count++;
+
+		if (!mdcache_reset_pending)
 			return false;
 		else
 		{
-			last_mdcache_invalidation_counter = mdcache_invalidation_counter;
+			mdcache_forget_all_entries();
+			mdcache_stats.resets++;
 			return true;
 		}
 	}
@@ -3207,6 +3456,306 @@ gpdb::MDCacheNeedsReset
 	return true;
 }
 
+/*
+ * Start tracking an entry of the metadata cache.
+ */
+static void
+mdcache_track_entry(const MDCacheEntryKey *key, Oid relid, AttrNumber attno)
+{
+	MDCacheTrackedEntry *entry;
+	bool		found;
+
+	if (mdcache_tracked_entries == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(MDCacheEntryKey);
+		ctl.entrysize = sizeof(MDCacheTrackedEntry);
+		mdcache_tracked_entries = hash_create("ORCA metadata cache entries",
+											  1024,
+											  &ctl,
+											  HASH_ELEM | HASH_BLOBS);
+	}
+
+	/*
+	 * Don't let the registry grow without bounds. Falling back to a full
+	 * reset on the next query also empties it.
+	 */
+	if (hash_get_num_entries(mdcache_tracked_entries) >= MDCACHE_MAX_TRACKED_ENTRIES)
+	{
+		mdcache_reset_pending = true;
+		return;
+	}
+
+	entry = (MDCacheTrackedEntry *) hash_search(mdcache_tracked_entries,
+												(void *) key,
+												HASH_ENTER,
+												&found);
+	entry->relid = relid;
+	entry->attno = attno;
+	entry->fetched_in = mdcache_optimization_count;
+}
+
+// Record an object handed over to the metadata cache
+void
+gpdb::MDCacheRegisterEntry
+	(
+	const MDCacheEntryKey *key,
+	Oid relid,
+	AttrNumber attno
+	)
+{
+	GP_WRAP_START;
+	{
+		mdcache_stats.fetches++;
+		mdcache_track_entry(key, relid, attno);
+	}
+	GP_WRAP_END;
+}
+
+// Return the keys of the metadata cache entries invalidated since the last
+// call. The caller is responsible for evicting them from the cache.
+List *
+gpdb::MDCacheGetInvalidatedEntries
+	(
+	void
+	)
+{
+	GP_WRAP_START;
+	{
+		MDCacheSyscacheInval invals[MDCACHE_MAX_PENDING_INVALS];
+		int			ninvals;
+		List	   *relids = NIL;
+		List	   *result = NIL;
+		HASH_SEQ_STATUS status;
+		MDCacheTrackedEntry *entry;
+		int			i;
+
+		/*
+		 * Take a copy of the pending invalidations before doing any catalog
+		 * access below, which may process more invalidation messages. Those
+		 * will be dealt with before planning the next query.
+		 */
+		ninvals = mdcache_num_inval_syscache;
+		memcpy(invals, mdcache_inval_syscache, ninvals * sizeof(MDCacheSyscacheInval));
+		for (i = 0; i < mdcache_num_inval_relids; i++)
+			relids = lappend_oid(relids, mdcache_inval_relids[i]);
+		mdcache_num_inval_syscache = 0;
+		mdcache_num_inval_relids = 0;
+
+		if (relids != NIL && mdcache_tracked_entries != NULL)
+			relids = mdcache_add_partition_ancestors(relids);
+
+		if (mdcache_tracked_entries == NULL || (ninvals == 0 && relids == NIL))
+		{
+			list_free(relids);
+			return NIL;
+		}
+
+		hash_seq_init(&status, mdcache_tracked_entries);
+		while ((entry = (MDCacheTrackedEntry *) hash_seq_search(&status)) != NULL)
+		{
+			MDCacheEntryKey *key;
+
+			if (!mdcache_entry_is_invalidated(entry, relids, invals, ninvals))
+				continue;
+
+			key = (MDCacheEntryKey *) palloc(sizeof(MDCacheEntryKey));
+			memcpy(key, &entry->key, sizeof(MDCacheEntryKey));
+			result = lappend(result, key);
+
+			/* it's OK to remove the current entry of a seq scan */
+			hash_search(mdcache_tracked_entries, key, HASH_REMOVE, NULL);
+			mdcache_stats.evictions++;
+		}
+
+		list_free(relids);
+		return result;
+	}
+	GP_WRAP_END;
+
+	return NIL;
+}
+
+static bool
+mdcache_collect_relids_walker(Node *node, List **relids)
+{
+	if (node == NULL)
+		return false;
+
+	if (IsA(node, RangeTblEntry))
+	{
+		RangeTblEntry *rte = (RangeTblEntry *) node;
+
+		if (rte->rtekind == RTE_RELATION)
+			*relids = list_append_unique_oid(*relids, rte->relid);
+		return false;
+	}
+
+	if (IsA(node, Query))
+		return query_tree_walker((Query *) node,
+								 (bool (*)()) mdcache_collect_relids_walker,
+								 (void *) relids, QTW_EXAMINE_RTES);
+
+	return expression_tree_walker(node,
+								  (bool (*)()) mdcache_collect_relids_walker,
+								  (void *) relids);
+}
+
+// Count the metadata cache hits of the optimization that just finished.
+//
+// ORCA looks objects up in its cache without telling the metadata
+// provider, so only misses are seen as they happen. But the relations of
+// the query and their statistics are always looked up, so one that is
+// tracked, and wasn't translated by this optimization, was found in the
+// cache.
+void
+gpdb::MDCacheCountHits
+	(
+	Query *query
+	)
+{
+	GP_WRAP_START;
+	{
+		List	   *relids = NIL;
+		ListCell   *lc;
+
+		if (mdcache_tracked_entries == NULL)
+			return;
+
+		(void) mdcache_collect_relids_walker((Node *) query, &relids);
+
+		foreach(lc, relids)
+		{
+			MDCacheEntryKey key;
+			MDCacheTrackedEntry *entry;
+
+			memset(&key, 0, sizeof(key));
+			key.oid = lfirst_oid(lc);
+
+			key.kind = MDCACHE_ENTRY_OBJECT;
+			entry = (MDCacheTrackedEntry *) hash_search(mdcache_tracked_entries,
+														(void *) &key,
+														HASH_FIND,
+														NULL);
+			if (entry != NULL && entry->fetched_in != mdcache_optimization_count)
+				mdcache_stats.hits++;
+
+			key.kind = MDCACHE_ENTRY_RELSTATS;
+			entry = (MDCacheTrackedEntry *) hash_search(mdcache_tracked_entries,
+														(void *) &key,
+														HASH_FIND,
+														NULL);
+			if (entry != NULL && entry->fetched_in != mdcache_optimization_count)
+				mdcache_stats.hits++;
+		}
+
+		list_free(relids);
+	}
+	GP_WRAP_END;
+}
+
+// Metadata cache activity of this backend
+void
+gpdb::MDCacheGetStats
+	(
+	MDCacheStats *stats
+	)
+{
+	*stats = mdcache_stats;
+	stats->entries = (mdcache_tracked_entries != NULL) ?
+		hash_get_num_entries(mdcache_tracked_entries) : 0;
+}
+
+// Can the shared metadata store be used for the current query?
+bool
+gpdb::MDCacheSharedBeginFetch
+	(
+	uint64 *catalog_version
+	)
+{
+	GP_WRAP_START;
+	{
+		/*
+		 * Objects translated in a transaction that has modified the catalogs
+		 * may reflect its uncommitted changes, and the entries in the store
+		 * may not reflect them. A transaction is assigned an xid before it
+		 * modifies anything.
+		 */
+		if (!OptMDCacheSharedEnabled() ||
+			!optimizer_metadata_caching ||
+			TransactionIdIsValid(GetTopTransactionIdIfAny()))
+			return false;
+
+		/*
+		 * Read the catalog version before catching up with invalidations.
+		 * A backend bumps the version only after it has queued its
+		 * invalidation messages, so if we see the new version, we also see
+		 * the messages, and won't translate an object from a stale syscache
+		 * entry. If we don't, the object won't be stored.
+		 */
+		*catalog_version = OptMDCacheGetCatalogVersion();
+		AcceptInvalidationMessages();
+
+		return true;
+	}
+	GP_WRAP_END;
+
+	return false;
+}
+
+// Look up the DXL of an object in the shared metadata store. The object is
+// about to enter the metadata cache of this backend, so start tracking it.
+char *
+gpdb::MDCacheSharedLookup
+	(
+	const MDCacheEntryKey *key
+	)
+{
+	GP_WRAP_START;
+	{
+		Oid			relid;
+		AttrNumber	attno;
+		char	   *dxl = OptMDCacheLookup(key, &relid, &attno);
+
+		if (dxl != NULL)
+			mdcache_track_entry(key, relid, attno);
+
+		return dxl;
+	}
+	GP_WRAP_END;
+
+	return NULL;
+}
+
+// Store the DXL of an object in the shared metadata store
+void
+gpdb::MDCacheSharedInsert
+	(
+	const MDCacheEntryKey *key,
+	Oid relid,
+	AttrNumber attno,
+	uint64 catalog_version,
+	const char *dxl
+	)
+{
+	GP_WRAP_START;
+	{
+		/*
+		 * The size and statistics of a partitioned table are derived from
+		 * its partitions, and invalidations of the partitions don't name it.
+		 * Keep such objects out of the store.
+		 */
+		/* catalog tables: pg_partition */
+		if (OidIsValid(relid) && rel_is_partitioned(relid))
+			return;
+
+		OptMDCacheInsert(key, relid, attno, catalog_version, dxl);
+	}
+	GP_WRAP_END;
+}
+
 // returns true if a query cancel is requested in GPDB
 bool
 gpdb::IsAbortRequested
@@ -15,11 +15,18 @@
 //---------------------------------------------------------------------------
 
 #include "postgres.h"
+#include "optimizer/orca.h"
+#include "portability/instr_time.h"
+#include "gpopt/gpdbwrappers.h"
 #include "gpopt/relcache/CMDProviderRelcache.h"
 #include "gpopt/translate/CTranslatorRelcacheToDXL.h"
 #include "gpopt/mdcache/CMDAccessor.h"
 
 #include "naucrates/dxl/CDXLUtils.h"
+#include "naucrates/md/CMDIdCast.h"
+#include "naucrates/md/CMDIdColStats.h"
+#include "naucrates/md/CMDIdRelStats.h"
+#include "naucrates/md/CMDIdScCmp.h"
 
 #include "naucrates/exception.h"
 
@@ -62,16 +69,211 @@ CMDProviderRelcache::GetMDObjDXLStr
 	)
 	const
 {
+	MDCacheEntryKey key;
+	GetMDCacheKey(md_id, &key);
+
+	// another backend may have translated the object already
+	uint64 catalog_version = 0;
+	BOOL use_shared_store = gpdb::MDCacheSharedBeginFetch(&catalog_version);
+	if (use_shared_store)
+	{
+		CHAR *dxl = gpdb::MDCacheSharedLookup(&key);
+		if (NULL != dxl)
+		{
+			CWStringDynamic *str = CDXLUtils::CreateDynamicStringFromCharArray(m_mp, dxl);
+			gpdb::GPDBFree(dxl);
+			optimizer_last_profile.md_shared_hits[key.kind]++;
+			return str;
+		}
+	}
+
+	instr_time start_time;
+	instr_time duration;
+	INSTR_TIME_SET_CURRENT(start_time);
+
 	IMDCacheObject *md_obj = CTranslatorRelcacheToDXL::RetrieveObject(mp, md_accessor, md_id);
 
 	GPOS_ASSERT(NULL != md_obj);
 
+	OID rel_oid = InvalidOid;
+	INT attno = InvalidAttrNumber;
+	RegisterMDObj(md_accessor, md_id, md_obj, &key, &rel_oid, &attno);
+
 	CWStringDynamic *str = CDXLUtils::SerializeMDObj(m_mp, md_obj, true /*fSerializeHeaders*/, false /*findent*/);
 
 	// cleanup DXL object
 	md_obj->Release();
 
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start_time);
+	optimizer_last_profile.md_fetch_time += INSTR_TIME_GET_MILLISEC(duration);
+	optimizer_last_profile.md_fetches[key.kind]++;
+
+	if (use_shared_store)
+	{
+		ULONG max_len = GPOS_WSZ_LENGTH(str->GetBuffer()) * GPOS_SIZEOF(WCHAR) + 1;
+		CHAR *dxl = (CHAR *) gpdb::GPDBAlloc(max_len);
+
+		// the DXL is converted back with the same locale by the backends
+		// of this database
+		if (0 <= gpos::clib::Wcstombs(dxl, const_cast<WCHAR *>(str->GetBuffer()), max_len))
+		{
+			dxl[max_len - 1] = '\0';
+			gpdb::MDCacheSharedInsert(&key, rel_oid, (AttrNumber) attno, catalog_version, dxl);
+		}
+		gpdb::GPDBFree(dxl);
+	}
+
 	return str;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::GetMDCacheKey
+//
+//	@doc:
+//		Identity of a metadata id, for tracking its entry in the metadata
+//		cache and for looking it up in the store shared between backends
+//
+//---------------------------------------------------------------------------
+void
+CMDProviderRelcache::GetMDCacheKey
+	(
+	IMDId *md_id,
+	MDCacheEntryKey *key
+	)
+{
+	// the key is hashed as a blob
+	memset(key, 0, sizeof(*key));
+
+	switch (md_id->MdidType())
+	{
+		case IMDId::EmdidGPDB:
+		{
+			key->kind = MDCACHE_ENTRY_OBJECT;
+			key->oid = CMDIdGPDB::CastMdid(md_id)->Oid();
+			break;
+		}
+
+		case IMDId::EmdidRelStats:
+		{
+			IMDId *mdid_rel = CMDIdRelStats::CastMdid(md_id)->GetRelMdId();
+
+			key->kind = MDCACHE_ENTRY_RELSTATS;
+			key->oid = CMDIdGPDB::CastMdid(mdid_rel)->Oid();
+			break;
+		}
+
+		case IMDId::EmdidColStats:
+		{
+			CMDIdColStats *mdid_col_stats = CMDIdColStats::CastMdid(md_id);
+
+			key->kind = MDCACHE_ENTRY_COLSTATS;
+			key->oid = CMDIdGPDB::CastMdid(mdid_col_stats->GetRelMdId())->Oid();
+			key->extra = (int32) mdid_col_stats->Position();
+			break;
+		}
+
+		case IMDId::EmdidCastFunc:
+		{
+			CMDIdCast *mdid_cast = CMDIdCast::CastMdid(md_id);
+
+			key->kind = MDCACHE_ENTRY_CAST;
+			key->oid = CMDIdGPDB::CastMdid(mdid_cast->MdidSrc())->Oid();
+			key->oid2 = CMDIdGPDB::CastMdid(mdid_cast->MdidDest())->Oid();
+			break;
+		}
+
+		case IMDId::EmdidScCmp:
+		{
+			CMDIdScCmp *mdid_scalar_cmp = CMDIdScCmp::CastMdid(md_id);
+
+			key->kind = MDCACHE_ENTRY_SCCMP;
+			key->oid = CMDIdGPDB::CastMdid(mdid_scalar_cmp->GetLeftMdid())->Oid();
+			key->oid2 = CMDIdGPDB::CastMdid(mdid_scalar_cmp->GetRightMdid())->Oid();
+			key->extra = (int32) mdid_scalar_cmp->ParseCmpType();
+			break;
+		}
+
+		default:
+			// RetrieveObject() doesn't produce any other kind of object
+			GPOS_RAISE(gpdxl::ExmaMD, gpdxl::ExmiMDCacheEntryNotFound, md_id->GetBuffer());
+	}
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDProviderRelcache::RegisterMDObj
+//
+//	@doc:
+//		Record an object that is about to enter the metadata cache, together
+//		with the relation it depends on, so that it can be evicted on its own
+//		when the underlying catalog entries change. Types, operators,
+//		functions and aggregates have no relation, and are evicted on any
+//		change to their catalogs instead
+//
+//---------------------------------------------------------------------------
+void
+CMDProviderRelcache::RegisterMDObj
+	(
+	CMDAccessor *md_accessor,
+	IMDId *md_id,
+	IMDCacheObject *md_obj,
+	const MDCacheEntryKey *key,
+	OID *rel_oid,
+	INT *attno
+	)
+	const
+{
+	*rel_oid = InvalidOid;
+	*attno = InvalidAttrNumber;
+
+	switch (key->kind)
+	{
+		case MDCACHE_ENTRY_OBJECT:
+		{
+			switch (md_obj->MDType())
+			{
+				case IMDCacheObject::EmdtRel:
+				case IMDCacheObject::EmdtInd:
+					*rel_oid = key->oid;
+					break;
+
+				case IMDCacheObject::EmdtTrigger:
+					// triggers are invalidated through their relation
+					*rel_oid = gpdb::GetTriggerRelid(key->oid);
+					break;
+
+				case IMDCacheObject::EmdtCheckConstraint:
+					*rel_oid = gpdb::GetCheckConstraintRelid(key->oid);
+					break;
+
+				default:
+					break;
+			}
+			break;
+		}
+
+		case MDCACHE_ENTRY_RELSTATS:
+			*rel_oid = key->oid;
+			break;
+
+		case MDCACHE_ENTRY_COLSTATS:
+		{
+			IMDId *mdid_rel = CMDIdColStats::CastMdid(md_id)->GetRelMdId();
+
+			*rel_oid = key->oid;
+
+			// pg_statistic is keyed by attribute number, not by position
+			*attno = md_accessor->RetrieveRel(mdid_rel)->GetMdCol(key->extra)->AttrNum();
+			break;
+		}
+
+		default:
+			break;
+	}
+
+	gpdb::MDCacheRegisterEntry(key, *rel_oid, (AttrNumber) *attno);
+}
+
 // EOF
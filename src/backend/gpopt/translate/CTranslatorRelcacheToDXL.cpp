@@ -65,6 +65,7 @@
 #include "naucrates/md/CMDPartConstraintGPDB.h"
 #include "naucrates/md/CMDIdRelStats.h"
 #include "naucrates/md/CDXLRelStats.h"
+#include "naucrates/md/IMDRelStats.h"
 #include "naucrates/md/CMDIdColStats.h"
 #include "naucrates/md/CDXLColStats.h"
 
@@ -2334,8 +2335,7 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 	ULONG pos = mdid_col_stats->Position();
 	OID rel_oid = CMDIdGPDB::CastMdid(mdid_rel)->Oid();
 
-	Relation rel = gpdb::GetRelation(rel_oid);
-	if (NULL == rel)
+	if (!gpdb::RelationExists(rel_oid))
 	{
 		GPOS_RAISE(gpdxl::ExmaMD, gpdxl::ExmiMDCacheEntryNotFound, mdid->GetBuffer());
 	}
@@ -2344,16 +2344,18 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 	const IMDColumn *md_col = md_rel->GetMdCol(pos);
 	AttrNumber attno = (AttrNumber) md_col->AttrNum();
 
-	// number of rows from pg_class
-	double num_rows;
-	bool stats_empty;
-
-	num_rows = gpdb::CdbEstimatePartitionedNumTuples(rel, &stats_empty);
+	// number of rows from pg_class. Go through the relation stats in the
+	// metadata cache, so that it is computed only once per relation rather
+	// than once per column. For a partitioned table, it is the sum over all
+	// leaf partitions.
+	CMDIdRelStats *mdid_rel_stats = GPOS_NEW(mp) CMDIdRelStats(CMDIdGPDB::CastMdid(mdid_rel));
+	mdid_rel->AddRef();
+	double num_rows = md_accessor->Pmdrelstats(mdid_rel_stats)->Rows().Get();
+	mdid_rel_stats->Release();
 
 	// extract column name and type
 	CMDName *md_colname = GPOS_NEW(mp) CMDName(mp, md_col->Mdname().GetMDName());
 	OID att_type = CMDIdGPDB::CastMdid(md_col->MdidType())->Oid();
-	gpdb::CloseRelation(rel);
 
 	CDXLBucketArray *dxl_stats_bucket_array = GPOS_NEW(mp) CDXLBucketArray(mp);
 
@@ -2363,6 +2365,7 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 		return GenerateStatsForSystemCols
 				(
 				mp,
+				md_accessor,
 				rel_oid,
 				mdid_col_stats,
 				md_colname,
@@ -2386,11 +2389,8 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 
 		if (!md_col->IsDropped())
 		{
-			CMDIdGPDB *mdid_atttype = GPOS_NEW(mp) CMDIdGPDB(att_type);
-			IMDType *md_type = RetrieveType(mp, mdid_atttype);
+			const IMDType *md_type = md_accessor->RetrieveType(md_col->MdidType());
 			width = CStatisticsUtils::DefaultColumnWidth(md_type);
-			md_type->Release();
-			mdid_atttype->Release();
 		}
 
 		return CDXLColStats::CreateDXLDummyColStats(mp, mdid_col_stats, md_colname, width);
@@ -2480,15 +2480,25 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 	// histogram values extracted from the pg_statistic tuple for a given column
 	AttStatsSlot hist_slot;
 
-	// get histogram datums from pg_statistic entry
-	(void) gpdb::GetAttrStatsSlot
-			(
-					&hist_slot,
-					stats_tup,
-					STATISTIC_KIND_HISTOGRAM,
-					InvalidOid,
-					ATTSTATSSLOT_VALUES
-			);
+	// Histograms of text columns are not used by the optimizer, see
+	// TransformStatsToDXLBucketArray(), so don't bother detoasting and
+	// copying their bounds
+	if (IsTextRelatedType(md_col->MdidType()))
+	{
+		memset(&hist_slot, 0, sizeof(hist_slot));
+	}
+	else
+	{
+		// get histogram datums from pg_statistic entry
+		(void) gpdb::GetAttrStatsSlot
+				(
+						&hist_slot,
+						stats_tup,
+						STATISTIC_KIND_HISTOGRAM,
+						InvalidOid,
+						ATTSTATSSLOT_VALUES
+				);
+	}
 
 	if (InvalidOid != hist_slot.valuetype && hist_slot.valuetype != att_type)
 	{
@@ -2525,6 +2535,7 @@ CTranslatorRelcacheToDXL::RetrieveColStats
 	TransformStatsToDXLBucketArray
 	(
 	 mp,
+	 md_accessor,
 	 att_type,
 	 num_distinct,
 	 null_freq,
@@ -2594,6 +2605,7 @@ CDXLColStats *
 CTranslatorRelcacheToDXL::GenerateStatsForSystemCols
        (
        CMemoryPool *mp,
+       CMDAccessor *md_accessor,
        OID rel_oid,
        CMDIdColStats *mdid_col_stats,
        CMDName *md_colname,
@@ -2610,7 +2622,8 @@ CTranslatorRelcacheToDXL::GenerateStatsForSystemCols
        GPOS_ASSERT(NULL != dxl_stats_bucket_array);
 
        CMDIdGPDB *mdid_atttype = GPOS_NEW(mp) CMDIdGPDB(att_type);
-       IMDType *md_type = RetrieveType(mp, mdid_atttype);
+       const IMDType *md_type = md_accessor->RetrieveType(mdid_atttype);
+       mdid_atttype->Release();
        GPOS_ASSERT(md_type->IsFixedLength());
 
        BOOL is_col_stats_missing = true;
@@ -2649,10 +2662,6 @@ CTranslatorRelcacheToDXL::GenerateStatsForSystemCols
 			}
         }
 
-       // cleanup
-       mdid_atttype->Release();
-       md_type->Release();
-
        return GPOS_NEW(mp) CDXLColStats
                        (
                        mp,
@@ -2828,6 +2837,26 @@ CTranslatorRelcacheToDXL::RetrieveScCmp
 	return GPOS_NEW(mp) CMDScCmpGPDB(mp, mdid, mdname, mdid_left, mdid_right, cmp_type, GPOS_NEW(mp) CMDIdGPDB(scalar_cmp_oid));
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CTranslatorRelcacheToDXL::IsTextRelatedType
+//
+//	@doc:
+//		Is the given type one of the text types whose histograms are not
+//		used by the optimizer
+//
+//---------------------------------------------------------------------------
+BOOL
+CTranslatorRelcacheToDXL::IsTextRelatedType
+	(
+	const IMDId *mdid
+	)
+{
+	return mdid->Equals(&CMDIdGPDB::m_mdid_varchar)
+			|| mdid->Equals(&CMDIdGPDB::m_mdid_bpchar)
+			|| mdid->Equals(&CMDIdGPDB::m_mdid_text);
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
@@ -2840,6 +2869,7 @@ CDXLBucketArray *
 CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
 	(
 	CMemoryPool *mp,
+	CMDAccessor *md_accessor,
 	OID att_type,
 	CDouble num_distinct,
 	CDouble null_freq,
@@ -2851,7 +2881,7 @@ CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
 	)
 {
 	CMDIdGPDB *mdid_atttype = GPOS_NEW(mp) CMDIdGPDB(att_type);
-	IMDType *md_type = RetrieveType(mp, mdid_atttype);
+	const IMDType *md_type = md_accessor->RetrieveType(mdid_atttype);
 
 	// translate MCVs to Orca histogram. Create an empty histogram if there are no MCVs.
 	CHistogram *gpdb_mcv_hist = TransformMcvToOrcaHistogram
@@ -2874,10 +2904,7 @@ CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
 		hist_freq = CDouble(1.0) - null_freq - mcv_freq;
 	}
 	
-	BOOL is_text_type = mdid_atttype->Equals(&CMDIdGPDB::m_mdid_varchar)
-			 || mdid_atttype->Equals(&CMDIdGPDB::m_mdid_bpchar)
-			 || mdid_atttype->Equals(&CMDIdGPDB::m_mdid_text);
-	BOOL has_hist = !is_text_type && 1 < num_hist_values && CStatistics::Epsilon < hist_freq;
+	BOOL has_hist = !IsTextRelatedType(mdid_atttype) && 1 < num_hist_values && CStatistics::Epsilon < hist_freq;
 
 	CHistogram *histogram = NULL;
 
@@ -2928,7 +2955,6 @@ CTranslatorRelcacheToDXL::TransformStatsToDXLBucketArray
 
 	// cleanup
 	mdid_atttype->Release();
-	md_type->Release();
 	GPOS_DELETE(gpdb_mcv_hist);
 
 	if (NULL != histogram)
@@ -13,6 +13,7 @@
 
 extern "C" {
 #include "postgres.h"
+#include "optimizer/orca.h"
 #include "utils/memutils.h"
 }
 
@@ -39,6 +40,9 @@ CMemoryPoolPalloc::NewImpl
 	CMemoryPool::EAllocationType eat
 	)
 {
+	optimizer_last_profile.allocations++;
+	optimizer_last_profile.bytes_allocated += bytes;
+
 	// if it's a singleton allocation, allocate requested memory
 	if (CMemoryPool::EatSingleton == eat)
 	{
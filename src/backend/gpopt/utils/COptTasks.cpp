@@ -29,6 +29,8 @@
 #include "gpopt/engine/CHint.h"
 
 #include "cdb/cdbvars.h"
+#include "optimizer/orca.h"
+#include "portability/instr_time.h"
 #include "utils/guc.h"
 #include "utils/fmgroids.h"
 
@@ -41,6 +43,7 @@
 #include "gpos/io/COstreamFile.h"
 #include "gpos/io/COstreamString.h"
 #include "gpos/memory/CAutoMemoryPool.h"
+#include "gpos/memory/CCacheAccessor.h"
 #include "gpos/task/CAutoTraceFlag.h"
 #include "gpos/common/CAutoP.h"
 
@@ -53,6 +56,7 @@
 #include "gpopt/engine/CCTEConfig.h"
 #include "gpopt/mdcache/CAutoMDAccessor.h"
 #include "gpopt/mdcache/CMDCache.h"
+#include "gpopt/mdcache/CMDKey.h"
 #include "gpopt/minidump/CMinidumperUtils.h"
 #include "gpopt/optimizer/COptimizer.h"
 #include "gpopt/optimizer/COptimizerConfig.h"
@@ -65,6 +69,7 @@
 #include "naucrates/base/CQueryToDXLResult.h"
 
 #include "naucrates/md/IMDId.h"
+#include "naucrates/md/CMDIdColStats.h"
 #include "naucrates/md/CMDIdRelStats.h"
 
 #include "naucrates/md/CSystemId.h"
@@ -520,6 +525,101 @@ COptTasks::GetCostModel
 	return cost_model;
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::EvictInvalidatedMDCacheEntries
+//
+//	@doc:
+//		Evict the metadata cache entries that were invalidated by catalog
+//		changes since the last optimized query. Entries that are still in
+//		use by a running accessor are removed once they are released.
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::EvictInvalidatedMDCacheEntries
+	(
+	CMemoryPool *mp
+	)
+{
+	List *invalidated_entries = gpdb::MDCacheGetInvalidatedEntries();
+
+	ListCell *lc = NULL;
+	ForEach (lc, invalidated_entries)
+	{
+		MDCacheEntryKey *entry_key = (MDCacheEntryKey *) lfirst(lc);
+		IMDId *mdid = NULL;
+
+		switch (entry_key->kind)
+		{
+			case MDCACHE_ENTRY_OBJECT:
+				mdid = GPOS_NEW(mp) CMDIdGPDB(entry_key->oid);
+				break;
+
+			case MDCACHE_ENTRY_RELSTATS:
+				mdid = GPOS_NEW(mp) CMDIdRelStats(GPOS_NEW(mp) CMDIdGPDB(entry_key->oid));
+				break;
+
+			case MDCACHE_ENTRY_COLSTATS:
+				mdid = GPOS_NEW(mp) CMDIdColStats(GPOS_NEW(mp) CMDIdGPDB(entry_key->oid), (ULONG) entry_key->extra);
+				break;
+
+			case MDCACHE_ENTRY_CAST:
+				mdid = GPOS_NEW(mp) CMDIdCast(GPOS_NEW(mp) CMDIdGPDB(entry_key->oid), GPOS_NEW(mp) CMDIdGPDB(entry_key->oid2));
+				break;
+
+			case MDCACHE_ENTRY_SCCMP:
+				mdid = GPOS_NEW(mp) CMDIdScCmp
+									(
+									GPOS_NEW(mp) CMDIdGPDB(entry_key->oid),
+									GPOS_NEW(mp) CMDIdGPDB(entry_key->oid2),
+									(IMDType::ECmpType) entry_key->extra
+									);
+				break;
+
+			default:
+				GPOS_ASSERT(!"Unexpected metadata cache entry kind");
+				continue;
+		}
+
+		{
+			// scope for cache accessor, one lookup per accessor
+			CMDKey md_key(mdid);
+			CCacheAccessor<IMDCacheObject*, CMDKey*> cache_accessor(CMDCache::Pcache());
+
+			if (NULL != cache_accessor.Lookup(&md_key))
+			{
+				cache_accessor.MarkForDeletion();
+			}
+		}
+
+		mdid->Release();
+	}
+
+	gpdb::ListFreeDeep(invalidated_entries);
+}
+
+//---------------------------------------------------------------------------
+//	@function:
+//		ElapsedMS
+//
+//	@doc:
+//		Milliseconds elapsed since the given time, for the optimizer profile
+//
+//---------------------------------------------------------------------------
+static double
+ElapsedMS
+	(
+	const instr_time &start_time
+	)
+{
+	instr_time duration;
+
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, start_time);
+
+	return INSTR_TIME_GET_MILLISEC(duration);
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		COptTasks::OptimizeTask
@@ -563,14 +663,26 @@ COptTasks::OptimizeTask
 		CMDCache::Reset();
 		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
 	}
-	else if (CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
+	else
 	{
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		// only drop the entries affected by catalog changes since the last query
+		EvictInvalidatedMDCacheEntries(mp);
+
+		if (CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
+		{
+			CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		}
 	}
 
 
 	// load search strategy
 	CSearchStageArray *search_strategy_arr = LoadSearchStrategy(mp, optimizer_search_strategy_path);
+	if (NULL != search_strategy_arr)
+	{
+		optimizer_last_profile.search_stages = search_strategy_arr->Size();
+	}
+
+	instr_time start_time;
 
 	CBitSet *trace_flags = NULL;
 	CBitSet *enabled_trace_flags = NULL;
@@ -600,6 +712,7 @@ COptTasks::OptimizeTask
 				num_segments_for_costing = num_segments;
 			}
 
+			INSTR_TIME_SET_CURRENT(start_time);
 			CAutoP<CTranslatorQueryToDXL> query_to_dxl_translator;
 			query_to_dxl_translator = CTranslatorQueryToDXL::QueryToDXLInstance
 							(
@@ -607,6 +720,7 @@ COptTasks::OptimizeTask
 							&mda,
 							(Query*) opt_ctxt->m_query
 							);
+			optimizer_last_profile.query_to_dxl_time += ElapsedMS(start_time);
 
 			ICostModel *cost_model = GetCostModel(mp, num_segments_for_costing);
 			COptimizerConfig *optimizer_config = CreateOptimizerConfig(mp, cost_model);
@@ -614,15 +728,18 @@ COptTasks::OptimizeTask
 			IConstExprEvaluator *expr_evaluator =
 					GPOS_NEW(mp) CConstExprEvaluatorDXL(mp, &mda, &expr_eval_proxy);
 
+			INSTR_TIME_SET_CURRENT(start_time);
 			CDXLNode *query_dxl = query_to_dxl_translator->TranslateQueryToDXL();
 			CDXLNodeArray *query_output_dxlnode_array = query_to_dxl_translator->GetQueryOutputCols();
 			CDXLNodeArray *cte_dxlnode_array = query_to_dxl_translator->GetCTEs();
 			GPOS_ASSERT(NULL != query_output_dxlnode_array);
+			optimizer_last_profile.query_to_dxl_time += ElapsedMS(start_time);
 
 			BOOL is_master_only = !optimizer_enable_motions ||
 						(!optimizer_enable_motions_masteronly_queries && !query_to_dxl_translator->HasDistributedTables());
 			CAutoTraceFlag atf(EopttraceDisableMotions, is_master_only);
 
+			INSTR_TIME_SET_CURRENT(start_time);
 			plan_dxl = COptimizer::PdxlnOptimize
 									(
 									mp,
@@ -637,6 +754,7 @@ COptTasks::OptimizeTask
 									search_strategy_arr,
 									optimizer_config
 									);
+			optimizer_last_profile.search_time = ElapsedMS(start_time);
 
 			if (opt_ctxt->m_should_serialize_plan_dxl)
 			{
@@ -650,9 +768,11 @@ COptTasks::OptimizeTask
 			// translate DXL->PlStmt only when needed
 			if (opt_ctxt->m_should_generate_plan_stmt)
 			{
+				INSTR_TIME_SET_CURRENT(start_time);
 				// always use opt_ctxt->m_query->can_set_tag as the query_to_dxl_translator->Pquery() is a mutated Query object
 				// that may not have the correct can_set_tag
 			  opt_ctxt->m_plan_stmt = (PlannedStmt *) gpdb::CopyObject(ConvertToPlanStmtFromDXL(mp, &mda, plan_dxl, opt_ctxt->m_query->canSetTag, query_to_dxl_translator->GetDistributionHashOpsKind()));
+				optimizer_last_profile.dxl_to_plstmt_time = ElapsedMS(start_time);
 			}
 
 			CStatisticsConfig *stats_conf = optimizer_config->GetStatsConf();
@@ -665,6 +785,9 @@ COptTasks::OptimizeTask
 			rel_stats->Release();
 			col_stats->Release();
 
+			// count the relations that were found in the metadata cache
+			gpdb::MDCacheCountHits((Query *) opt_ctxt->m_query);
+
 			expr_evaluator->Release();
 			query_dxl->Release();
 			optimizer_config->Release();
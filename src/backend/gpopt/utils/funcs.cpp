@@ -126,3 +126,34 @@ OptVersion()
 	return GPORCA_VERSION_STRING;
 }
 }
+
+//---------------------------------------------------------------------------
+//	@function:
+//		MDCacheStatsValues
+//
+//	@doc:
+//		Returns the metadata cache activity counters of this backend
+//
+//---------------------------------------------------------------------------
+extern "C" {
+void
+MDCacheStatsValues
+	(
+	int64 *entries,
+	int64 *hits,
+	int64 *fetches,
+	int64 *evictions,
+	int64 *resets
+	)
+{
+	MDCacheStats stats;
+
+	gpdb::MDCacheGetStats(&stats);
+
+	*entries = stats.entries;
+	*hits = stats.hits;
+	*fetches = stats.fetches;
+	*evictions = stats.evictions;
+	*resets = stats.resets;
+}
+}
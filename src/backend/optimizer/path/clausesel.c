@@ -23,6 +23,8 @@
 #include "optimizer/cost.h"
 #include "optimizer/pathnode.h"
 #include "optimizer/plancat.h"
+#include "parser/parsetree.h"
+#include "utils/attoptcache.h"
 #include "utils/fmgroids.h"
 #include "utils/lsyscache.h"
 #include "utils/selfuncs.h"
@@ -43,8 +45,21 @@ typedef struct RangeQueryClause
 	Selectivity hibound;		/* Selectivity of a var < something clause */
 } RangeQueryClause;
 
+/*
+ * A "Var = constant" clause found by clauselist_selectivity, kept aside to
+ * apply functional dependencies between columns of the same relation.
+ */
+typedef struct EqualityClause
+{
+	Var		   *var;			/* the column */
+	Selectivity s;				/* selectivity of the clause alone */
+} EqualityClause;
+
 static void addRangeClause(RangeQueryClause **rqlist, Node *clause,
 			   bool varonleft, bool isLTsel, Selectivity s2);
+static int	addEqualityClauses(PlannerInfo *root, List *eqlist,
+				   Selectivity *rgsel, int pos, Selectivity *groupsel);
+static bool has_column_group(PlannerInfo *root, Var *var);
 
 /* cmpSelectivity
  * comparison function for using qsort on an array of Selectivity entries
@@ -110,6 +125,11 @@ cmpSelectivity
  * A free side-effect is that we can recognize redundant inequalities such
  * as "x < 4 AND x < 5"; only the tighter constraint will be counted.
  *
+ * We also set aside "column = constant" clauses, so that where ANALYZE found
+ * the value of one column to determine the value of another (see the
+ * statistics_group column option), the second clause doesn't reduce the
+ * selectivity as much as if they were independent.  See addEqualityClauses.
+ *
  * Of course this is all very dependent on the behavior of
  * scalarltsel/scalargtsel; perhaps some day we can generalize the approach.
  */
@@ -122,8 +142,10 @@ clauselist_selectivity(PlannerInfo *root,
 					   bool use_damping)
 {
 	Selectivity s1 = 1.0;
+	Selectivity groupsel = 1.0;
 	Selectivity *rgsel = NULL;
 	RangeQueryClause *rqlist = NULL;
+	List	   *eqlist = NIL;
 	ListCell   *l;
 
 	int pos = 0;
@@ -219,6 +241,26 @@ clauselist_selectivity(PlannerInfo *root,
 						addRangeClause(&rqlist, clause,
 									   varonleft, false, s2);
 						break;
+					case F_EQSEL:
+						{
+							Node	   *var = varonleft ?
+								get_leftop((Expr *) clause) :
+								get_rightop((Expr *) clause);
+
+							if (var && IsA(var, Var) &&
+								((Var *) var)->varattno > 0 &&
+								((Var *) var)->varlevelsup == 0)
+							{
+								EqualityClause *eq = palloc(sizeof(EqualityClause));
+
+								eq->var = (Var *) var;
+								eq->s = s2;
+								eqlist = lappend(eqlist, eq);
+							}
+							else
+								rgsel[pos++] = s2;
+						}
+						break;
 					default:
 						/* Just merge the selectivity in generically */
 						rgsel[pos++] = s2;
@@ -307,6 +349,15 @@ clauselist_selectivity(PlannerInfo *root,
 		rqlist = rqnext;
 	}
 
+	/*
+	 * And the equality clauses.
+	 */
+	if (eqlist != NIL)
+	{
+		pos = addEqualityClauses(root, eqlist, rgsel, pos, &groupsel);
+		list_free_deep(eqlist);
+	}
+
 	Assert(pos <= list_length(clauses));
 
 	if (use_damping && pos >= 2)
@@ -330,6 +381,12 @@ clauselist_selectivity(PlannerInfo *root,
 		s1 *= rgsel[i];
 	}
 
+	/*
+	 * The clauses that ANALYZE's column groups cover already account for
+	 * the correlation between their columns, so they are not damped.
+	 */
+	s1 *= groupsel;
+
 	pfree(rgsel);
 	/* 
 	 * For Anti Semi Join, selectivity is determined by the fraction of 
@@ -437,6 +494,197 @@ addRangeClause(RangeQueryClause **rqlist, Node *clause,
 	*rqlist = rqelem;
 }
 
+/*
+ * addEqualityClauses --- add "Var = constant" clauses for clauselist_selectivity
+ *
+ * If ANALYZE found the value of column a to determine the value of column b
+ * with degree d, then given "a = x AND b = y" we estimate
+ *
+ *		P(a = x AND b = y) = P(a = x) * (d + (1 - d) * P(b = y))
+ *
+ * Dependencies are applied strongest first.  A clause is only adjusted once,
+ * and the clause of a determining column isn't itself adjusted, so that we
+ * never go around in circles.
+ *
+ * The clauses that take part in a dependency, on either side, are multiplied
+ * into *groupsel instead of being added to rgsel, so that the caller doesn't
+ * damp them a second time.  Returns the new number of entries in rgsel.
+ */
+static int
+addEqualityClauses(PlannerInfo *root, List *eqlist, Selectivity *rgsel,
+				   int pos, Selectivity *groupsel)
+{
+	int			neq = list_length(eqlist);
+	EqualityClause **eqs;
+	double	   *degree;
+	bool	   *hasgroup;
+	bool	   *implied;
+	bool	   *determines;
+	bool		any = false;
+	bool		found = false;
+	ListCell   *l;
+	int			i,
+				j;
+
+	if (neq == 1)
+	{
+		rgsel[pos++] = ((EqualityClause *) linitial(eqlist))->s;
+		return pos;
+	}
+
+	/*
+	 * Only a column with the statistics_group option carries group
+	 * statistics.  The option is in the attribute options cache, which is
+	 * much cheaper to look at than the statistics, so don't go looking for
+	 * those at all if none of the columns has it.
+	 */
+	eqs = (EqualityClause **) palloc(neq * sizeof(EqualityClause *));
+	hasgroup = (bool *) palloc(neq * sizeof(bool));
+	i = 0;
+	foreach(l, eqlist)
+	{
+		eqs[i] = (EqualityClause *) lfirst(l);
+		hasgroup[i] = has_column_group(root, eqs[i]->var);
+		any |= hasgroup[i];
+		i++;
+	}
+
+	if (!any)
+	{
+		for (i = 0; i < neq; i++)
+			rgsel[pos++] = eqs[i]->s;
+		pfree(hasgroup);
+		pfree(eqs);
+		return pos;
+	}
+
+	/* degree[i * neq + j] is the degree of the dependency of eqs[j] on eqs[i] */
+	degree = (double *) palloc0(neq * neq * sizeof(double));
+
+	for (i = 0; i < neq; i++)
+	{
+		VariableStatData vardata;
+		ColumnGroupStats group;
+		bool		ok;
+		int			a,
+					b;
+
+		if (!hasgroup[i])
+			continue;
+
+		examine_variable(root, (Node *) eqs[i]->var, 0, &vardata);
+		ok = get_column_group_stats(&vardata, &group);
+		ReleaseVariableStats(vardata);
+		if (!ok)
+			continue;
+
+		for (j = 0; j < neq; j++)
+		{
+			int			k;
+
+			if (eqs[j]->var->varno != eqs[i]->var->varno)
+				continue;
+			for (a = 0; a < group.ncolumns; a++)
+			{
+				if (group.attnums[a] == eqs[j]->var->varattno)
+					break;
+			}
+			if (a == group.ncolumns)
+				continue;
+
+			for (k = 0; k < neq; k++)
+			{
+				if (eqs[k]->var->varno != eqs[i]->var->varno ||
+					eqs[k]->var->varattno == eqs[j]->var->varattno)
+					continue;
+				for (b = 0; b < group.ncolumns; b++)
+				{
+					if (group.attnums[b] == eqs[k]->var->varattno)
+						break;
+				}
+				if (b == group.ncolumns)
+					continue;
+
+				if (degree[j * neq + k] < group.degree[a][b])
+				{
+					degree[j * neq + k] = group.degree[a][b];
+					found = true;
+				}
+			}
+		}
+	}
+
+	implied = (bool *) palloc0(neq * sizeof(bool));
+	determines = (bool *) palloc0(neq * sizeof(bool));
+
+	if (found)
+	{
+
+		for (;;)
+		{
+			double		best = 0.0;
+			int			bi = -1;
+			int			bj = -1;
+
+			for (i = 0; i < neq; i++)
+			{
+				if (implied[i])
+					continue;
+				for (j = 0; j < neq; j++)
+				{
+					if (implied[j] || determines[j])
+						continue;
+					if (degree[i * neq + j] > best)
+					{
+						best = degree[i * neq + j];
+						bi = i;
+						bj = j;
+					}
+				}
+			}
+			if (bi < 0)
+				break;
+
+			determines[bi] = true;
+			implied[bj] = true;
+			CLAMP_PROBABILITY(best);
+			eqs[bj]->s = best + (1.0 - best) * eqs[bj]->s;
+		}
+	}
+
+	for (i = 0; i < neq; i++)
+	{
+		if (implied[i] || determines[i])
+			*groupsel *= eqs[i]->s;
+		else
+			rgsel[pos++] = eqs[i]->s;
+	}
+
+	pfree(implied);
+	pfree(determines);
+	pfree(degree);
+	pfree(hasgroup);
+	pfree(eqs);
+
+	return pos;
+}
+
+/*
+ * has_column_group --- does the column have the statistics_group option?
+ */
+static bool
+has_column_group(PlannerInfo *root, Var *var)
+{
+	RangeTblEntry *rte = planner_rt_fetch(var->varno, root);
+	AttributeOpts *aopt;
+
+	if (rte->rtekind != RTE_RELATION || var->varattno <= 0)
+		return false;
+
+	aopt = get_attribute_options(rte->relid, var->varattno);
+	return aopt != NULL && aopt->statistics_group_offset != 0;
+}
+
 /*
  * bms_is_subset_singleton
  *
@@ -36,6 +36,11 @@
 /* GPORCA entry point */
 extern PlannedStmt * GPOPTOptimizedPlan(Query *parse, bool *had_unexpected_failure);
 
+/* filled in by GPORCA while it optimizes a query */
+OptimizerProfile optimizer_last_profile;
+OptimizerProfile optimizer_total_profile;
+int64		optimizer_profile_count = 0;
+
 /*
  * Logging of optimization outcome
  */
@@ -62,6 +67,32 @@ log_optimizer(PlannedStmt *plan, bool fUnexpectedFailure)
 	}
 }
 
+/*
+ * Add the profile of the last optimization to the totals of this backend.
+ */
+static void
+accumulate_optimizer_profile(void)
+{
+	OptimizerProfile *last = &optimizer_last_profile;
+	OptimizerProfile *total = &optimizer_total_profile;
+	int			i;
+
+	total->query_to_dxl_time += last->query_to_dxl_time;
+	total->search_time += last->search_time;
+	total->dxl_to_plstmt_time += last->dxl_to_plstmt_time;
+	total->md_fetch_time += last->md_fetch_time;
+	total->total_time += last->total_time;
+	for (i = 0; i < MDCACHE_NUM_ENTRY_KINDS; i++)
+	{
+		total->md_fetches[i] += last->md_fetches[i];
+		total->md_shared_hits[i] += last->md_shared_hits[i];
+	}
+	total->allocations += last->allocations;
+	total->bytes_allocated += last->bytes_allocated;
+
+	optimizer_profile_count++;
+}
+
 
 /*
  * optimize_query
@@ -82,6 +113,8 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	List		   *invalItems;
 	ListCell	   *lc;
 	ListCell	   *lp;
+	instr_time		starttime;
+	instr_time		duration;
 
 	/*
 	 * Initialize a dummy PlannerGlobal struct. ORCA doesn't use it, but the
@@ -128,8 +161,16 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	pqueryCopy = preprocess_query_optimizer(root, pqueryCopy, boundParams);
 
 	/* Ok, invoke ORCA. */
+	MemSet(&optimizer_last_profile, 0, sizeof(optimizer_last_profile));
+	INSTR_TIME_SET_CURRENT(starttime);
+
 	result = GPOPTOptimizedPlan(pqueryCopy, &fUnexpectedFailure);
 
+	INSTR_TIME_SET_CURRENT(duration);
+	INSTR_TIME_SUBTRACT(duration, starttime);
+	optimizer_last_profile.total_time = INSTR_TIME_GET_MILLISEC(duration);
+	accumulate_optimizer_profile();
+
 	log_optimizer(result, fUnexpectedFailure);
 
 	CHECK_FOR_INTERRUPTS();
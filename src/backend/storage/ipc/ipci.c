@@ -55,6 +55,7 @@
 #include "utils/faultinjector.h"
 #include "utils/sharedsnapshot.h"
 #include "utils/gpexpand.h"
+#include "utils/optmdcache.h"
 #include "utils/snapmgr.h"
 
 #include "libpq-fe.h"
@@ -186,6 +187,9 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 		size = add_size(size, CheckpointerShmemSize());
 		size = add_size(size, CancelBackendMsgShmemSize());
 		size = add_size(size, WorkFileShmemSize());
+#ifdef USE_ORCA
+		size = add_size(size, OptMDCacheShmemSize());
+#endif
 
 #ifdef FAULT_INJECTOR
 		size = add_size(size, FaultInjector_ShmemSize());
@@ -350,6 +354,9 @@ CreateSharedMemoryAndSemaphores(bool makePrivate, int port)
 	AsyncShmemInit();
 	BackendCancelShmemInit();
 	WorkFileShmemInit();
+#ifdef USE_ORCA
+	OptMDCacheShmemInit();
+#endif
 
 	/*
 	 * Set up Instrumentation free list
@@ -1687,6 +1687,7 @@ SnapshotResetDslm(Snapshot snapshot)
 	dslm->currentLocalXidsCount = 0;
 	dslm->minCachedLocalXid = InvalidTransactionId;
 	dslm->maxCachedLocalXid = InvalidTransactionId;
+	DistributedSnapshotWithLocalMapping_ResetMemo(dslm);
 	if (dslm->inProgressMappedLocalXids == NULL)
 	{
 		dslm->inProgressMappedLocalXids =
@@ -21,6 +21,7 @@
 #include "storage/proc.h"
 #include "storage/sinvaladt.h"
 #include "utils/inval.h"
+#include "utils/optmdcache.h"
 
 #include "cdb/cdbtm.h"          /* DtxContext */
 #include "tcop/idle_resource_cleaner.h"
@@ -56,6 +57,9 @@ void
 SendSharedInvalidMessages(const SharedInvalidationMessage *msgs, int n)
 {
 	SIInsertDataEntries(msgs, n);
+
+	/* after queueing them, see OptMDCacheInvalidateMessages() */
+	OptMDCacheInvalidateMessages(msgs, n);
 }
 
 /*
@@ -1421,7 +1421,8 @@ static void
 exec_mpp_dtx_protocol_command(DtxProtocolCommand dtxProtocolCommand,
 							  const char *loggingStr,
 							  const char *gid,
-							  DtxContextInfo *contextInfo)
+							  DtxContextInfo *contextInfo,
+							  bool readOnly)
 {
 	CommandDest dest = whereToSendOutput;
 	const char *commandTag = loggingStr;
@@ -1464,7 +1465,25 @@ exec_mpp_dtx_protocol_command(DtxProtocolCommand dtxProtocolCommand,
 
 	BeginCommand(commandTag, dest);
 
-	performDtxProtocolCommand(dtxProtocolCommand, gid, contextInfo);
+	/*
+	 * The QD asks segments that didn't write to prepare too, so that they
+	 * can simply commit now and be left out of the second phase. The reply
+	 * still carries the 'Prepare' tag the QD expects. A transaction that has
+	 * an xid did write, if only to a temporary or unlogged table, and
+	 * committing it here would break the atomicity of the distributed
+	 * transaction, so refuse.
+	 */
+	if (dtxProtocolCommand == DTX_PROTOCOL_COMMAND_PREPARE && readOnly)
+	{
+		if (TransactionIdIsValid(GetTopTransactionIdIfAny()))
+			ereport(ERROR,
+					(errcode(ERRCODE_INTERNAL_ERROR),
+					 errmsg("distributed transaction \"%s\" wrote on segment %d, but was asked to commit it without preparing",
+							gid, GpIdentity.segindex)));
+		performDtxProtocolCommand(DTX_PROTOCOL_COMMAND_COMMIT_ONEPHASE, gid, contextInfo);
+	}
+	else
+		performDtxProtocolCommand(dtxProtocolCommand, gid, contextInfo);
 
 	elog((Debug_print_full_dtm ? LOG : DEBUG5),"exec_mpp_dtx_protocol_command calling EndCommand for dtxProtocolCommand = %d (%s) gid = %s",
 		 dtxProtocolCommand, loggingStr, gid);
@@ -5287,6 +5306,8 @@ PostgresMain(int argc, char *argv[],
 					const char *gid;
 					int serializedDtxContextInfolen;
 					const char *serializedDtxContextInfo;
+					int numReadOnlySegments;
+					bool readOnly = false;
 
 					if (Gp_role != GP_ROLE_EXECUTE)
 						ereport(ERROR,
@@ -5320,9 +5341,18 @@ PostgresMain(int argc, char *argv[],
 
 					DtxContextInfo_Deserialize(serializedDtxContextInfo, serializedDtxContextInfolen, &TempDtxContextInfo);
 
+					/* segments that only need to commit, because they didn't write */
+					numReadOnlySegments = pq_getmsgint(&input_message, 4);
+					while (numReadOnlySegments-- > 0)
+					{
+						if ((int) pq_getmsgint(&input_message, 4) == GpIdentity.segindex)
+							readOnly = true;
+					}
+
 					pq_getmsgend(&input_message);
 
-					exec_mpp_dtx_protocol_command(dtxProtocolCommand, loggingStr, gid, &TempDtxContextInfo);
+					exec_mpp_dtx_protocol_command(dtxProtocolCommand, loggingStr, gid, &TempDtxContextInfo,
+												  readOnly);
 
 					send_ready_for_query = true;
             	}
@@ -8,14 +8,24 @@
  *
  * gp_opt_version: This function wraps LibraryVersion. 
  *
+ * gp_optimizer_mdcache_stats: This function wraps MDCacheStatsValues.
+ *
+ * gp_optimizer_profile_stats: This function reads the optimizer profile
+ * totals of the backend.
+ *
  * Copyright(c) 2012 - present, EMC/Greenplum
  */
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
 #include "funcapi.h"
 #include "utils/builtins.h"
 
+#ifdef USE_ORCA
+#include "optimizer/orca.h"
+#endif
+
 extern Datum EnableXform(PG_FUNCTION_ARGS);
 
 /*
@@ -60,3 +70,86 @@ gp_opt_version(PG_FUNCTION_ARGS pg_attribute_unused())
 	return CStringGetTextDatum("Server has been compiled without ORCA");
 #endif
 }
+
+extern void MDCacheStatsValues(int64 *entries, int64 *hits, int64 *fetches, int64 *evictions, int64 *resets);
+
+/*
+ * Returns the activity counters of this backend's optimizer metadata cache.
+ */
+Datum
+gp_optimizer_mdcache_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[5];
+	bool		nulls[5];
+	int64		entries = 0;
+	int64		hits = 0;
+	int64		fetches = 0;
+	int64		evictions = 0;
+	int64		resets = 0;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+#ifdef USE_ORCA
+	MDCacheStatsValues(&entries, &hits, &fetches, &evictions, &resets);
+#endif
+
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(entries);
+	values[1] = Int64GetDatum(hits);
+	values[2] = Int64GetDatum(fetches);
+	values[3] = Int64GetDatum(evictions);
+	values[4] = Int64GetDatum(resets);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * Returns where the time and memory of the optimizations done by this
+ * backend went, summed over all of them.  Times are in milliseconds.
+ */
+Datum
+gp_optimizer_profile_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[14];
+	bool		nulls[14];
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	/* without ORCA, there is nothing to report but zeros */
+	MemSet(values, 0, sizeof(values));
+	MemSet(nulls, 0, sizeof(nulls));
+
+#ifdef USE_ORCA
+	{
+		OptimizerProfile *profile = &optimizer_total_profile;
+		int64		shared_hits = 0;
+		int			i;
+
+		for (i = 0; i < MDCACHE_NUM_ENTRY_KINDS; i++)
+			shared_hits += profile->md_shared_hits[i];
+
+		values[0] = Int64GetDatum(optimizer_profile_count);
+		values[1] = Float8GetDatum(profile->total_time);
+		values[2] = Float8GetDatum(profile->query_to_dxl_time);
+		values[3] = Float8GetDatum(profile->search_time);
+		values[4] = Float8GetDatum(profile->dxl_to_plstmt_time);
+		values[5] = Float8GetDatum(profile->md_fetch_time);
+		values[6] = Int64GetDatum(profile->md_fetches[MDCACHE_ENTRY_OBJECT]);
+		values[7] = Int64GetDatum(profile->md_fetches[MDCACHE_ENTRY_RELSTATS]);
+		values[8] = Int64GetDatum(profile->md_fetches[MDCACHE_ENTRY_COLSTATS]);
+		values[9] = Int64GetDatum(profile->md_fetches[MDCACHE_ENTRY_CAST]);
+		values[10] = Int64GetDatum(profile->md_fetches[MDCACHE_ENTRY_SCCMP]);
+		values[11] = Int64GetDatum(shared_hits);
+		values[12] = Int64GetDatum(profile->allocations);
+		values[13] = Int64GetDatum(profile->bytes_allocated);
+	}
+#endif
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
@@ -3177,6 +3177,98 @@ add_unique_group_var(PlannerInfo *root, List *varinfos,
 	return varinfos;
 }
 
+/*
+ * Helper routine for estimate_num_groups: reldistinct is the product of the
+ * ndistinct estimates of relvarinfos, the grouping Vars of one relation.
+ * Where ANALYZE collected the number of distinct combinations of a group of
+ * correlated columns that are all grouped by, use that instead of the
+ * product of the group's individual estimates.
+ */
+static double
+apply_column_group_ndistinct(PlannerInfo *root, RelOptInfo *rel,
+							 List *relvarinfos, double reldistinct,
+							 double *relmaxndistinct)
+{
+	Bitmapset  *attnums = NULL;
+	ListCell   *lc;
+
+	/* Collect the grouped columns that no group has accounted for yet */
+	foreach(lc, relvarinfos)
+	{
+		GroupVarInfo *varinfo = (GroupVarInfo *) lfirst(lc);
+		Var		   *var = (Var *) varinfo->var;
+
+		if (IsA(var, Var) && var->varattno > 0 && varinfo->ndistinct > 0)
+			attnums = bms_add_member(attnums, var->varattno);
+	}
+
+	foreach(lc, relvarinfos)
+	{
+		GroupVarInfo *varinfo = (GroupVarInfo *) lfirst(lc);
+		Var		   *var = (Var *) varinfo->var;
+		VariableStatData vardata;
+		ColumnGroupStats group;
+		bool		found;
+		double		groupdistinct;
+		double		product;
+		ListCell   *lc2;
+		int			i;
+
+		if (!IsA(var, Var) || var->varattno <= 0 ||
+			!bms_is_member(var->varattno, attnums))
+			continue;
+
+		examine_variable(root, (Node *) var, 0, &vardata);
+		found = get_column_group_stats(&vardata, &group);
+		ReleaseVariableStats(vardata);
+		if (!found)
+			continue;
+
+		for (i = 0; i < group.ncolumns; i++)
+		{
+			if (!bms_is_member(group.attnums[i], attnums))
+				break;
+		}
+		if (i < group.ncolumns)
+			continue;
+
+		if (group.ndistinct < 0)
+			groupdistinct = -group.ndistinct * rel->tuples;
+		else
+			groupdistinct = group.ndistinct;
+		if (groupdistinct < 1.0)
+			continue;
+
+		product = 1.0;
+		foreach(lc2, relvarinfos)
+		{
+			GroupVarInfo *varinfo2 = (GroupVarInfo *) lfirst(lc2);
+			Var		   *var2 = (Var *) varinfo2->var;
+
+			if (!IsA(var2, Var) || var2->varattno <= 0)
+				continue;
+			for (i = 0; i < group.ncolumns; i++)
+			{
+				if (group.attnums[i] == var2->varattno)
+				{
+					product *= varinfo2->ndistinct;
+					attnums = bms_del_member(attnums, var2->varattno);
+					break;
+				}
+			}
+		}
+
+		if (groupdistinct < product)
+			reldistinct = reldistinct / product * groupdistinct;
+		if (*relmaxndistinct < groupdistinct)
+			*relmaxndistinct = groupdistinct;
+	}
+
+	bms_free(attnums);
+
+	return reldistinct;
+}
+
 /*
  * estimate_num_groups		- Estimate number of groups in a grouped query
  *
@@ -3225,16 +3317,20 @@ add_unique_group_var(PlannerInfo *root, List *varinfos,
  *		if we considered ones of the same rel, we'd be double-counting the
  *		restriction selectivity of the equality in the next step.
  *	4.  For Vars within a single source rel, we multiply together the numbers
- *		of values, clamp to the number of rows in the rel (divided by 10 if
- *		more than one Var), and then multiply by a factor based on the
- *		selectivity of the restriction clauses for that rel.  When there's
- *		more than one Var, the initial product is probably too high (it's the
- *		worst case) but clamping to a fraction of the rel's rows seems to be a
- *		helpful heuristic for not letting the estimate get out of hand.  (The
- *		factor of 10 is derived from pre-Postgres-7.4 practice.)  The factor
- *		we multiply by to adjust for the restriction selectivity assumes that
- *		the restriction clauses are independent of the grouping, which may not
- *		be a valid assumption, but it's hard to do better.
+ *		of values, except that where ANALYZE collected the number of distinct
+ *		combinations of a group of the Vars (see the statistics_group column
+ *		option), we use that for the group.  We clamp the result to the number
+ *		of rows in the rel (divided by 10 if more than one Var), and then
+ *		multiply by a factor based on the selectivity of the restriction
+ *		clauses for that rel.  When there's more than one Var, the initial
+ *		product is probably too high (it's the worst case, unless group
+ *		statistics covered all the Vars) but clamping to a fraction of the
+ *		rel's rows seems to be a helpful heuristic for not letting the
+ *		estimate get out of hand.  (The factor of 10 is derived from
+ *		pre-Postgres-7.4 practice.)  The factor we multiply by to adjust for
+ *		the restriction selectivity assumes that the restriction clauses are
+ *		independent of the grouping, which may not be a valid assumption, but
+ *		it's hard to do better.
  *	5.  If there are Vars from multiple rels, we repeat step 4 for each such
  *		rel, and multiply the results together.
  * Note that rels not containing grouped Vars are ignored completely, as are
@@ -3374,6 +3470,7 @@ estimate_num_groups(PlannerInfo *root, List *groupExprs, double input_rows,
 		double		reldistinct = varinfo1->ndistinct;
 		double		relmaxndistinct = reldistinct;
 		int			relvarcount = 1;
+		List	   *relvarinfos = list_make1(varinfo1);
 		List	   *newvarinfos = NIL;
 
 		/*
@@ -3390,6 +3487,7 @@ estimate_num_groups(PlannerInfo *root, List *groupExprs, double input_rows,
 				if (relmaxndistinct < varinfo2->ndistinct)
 					relmaxndistinct = varinfo2->ndistinct;
 				relvarcount++;
+				relvarinfos = lappend(relvarinfos, varinfo2);
 			}
 			else
 			{
@@ -3398,6 +3496,12 @@ estimate_num_groups(PlannerInfo *root, List *groupExprs, double input_rows,
 			}
 		}
 
+		if (relvarcount > 1)
+			reldistinct = apply_column_group_ndistinct(root, rel, relvarinfos,
+													   reldistinct,
+													   &relmaxndistinct);
+		list_free(relvarinfos);
+
 		/*
 		 * Sanity check --- don't divide by zero if empty relation.
 		 */
@@ -5159,6 +5263,55 @@ get_variable_numdistinct(VariableStatData *vardata, bool *isdefault)
 	return DEFAULT_NUM_DISTINCT;
 }
 
+/*
+ * get_column_group_stats
+ *	  Fetch the multi-column statistics that ANALYZE stored with a column,
+ *	  because of its statistics_group option.
+ *
+ * vardata: results of examine_variable for the first column of the group
+ * group: filled in with the statistics
+ *
+ * Returns false if there are none.
+ */
+bool
+get_column_group_stats(VariableStatData *vardata, ColumnGroupStats *group)
+{
+	AttStatsSlot sslot;
+	int			ncolumns;
+	int			a,
+				b;
+
+	if (!HeapTupleIsValid(vardata->statsTuple))
+		return false;
+
+	if (!get_attstatsslot(&sslot, vardata->statsTuple,
+						  STATISTIC_KIND_COLUMN_GROUP, InvalidOid,
+						  ATTSTATSSLOT_VALUES | ATTSTATSSLOT_NUMBERS))
+		return false;
+
+	ncolumns = sslot.nvalues;
+	if (sslot.valuetype != INT2OID ||
+		ncolumns < 2 || ncolumns > STATISTIC_GROUP_MAX_COLUMNS ||
+		sslot.nnumbers != 1 + ncolumns * ncolumns)
+	{
+		free_attstatsslot(&sslot);
+		return false;
+	}
+
+	group->ncolumns = ncolumns;
+	for (a = 0; a < ncolumns; a++)
+		group->attnums[a] = DatumGetInt16(sslot.values[a]);
+	group->ndistinct = sslot.numbers[0];
+	for (a = 0; a < ncolumns; a++)
+	{
+		for (b = 0; b < ncolumns; b++)
+			group->degree[a][b] = sslot.numbers[1 + a * ncolumns + b];
+	}
+
+	free_attstatsslot(&sslot);
+	return true;
+}
+
 /*
  * get_variable_range
  *		Estimate the minimum and maximum value of the specified variable.
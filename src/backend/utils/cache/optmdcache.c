@@ -0,0 +1,688 @@
+/*-------------------------------------------------------------------------
+ *
+ * optmdcache.c
+ *	  Shared-memory store of serialized ORCA metadata objects.
+ *
+ * Every backend has its own ORCA metadata cache, which is filled by
+ * translating catalog entries into DXL. On a coordinator with many sessions,
+ * each of them translates and holds the same objects. This module keeps the
+ * serialized DXL of the translated objects in shared memory, so that a
+ * backend that misses in its own cache can pick up an object that another
+ * backend has already translated, instead of going to the catalogs.
+ *
+ * Entries are keyed by the database and the identity of the metadata id (see
+ * MDCacheEntryKey), and stored in a pool of fixed-size blocks. The store is
+ * read-mostly: lookups take OptimizerMDCacheLock in shared mode, and only
+ * inserting an entry takes it exclusively.
+ *
+ * Invalidation
+ * ------------
+ *
+ * The store follows the normal shared invalidation path. Whenever a backend
+ * sends invalidation messages, which it does when it commits a transaction
+ * that changed the catalogs, OptMDCacheInvalidateMessages() is called for
+ * them (see SendSharedInvalidMessages()). It doesn't search the store.
+ * Instead, the relation or syscache hash value of each message is hashed
+ * into an array of generation counters, and the counter is bumped. When an
+ * entry is stored, it records the current generation of every counter its
+ * object depends on, and a lookup treats an entry as missing if any of them
+ * has moved since. A collision merely makes an entry go stale that didn't
+ * need to. The space of stale entries is reclaimed when the store runs out
+ * of blocks.
+ *
+ * Because the sender does it, the counters move for every catalog change,
+ * whether or not the backends that are running at the time use ORCA, and
+ * backends that connect later see them, too. A catalog version counter of
+ * the database of the change is bumped along with them, after the messages
+ * have been queued. A backend reads it, and the counter of the shared
+ * catalogs, before it catches up with invalidations and translates an
+ * object, and the object is only stored if neither has moved since, so a
+ * translation that raced with a concurrent catalog change cannot be stored
+ * with generations taken after the change. The version is per database,
+ * not per object: any catalog change in a database, even to an unrelated
+ * table, keeps the objects of that database that are being translated at
+ * the same time from being stored. They are stored by the next backend that
+ * translates them.
+ *
+ * Partitioned tables are not stored, because their size and statistics are
+ * derived from their partitions, and the invalidation messages for a
+ * partition don't name the partitioned table.
+ *
+ * Objects translated in a transaction that has modified the catalogs may
+ * reflect its uncommitted changes, so such transactions neither read from
+ * nor write to the store (see gpdb::MDCacheSharedBeginFetch()).
+ *
+ * Copyright (c) 2019-Present Pivotal Software, Inc.
+ *
+ * src/backend/utils/cache/optmdcache.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "access/htup_details.h"
+#include "cdb/cdbvars.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "storage/lwlock.h"
+#include "storage/shmem.h"
+#include "storage/sinval.h"
+#include "utils/builtins.h"
+#include "utils/guc.h"
+#include "utils/hsearch.h"
+#include "utils/optmdcache.h"
+#include "utils/syscache.h"
+
+#define OPTMDCACHE_BLOCK_SIZE	1024
+
+/*
+ * Number of generation counters that invalidations are hashed into. The
+ * counter after the last one is bumped by invalidations that can't be
+ * mapped back to individual objects, and every entry depends on it.
+ */
+#define OPTMDCACHE_NUM_SLOTS	4096
+#define OPTMDCACHE_ALL_SLOT		OPTMDCACHE_NUM_SLOTS
+
+#define OPTMDCACHE_MAX_DEPS		8
+
+/*
+ * Number of catalog version counters that databases are hashed into. The
+ * counter after the last one is for the shared catalogs.
+ */
+#define OPTMDCACHE_NUM_VERSIONS		64
+#define OPTMDCACHE_SHARED_VERSION	OPTMDCACHE_NUM_VERSIONS
+
+/* pseudo cache id, for relcache invalidations */
+#define OPTMDCACHE_RELCACHE		(-1)
+
+typedef struct OptMDCacheSharedKey
+{
+	Oid			dbid;
+	MDCacheEntryKey key;
+} OptMDCacheSharedKey;
+
+typedef struct OptMDCacheDep
+{
+	uint32		slot;
+	uint32		generation;
+} OptMDCacheDep;
+
+typedef struct OptMDCacheEntry
+{
+	OptMDCacheSharedKey key;	/* hash key, must be first */
+	Oid			relid;			/* relation the object depends on, if any */
+	AttrNumber	attno;			/* attribute number, for column statistics */
+	int			ndeps;
+	OptMDCacheDep deps[OPTMDCACHE_MAX_DEPS];
+	int			first_block;
+	Size		len;			/* length of the DXL, without terminator */
+} OptMDCacheEntry;
+
+typedef struct OptMDCacheControl
+{
+	pg_atomic_uint64 catalog_versions[OPTMDCACHE_NUM_VERSIONS + 1];
+	pg_atomic_uint64 hits;
+	pg_atomic_uint64 misses;
+
+	/* these are protected by OptimizerMDCacheLock */
+	uint64		inserts;
+	uint64		rejects;
+	int			nblocks;
+	int			nfree;
+	int			free_block;		/* head of the free list */
+
+	pg_atomic_uint32 generations[OPTMDCACHE_NUM_SLOTS + 1];
+} OptMDCacheControl;
+
+static OptMDCacheControl *optMDCache = NULL;
+static int *optMDCacheBlockLinks;
+static char *optMDCacheBlocks;
+static HTAB *optMDCacheHash;
+
+/*
+ * The store only exists on the dispatcher, which is the only node that runs
+ * the optimizer.
+ */
+static int
+optmdcache_num_blocks(void)
+{
+	if (Gp_role != GP_ROLE_DISPATCH || optimizer_mdcache_shared_size <= 0)
+		return 0;
+
+	return (int) (((Size) optimizer_mdcache_shared_size * 1024) / OPTMDCACHE_BLOCK_SIZE);
+}
+
+static Size
+optmdcache_struct_size(int nblocks)
+{
+	Size		size;
+
+	size = MAXALIGN(sizeof(OptMDCacheControl));
+	size = add_size(size, MAXALIGN(mul_size(nblocks, sizeof(int))));
+	size = add_size(size, mul_size(nblocks, OPTMDCACHE_BLOCK_SIZE));
+
+	return size;
+}
+
+Size
+OptMDCacheShmemSize(void)
+{
+	int			nblocks = optmdcache_num_blocks();
+
+	if (nblocks == 0)
+		return 0;
+
+	return add_size(optmdcache_struct_size(nblocks),
+					hash_estimate_size(nblocks, sizeof(OptMDCacheEntry)));
+}
+
+void
+OptMDCacheShmemInit(void)
+{
+	int			nblocks = optmdcache_num_blocks();
+	HASHCTL		info;
+	bool		found;
+	int			i;
+
+	if (nblocks == 0)
+		return;
+
+	optMDCache = (OptMDCacheControl *)
+		ShmemInitStruct("ORCA metadata cache",
+						optmdcache_struct_size(nblocks),
+						&found);
+	optMDCacheBlockLinks = (int *)
+		((char *) optMDCache + MAXALIGN(sizeof(OptMDCacheControl)));
+	optMDCacheBlocks = (char *) optMDCacheBlockLinks +
+		MAXALIGN(nblocks * sizeof(int));
+
+	if (!found)
+	{
+		for (i = 0; i <= OPTMDCACHE_NUM_VERSIONS; i++)
+			pg_atomic_init_u64(&optMDCache->catalog_versions[i], 0);
+		pg_atomic_init_u64(&optMDCache->hits, 0);
+		pg_atomic_init_u64(&optMDCache->misses, 0);
+		optMDCache->inserts = 0;
+		optMDCache->rejects = 0;
+		optMDCache->nblocks = nblocks;
+
+		for (i = 0; i <= OPTMDCACHE_NUM_SLOTS; i++)
+			pg_atomic_init_u32(&optMDCache->generations[i], 0);
+
+		/* all blocks start out on the free list */
+		for (i = 0; i < nblocks; i++)
+			optMDCacheBlockLinks[i] = i + 1;
+		optMDCacheBlockLinks[nblocks - 1] = -1;
+		optMDCache->free_block = 0;
+		optMDCache->nfree = nblocks;
+	}
+
+	/* every entry takes at least one block */
+	MemSet(&info, 0, sizeof(info));
+	info.keysize = sizeof(OptMDCacheSharedKey);
+	info.entrysize = sizeof(OptMDCacheEntry);
+	optMDCacheHash = ShmemInitHash("ORCA metadata cache entries",
+								   nblocks,
+								   nblocks,
+								   &info,
+								   HASH_ELEM | HASH_BLOBS);
+}
+
+bool
+OptMDCacheSharedEnabled(void)
+{
+	return optMDCache != NULL;
+}
+
+static uint32
+optmdcache_slot(int cacheid, uint32 hashvalue)
+{
+	uint32		h;
+
+	h = DatumGetUInt32(hash_uint32((uint32) cacheid)) ^
+		DatumGetUInt32(hash_uint32(hashvalue));
+
+	return h % OPTMDCACHE_NUM_SLOTS;
+}
+
+static pg_atomic_uint64 *
+optmdcache_version(Oid dbid)
+{
+	if (!OidIsValid(dbid))
+		return &optMDCache->catalog_versions[OPTMDCACHE_SHARED_VERSION];
+
+	return &optMDCache->catalog_versions[DatumGetUInt32(hash_uint32((uint32) dbid)) %
+										 OPTMDCACHE_NUM_VERSIONS];
+}
+
+/*
+ * The catalog version that the objects of the current database depend on.
+ * Both counters only go up, so their sum only stays the same if neither
+ * moved.
+ */
+static uint64
+optmdcache_catalog_version(void)
+{
+	return pg_atomic_read_u64(optmdcache_version(MyDatabaseId)) +
+		pg_atomic_read_u64(optmdcache_version(InvalidOid));
+}
+
+static void
+optmdcache_bump(Oid dbid, uint32 slot)
+{
+	/*
+	 * The catalog version has to move before the generation, see
+	 * OptMDCacheInsert(). The atomic operations are full barriers.
+	 */
+	pg_atomic_fetch_add_u64(optmdcache_version(dbid), 1);
+	pg_atomic_fetch_add_u32(&optMDCache->generations[slot], 1);
+}
+
+static void
+optmdcache_invalidate_relation(Oid dbid, Oid relid)
+{
+	optmdcache_bump(dbid, optmdcache_slot(OPTMDCACHE_RELCACHE, relid));
+}
+
+static void
+optmdcache_invalidate_syscache(Oid dbid, int cacheid, uint32 hashvalue)
+{
+	optmdcache_bump(dbid, optmdcache_slot(cacheid, hashvalue));
+
+	/* for entries that depend on any change to the catalog */
+	optmdcache_bump(dbid, optmdcache_slot(cacheid, 0));
+}
+
+static void
+optmdcache_invalidate_all(Oid dbid)
+{
+	optmdcache_bump(dbid, OPTMDCACHE_ALL_SLOT);
+}
+
+/*
+ * Invalidate the objects affected by invalidation messages that are being
+ * sent to all backends.
+ */
+void
+OptMDCacheInvalidateMessages(const SharedInvalidationMessage *msgs, int n)
+{
+	int			i;
+
+	if (optMDCache == NULL)
+		return;
+
+	for (i = 0; i < n; i++)
+	{
+		const SharedInvalidationMessage *msg = &msgs[i];
+
+		if (msg->id >= 0)
+		{
+			/*
+			 * Operator families and the partitioning catalogs feed into too
+			 * many different metadata objects to track them individually.
+			 */
+			if (msg->cc.id == AMOPOPID ||
+				msg->cc.id == OPFAMILYOID ||
+				msg->cc.id == PARTOID ||
+				msg->cc.id == PARTRULEOID)
+				optmdcache_invalidate_all(msg->cc.dbId);
+			else
+				optmdcache_invalidate_syscache(msg->cc.dbId, msg->cc.id,
+											   msg->cc.hashValue);
+		}
+		else if (msg->id == SHAREDINVALCATALOG_ID)
+		{
+			/* a whole catalog was flushed */
+			optmdcache_invalidate_all(msg->cat.dbId);
+		}
+		else if (msg->id == SHAREDINVALRELCACHE_ID)
+		{
+			/* InvalidOid means that the whole relcache is to be flushed */
+			if (OidIsValid(msg->rc.relId))
+				optmdcache_invalidate_relation(msg->rc.dbId, msg->rc.relId);
+			else
+				optmdcache_invalidate_all(msg->rc.dbId);
+		}
+	}
+}
+
+uint64
+OptMDCacheGetCatalogVersion(void)
+{
+	Assert(optMDCache != NULL);
+
+	return optmdcache_catalog_version();
+}
+
+/*
+ * Collect the generation counters that an entry depends on. This mirrors
+ * mdcache_entry_is_invalidated() in gpdbwrappers.cpp, which does the same
+ * for the backend-local metadata cache.
+ */
+static int
+optmdcache_entry_deps(const MDCacheEntryKey *key, Oid relid, AttrNumber attno,
+					  OptMDCacheDep *deps)
+{
+	Datum		oid = ObjectIdGetDatum(key->oid);
+	int			n = 0;
+
+	deps[n++].slot = OPTMDCACHE_ALL_SLOT;
+	if (OidIsValid(relid))
+		deps[n++].slot = optmdcache_slot(OPTMDCACHE_RELCACHE, relid);
+
+	switch (key->kind)
+	{
+		case MDCACHE_ENTRY_OBJECT:
+			deps[n++].slot = optmdcache_slot(TYPEOID, GetSysCacheHashValue1(TYPEOID, oid));
+			deps[n++].slot = optmdcache_slot(OPEROID, GetSysCacheHashValue1(OPEROID, oid));
+			deps[n++].slot = optmdcache_slot(PROCOID, GetSysCacheHashValue1(PROCOID, oid));
+			deps[n++].slot = optmdcache_slot(AGGFNOID, GetSysCacheHashValue1(AGGFNOID, oid));
+			deps[n++].slot = optmdcache_slot(CONSTROID, GetSysCacheHashValue1(CONSTROID, oid));
+			break;
+
+		case MDCACHE_ENTRY_RELSTATS:
+			/* comes from pg_class only, covered by the relation */
+			break;
+
+		case MDCACHE_ENTRY_COLSTATS:
+			deps[n++].slot = optmdcache_slot(STATRELATTINH,
+											 GetSysCacheHashValue3(STATRELATTINH,
+																   oid,
+																   Int16GetDatum(attno),
+																   BoolGetDatum(false)));
+			deps[n++].slot = optmdcache_slot(STATRELATTINH,
+											 GetSysCacheHashValue3(STATRELATTINH,
+																   oid,
+																   Int16GetDatum(attno),
+																   BoolGetDatum(true)));
+			break;
+
+		case MDCACHE_ENTRY_CAST:
+			deps[n++].slot = optmdcache_slot(CASTSOURCETARGET,
+											 GetSysCacheHashValue2(CASTSOURCETARGET,
+																   oid,
+																   ObjectIdGetDatum(key->oid2)));
+			deps[n++].slot = optmdcache_slot(TYPEOID, 0);
+			deps[n++].slot = optmdcache_slot(PROCOID, 0);
+			break;
+
+		case MDCACHE_ENTRY_SCCMP:
+			deps[n++].slot = optmdcache_slot(TYPEOID, 0);
+			deps[n++].slot = optmdcache_slot(OPEROID, 0);
+			deps[n++].slot = optmdcache_slot(CASTSOURCETARGET, 0);
+			break;
+	}
+
+	Assert(n <= OPTMDCACHE_MAX_DEPS);
+
+	return n;
+}
+
+static bool
+optmdcache_entry_is_valid(const OptMDCacheEntry *entry)
+{
+	int			i;
+
+	for (i = 0; i < entry->ndeps; i++)
+	{
+		if (pg_atomic_read_u32(&optMDCache->generations[entry->deps[i].slot]) !=
+			entry->deps[i].generation)
+			return false;
+	}
+
+	return true;
+}
+
+static void
+optmdcache_make_key(OptMDCacheSharedKey *skey, const MDCacheEntryKey *key)
+{
+	/* the key is hashed as a blob */
+	MemSet(skey, 0, sizeof(OptMDCacheSharedKey));
+	skey->dbid = MyDatabaseId;
+	skey->key = *key;
+}
+
+/*
+ * Remove an entry, and put its blocks back on the free list. The caller
+ * must hold OptimizerMDCacheLock exclusively.
+ */
+static void
+optmdcache_remove_entry(OptMDCacheEntry *entry)
+{
+	int			block = entry->first_block;
+
+	while (block >= 0)
+	{
+		int			next = optMDCacheBlockLinks[block];
+
+		optMDCacheBlockLinks[block] = optMDCache->free_block;
+		optMDCache->free_block = block;
+		optMDCache->nfree++;
+		block = next;
+	}
+
+	hash_search(optMDCacheHash, &entry->key, HASH_REMOVE, NULL);
+}
+
+/*
+ * Reclaim the space of entries that have gone stale. The caller must hold
+ * OptimizerMDCacheLock exclusively.
+ */
+static void
+optmdcache_remove_stale_entries(void)
+{
+	HASH_SEQ_STATUS status;
+	OptMDCacheEntry *entry;
+
+	hash_seq_init(&status, optMDCacheHash);
+	while ((entry = (OptMDCacheEntry *) hash_seq_search(&status)) != NULL)
+	{
+		/* it's OK to remove the current entry of a seq scan */
+		if (!optmdcache_entry_is_valid(entry))
+			optmdcache_remove_entry(entry);
+	}
+}
+
+/*
+ * Look up an object in the store. Returns a palloc'd copy of its DXL, and
+ * the relation and attribute it depends on, or NULL if it is not present or
+ * has been invalidated.
+ */
+char *
+OptMDCacheLookup(const MDCacheEntryKey *key, Oid *relid, AttrNumber *attno)
+{
+	OptMDCacheSharedKey skey;
+	OptMDCacheEntry *entry;
+	char	   *result = NULL;
+
+	Assert(optMDCache != NULL);
+
+	optmdcache_make_key(&skey, key);
+
+	LWLockAcquire(OptimizerMDCacheLock, LW_SHARED);
+
+	entry = (OptMDCacheEntry *) hash_search(optMDCacheHash, &skey, HASH_FIND, NULL);
+	if (entry != NULL && optmdcache_entry_is_valid(entry))
+	{
+		Size		remaining = entry->len;
+		int			block = entry->first_block;
+		char	   *dst;
+
+		result = dst = palloc(entry->len + 1);
+		while (remaining > 0)
+		{
+			Size		chunk = Min(remaining, OPTMDCACHE_BLOCK_SIZE);
+
+			Assert(block >= 0);
+			memcpy(dst, optMDCacheBlocks + (Size) block * OPTMDCACHE_BLOCK_SIZE, chunk);
+			dst += chunk;
+			remaining -= chunk;
+			block = optMDCacheBlockLinks[block];
+		}
+		*dst = '\0';
+
+		*relid = entry->relid;
+		*attno = entry->attno;
+	}
+
+	LWLockRelease(OptimizerMDCacheLock);
+
+	if (result != NULL)
+		pg_atomic_fetch_add_u64(&optMDCache->hits, 1);
+	else
+		pg_atomic_fetch_add_u64(&optMDCache->misses, 1);
+
+	return result;
+}
+
+/*
+ * Store the DXL of an object. 'catalog_version' is the value that
+ * OptMDCacheGetCatalogVersion() returned before the object was translated.
+ * If the store is full even after reclaiming stale entries, the object is
+ * not stored.
+ */
+void
+OptMDCacheInsert(const MDCacheEntryKey *key, Oid relid, AttrNumber attno,
+				 uint64 catalog_version, const char *data)
+{
+	OptMDCacheSharedKey skey;
+	OptMDCacheEntry *entry;
+	OptMDCacheDep deps[OPTMDCACHE_MAX_DEPS];
+	int			ndeps;
+	Size		len = strlen(data);
+	int			nneeded = (int) ((len + OPTMDCACHE_BLOCK_SIZE - 1) / OPTMDCACHE_BLOCK_SIZE);
+	bool		found;
+	int			prev;
+	int			i;
+
+	Assert(optMDCache != NULL);
+
+	if (nneeded > optMDCache->nblocks)
+		return;
+
+	/* computing the syscache hash values may access the catalogs */
+	optmdcache_make_key(&skey, key);
+	ndeps = optmdcache_entry_deps(key, relid, attno, deps);
+
+	LWLockAcquire(OptimizerMDCacheLock, LW_EXCLUSIVE);
+
+	/*
+	 * Read the generations first, and the catalog version after them.
+	 * Invalidations bump the catalog version first, so if it hasn't moved
+	 * since the object was translated, none of the generations read here can
+	 * be newer than the translation.
+	 */
+	for (i = 0; i < ndeps; i++)
+		deps[i].generation = pg_atomic_read_u32(&optMDCache->generations[deps[i].slot]);
+	pg_memory_barrier();
+	if (optmdcache_catalog_version() != catalog_version)
+	{
+		LWLockRelease(OptimizerMDCacheLock);
+		return;
+	}
+
+	entry = (OptMDCacheEntry *) hash_search(optMDCacheHash, &skey, HASH_FIND, NULL);
+	if (entry != NULL)
+		optmdcache_remove_entry(entry);
+
+	if (optMDCache->nfree < nneeded)
+		optmdcache_remove_stale_entries();
+
+	if (optMDCache->nfree < nneeded)
+	{
+		optMDCache->rejects++;
+		LWLockRelease(OptimizerMDCacheLock);
+		return;
+	}
+
+	entry = (OptMDCacheEntry *) hash_search(optMDCacheHash, &skey, HASH_ENTER_NULL, &found);
+	if (entry == NULL)
+	{
+		optMDCache->rejects++;
+		LWLockRelease(OptimizerMDCacheLock);
+		return;
+	}
+	Assert(!found);
+
+	entry->relid = relid;
+	entry->attno = attno;
+	entry->ndeps = ndeps;
+	memcpy(entry->deps, deps, ndeps * sizeof(OptMDCacheDep));
+	entry->len = len;
+	entry->first_block = -1;
+
+	prev = -1;
+	while (len > 0)
+	{
+		int			block = optMDCache->free_block;
+		Size		chunk = Min(len, OPTMDCACHE_BLOCK_SIZE);
+
+		optMDCache->free_block = optMDCacheBlockLinks[block];
+		optMDCache->nfree--;
+
+		optMDCacheBlockLinks[block] = -1;
+		if (prev < 0)
+			entry->first_block = block;
+		else
+			optMDCacheBlockLinks[prev] = block;
+		prev = block;
+
+		memcpy(optMDCacheBlocks + (Size) block * OPTMDCACHE_BLOCK_SIZE, data, chunk);
+		data += chunk;
+		len -= chunk;
+	}
+
+	optMDCache->inserts++;
+
+	LWLockRelease(OptimizerMDCacheLock);
+}
+
+/*
+ * Returns the size and activity counters of the shared metadata store.
+ */
+Datum
+gp_optimizer_mdcache_shared_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[7];
+	bool		nulls[7];
+	int64		entries = 0;
+	int64		size = 0;
+	int64		used = 0;
+	int64		hits = 0;
+	int64		misses = 0;
+	int64		inserts = 0;
+	int64		rejects = 0;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	if (optMDCache != NULL)
+	{
+		LWLockAcquire(OptimizerMDCacheLock, LW_SHARED);
+		entries = hash_get_num_entries(optMDCacheHash);
+		size = (int64) optMDCache->nblocks * OPTMDCACHE_BLOCK_SIZE;
+		used = (int64) (optMDCache->nblocks - optMDCache->nfree) * OPTMDCACHE_BLOCK_SIZE;
+		inserts = optMDCache->inserts;
+		rejects = optMDCache->rejects;
+		LWLockRelease(OptimizerMDCacheLock);
+
+		hits = pg_atomic_read_u64(&optMDCache->hits);
+		misses = pg_atomic_read_u64(&optMDCache->misses);
+	}
+
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(entries);
+	values[1] = Int64GetDatum(size);
+	values[2] = Int64GetDatum(used);
+	values[3] = Int64GetDatum(hits);
+	values[4] = Int64GetDatum(misses);
+	values[5] = Int64GetDatum(inserts);
+	values[6] = Int64GetDatum(rejects);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
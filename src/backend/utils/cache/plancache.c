@@ -61,10 +61,14 @@
 #include "optimizer/prep.h"
 #include "parser/analyze.h"
 #include "parser/parsetree.h"
+#include "portability/instr_time.h"
 #include "storage/lmgr.h"
 #include "tcop/pquery.h"
 #include "tcop/utility.h"
+#include "utils/datum.h"
+#include "utils/guc.h"
 #include "utils/inval.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/resowner_private.h"
 #include "utils/rls.h"
@@ -90,8 +94,17 @@
 static CachedPlanSource *first_saved_plan = NULL;
 
 static void ReleaseGenericPlan(CachedPlanSource *plansource);
+static void ReleaseOrcaPlans(CachedPlanSource *plansource);
 static List *RevalidateCachedQuery(CachedPlanSource *plansource, IntoClause *intoClause);
 static bool CheckCachedPlan(CachedPlanSource *plansource);
+static bool RevalidateCachedPlan(CachedPlan *plan);
+static CachedPlan *GetOrcaPlan(CachedPlanSource *plansource,
+			ParamListInfo boundParams, IntoClause *intoClause);
+static void RememberOrcaPlan(CachedPlanSource *plansource, CachedPlan *plan,
+				 ParamListInfo boundParams, IntoClause *intoClause);
+static bool orca_plan_reuse_allowed(CachedPlanSource *plansource,
+						ParamListInfo boundParams, IntoClause *intoClause);
+static bool param_lists_equal(ParamListInfo a, ParamListInfo b);
 static CachedPlan *BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 				ParamListInfo boundParams, IntoClause *intoClause);
 static bool choose_custom_plan(CachedPlanSource *plansource,
@@ -103,6 +116,9 @@ static void AcquirePlannerLocks(List *stmt_list, bool acquire);
 static void ScanQueryForLocks(Query *parsetree, bool acquire);
 static bool ScanQueryWalker(Node *node, bool *acquire);
 static bool plan_list_is_oneoff(List *stmt_list);
+static bool plan_list_is_orca(List *stmt_list);
+static bool plan_depends_on_rel(CachedPlan *plan, Oid relid);
+static bool plan_depends_on_item(CachedPlan *plan, int cacheid, uint32 hashvalue);
 static TupleDesc PlanCacheComputeResultDesc(List *stmt_list);
 static void PlanCacheRelCallback(Datum arg, Oid relid);
 static void PlanCacheFuncCallback(Datum arg, int cacheid, uint32 hashvalue);
@@ -213,6 +229,10 @@ CreateCachedPlan(Node *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->orca_plans = NIL;
+	plansource->num_orca_lookups = 0;
+	plansource->num_orca_hits = 0;
+	plansource->orca_saved_time = 0;
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -281,6 +301,10 @@ CreateOneShotCachedPlan(Node *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->orca_plans = NIL;
+	plansource->num_orca_lookups = 0;
+	plansource->num_orca_hits = 0;
+	plansource->orca_saved_time = 0;
 
 	return plansource;
 }
@@ -467,6 +491,7 @@ SaveCachedPlan(CachedPlanSource *plansource)
 	 * long-lived.  Best thing to do seems to be to discard the plan.
 	 */
 	ReleaseGenericPlan(plansource);
+	ReleaseOrcaPlans(plansource);
 
 	/*
 	 * Reparent the source memory context under CacheMemoryContext so that it
@@ -520,6 +545,7 @@ DropCachedPlan(CachedPlanSource *plansource)
 
 	/* Decrement generic CachePlan's refcount and drop if no longer needed */
 	ReleaseGenericPlan(plansource);
+	ReleaseOrcaPlans(plansource);
 
 	/* Mark it no longer valid */
 	plansource->magic = 0;
@@ -549,6 +575,22 @@ ReleaseGenericPlan(CachedPlanSource *plansource)
 	}
 }
 
+/*
+ * ReleaseOrcaPlans: release the ORCA plans a CachedPlanSource keeps for reuse.
+ */
+static void
+ReleaseOrcaPlans(CachedPlanSource *plansource)
+{
+	while (plansource->orca_plans != NIL)
+	{
+		CachedPlan *plan = (CachedPlan *) linitial(plansource->orca_plans);
+
+		Assert(plan->magic == CACHEDPLAN_MAGIC);
+		plansource->orca_plans = list_delete_first(plansource->orca_plans);
+		ReleaseCachedPlan(plan, false);
+	}
+}
+
 /*
  * RevalidateCachedQuery: ensure validity of analyzed-and-rewritten query tree.
  *
@@ -665,6 +707,7 @@ RevalidateCachedQuery(CachedPlanSource *plansource, IntoClause *intoClause)
 
 	/* Drop the generic plan reference if any */
 	ReleaseGenericPlan(plansource);
+	ReleaseOrcaPlans(plansource);
 
 	/*
 	 * Now re-do parse analysis and rewrite.  This not incidentally acquires
@@ -836,6 +879,27 @@ CheckCachedPlan(CachedPlanSource *plansource)
 	/* Generic plans are never one-shot */
 	Assert(!plan->is_oneshot);
 
+	if (RevalidateCachedPlan(plan))
+		return true;
+
+	/*
+	 * Plan has been invalidated, so unlink it from the parent and release it.
+	 */
+	ReleaseGenericPlan(plansource);
+
+	return false;
+}
+
+/*
+ * RevalidateCachedPlan: see if a plan kept by a CachedPlanSource is still
+ * valid, acquiring the locks needed to run it if so.
+ *
+ * This is the part of CheckCachedPlan that is shared with the ORCA plans
+ * kept for reuse; the caller is responsible for releasing an invalid plan.
+ */
+static bool
+RevalidateCachedPlan(CachedPlan *plan)
+{
 	/*
 	 * If plan isn't valid for current role, we can't use it.
 	 */
@@ -880,11 +944,6 @@ CheckCachedPlan(CachedPlanSource *plansource)
 		AcquireExecutorLocks(plan->stmt_list, false);
 	}
 
-	/*
-	 * Plan has been invalidated, so unlink it from the parent and release it.
-	 */
-	ReleaseGenericPlan(plansource);
-
 	return false;
 }
 
@@ -1056,6 +1115,8 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	plan->is_oneshot = plansource->is_oneshot;
 	plan->is_saved = false;
 	plan->is_valid = true;
+	plan->planning_time = 0;
+	plan->boundParams = NULL;
 
 	/* assign generation number to new plan */
 	plan->generation = ++(plansource->generation);
@@ -1205,6 +1266,167 @@ cached_plan_cost(CachedPlan *plan, bool include_planner)
 	return result;
 }
 
+/*
+ * orca_plan_reuse_allowed: can a custom plan for these parameters be kept
+ * for reuse, or be satisfied by one that was kept?
+ *
+ * ORCA folds the parameter values into the query as constants before
+ * optimizing it (see preprocess_query_optimizer()), and may use them for
+ * partition elimination and direct dispatch, so its custom plans are only
+ * valid for exactly the same values.  Parameters that are fetched on demand
+ * (e.g. PL/pgSQL variables) can't be compared cheaply, so we don't try.
+ */
+static bool
+orca_plan_reuse_allowed(CachedPlanSource *plansource,
+						ParamListInfo boundParams, IntoClause *intoClause)
+{
+	if (!optimizer || optimizer_plan_cache_size <= 0)
+		return false;
+
+	/* Only saved plans live long enough, and are invalidated properly */
+	if (!plansource->is_saved || plansource->is_oneshot)
+		return false;
+
+	/* CTAS plans depend on the target table, see GetCachedPlan() */
+	if (intoClause != NULL)
+		return false;
+
+	if (boundParams == NULL || boundParams->paramFetch != NULL)
+		return false;
+
+	return true;
+}
+
+/*
+ * GetOrcaPlan: look for a kept ORCA plan that was built for the same
+ * parameter values.
+ *
+ * On success, the plan is valid and we have acquired the locks needed to
+ * run it, as with CheckCachedPlan.  The caller is responsible for bumping
+ * the refcount.
+ */
+static CachedPlan *
+GetOrcaPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
+			IntoClause *intoClause)
+{
+	ListCell   *lc;
+
+	if (!orca_plan_reuse_allowed(plansource, boundParams, intoClause))
+		return NULL;
+
+	plansource->num_orca_lookups++;
+
+	foreach(lc, plansource->orca_plans)
+	{
+		CachedPlan *plan = (CachedPlan *) lfirst(lc);
+
+		Assert(plan->magic == CACHEDPLAN_MAGIC);
+
+		if (!param_lists_equal(plan->boundParams, boundParams))
+			continue;
+
+		/* There is at most one plan per set of parameter values */
+		plansource->orca_plans = list_delete_ptr(plansource->orca_plans, plan);
+
+		if (!RevalidateCachedPlan(plan))
+		{
+			ReleaseCachedPlan(plan, false);
+			return NULL;
+		}
+
+		/* Move it to the front of the list, so that LRU plans go first */
+		plansource->orca_plans = lcons(plan, plansource->orca_plans);
+
+		plansource->num_orca_hits++;
+		plansource->orca_saved_time += plan->planning_time;
+
+		return plan;
+	}
+
+	return NULL;
+}
+
+/*
+ * RememberOrcaPlan: keep a newly built custom plan for reuse, if it was
+ * produced by ORCA and can be reused at all.
+ */
+static void
+RememberOrcaPlan(CachedPlanSource *plansource, CachedPlan *plan,
+				 ParamListInfo boundParams, IntoClause *intoClause)
+{
+	MemoryContext oldcxt;
+
+	if (!orca_plan_reuse_allowed(plansource, boundParams, intoClause))
+		return;
+
+	/* Plans that are redone on every execution or xmin change won't do */
+	if (TransactionIdIsValid(plan->saved_xmin))
+		return;
+
+	if (!plan_list_is_orca(plan->stmt_list))
+		return;
+
+	/* Keep a copy of the parameters to compare against */
+	oldcxt = MemoryContextSwitchTo(plan->context);
+	plan->boundParams = copyParamList(boundParams);
+
+	/*
+	 * Link the plan into the plansource, and reparent it right away: the
+	 * link must not point into memory that goes away at end of statement.
+	 */
+	MemoryContextSwitchTo(plansource->context);
+	plansource->orca_plans = lcons(plan, plansource->orca_plans);
+	plan->refcount++;
+	MemoryContextSwitchTo(oldcxt);
+
+	MemoryContextSetParent(plan->context, CacheMemoryContext);
+	plan->is_saved = true;
+
+	/* Make room by releasing the least recently used plans */
+	while (list_length(plansource->orca_plans) > optimizer_plan_cache_size)
+	{
+		CachedPlan *victim = (CachedPlan *) llast(plansource->orca_plans);
+
+		plansource->orca_plans = list_delete_ptr(plansource->orca_plans,
+												 victim);
+		ReleaseCachedPlan(victim, false);
+	}
+}
+
+/*
+ * param_lists_equal: do two sets of bound parameters have the same values?
+ */
+static bool
+param_lists_equal(ParamListInfo a, ParamListInfo b)
+{
+	int			i;
+
+	if (a->numParams != b->numParams)
+		return false;
+
+	for (i = 0; i < a->numParams; i++)
+	{
+		ParamExternData *pa = &a->params[i];
+		ParamExternData *pb = &b->params[i];
+		int16		typlen;
+		bool		typbyval;
+
+		if (pa->ptype != pb->ptype ||
+			pa->pflags != pb->pflags ||
+			pa->isnull != pb->isnull)
+			return false;
+
+		if (pa->isnull || !OidIsValid(pa->ptype))
+			continue;
+
+		get_typlenbyval(pa->ptype, &typlen, &typbyval);
+		if (!datumIsEqual(pa->value, pb->value, typbyval, typlen))
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * GetCachedPlan: get a cached plan from a CachedPlanSource.
  *
@@ -1307,12 +1529,35 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 
 	if (customplan)
 	{
-		/* Build a custom plan */
-		plan = BuildCachedPlan(plansource, qlist, boundParams, intoClause);
-		/* Accumulate total costs of custom plans, but 'ware overflow */
+		bool		reused;
+
+		/*
+		 * GPDB: if ORCA already made a custom plan for these very parameter
+		 * values, reuse it.  Otherwise build a custom plan, and keep it for
+		 * reuse if that's allowed.
+		 */
+		plan = GetOrcaPlan(plansource, boundParams, intoClause);
+		reused = (plan != NULL);
+		if (!reused)
+		{
+			instr_time	starttime;
+			instr_time	duration;
+
+			INSTR_TIME_SET_CURRENT(starttime);
+			plan = BuildCachedPlan(plansource, qlist, boundParams, intoClause);
+			INSTR_TIME_SET_CURRENT(duration);
+			INSTR_TIME_SUBTRACT(duration, starttime);
+			plan->planning_time = INSTR_TIME_GET_MILLISEC(duration);
+
+			RememberOrcaPlan(plansource, plan, boundParams, intoClause);
+		}
+		/*
+		 * Accumulate total costs of custom plans, but 'ware overflow.  A
+		 * reused plan cost nothing to plan, so don't charge for planning.
+		 */
 		if (plansource->num_custom_plans < INT_MAX)
 		{
-			plansource->total_custom_cost += cached_plan_cost(plan, true);
+			plansource->total_custom_cost += cached_plan_cost(plan, !reused);
 			plansource->num_custom_plans++;
 		}
 	}
@@ -1500,6 +1745,12 @@ CopyCachedPlan(CachedPlanSource *plansource)
 	newsource->total_custom_cost = plansource->total_custom_cost;
 	newsource->num_custom_plans = plansource->num_custom_plans;
 
+	/* ... but not the ORCA plans, which belong to the source */
+	newsource->orca_plans = NIL;
+	newsource->num_orca_lookups = 0;
+	newsource->num_orca_hits = 0;
+	newsource->orca_saved_time = 0;
+
 	MemoryContextSwitchTo(oldcxt);
 
 	return newsource;
@@ -1836,6 +2087,86 @@ plan_list_is_oneoff(List *stmt_list)
 	return false;
 }
 
+/*
+ * plan_list_is_orca: were all the PlannedStmts in the list produced by ORCA?
+ */
+static bool
+plan_list_is_orca(List *stmt_list)
+{
+	ListCell   *lc;
+	bool		found = false;
+
+	foreach(lc, stmt_list)
+	{
+		PlannedStmt *plannedstmt = (PlannedStmt *) lfirst(lc);
+
+		if (!IsA(plannedstmt, PlannedStmt))
+			continue;			/* Ignore utility statements */
+
+		if (plannedstmt->planGen != PLANGEN_OPTIMIZER)
+			return false;
+		found = true;
+	}
+
+	return found;
+}
+
+/*
+ * plan_depends_on_rel: does the plan mention the given rel, or any rel at
+ * all if relid == InvalidOid?
+ */
+static bool
+plan_depends_on_rel(CachedPlan *plan, Oid relid)
+{
+	ListCell   *lc;
+
+	foreach(lc, plan->stmt_list)
+	{
+		PlannedStmt *plannedstmt = (PlannedStmt *) lfirst(lc);
+
+		Assert(!IsA(plannedstmt, Query));
+		if (!IsA(plannedstmt, PlannedStmt))
+			continue;			/* Ignore utility statements */
+		if ((relid == InvalidOid) ? plannedstmt->relationOids != NIL :
+			list_member_oid(plannedstmt->relationOids, relid))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * plan_depends_on_item: does the plan mention the object with the specified
+ * hash value, or any member of the cache if hashvalue == 0?
+ */
+static bool
+plan_depends_on_item(CachedPlan *plan, int cacheid, uint32 hashvalue)
+{
+	ListCell   *lc;
+
+	foreach(lc, plan->stmt_list)
+	{
+		PlannedStmt *plannedstmt = (PlannedStmt *) lfirst(lc);
+		ListCell   *lc3;
+
+		Assert(!IsA(plannedstmt, Query));
+		if (!IsA(plannedstmt, PlannedStmt))
+			continue;			/* Ignore utility statements */
+		foreach(lc3, plannedstmt->invalItems)
+		{
+			PlanInvalItem *item = (PlanInvalItem *) lfirst(lc3);
+
+			if (item->cacheId != cacheid)
+				continue;
+			if (hashvalue == 0 ||
+				item->hashValue == hashvalue)
+				return true;
+		}
+	}
+
+	return false;
+}
+
 /*
  * PlanCacheComputeResultDesc: given a list of analyzed-and-rewritten Queries,
  * determine the result tupledesc it will produce.  Returns NULL if the
@@ -1889,6 +2220,8 @@ PlanCacheRelCallback(Datum arg, Oid relid)
 
 	for (plansource = first_saved_plan; plansource; plansource = plansource->next_saved)
 	{
+		ListCell   *lc;
+
 		Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
 
 		/* No work if it's already invalidated */
@@ -1915,25 +2248,20 @@ PlanCacheRelCallback(Datum arg, Oid relid)
 		 * The generic plan, if any, could have more dependencies than the
 		 * querytree does, so we have to check it too.
 		 */
-		if (plansource->gplan && plansource->gplan->is_valid)
+		if (plansource->gplan && plansource->gplan->is_valid &&
+			plan_depends_on_rel(plansource->gplan, relid))
 		{
-			ListCell   *lc;
+			/* Invalidate the generic plan only */
+			plansource->gplan->is_valid = false;
+		}
 
-			foreach(lc, plansource->gplan->stmt_list)
-			{
-				PlannedStmt *plannedstmt = (PlannedStmt *) lfirst(lc);
+		/* Likewise for the ORCA plans kept for reuse */
+		foreach(lc, plansource->orca_plans)
+		{
+			CachedPlan *plan = (CachedPlan *) lfirst(lc);
 
-				Assert(!IsA(plannedstmt, Query));
-				if (!IsA(plannedstmt, PlannedStmt))
-					continue;	/* Ignore utility statements */
-				if ((relid == InvalidOid) ? plannedstmt->relationOids != NIL :
-					list_member_oid(plannedstmt->relationOids, relid))
-				{
-					/* Invalidate the generic plan only */
-					plansource->gplan->is_valid = false;
-					break;		/* out of stmt_list scan */
-				}
-			}
+			if (plan->is_valid && plan_depends_on_rel(plan, relid))
+				plan->is_valid = false;
 		}
 	}
 }
@@ -1991,33 +2319,21 @@ PlanCacheFuncCallback(Datum arg, int cacheid, uint32 hashvalue)
 		 * The generic plan, if any, could have more dependencies than the
 		 * querytree does, so we have to check it too.
 		 */
-		if (plansource->gplan && plansource->gplan->is_valid)
+		if (plansource->gplan && plansource->gplan->is_valid &&
+			plan_depends_on_item(plansource->gplan, cacheid, hashvalue))
 		{
-			foreach(lc, plansource->gplan->stmt_list)
-			{
-				PlannedStmt *plannedstmt = (PlannedStmt *) lfirst(lc);
-				ListCell   *lc3;
+			/* Invalidate the generic plan only */
+			plansource->gplan->is_valid = false;
+		}
 
-				Assert(!IsA(plannedstmt, Query));
-				if (!IsA(plannedstmt, PlannedStmt))
-					continue;	/* Ignore utility statements */
-				foreach(lc3, plannedstmt->invalItems)
-				{
-					PlanInvalItem *item = (PlanInvalItem *) lfirst(lc3);
-
-					if (item->cacheId != cacheid)
-						continue;
-					if (hashvalue == 0 ||
-						item->hashValue == hashvalue)
-					{
-						/* Invalidate the generic plan only */
-						plansource->gplan->is_valid = false;
-						break;	/* out of invalItems scan */
-					}
-				}
-				if (!plansource->gplan->is_valid)
-					break;		/* out of stmt_list scan */
-			}
+		/* Likewise for the ORCA plans kept for reuse */
+		foreach(lc, plansource->orca_plans)
+		{
+			CachedPlan *plan = (CachedPlan *) lfirst(lc);
+
+			if (plan->is_valid &&
+				plan_depends_on_item(plan, cacheid, hashvalue))
+				plan->is_valid = false;
 		}
 	}
 }
@@ -57,6 +57,10 @@
 #include <assert.h>
 #include <math.h>
 #include <string.h>
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define USE_SSE2_HLL
+#endif
 
 #include "postgres.h"
 #include "fmgr.h"
@@ -71,6 +75,13 @@
 
 #define GPHLLDATARAWSIZE(hloglog) (POW2(hloglog->b))
 
+/* one byte per register, rather than binbits */
+#define GPHLL_IS_UNPACKED(hloglog) \
+	((hloglog)->format == UNPACKED || (hloglog)->format == UNPACKED_UNPACKED)
+
+/* registers decoded at a time, when working on a packed counter */
+#define GPHLL_REGISTER_CHUNK 1024
+
 /* ------------- function declarations for local functions --------------- */
 static double gp_hll_estimate_dense(GpHLLCounter hloglog);
 static double gp_error_estimate(double E,int b);
@@ -83,13 +94,16 @@ static GpHLLCounter gp_hll_decompress_unpacked(GpHLLCounter hloglog);
 static GpHLLCounter gp_hll_decompress_dense(GpHLLCounter hloglog);
 static GpHLLCounter gp_hll_decompress_dense_unpacked(GpHLLCounter hloglog);
 
+static void gp_hll_unpack_registers(const uint8_t *packed, int binbits,
+									int first, int count, uint8_t *out);
+static void gp_hll_max_registers(uint8_t *dst, const uint8_t *src, int count);
+static void gp_hll_merge_into(GpHLLCounter result, GpHLLCounter counter);
+
 /* ---------------------- function definitions --------------------------- */
 
 GpHLLCounter
 gp_hll_unpack(GpHLLCounter hloglog){
 
-	char entry;
-	int i;
 	Size data_rawsize;
 	GpHLLCounter htemp;
 
@@ -104,29 +118,27 @@ gp_hll_unpack(GpHLLCounter hloglog){
 		return gp_hll_decompress_unpacked(hloglog);
 	}
 
-	/* set format to unpacked*/
-	if (hloglog->format == PACKED_UNPACKED)
-	{
-		hloglog->format = UNPACKED_UNPACKED;
-	}
-	else if (hloglog->format == PACKED)
-	{
-		hloglog->format = UNPACKED;
-	}
-
 	/*
-	 * Allocate and zero an array large enough to hold all the decompressed
-	 * bins
+	 * Allocate an array large enough to hold all the unpacked bins. The
+	 * original counter is left alone.
 	 */
 	data_rawsize = GPHLLDATARAWSIZE(hloglog);
 	htemp = palloc(sizeof(GpHLLData) + data_rawsize);
 	memcpy(htemp, hloglog, sizeof(GpHLLData));
 
-	for(i=0; i < data_rawsize; i++){
-		GP_HLL_DENSE_GET_REGISTER(entry,hloglog->data,i,hloglog->binbits);
-		htemp->data[i] = entry;
+	/* set format to unpacked*/
+	if (hloglog->format == PACKED_UNPACKED)
+	{
+		htemp->format = UNPACKED_UNPACKED;
+	}
+	else
+	{
+		htemp->format = UNPACKED;
 	}
 
+	gp_hll_unpack_registers((uint8_t *) hloglog->data, hloglog->binbits,
+							0, data_rawsize, (uint8_t *) htemp->data);
+
 	hloglog = htemp;
 
 	/* set the varsize to the appropriate length  */
@@ -157,18 +169,18 @@ gp_hll_decompress_dense_unpacked(GpHLLCounter hloglog)
 	Size data_rawsize;
 	GpHLLCounter htemp;
 
-	/* reset b to positive value for calcs and to indicate data is
-	* decompressed */
-	hloglog->b = -1 * (hloglog->b);
-	hloglog->format = UNPACKED;
-
 	/* allocate and zero an array large enough to hold all the decompressed
 	* bins */
-	data_rawsize = GPHLLDATARAWSIZE(hloglog);
+	data_rawsize = POW2(-1 * hloglog->b);
 	htemp = palloc(sizeof(GpHLLData) + data_rawsize);
 	memset(htemp, 0, sizeof(GpHLLData) + data_rawsize);
 	memcpy(htemp, hloglog, sizeof(GpHLLData));
 
+	/* reset b to positive value for calcs and to indicate data is
+	* decompressed */
+	htemp->b = -1 * (hloglog->b);
+	htemp->format = UNPACKED;
+
 	/* decompress the data */
 	pglz_decompress(hloglog->data, VARSIZE_ANY(hloglog) - sizeof(GpHLLData),
 					(char *) &htemp->data, data_rawsize);
@@ -270,7 +282,6 @@ GpHLLCounter
 gp_hll_merge(GpHLLCounter counter1, GpHLLCounter counter2)
 {
 
-	int i;
 	GpHLLCounter result = counter1;
 	int upper_bound = POW2(result->b);
 
@@ -282,13 +293,101 @@ gp_hll_merge(GpHLLCounter counter1, GpHLLCounter counter2)
 
 
 	/* Keep the maximum register value for each bin */
-	for (i = 0; i < upper_bound; i += 1){
-		result->data[i] = ((counter2->data[i] > result->data[i]) ? counter2->data[i] : result->data[i]);
-	}
+	gp_hll_max_registers((uint8_t *) result->data, (uint8_t *) counter2->data,
+						 upper_bound);
 
 	return result;
 }
 
+/* Merges an uncompressed counter, packed or not, into an unpacked one in
+ * place. A packed counter is decoded a chunk at a time, so no unpacked copy
+ * of it is made. */
+static void
+gp_hll_merge_into(GpHLLCounter result, GpHLLCounter counter)
+{
+	uint8_t chunk[GPHLL_REGISTER_CHUNK];
+	int m = POW2(result->b);
+	int i, n;
+
+	Assert(GPHLL_IS_UNPACKED(result) && result->b > 0 && counter->b > 0);
+
+	if (counter->b != result->b)
+		elog(ERROR, "index size of estimators differs (%d != %d)", result->b, counter->b);
+
+	if (GPHLL_IS_UNPACKED(counter))
+	{
+		gp_hll_max_registers((uint8_t *) result->data, (uint8_t *) counter->data, m);
+		return;
+	}
+
+	for (i = 0; i < m; i += n)
+	{
+		n = Min(m - i, GPHLL_REGISTER_CHUNK);
+		gp_hll_unpack_registers((uint8_t *) counter->data, counter->binbits,
+								i, n, chunk);
+		gp_hll_max_registers((uint8_t *) result->data + i, chunk, n);
+	}
+}
+
+/* Keeps the larger of each pair of registers in dst. Registers are small
+ * unsigned values, so 16 of them are compared at once where SSE2 is
+ * available. */
+static void
+gp_hll_max_registers(uint8_t *dst, const uint8_t *src, int count)
+{
+	int i = 0;
+
+#ifdef USE_SSE2_HLL
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i a = _mm_loadu_si128((const __m128i *) (dst + i));
+		__m128i b = _mm_loadu_si128((const __m128i *) (src + i));
+
+		_mm_storeu_si128((__m128i *) (dst + i), _mm_max_epu8(a, b));
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		if (src[i] > dst[i])
+			dst[i] = src[i];
+	}
+}
+
+/* Decodes 'count' registers of a packed counter, starting at register
+ * 'first', into one byte each. The default counter uses 6 bits per register,
+ * so every 3 bytes hold 4 registers, and those are decoded 4 at a time. */
+static void
+gp_hll_unpack_registers(const uint8_t *packed, int binbits,
+						int first, int count, uint8_t *out)
+{
+	int i = 0;
+
+	if (binbits == 6 && first % 4 == 0)
+	{
+		const uint8_t *p = packed + (first / 4) * 3;
+
+		for (; i + 4 <= count; i += 4, p += 3)
+		{
+			uint32_t w = p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16);
+
+			out[i] = w & 0x3F;
+			out[i + 1] = (w >> 6) & 0x3F;
+			out[i + 2] = (w >> 12) & 0x3F;
+			out[i + 3] = (w >> 18) & 0x3F;
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		uint8_t entry;
+		int regnum = first + i;
+
+		GP_HLL_DENSE_GET_REGISTER(entry, packed, regnum, binbits);
+		out[i] = entry;
+	}
+}
+
 
 /* Computes size of the structure, depending on the requested error rate and
  * ndistinct. */
@@ -347,21 +446,46 @@ gp_hll_estimate_dense(GpHLLCounter hloglog)
 	double H = 0, E = 0;
 	int j, V = 0;
 	int m = POW2(hloglog->b);
+	uint32_t counts[256];
 
-	/* compute the sum for the harmonic mean */
-	if (hloglog->binbits <= MAX_PRECOMPUTED_EXPONENTS_BINWIDTH){
-		for (j = 0; j < m; j++){
-			H += PE[(int)hloglog->data[j]];
+	/*
+	 * Count the registers holding each value. The sum for the harmonic mean
+	 * then takes one term per distinct value instead of one per register,
+	 * and the empty registers for linear counting are counts[0]. Packed
+	 * counters are read a chunk at a time, without unpacking them first.
+	 */
+	memset(counts, 0, sizeof(counts));
+	if (GPHLL_IS_UNPACKED(hloglog))
+	{
+		const uint8_t *data = (const uint8_t *) hloglog->data;
+
+		for (j = 0; j < m; j++)
+			counts[data[j]]++;
+	}
+	else
+	{
+		uint8_t chunk[GPHLL_REGISTER_CHUNK];
+		int i, n;
+
+		for (j = 0; j < m; j += n)
+		{
+			n = Min(m - j, GPHLL_REGISTER_CHUNK);
+			gp_hll_unpack_registers((uint8_t *) hloglog->data, hloglog->binbits,
+									j, n, chunk);
+			for (i = 0; i < n; i++)
+				counts[chunk[i]]++;
 		}
 	}
-	else {
-		for (j = 0; j < m; j++){
-			if (0 <= hloglog->data[j] && hloglog->data[j] < NUM_OF_PRECOMPUTED_EXPONENTS){
-				H += PE[(int)hloglog->data[j]];
-			}
-			else {
-				H += pow(0.5, hloglog->data[j]);
-			}
+
+	/* compute the sum for the harmonic mean */
+	for (j = 0; j < 256; j++){
+		if (counts[j] == 0)
+			continue;
+		if (j < NUM_OF_PRECOMPUTED_EXPONENTS){
+			H += counts[j] * PE[j];
+		}
+		else {
+			H += counts[j] * pow(0.5, j);
 		}
 	}
 
@@ -375,12 +499,8 @@ gp_hll_estimate_dense(GpHLLCounter hloglog)
 		/* account for hloglog low cardinality bias */
 		E = E - gp_error_estimate(E, hloglog->b);
 
-		/* search for empty registers for linear counting */
-		for (j = 0; j < m; j++){
-			if (hloglog->data[j] == 0){
-				V += 1;
-			}
-		}
+		/* empty registers for linear counting */
+		V = counts[0];
 
 		/* Don't use linear counting if there are no empty registers since we
 		* don't to divide by 0 */
@@ -557,8 +677,8 @@ static GpHLLCounter
 gp_hll_compress_dense(GpHLLCounter hloglog)
 {
     char *dest;
-    char entry,*data;    
-    int i, len;
+    char *data;
+    int len;
     Size data_rawsize;
 
     /* make sure the dest struct has enough space for an unsuccessful 
@@ -584,10 +704,8 @@ gp_hll_compress_dense(GpHLLCounter hloglog)
 
     /* put all registers in a normal array  i.e. remove dense packing so
      * lz compression can work optimally */
-    for(i=0; i < data_rawsize ; i++){
-        GP_HLL_DENSE_GET_REGISTER(entry,hloglog->data,i,hloglog->binbits);
-        data[i] = entry;
-    }
+    gp_hll_unpack_registers((uint8_t *) hloglog->data, hloglog->binbits,
+                            0, data_rawsize, (uint8_t *) data);
 
     /* lz_compress the normalized array and copy that data into hloglog->data
      * if any compression was achieved */
@@ -797,9 +915,14 @@ double
 gp_hyperloglog_estimate(GpHLLCounter hyperloglog)
 {
 	double estimate;
-	
-	/* unpack if needed */
-	GpHLLCounter hyperloglog_unpacked = gp_hll_unpack(hyperloglog);
+	GpHLLCounter hyperloglog_unpacked;
+
+	/* packed counters can be estimated as they are */
+	if (hyperloglog->b > 0)
+		return gp_hll_estimate(hyperloglog);
+
+	/* decompress */
+	hyperloglog_unpacked = gp_hll_unpack(hyperloglog);
 	
 	estimate = gp_hll_estimate(hyperloglog_unpacked);
 
@@ -831,15 +954,19 @@ gp_hyperloglog_merge_counters(GpHLLCounter counter1, GpHLLCounter counter2)
 	else
 	{
 		/* ok, we already have the estimator - merge the second one into it */
-		/* unpack if needed */
+		/* unpack a copy of the first one; neither counter is modified */
 		GpHLLCounter counter1_new = gp_hll_unpack(counter1);
-		GpHLLCounter counter2_new = gp_hll_unpack(counter2);
 
-		/* perform the merge */
-		counter1_new = gp_hll_merge(counter1_new, counter2_new);
+		/* perform the merge; only a compressed counter needs a copy */
+		if (counter2->b < 0)
+		{
+			GpHLLCounter counter2_new = gp_hll_unpack(counter2);
 
-		/*  counter2_new is not required any more */
-		pfree(counter2_new);
+			gp_hll_merge_into(counter1_new, counter2_new);
+			pfree(counter2_new);
+		}
+		else
+			gp_hll_merge_into(counter1_new, counter2);
 
 		/* return the updated GpHLLCounter */
 		return counter1_new;
@@ -1176,14 +1303,29 @@ gp_hyperloglog_merge(PG_FUNCTION_ARGS)
 		/* if second counter is null just return the the first estimator */
 		counter1_merged = PG_GETARG_HLL_P_COPY(0);
 
+	} else if (AggCheckCallContext(fcinfo, NULL)) {
+		/*
+		 * As the combine function of gp_hyperloglog_accum, the first counter
+		 * is the aggregate's own state. Once it has been unpacked by an
+		 * earlier merge, merge the second one into it in place.
+		 */
+		counter1 = PG_GETARG_HLL_P(0);
+		counter2 = PG_GETARG_HLL_P(1);
+
+		if (counter1->b > 0 && GPHLL_IS_UNPACKED(counter1) && counter2->b > 0)
+		{
+			gp_hll_merge_into(counter1, counter2);
+			counter1_merged = counter1;
+		}
+		else
+			counter1_merged = gp_hyperloglog_merge_counters(counter1, counter2);
+
 	} else {
 		/* ok, we already have the estimator - merge the second one into it */
-		counter1 = PG_GETARG_HLL_P_COPY(0);
-		counter2 = PG_GETARG_HLL_P_COPY(1);
+		counter1 = PG_GETARG_HLL_P(0);
+		counter2 = PG_GETARG_HLL_P(1);
 
 		counter1_merged = gp_hyperloglog_merge_counters(counter1, counter2);
-		pfree(counter1);
-		pfree(counter2);
 	}
 
 	/* return the updated bytea */
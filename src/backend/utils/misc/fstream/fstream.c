@@ -13,6 +13,7 @@
 #include <postgres.h>
 #include <commands/copy.h>
 #include <fstream/fstream.h>
+#include <port/pg_bytescan.h>
 #include <assert.h>
 #include <glob.h>
 #include <stdio.h>
@@ -25,7 +26,6 @@
 #endif
 
 #define FILE_ERROR_SZ 200
-char* format_error(char* c1, char* c2);
 
 typedef struct
 {
@@ -46,9 +46,12 @@ struct fstream_t
 	char* 			buffer;			 /* buffer to store data read from file */
 	int 			buffer_cur_size; /* number of bytes in buffer currently */
 	const char*		ferror; 		 /* error string */
+	char			ferror_buf[FILE_ERROR_SZ]; /* for error strings built at runtime */
 	struct fstream_options options;
 };
 
+static const char* format_error(fstream_t* fs, const char* c1, const char* c2);
+
 /*
  * Returns a pointer to the end of the last delimiter occurrence,
  * or the start pointer if delimiter doesn't appear.
@@ -181,6 +184,8 @@ fstream_get_error(fstream_t*fs)
  * server. That is because it may be inside a quote. We have to carefully parse
  * the data from the start in order to find the last unquoted newline.
  *
+ * Only quotes, escapes and newlines change the state, so the runs of other
+ * bytes between them are skipped with bytescan_find().
  */
 
 static char*
@@ -191,12 +196,23 @@ scan_csv_records_crlf(char *p, char* q, int one, fstream_t* fs)
 	int 	qc = fs->options.quote;
 	int 	xc = fs->options.escape;
 	char*	last_record_loc = 0;
-	int 	ch = 0;
-	int 	lastch = 0;
+	char*	start = p;
+	int 	ch;
+	ByteScanSet special;
+
+	bytescan_init(&special, false);
+	bytescan_add(&special, qc);
+	bytescan_add(&special, xc);
+	bytescan_add(&special, '\n');
 
 	while (p < q)
 	{
-		lastch = ch;
+		if (!last_was_esc)
+		{
+			p = (char*) bytescan_find(&special, p, q);
+			if (p == q)
+				break;
+		}
 		ch = *p++;
 
 		if (in_quote)
@@ -211,7 +227,7 @@ scan_csv_records_crlf(char *p, char* q, int one, fstream_t* fs)
 			else
 				last_was_esc = 0;
 		}
-		else if (ch == '\n' && lastch == '\r')
+		else if (ch == '\n' && p - 2 >= start && p[-2] == '\r')
 		{
 			last_record_loc = p;
 			fs->line_number++;
@@ -233,10 +249,24 @@ scan_csv_records_cr_or_lf(char *p, char *q, int one, fstream_t *fs, int nc)
 	int 	qc = fs->options.quote;
 	int 	xc = fs->options.escape;
 	char*	last_record_loc = 0;
+	ByteScanSet special;
+
+	bytescan_init(&special, false);
+	bytescan_add(&special, qc);
+	bytescan_add(&special, xc);
+	bytescan_add(&special, nc);
 
 	while (p < q)
 	{
-		int ch = *p++;
+		int ch;
+
+		if (!last_was_esc)
+		{
+			p = (char*) bytescan_find(&special, p, q);
+			if (p == q)
+				break;
+		}
+		ch = *p++;
 
 		if (in_quote)
 		{
@@ -441,10 +471,12 @@ static int glob_adjust(fstream_t* fs, char* filename, int* response_code, const
  * in our filestream that we return.
  *
  * In case of errors we set the proper http response code to send to the client.
+ * The response string may be built in response_buf.
  */
 fstream_t*
 fstream_open(const char *path, const struct fstream_options *options,
-			 int *response_code, const char **response_string)
+			 int *response_code, const char **response_string,
+			 char *response_buf, size_t response_bufsize)
 {
 	int i;
 	fstream_t* fs;
@@ -598,7 +630,7 @@ fstream_open(const char *path, const struct fstream_options *options,
 		gfile_close(&fs->fd);
 
 		if (gfile_open(&fs->fd, fs->glob.gl_pathv[i], gfile_open_flags(options->forwrite, options->usesync),
-					   response_code, response_string, transform))
+					   response_code, response_string, response_buf, response_bufsize, transform))
 		{
 			gfile_printf_then_putc_newline("fstream unable to open file %s",
 					fs->glob.gl_pathv[i]);
@@ -656,7 +688,7 @@ static int nextFile(fstream_t*fs)
 		fs->skip_header_line = fs->options.header;
 
 		if (gfile_open(&fs->fd, fs->glob.gl_pathv[fs->fidx], GFILE_OPEN_FOR_READ, 
-					   &response_code, &response_string, transform))
+					   &response_code, &response_string, fs->ferror_buf, FILE_ERROR_SZ, transform))
 		{
 			gfile_printf_then_putc_newline("fstream unable to open file %s",
 											fs->glob.gl_pathv[fs->fidx]);
@@ -672,13 +704,14 @@ static int nextFile(fstream_t*fs)
  * format_error
  * enables addition of string parameters to the const char* error message in fstream_t
  * while enabling the calling functions not to worry about freeing memory - which is 
- * the present behaviour
+ * the present behaviour. The message is kept in the fstream, as gpfdist may read
+ * several fstreams at once in worker threads.
  */
-char* format_error(char* c1, char* c2)
+static const char* format_error(fstream_t* fs, const char* c1, const char* c2)
 {
 	int len1, len2;
 	
-	static char err_msg[FILE_ERROR_SZ];
+	char* err_msg = fs->ferror_buf;
 	memset(err_msg, 0, FILE_ERROR_SZ);
 	
 	len1 = strlen(c1);
@@ -716,7 +749,7 @@ int fstream_read(fstream_t *fs,
 				 const int line_delim_length)
 {
 	int buffer_capacity = fs->options.bufsize;
-	static char err_buf[FILE_ERROR_SZ] = {0};
+	char* err_buf = fs->ferror_buf;
 	
 	if (fs->ferror)
 		return -1;
@@ -749,7 +782,7 @@ int fstream_read(fstream_t *fs,
 
 			if (bytesread < 0)
 			{
-				fs->ferror = format_error("cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+				fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
 				return -1;
 			}
 
@@ -835,7 +868,7 @@ int fstream_read(fstream_t *fs,
 
 			if (bytesread2 < 0)
 			{
-				fs->ferror = format_error("cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+				fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
 				return -1;
 			}
 
@@ -904,10 +937,10 @@ int fstream_read(fstream_t *fs,
 			if (!p || (char*)dest + size >= p + buffer_capacity)
 			{
 #ifdef WIN32
-				snprintf(err_buf, sizeof(err_buf)-1, "line too long in file %s near (%ld bytes)",
+				snprintf(err_buf, FILE_ERROR_SZ - 1, "line too long in file %s near (%ld bytes)",
 						 fs->glob.gl_pathv[fs->fidx], (long) fs->foff);
 #else
-				snprintf(err_buf, sizeof(err_buf)-1, "line too long in file %s near (%lld bytes)",
+				snprintf(err_buf, FILE_ERROR_SZ - 1, "line too long in file %s near (%lld bytes)",
 						 fs->glob.gl_pathv[fs->fidx], (long long) fs->foff);
 #endif
 				fs->ferror = err_buf;
@@ -953,7 +986,7 @@ int fstream_read(fstream_t *fs,
 
 		if (bytesread < 0)
 		{
-			fs->ferror = format_error("cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+			fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
 			
 			return -1;
 		}
@@ -971,6 +1004,189 @@ int fstream_read(fstream_t *fs,
 	}
 }
 
+/*
+ * fstream_read_range
+ *
+ * Like fstream_read() with 'read_whole_lines', but for a text format stream
+ * positioned in an uncompressed regular file, don't read the data. Instead,
+ * find the longest run of whole lines of at most 'size' bytes at the current
+ * position, move past it, and return its length, with a duplicate of the file
+ * descriptor in *fd, which the caller must close, and the file offset of the
+ * data in *offset. Only the end of the run is read to find the last line
+ * delimiter, so the caller can send the data with sendfile().
+ *
+ * Return 0 at the end of the stream, -1 on error, and FSTREAM_RANGE_UNAVAILABLE
+ * if the next data must be read with fstream_read().
+ */
+int fstream_read_range(fstream_t *fs,
+					   int size,
+					   struct fstream_filename_and_offset *fo,
+					   const char *line_delim_str,
+					   const int line_delim_length,
+					   int *fd,
+					   int64_t *offset)
+{
+#ifndef WIN32
+	char*		err_buf = fs->ferror_buf;
+	const char*	delim = line_delim_str;
+	int			delim_length = line_delim_length;
+
+	if (fs->ferror)
+		return -1;
+
+	/* text with \n as delimiter (by default) */
+	if (delim_length <= 0)
+	{
+		delim = "\n";
+		delim_length = 1;
+	}
+
+	for (;;)
+	{
+		int		filefd;
+		off_t	filesize;
+		int64_t	remaining;
+		int64_t	len;
+
+		if (!size || fs->fidx == fs->glob.gl_pathc)
+			return 0;
+
+		/*
+		 * CSV rows may have quoted line delimiters, which we can only find by
+		 * scanning all the data.
+		 */
+		if (fs->options.is_csv)
+			return FSTREAM_RANGE_UNAVAILABLE;
+
+		filefd = gfile_get_file_fd(&fs->fd, &filesize);
+		if (filefd < 0)
+			return FSTREAM_RANGE_UNAVAILABLE;
+
+		/*
+		 * Whatever an earlier fstream_read() left in our buffer is a copy of
+		 * the file from fs->foff on. Drop it, and send it from the file, so
+		 * that one fallback to fstream_read() doesn't disable sendfile() for
+		 * the rest of the file.
+		 */
+		fs->buffer_cur_size = 0;
+
+		if (fs->skip_header_line)
+		{
+			ssize_t	bytesread;
+			char*	p;
+
+			do
+				bytesread = pread(filefd, fs->buffer, fs->options.bufsize, fs->foff);
+			while (bytesread < 0 && errno == EINTR);
+
+			if (bytesread < 0)
+			{
+				fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+				return -1;
+			}
+
+			p = find_first_eol_delim(fs->buffer, fs->buffer + bytesread,
+									 delim, delim_length);
+			if (p < fs->buffer + bytesread)
+				p++;
+			else if (bytesread == fs->options.bufsize)
+			{
+				gfile_printf_then_putc_newline(
+						"fstream ERROR: header too long in file %s",
+						fs->glob.gl_pathv[fs->fidx]);
+
+				fs->ferror = "line too long in file";
+				return -1;
+			}
+
+			fs->foff += p - fs->buffer;
+			fs->line_number++;
+			fs->skip_header_line = 0;
+		}
+
+		remaining = filesize - fs->foff;
+		if (remaining <= 0)
+		{
+			if (nextFile(fs))
+				return -1;
+			continue;
+		}
+
+		if (remaining <= size)
+		{
+			/* the rest of the file, as fstream_read() does on a short read */
+			len = remaining;
+		}
+		else
+		{
+			/*
+			 * Search the range backwards for the last delimiter, a window at a
+			 * time. Windows overlap so that a delimiter isn't split.
+			 */
+			int64_t	end = fs->foff + size;
+			int		window = Min(fs->options.bufsize, 64 * 1024);
+
+			len = 0;
+			while (end - fs->foff >= delim_length)
+			{
+				int64_t	start = Max(fs->foff, end - window);
+				ssize_t	bytesread;
+				char*	p;
+
+				do
+					bytesread = pread(filefd, fs->buffer, end - start, start);
+				while (bytesread < 0 && errno == EINTR);
+
+				if (bytesread < 0)
+				{
+					fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+					return -1;
+				}
+
+				p = find_last_eol_delim(fs->buffer, bytesread, delim, delim_length);
+				if (fs->buffer <= p)
+				{
+					len = start + (p + 1 - fs->buffer) - fs->foff;
+					break;
+				}
+
+				if (start == fs->foff || bytesread < end - start)
+					break;
+				end = start + delim_length - 1;
+			}
+
+			if (len == 0)
+			{
+				snprintf(err_buf, FILE_ERROR_SZ - 1, "line too long in file %s near (%lld bytes)",
+						 fs->glob.gl_pathv[fs->fidx], (long long) fs->foff);
+				fs->ferror = err_buf;
+				gfile_printf_then_putc_newline("%s", err_buf);
+				return -1;
+			}
+		}
+
+		/* the caller sends the data after we may have moved to the next file */
+		*fd = dup(filefd);
+		if (*fd < 0 || gfile_seek(&fs->fd, fs->foff + len))
+		{
+			if (*fd >= 0)
+				close(*fd);
+			fs->ferror = format_error(fs, "cannot read file - ", fs->glob.gl_pathv[fs->fidx]);
+			return -1;
+		}
+
+		updateCurFileState(fs, fo);
+		*offset = fs->foff;
+		fs->foff += len;
+		fs->line_number = 0;
+
+		return len;
+	}
+#else
+	return FSTREAM_RANGE_UNAVAILABLE;
+#endif
+}
+
 int fstream_write(fstream_t *fs,
 				  void *buf,
 				  int size,
@@ -681,7 +681,8 @@ gfile_open_flags(int writing, int usesync)
 }
 
 
-int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, const char** response_string, struct gpfxdist_t* transform)
+int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, const char** response_string,
+			   char* response_buf, size_t response_bufsize, struct gpfxdist_t* transform)
 {
 	const char* s = strrchr(fpath, '.');
 	bool_t is_win_pipe = FALSE;
@@ -879,15 +880,14 @@ int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, co
 
 	if (!fd->is_win_pipe && -1 == fd->fd.filefd) 
 	{
-		static char buf[256];
 		gfile_printf_then_putc_newline("gfile open (for %s) failed %s: %s",
 									   ((flags == GFILE_OPEN_FOR_READ) ? "read" : 
 										((flags == GFILE_OPEN_FOR_WRITE_SYNC) ? "write (sync)" : "write")),
 					  				  fpath, strerror(errno));
 		*response_code = 404;
-		snprintf(buf, sizeof buf, "file open failure %s: %s", fpath, 
+		snprintf(response_buf, response_bufsize, "file open failure %s: %s", fpath,
 				strerror(errno));
-		*response_string = buf;
+		*response_string = response_buf;
 		return 1;
 	}
 
@@ -1106,3 +1106,44 @@ off_t gfile_get_compressed_position(gfile_t *fd)
 {
 	return fd->compressed_position;
 }
+
+/*
+ * gfile_get_file_fd
+ *
+ * Return the descriptor of an uncompressed regular file opened for read, so
+ * the caller can send its bytes to a socket without reading them, and set
+ * *size to the current size of the file. Return -1 for anything else.
+ */
+int gfile_get_file_fd(gfile_t *fd, off_t *size)
+{
+#ifndef WIN32
+	struct stat sta;
+
+	if (fd->is_write || fd->is_win_pipe || fd->transform ||
+		fd->compression != NO_COMPRESSION || fd->fd.filefd < 0)
+		return -1;
+
+	if (fstat(fd->fd.filefd, &sta) != 0 || !S_ISREG(sta.st_mode))
+		return -1;
+
+	*size = sta.st_size;
+	return fd->fd.filefd;
+#else
+	return -1;
+#endif
+}
+
+/*
+ * gfile_seek
+ *
+ * Move the read position of a file returned by gfile_get_file_fd(), after
+ * the caller consumed the bytes up to 'offset' by itself.
+ */
+int gfile_seek(gfile_t *fd, off_t offset)
+{
+	if (lseek(fd->fd.filefd, offset, SEEK_SET) < 0)
+		return -1;
+
+	fd->compressed_position = offset;
+	return 0;
+}
@@ -19,6 +19,7 @@
 #include <sys/stat.h>
 #include <sys/unistd.h>
 
+#include "access/distributedlog.h"
 #include "access/reloptions.h"
 #include "access/transam.h"
 #include "access/url.h"
@@ -135,9 +136,11 @@ bool		Test_print_direct_dispatch_info = false;
 bool		Test_copy_qd_qe_split = false;
 bool		gp_permit_relation_node_change = false;
 int			gp_max_local_distributed_cache = 1024;
+int			gp_distributedlog_buffers = 64;
 bool		gp_appendonly_verify_block_checksums = true;
 bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_compaction = true;
+bool		gp_analyze_cache_ao_samples = true;
 int			gp_appendonly_compaction_threshold = 0;
 bool		gp_heap_require_relhasoids_match = true;
 bool		gp_local_distributed_cache_stats = false;
@@ -154,6 +157,7 @@ bool		gp_create_table_random_default_distribution = true;
 bool		gp_allow_non_uniform_partitioning_ddl = true;
 bool		gp_enable_exchange_default_partition = false;
 int			dtx_phase2_retry_count = 0;
+bool		gp_dtx_skip_readonly_segments = false;
 
 bool		log_dispatch_stats = false;
 
@@ -295,6 +299,8 @@ int			optimizer_minidump;
 int			optimizer_cost_model;
 bool		optimizer_metadata_caching;
 int			optimizer_mdcache_size;
+int			optimizer_mdcache_shared_size;
+int			optimizer_plan_cache_size;
 bool		optimizer_use_gpdb_allocators;
 
 /* Optimizer debugging GUCs */
@@ -1904,6 +1910,18 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_dtx_skip_readonly_segments", PGC_USERSET, DEVELOPER_OPTIONS,
+			gettext_noop("Commit segments that did not write without preparing them."),
+			gettext_noop("Such segments commit during the prepare round and are left out of "
+						 "the second phase of two-phase commit."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_dtx_skip_readonly_segments,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_recursive_cte_prototype", PGC_USERSET, DEPRECATED_OPTIONS,
 			gettext_noop("Enable RECURSIVE clauses in CTE queries (deprecated option, use \"gp_recursive_cte\" instead)."),
@@ -2583,6 +2601,17 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_analyze_cache_ao_samples", PGC_USERSET, STATS_ANALYZE,
+			gettext_noop("Keep the ANALYZE sample of each append-only segment file, and reuse it while the file is unchanged."),
+			NULL,
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_analyze_cache_ao_samples,
+		true,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"optimizer_analyze_root_partition", PGC_USERSET, STATS_ANALYZE,
 			gettext_noop("Enable statistics collection on root partitions during ANALYZE"),
@@ -2898,6 +2927,15 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true, check_verify_gpfdists_cert, NULL
 	},
 
+	{
+		{"gpfdist_compression", PGC_USERSET, EXTERNAL_TABLES,
+			gettext_noop("Compresses the data transferred between segments and gpfdist with zstd."),
+			gettext_noop("Takes effect only if gpfdist supports it.")
+		},
+		&gpfdist_compression,
+		false, NULL, NULL
+	},
+
 	{
 		{"gp_external_enable_filter_pushdown", PGC_USERSET, EXTERNAL_TABLES,
 			gettext_noop("Enable passing of query constraints to external table providers"),
@@ -3006,6 +3044,16 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_distributedlog_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of distributed log buffers on a segment."),
+			gettext_noop("The buffers are split into banks of 8, each with its own lock.")
+		},
+		&gp_distributedlog_buffers,
+		64, DISTRIBUTEDLOG_BANK_BUFFERS, DISTRIBUTEDLOG_BANK_BUFFERS * MAX_DISTRIBUTEDLOG_BANKS,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"debug_dtm_action_segment", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Sets the debug DTM action segment."),
@@ -4052,6 +4100,29 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimizer_mdcache_shared_size", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the size of the MDCache store shared by all sessions on the coordinator."),
+			gettext_noop("0 disables the shared store. Objects translated while the catalogs "
+						 "of their database change, even for unrelated tables, are not stored."),
+			GUC_UNIT_KB
+		},
+		&optimizer_mdcache_shared_size,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"optimizer_plan_cache_size", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Sets the number of GPORCA custom plans kept for reuse per prepared statement."),
+			gettext_noop("A kept plan is reused when the statement is executed again with "
+						 "the same parameter values. 0 disables reuse.")
+		},
+		&optimizer_plan_cache_size,
+		0, 0, 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"memory_profiler_dataset_size", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Set the size in GB"),
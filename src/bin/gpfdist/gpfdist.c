@@ -27,6 +27,7 @@
 #include <gpfxdist.h>
 #endif
 #include <fstream/fstream.h>
+#include <fstream/gpfdist_zstd.h>
 
 #ifndef WIN32
 #include <unistd.h>
@@ -36,6 +37,10 @@
 #include <netdb.h>
 #include <arpa/inet.h>
 #include <pthread.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#define GPFDIST_ZERO_COPY
+#endif
 #define SOCKET int
 #ifndef closesocket
 #define closesocket(x)   close(x)
@@ -58,6 +63,9 @@
 #include <pg_config.h>
 #include <pg_config_manual.h>
 #include "gpfdist_helper.h"
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 #ifdef USE_SSL
 #include <openssl/ssl.h>
 #include <openssl/rand.h>
@@ -81,6 +89,10 @@ struct block_t
 	blockhdr_t 	hdr;
 	int 		bot, top;
 	char*      	data;
+	int			fd;		/* if >= 0, the data is at foff in this file instead */
+	apr_int64_t	foff;
+	char*		zdata;		/* spare buffer of -m bytes to compress data into */
+	int			compressed;	/* data is a zstd frame */
 };
 
 /*  Get session id for this request */
@@ -126,6 +138,14 @@ static void flush_ssl_buffer(int fd, short event, void* arg);
  not property terminated, then gpfdist encountered some error, and caller
  should check the gpfdist error log.
 
+ X-GP-ZSTD = 1
+ the client can take zstd compressed data. If gpfdist is built with zstd,
+ it answers with the same header, and then
+ - with X-GP-PROTO = 1, it may send a data block as a 'Z' block instead,
+   which holds a zstd frame with the content size of the data.
+ - POST requests with a "Content-Encoding: zstd" header have a body
+   compressed as a zstd stream.
+
  **************/
 
 typedef struct gnet_request_t gnet_request_t;
@@ -175,7 +195,21 @@ static struct
 	struct transform* trlist; /* transforms from config file */
 	const char* ssl; /* path to certificates in case we use gpfdist with ssl */
 	int			w; /* The time used for session timeout in seconds */
-} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0 };
+	int			multi_thread; /* number of worker threads reading data, 0 to read on the event loop */
+	int			zero_copy; /* send uncompressed text files with sendfile */
+} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0, 0, 0 };
+
+/* upper limit of --multi_thread */
+#define GPFDIST_MAX_WORKER_THREADS 256
+
+/*
+ * A worker thread reads up to PREFETCH_BYTES ahead for each session, but at
+ * least 2 and at most PREFETCH_MAX_BLOCKS blocks of -m bytes.
+ */
+#define PREFETCH_BYTES (4 * 1024 * 1024)
+#define PREFETCH_MAX_BLOCKS 64
+
+typedef struct prefetch_t prefetch_t;
 
 
 typedef union address
@@ -207,8 +241,32 @@ static struct
 #ifdef USE_SSL
 	BIO 			*bio_err;	/* for SSL */
 	SSL_CTX 		*server_ctx;/* for SSL */
+#endif
+#ifdef HAVE_LIBZSTD
+	struct
+	{
+		ZSTD_CCtx*	cctx;		/* for blocks sent by the event loop */
+		ZSTD_DCtx*	dctx;		/* for POST bodies */
+	} zstd;
 #endif
 	int 			wdtimer; /* Kill gpfdist after k seconds of inactivity. 0 to disable. */
+#ifndef WIN32
+	/*
+	 * Worker threads of --multi_thread. They take sessions off the work queue
+	 * and read blocks for them, so the event loop only does network I/O.
+	 */
+	struct
+	{
+		pthread_mutex_t	mutex;		/* protects this and all prefetch_t */
+		pthread_cond_t	work_cond;	/* signaled when a session is queued */
+		pthread_cond_t	idle_cond;	/* signaled when a worker leaves a stopping session */
+		prefetch_t*		work_head;	/* sessions that need blocks, FIFO */
+		prefetch_t*		work_tail;
+		prefetch_t*		ready;		/* sessions with parked requests that got blocks */
+		int				notify_fd[2];	/* pipe to wake up the event loop */
+		struct event	notify_event;
+	} workers;
+#endif
 } gcb;
 
 /*  A session */
@@ -234,6 +292,7 @@ struct session_t
 	struct timeval 	tm;             /* timeout for struct event */
 	struct event   	ev;             /* event we are watching for this session*/
 	apr_hash_t		*requests;
+	prefetch_t*		prefetch;		/* blocks read by worker threads, NULL if read on the event loop */
 };
 
 /*  An http request */
@@ -272,6 +331,7 @@ struct request_t
 	int				is_get;     /* true for GET, false for POST */
 	int				is_final;	/* the final POST request. a signal from client to end session */
 	int				segid;		/* the segment id of the segdb with the request */
+	int				zstd;		/* client takes zstd compressed data, and we agreed */
 	int				totalsegs;	/* the total number of segdbs */
 
 	struct
@@ -289,6 +349,7 @@ struct request_t
 	block_t	outblock;	/* next block to send out */
 	char*           line_delim_str;
 	int             line_delim_length;
+	request_t*		next_waiter;	/* next request waiting for a block of the same session */
 
 #ifdef USE_SSL
 	/* SSL related */
@@ -301,6 +362,43 @@ struct request_t
 
 
 
+/* A block read ahead by a worker thread */
+typedef struct prefetch_block_t prefetch_block_t;
+struct prefetch_block_t
+{
+	char*		data;		/* -m bytes */
+	int			size;		/* bytes of whole rows in data */
+	struct fstream_filename_and_offset fos;
+};
+
+/*
+ * Read-ahead state of a GET session served with --multi_thread. All fields
+ * but 'waiters' are protected by gcb.workers.mutex. A worker fills the block
+ * after the last ready one while the event loop hands out blocks from 'head',
+ * so the blocks themselves are accessed without the lock.
+ */
+struct prefetch_t
+{
+	session_t*			session;
+	prefetch_block_t*	blocks;		/* ring of 'depth' blocks */
+	int					depth;
+	int					head;		/* next block to hand out */
+	int					count;		/* blocks ready to hand out */
+	apr_int64_t			read_bytes;	/* compressed bytes read, not yet in gcb.read_bytes */
+	int					eof;		/* all data has been read */
+	const char*			ferror;		/* reading failed */
+	int					queued;		/* on the work queue */
+	int					reading;	/* a worker is reading a block */
+	int					stopping;	/* the session is ending, don't read more */
+	int					has_waiters;	/* requests wait for a block */
+	int					on_ready;	/* on gcb.workers.ready */
+	prefetch_t*			next_work;
+	prefetch_t*			next_ready;
+	const char*			line_delim_str;
+	int					line_delim_length;
+	request_t*			waiters;	/* parked requests, only used by the event loop */
+};
+
 #if APR_IS_BIGENDIAN
 #define local_htonll(n)  (n)
 #define local_ntohll(n)  (n)
@@ -370,6 +468,11 @@ static void setup_flush_ssl_buffer(request_t* r);
 static void request_cleanup_and_free_SSL_resources(request_t* r);
 #endif
 static int local_send(request_t *r, const char* buf, int buflen);
+static int local_sendfile(request_t *r, block_t* b, int buflen);
+static void block_close_file(block_t* b);
+static void block_compress(const request_t* r, block_t* b);
+static int request_write_rows(request_t* r);
+static int request_decompress(request_t* r, const char* data, int len);
 
 static int get_unsent_bytes(request_t* r);
 
@@ -383,6 +486,11 @@ int gpfdist_init(int argc, const char* const argv[]);
 int gpfdist_run(void);
 
 static void delay_watchdog_timer(void);
+static void workers_setup(void);
+static void prefetch_create(session_t* session, request_t* r);
+static void prefetch_stop(session_t* session);
+static int prefetch_park(request_t* r);
+static const char* prefetch_get_block(const request_t* r, block_t* retblock);
 #ifndef WIN32
 static apr_time_t shutdown_time;
 static void* watchdog_thread(void*);
@@ -443,8 +551,8 @@ static void block_fill_header(const request_t *r, block_t* b,
 	gdebug(r, "L %lu", (unsigned long)local_ntohll(len8));
 #endif
 
-	/* DATA: 'D' + len */
-	*p++ = 'D';
+	/* DATA: 'D' + len, or 'Z' + len for compressed data */
+	*p++ = b->compressed ? 'Z' : 'D';
 	len = htonl(b->top-b->bot);
 	memcpy(p, &len, 4);
 	p += 4;
@@ -504,6 +612,12 @@ static void usage_error(const char* msg, int print_usage)
 			fprintf(stderr,
 					"gpfdist -- file distribution web server\n\n"
 						"usage: gpfdist [--ssl <certificates_directory>] [-d <directory>] [-p <http(s)_port>] [-l <log_file>] [-t <timeout>] [-v | -V | -s] [-m <maxlen>] [-w <timeout>]"
+#ifndef WIN32
+						" [--multi_thread <num_threads>]"
+#endif
+#ifdef GPFDIST_ZERO_COPY
+						" [--zero_copy]"
+#endif
 #ifdef GPFXDIST
 					    "[-c file]"
 #endif
@@ -527,6 +641,12 @@ static void usage_error(const char* msg, int print_usage)
 #endif
 #ifdef GPFXDIST
 					    "        -c file    : configuration file for transformations\n"
+#endif
+#ifndef WIN32
+						"        --multi_thread num_threads : read and parse the data in this many threads\n"
+#endif
+#ifdef GPFDIST_ZERO_COPY
+						"        --zero_copy : send uncompressed text files without copying them through gpfdist\n"
 #endif
 						"        --version  : print version information\n"
 						"        -w timeout : timeout in seconds before close target file\n\n");
@@ -592,6 +712,8 @@ static void parse_command_line(int argc, const char* const argv[],
 #endif
 	{ "version", 256, 0, "print version number" },
 	{ NULL, 'w', 1, "wait for session timeout in seconds" },
+	{ "multi_thread", 258, 1, "number of threads that read and parse data" },
+	{ "zero_copy", 259, 0, "send uncompressed text files with sendfile" },
 	{ 0 } };
 
 	status = apr_getopt_init(&os, pool, argc, argv);
@@ -676,6 +798,24 @@ static void parse_command_line(int argc, const char* const argv[],
 		case 'w':
 			opt.w = atoi(arg);
 			break;
+#ifndef WIN32
+		case 258:
+			opt.multi_thread = atoi(arg);
+			break;
+#else
+		case 258:
+			usage_error("--multi_thread is not supported on this platform", 0);
+			break;
+#endif
+#ifdef GPFDIST_ZERO_COPY
+		case 259:
+			opt.zero_copy = 1;
+			break;
+#else
+		case 259:
+			usage_error("--zero_copy is not supported on this platform", 0);
+			break;
+#endif
 		}
 	}
 
@@ -704,6 +844,16 @@ static void parse_command_line(int argc, const char* const argv[],
     if (!is_valid_listen_queue_size(opt.z))
 		usage_error("Error: -z listen queue size must be between 16 and 512 (default is 256)", 0);
 
+	if (opt.multi_thread < 0 || opt.multi_thread > GPFDIST_MAX_WORKER_THREADS)
+		usage_error(apr_psprintf(pool, "Error: --multi_thread must be between 0 and %d",
+								 GPFDIST_MAX_WORKER_THREADS), 0);
+
+	if (opt.zero_copy && opt.multi_thread)
+		usage_error("Error: --zero_copy and --multi_thread cannot be used together", 0);
+
+	if (opt.zero_copy && opt.ssl)
+		usage_error("Error: --zero_copy cannot be used with --ssl", 0);
+
     /* get current directory, for ssl directory validation */
     if (0 != apr_filepath_get(&current_directory, APR_FILEPATH_NATIVE, pool))
 		usage_error(apr_psprintf(pool, "Error: cannot access directory '.'\n"
@@ -883,12 +1033,13 @@ static apr_status_t http_ok(request_t* r)
 		"Expires: 0\r\n"
 		"X-GPFDIST-VERSION: " GP_VERSION "\r\n"
 		"X-GP-PROTO: %d\r\n"
+		"%s"
 		"Cache-Control: no-cache\r\n"
 		"Connection: close\r\n\r\n";
 	char buf[1024];
 	int m, n;
 
-	n = apr_snprintf(buf, sizeof(buf), fmt, r->gp_proto);
+	n = apr_snprintf(buf, sizeof(buf), fmt, r->gp_proto, r->zstd ? "X-GP-ZSTD: 1\r\n" : "");
 	if (n >= sizeof(buf) - 1)
 		gfatal(r, "internal error - buffer overflow during http_ok");
 
@@ -1150,6 +1301,8 @@ static void request_end(request_t* r, int error, const char* errmsg)
 		session_detach(r);
 	}
 
+	block_close_file(&r->outblock);
+
 	/* If we still have data in the buffer - flush it */
 #ifdef USE_SSL
 	if (opt.ssl)
@@ -1189,6 +1342,95 @@ static int local_send(request_t *r, const char* buf, int buflen)
 	return n;
 }
 
+/*
+ * local_sendfile
+ *
+ * Like local_send(), for a block whose data is in a file: the kernel copies
+ * the data from the page cache to the socket.
+ */
+static int local_sendfile(request_t *r, block_t* b, int buflen)
+{
+#ifdef GPFDIST_ZERO_COPY
+	off_t	offset = b->foff + b->bot;
+	ssize_t	n;
+
+	do
+		n = sendfile(r->sock, b->fd, &offset, buflen);
+	while (n < 0 && errno == EINTR);
+
+	if (n < 0)
+	{
+		int e = errno;
+
+		if (e == EPIPE || e == ECONNRESET)
+		{
+			gwarning(r, "sendfile failed - the connection was terminated by the client (%d: %s)", e, strerror(e));
+			/* close stream and release fd & flock on pipe file*/
+			if (r->session)
+				session_end(r->session, 0);
+		}
+		else if (e != EAGAIN)
+			gwarning(r, "sendfile failed - due to (%d: %s)", e, strerror(e));
+		return e == EAGAIN ? 0 : -1;
+	}
+
+	if (n == 0 && buflen > 0)
+	{
+		gwarning(r, "sendfile failed - the file was truncated");
+		return -1;
+	}
+
+	return n;
+#else
+	return -1;
+#endif
+}
+
+/* close the file of a block sent with local_sendfile() */
+static void block_close_file(block_t* b)
+{
+	if (b->fd >= 0)
+	{
+		close(b->fd);
+		b->fd = -1;
+	}
+}
+
+/*
+ * block_compress
+ *
+ * Compress the data of a block for a client that takes zstd, if that makes
+ * it smaller. Blocks sent with sendfile are left alone.
+ */
+static void block_compress(const request_t* r, block_t* b)
+{
+	b->compressed = 0;
+
+#ifdef HAVE_LIBZSTD
+	if (r->zstd && b->zdata && b->fd < 0 && b->top - b->bot > 1)
+	{
+		size_t	ret;
+		char*	tmp;
+
+		if (!gcb.zstd.cctx && !(gcb.zstd.cctx = ZSTD_createCCtx()))
+			gfatal(NULL, "out of memory when creating zstd context");
+
+		/* fails if it doesn't get smaller */
+		ret = ZSTD_compressCCtx(gcb.zstd.cctx, b->zdata, b->top - b->bot - 1,
+								b->data + b->bot, b->top - b->bot, GPFDIST_ZSTD_COMPRESSION_LEVEL);
+		if (ZSTD_isError(ret))
+			return;
+
+		tmp = b->data;
+		b->data = b->zdata;
+		b->zdata = tmp;
+		b->bot = 0;
+		b->top = ret;
+		b->compressed = 1;
+	}
+#endif
+}
+
 static int local_sendall(request_t* r, const char* buf, int buflen)
 {
 	int oldlen = buflen;
@@ -1302,6 +1544,7 @@ session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, i
 
 	session_t *session = r->session;
 
+	block_close_file(retblock);
 	retblock->bot = retblock->top = 0;
 
 	if (session->is_error || 0 == session->fstream)
@@ -1311,11 +1554,19 @@ session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, i
 		return 0;
 	}
 
+	if (session->prefetch)
+		return prefetch_get_block(r, retblock);
+
 	gcb.read_bytes -= fstream_get_compressed_position(session->fstream);
 
 	/* read data from our filestream as a chunk with whole data rows */
 
-	size = fstream_read(session->fstream, retblock->data, opt.m, &fos, whole_rows, line_delim_str, line_delim_length);
+	size = FSTREAM_RANGE_UNAVAILABLE;
+	if (opt.zero_copy)
+		size = fstream_read_range(session->fstream, opt.m, &fos, line_delim_str, line_delim_length,
+								  &retblock->fd, &retblock->foff);
+	if (size == FSTREAM_RANGE_UNAVAILABLE)
+		size = fstream_read(session->fstream, retblock->data, opt.m, &fos, whole_rows, line_delim_str, line_delim_length);
 	delay_watchdog_timer();
 
 	if (size == 0)
@@ -1330,7 +1581,8 @@ session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, i
 
 	if (size < 0)
 	{
-		const char* ferror = fstream_get_error(session->fstream);
+		/* the message lives in the fstream, which session_end() frees */
+		const char* ferror = apr_pstrdup(r->pool, fstream_get_error(session->fstream));
 		gwarning(NULL, "session_get_block end session due to %s", ferror);
 		session_end(session, 1);
 		return ferror;
@@ -1338,6 +1590,8 @@ session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, i
 
 	retblock->top = size;
 
+	block_compress(r, retblock);
+
 	/* fill the block header with meta data for the client to parse and use */
 	block_fill_header(r, retblock, &fos);
 
@@ -1352,6 +1606,8 @@ static void session_end(session_t* session, int error)
 	if (error)
 		session->is_error = error;
 
+	prefetch_stop(session);
+
 	if (session->fstream)
 	{
 		fstream_close(session->fstream);
@@ -1364,6 +1620,8 @@ static void session_free(session_t* session)
 {
 	gprintln(NULL, "free session %s", session->key);
 
+	prefetch_stop(session);
+
 	if (session->fstream)
 	{
 		fstream_close(session->fstream);
@@ -1516,6 +1774,7 @@ static int session_attach(request_t* r)
 		apr_pool_t* pool;
 		int 		response_code;
 		const char*	response_string;
+		char		response_buf[256];
 		struct fstream_options fstream_options;
 
 		/* remove any outdated sessions*/
@@ -1586,7 +1845,8 @@ static int session_attach(request_t* r)
 
 		/* try opening the fstream */
 		gprintlnif(r, "new session trying to open the data stream");
-		fstream = fstream_open(r->path, &fstream_options, &response_code, &response_string);
+		fstream = fstream_open(r->path, &fstream_options, &response_code, &response_string,
+							   response_buf, sizeof(response_buf));
 		delay_watchdog_timer();
 
 		if (!fstream)
@@ -1628,6 +1888,13 @@ static int session_attach(request_t* r)
 		if (session->tid == 0 || session->path == 0 || session->key == 0)
 			gfatal(r, "out of memory in session_attach");
 
+		/*
+		 * Let the worker threads read the data. Not for transforms, their
+		 * fstream allocates from the session pool, which isn't thread-safe.
+		 */
+		if (session->is_get && opt.multi_thread > 0 && !fstream_options.transform)
+			prefetch_create(session, r);
+
 		/* insert into hashtable */
 		apr_hash_set(gcb.session.tab, session->key, APR_HASH_KEY_STRING, session);
 
@@ -1746,7 +2013,13 @@ static void do_write(int fd, short event, void* arg)
 		/* get a block (or find a remaining block) */
 		if (r->outblock.top == r->outblock.bot)
 		{
-			const char* ferror = session_get_block(r, &r->outblock, r->line_delim_str, r->line_delim_length);
+			const char* ferror;
+
+			/* wait for a worker thread to read the next block */
+			if (prefetch_park(r))
+				return;
+
+			ferror = session_get_block(r, &r->outblock, r->line_delim_str, r->line_delim_length);
 
 			if (ferror)
 			{
@@ -1795,7 +2068,10 @@ static void do_write(int fd, short event, void* arg)
 		 * write out the block data
 		 */
 		n = datablock->top - datablock->bot;
-		n = local_send(r, datablock->data + datablock->bot, n);
+		if (datablock->fd >= 0)
+			n = local_sendfile(r, datablock, n);
+		else
+			n = local_send(r, datablock->data + datablock->bot, n);
 		if (n < 0)
 		{
 			/*
@@ -2151,6 +2427,7 @@ static void do_accept(int fd, short event, void* arg)
 
 	/* use the block size specified by -m option */
 	r->outblock.data = palloc_safe(r, pool, opt.m, "out of memory when allocating buffer: %d bytes", opt.m);
+	r->outblock.fd = -1;
 
 	r->line_delim_str = "";
 	r->line_delim_length = -1;
@@ -2888,6 +3165,9 @@ void percent_encoding_to_char(char* p, char* pp, char* path)
 
 static void handle_get_request(request_t *r)
 {
+	if (r->zstd && r->gp_proto == 1)
+		r->outblock.zdata = palloc_safe(r, r->pool, opt.m, "out of memory when allocating buffer: %d bytes", opt.m);
+
 	/* setup to receive EV_WRITE events to write to socket */
 	if (setup_write(r))
 	{
@@ -2904,6 +3184,116 @@ static void handle_get_request(request_t *r)
 	}
 }
 
+/*
+ * request_write_rows
+ *
+ * Write the whole rows in the data buffer of a POST request to the file, and
+ * move the rest to the start of the buffer. Return -1 after ending the
+ * request on error.
+ */
+static int request_write_rows(request_t *r)
+{
+	session_t*	session = r->session;
+	int			wrote;
+
+	/* only write up to end of last row */
+	wrote = fstream_write(session->fstream, r->in.dbuf, r->in.dbuftop, 1, r->line_delim_str, r->line_delim_length);
+	gdebug(r, "wrote %d bytes to file", wrote);
+	delay_watchdog_timer();
+
+	if (wrote == -1)
+	{
+		/* write error */
+		gwarning(r, "handle_post_request, write error: %s", fstream_get_error(session->fstream));
+		http_error(r, FDIST_INTERNAL_ERROR, fstream_get_error(session->fstream));
+		request_end(r, 1, 0);
+		return -1;
+	}
+	else if(wrote == r->in.dbuftop)
+	{
+		/* wrote the whole buffer. clean it for next round */
+		r->in.dbuftop = 0;
+	}
+	else
+	{
+		/* wrote up to last line, some data left over in buffer. move to front */
+		int bytes_left_over = r->in.dbuftop - wrote;
+
+		memmove(r->in.dbuf, r->in.dbuf + wrote, bytes_left_over);
+		r->in.dbuftop = bytes_left_over;
+	}
+
+	return 0;
+}
+
+/*
+ * request_decompress
+ *
+ * Decompress the next 'len' bytes of a zstd compressed POST body into the
+ * data buffer, writing out the rows whenever the buffer fills up and when
+ * the body is complete. Return -1 after ending the request on error.
+ */
+static int request_decompress(request_t *r, const char* data, int len)
+{
+#ifdef HAVE_LIBZSTD
+	ZSTD_inBuffer	input;
+	size_t			ret;
+
+	input.src = data;
+	input.size = len;
+	input.pos = 0;
+
+	for (;;)
+	{
+		ZSTD_outBuffer	output;
+
+		output.dst = r->in.dbuf;
+		output.size = r->in.dbufmax;
+		output.pos = r->in.dbuftop;
+
+		ret = ZSTD_decompressStream(gcb.zstd.dctx, &output, &input);
+		if (ZSTD_isError(ret))
+		{
+			gwarning(r, "handle_post_request, cannot decompress data: %s", ZSTD_getErrorName(ret));
+			http_error(r, FDIST_BAD_REQUEST, "invalid compressed data");
+			request_end(r, 1, 0);
+			return -1;
+		}
+
+		r->in.dbuftop = output.pos;
+
+		/* a full buffer may leave more data in the decompressor */
+		if (r->in.dbuftop == r->in.dbufmax)
+		{
+			if (request_write_rows(r))
+				return -1;
+			continue;
+		}
+
+		if (input.pos == input.size)
+			break;
+	}
+
+	if (r->in.davailable > 0)
+		return 0;
+
+	/* the whole body is here, so the stream must be complete */
+	if (ret != 0)
+	{
+		gwarning(r, "handle_post_request, compressed data ends suddenly");
+		http_error(r, FDIST_BAD_REQUEST, "invalid compressed data");
+		request_end(r, 1, 0);
+		return -1;
+	}
+
+	return r->in.dbuftop > 0 ? request_write_rows(r) : 0;
+#else
+	http_error(r, FDIST_BAD_REQUEST, "compressed data is not supported");
+	request_end(r, 1, 0);
+	return -1;
+#endif
+}
+
 static void handle_post_request(request_t *r, int header_end)
 {
 	int h_count = r->in.req->hc;
@@ -2911,6 +3301,9 @@ static void handle_post_request(request_t *r, int header_end)
 	char** h_values = r->in.req->hvalue;
 	int i = 0;
 	int b_continue = 0;
+	int zstd_body = 0;
+	char *zbuf = 0;
+	int zbufmax = 0;
 	char *data_start = 0;
 	int data_bytes_in_req = 0;
 	int wrote = 0;
@@ -2934,6 +3327,19 @@ static void handle_post_request(request_t *r, int header_end)
 		/* find out how long is our data by looking at "Content-Length" header*/
 		if(strcmp("Content-Length", h_names[i]) == 0)
 			r->in.davailable = atoi(h_values[i]);
+
+		/* is the data compressed? we only agree to zstd */
+		if(strcmp("Content-Encoding", h_names[i]) == 0)
+		{
+			if (!r->zstd || strcmp("zstd", h_values[i]) != 0)
+			{
+				gwarning(r, "reject request with unsupported Content-Encoding: %s", h_values[i]);
+				http_error(r, FDIST_BAD_REQUEST, "unsupported content encoding");
+				request_end(r, 1, 0);
+				return;
+			}
+			zstd_body = 1;
+		}
 	}
 
 	/* if client asked for 100-Continue, send it. otherwise, move on. */
@@ -3002,6 +3408,15 @@ static void handle_post_request(request_t *r, int header_end)
 	r->in.dbuftop = 0;
 	r->in.dbuf = palloc_safe(r, r->pool, r->in.dbufmax, "out of memory when allocating r->in.dbuf: %d bytes", r->in.dbufmax);
 
+#ifdef HAVE_LIBZSTD
+	if (zstd_body)
+	{
+		if (!gcb.zstd.dctx && !(gcb.zstd.dctx = ZSTD_createDCtx()))
+			gfatal(r, "out of memory when creating zstd context");
+		ZSTD_initDStream(gcb.zstd.dctx);
+	}
+#endif
+
 	/* if some data come along with the request, copy it first */
 	data_start = strstr(r->in.hbuf, "\r\n\r\n");
 	if(data_start)
@@ -3010,7 +3425,13 @@ static void handle_post_request(request_t *r, int header_end)
 		data_bytes_in_req = (r->in.hbuf + r->in.hbuftop) - data_start;
 	}
 
-	if(data_bytes_in_req > 0)
+	if (data_bytes_in_req > 0 && zstd_body)
+	{
+		r->in.davailable -= data_bytes_in_req;
+		if (request_decompress(r, data_start, data_bytes_in_req))
+			return;
+	}
+	else if(data_bytes_in_req > 0)
 	{
 		/* we have data after the request headers. consume it */
 		/* should make sure r->in.dbuftop + data_bytes_in_req <  r->in.dbufmax */
@@ -3042,6 +3463,19 @@ static void handle_post_request(request_t *r, int header_end)
 		size_t want;
 		ssize_t n;
 		size_t buf_space_left = r->in.dbufmax - r->in.dbuftop;
+		char* recvbuf = r->in.dbuf + r->in.dbuftop;
+
+		if (zstd_body)
+		{
+			/* compressed data goes through zbuf */
+			if (!zbuf)
+			{
+				zbufmax = opt.m;
+				zbuf = palloc_safe(r, r->pool, zbufmax, "out of memory when allocating buffer: %d bytes", zbufmax);
+			}
+			recvbuf = zbuf;
+			buf_space_left = zbufmax;
+		}
 
 		if (r->in.davailable > buf_space_left)
 			want = buf_space_left;
@@ -3049,7 +3483,7 @@ static void handle_post_request(request_t *r, int header_end)
 			want = r->in.davailable;
 
 		/* read from socket into data buf */
-		n = gpfdist_receive(r, r->in.dbuf + r->in.dbuftop, want);
+		n = gpfdist_receive(r, recvbuf, want);
 
 		if (n < 0)
 		{
@@ -3082,37 +3516,21 @@ static void handle_post_request(request_t *r, int header_end)
 			r->bytes += n;
 			r->last = apr_time_now();
 			r->in.davailable -= n;
+
+			if (zstd_body)
+			{
+				if (request_decompress(r, zbuf, n))
+					return;
+				continue;
+			}
+
 			r->in.dbuftop += n;
 
 			/* if filled our buffer or no more data expected, write it */
 			if (r->in.dbufmax == r->in.dbuftop || r->in.davailable == 0)
 			{
-				/* only write up to end of last row */
-				wrote = fstream_write(session->fstream, r->in.dbuf, r->in.dbuftop, 1, r->line_delim_str, r->line_delim_length);
-				gdebug(r, "wrote %d bytes to file", wrote);
-				delay_watchdog_timer();
-
-				if (wrote == -1)
-				{
-					/* write error */
-					gwarning(r, "handle_post_request, write error: %s", fstream_get_error(session->fstream));
-					http_error(r, FDIST_INTERNAL_ERROR, fstream_get_error(session->fstream));
-					request_end(r, 1, 0);
+				if (request_write_rows(r))
 					return;
-				}
-				else if(wrote == r->in.dbuftop)
-				{
-					/* wrote the whole buffer. clean it for next round */
-					r->in.dbuftop = 0;
-				}
-				else
-				{
-					/* wrote up to last line, some data left over in buffer. move to front */
-					int bytes_left_over = r->in.dbuftop - wrote;
-
-					memmove(r->in.dbuf, r->in.dbuf + wrote, bytes_left_over);
-					r->in.dbuftop = bytes_left_over;
-				}
 			}
 		}
 
@@ -3280,6 +3698,10 @@ static int request_parse_gp_headers(request_t *r, int opt_g)
 			gp_proto = r->in.req->hvalue[i];
 		else if (0 == strcasecmp("X-GP-DONE", r->in.req->hname[i]))
 			r->is_final = 1;
+#ifdef HAVE_LIBZSTD
+		else if (0 == strcasecmp("X-GP-ZSTD", r->in.req->hname[i]))
+			r->zstd = (atoi(r->in.req->hvalue[i]) == 1);
+#endif
 		else if (0 == strcasecmp("X-GP-SEGMENT-COUNT", r->in.req->hname[i]))
 			r->totalsegs = atoi(r->in.req->hvalue[i]);
 		else if (0 == strcasecmp("X-GP-SEGMENT-ID", r->in.req->hname[i]))
@@ -3554,6 +3976,7 @@ int gpfdist_init(int argc, const char* const argv[])
 
     signal_register();
 	http_setup();
+	workers_setup();
 
 #ifdef USE_SSL
 	if (opt.ssl)
@@ -4410,3 +4833,410 @@ static void delay_watchdog_timer()
 {
 }
 #endif
+
+#ifndef WIN32
+/*
+ * prefetch_schedule
+ *
+ * Queue the session for a worker thread if it has room for another block.
+ * Caller holds gcb.workers.mutex.
+ */
+static void prefetch_schedule(prefetch_t* p)
+{
+	if (p->queued || p->reading || p->stopping || p->eof || p->ferror ||
+		p->count == p->depth)
+		return;
+
+	p->queued = 1;
+	p->next_work = NULL;
+	if (gcb.workers.work_tail)
+		gcb.workers.work_tail->next_work = p;
+	else
+		gcb.workers.work_head = p;
+	gcb.workers.work_tail = p;
+
+	pthread_cond_signal(&gcb.workers.work_cond);
+}
+
+/*
+ * prefetch_worker
+ *
+ * Worker thread: read one block at a time for the session at the head of the
+ * work queue, and put the session back at the tail while it has room, so the
+ * workers go round the sessions. File reading, decompression and finding row
+ * boundaries all happen here, off the event loop.
+ */
+static void* prefetch_worker(void* arg)
+{
+	sigset_t	sigs;
+
+	/* signals are handled by the event loop */
+	sigfillset(&sigs);
+	pthread_sigmask(SIG_BLOCK, &sigs, NULL);
+
+	pthread_mutex_lock(&gcb.workers.mutex);
+
+	for (;;)
+	{
+		prefetch_t*			p;
+		prefetch_block_t*	b;
+		fstream_t*			fs;
+		apr_int64_t			pos;
+		int					size;
+		int					notify = 0;
+
+		while (!gcb.workers.work_head)
+			pthread_cond_wait(&gcb.workers.work_cond, &gcb.workers.mutex);
+
+		p = gcb.workers.work_head;
+		gcb.workers.work_head = p->next_work;
+		if (!gcb.workers.work_head)
+			gcb.workers.work_tail = NULL;
+		p->next_work = NULL;
+		p->queued = 0;
+		p->reading = 1;
+
+		b = &p->blocks[(p->head + p->count) % p->depth];
+		fs = p->session->fstream;
+
+		pthread_mutex_unlock(&gcb.workers.mutex);
+
+		pos = fstream_get_compressed_position(fs);
+		size = fstream_read(fs, b->data, opt.m, &b->fos, 1,
+							p->line_delim_str, p->line_delim_length);
+
+		pthread_mutex_lock(&gcb.workers.mutex);
+
+		p->reading = 0;
+		if (size > 0)
+		{
+			b->size = size;
+			p->count++;
+			p->read_bytes += fstream_get_compressed_position(fs) - pos;
+		}
+		else if (size == 0)
+		{
+			p->eof = 1;
+			p->read_bytes += fstream_get_compressed_size(fs) - pos;
+		}
+		else
+		{
+			p->ferror = fstream_get_error(fs);
+			p->read_bytes += fstream_get_compressed_position(fs) - pos;
+		}
+
+		if (p->stopping)
+		{
+			/* prefetch_stop() waits to close the fstream */
+			pthread_cond_broadcast(&gcb.workers.idle_cond);
+			continue;
+		}
+
+		prefetch_schedule(p);
+
+		if (p->has_waiters && !p->on_ready)
+		{
+			p->on_ready = 1;
+			p->next_ready = gcb.workers.ready;
+			gcb.workers.ready = p;
+			notify = 1;
+		}
+
+		if (notify)
+		{
+			pthread_mutex_unlock(&gcb.workers.mutex);
+
+			/* a full pipe already has a wakeup pending */
+			if (write(gcb.workers.notify_fd[1], "", 1) < 0 && errno != EAGAIN)
+				gwarning(NULL, "cannot wake up the event loop: %s", strerror(errno));
+
+			pthread_mutex_lock(&gcb.workers.mutex);
+		}
+	}
+
+	return NULL;
+}
+
+/* reschedule requests that waited for a block of the session */
+static void prefetch_wake(prefetch_t* p)
+{
+	request_t* r = p->waiters;
+
+	p->waiters = NULL;
+
+	while (r)
+	{
+		request_t* next = r->next_waiter;
+
+		r->next_waiter = NULL;
+		if (setup_write(r))
+			request_end(r, 1, 0);
+		r = next;
+	}
+}
+
+/*
+ * prefetch_notify_cb
+ *
+ * Callback when a worker thread read blocks for sessions with parked requests.
+ */
+static void prefetch_notify_cb(int fd, short event, void* arg)
+{
+	char		buf[64];
+	prefetch_t*	ready;
+	prefetch_t*	p;
+
+	while (read(fd, buf, sizeof(buf)) > 0)
+		;
+
+	pthread_mutex_lock(&gcb.workers.mutex);
+	ready = gcb.workers.ready;
+	gcb.workers.ready = NULL;
+	for (p = ready; p; p = p->next_ready)
+	{
+		p->on_ready = 0;
+		p->has_waiters = 0;
+	}
+	pthread_mutex_unlock(&gcb.workers.mutex);
+
+	while (ready)
+	{
+		p = ready;
+		ready = p->next_ready;
+		p->next_ready = NULL;
+		prefetch_wake(p);
+	}
+}
+
+/* start the worker threads of --multi_thread */
+static void workers_setup(void)
+{
+	int i;
+
+	if (opt.multi_thread == 0)
+		return;
+
+	pthread_mutex_init(&gcb.workers.mutex, NULL);
+	pthread_cond_init(&gcb.workers.work_cond, NULL);
+	pthread_cond_init(&gcb.workers.idle_cond, NULL);
+
+	if (pipe(gcb.workers.notify_fd) == -1)
+		gfatal(NULL, "cannot create pipe for worker threads: %s", strerror(errno));
+
+	for (i = 0; i < 2; i++)
+	{
+		if (fcntl(gcb.workers.notify_fd[i], F_SETFD, 1) == -1 ||
+			fcntl(gcb.workers.notify_fd[i], F_SETFL, O_NONBLOCK) == -1)
+			gfatal(NULL, "cannot set up pipe for worker threads: %s", strerror(errno));
+	}
+
+	event_set(&gcb.workers.notify_event, gcb.workers.notify_fd[0], EV_READ | EV_PERSIST,
+			  prefetch_notify_cb, 0);
+	if (event_add(&gcb.workers.notify_event, 0))
+		gfatal(NULL, "cannot set up event on worker thread pipe");
+
+	for (i = 0; i < opt.multi_thread; i++)
+	{
+		pthread_t thread;
+
+		if (pthread_create(&thread, NULL, prefetch_worker, NULL))
+			gfatal(NULL, "cannot create worker thread");
+		pthread_detach(thread);
+	}
+
+	gprintln(NULL, "started %d worker threads", opt.multi_thread);
+}
+
+/* set up the read-ahead of a new GET session and start reading */
+static void prefetch_create(session_t* session, request_t* r)
+{
+	prefetch_t*	p;
+	int			i;
+
+	p = pcalloc_safe(r, session->pool, sizeof(prefetch_t), "out of memory in prefetch_create");
+
+	p->session = session;
+	p->depth = Max(2, Min(PREFETCH_MAX_BLOCKS, PREFETCH_BYTES / opt.m));
+	p->blocks = pcalloc_safe(r, session->pool, sizeof(prefetch_block_t) * p->depth,
+							 "out of memory in prefetch_create");
+	for (i = 0; i < p->depth; i++)
+		p->blocks[i].data = palloc_safe(r, session->pool, opt.m,
+										"out of memory when allocating buffer: %d bytes", opt.m);
+	p->line_delim_str = apr_pstrdup(session->pool, r->line_delim_str);
+	p->line_delim_length = r->line_delim_length;
+
+	session->prefetch = p;
+
+	pthread_mutex_lock(&gcb.workers.mutex);
+	prefetch_schedule(p);
+	pthread_mutex_unlock(&gcb.workers.mutex);
+}
+
+/*
+ * prefetch_stop
+ *
+ * Stop reading ahead for a session before its fstream is closed, and let
+ * parked requests find out that the session has ended.
+ */
+static void prefetch_stop(session_t* session)
+{
+	prefetch_t* p = session->prefetch;
+
+	if (!p)
+		return;
+
+	pthread_mutex_lock(&gcb.workers.mutex);
+
+	p->stopping = 1;
+
+	if (p->queued)
+	{
+		prefetch_t** link = &gcb.workers.work_head;
+
+		gcb.workers.work_tail = NULL;
+		while (*link)
+		{
+			if (*link == p)
+				*link = p->next_work;
+			else
+			{
+				gcb.workers.work_tail = *link;
+				link = &(*link)->next_work;
+			}
+		}
+		p->queued = 0;
+	}
+
+	if (p->on_ready)
+	{
+		prefetch_t** link = &gcb.workers.ready;
+
+		while (*link != p)
+			link = &(*link)->next_ready;
+		*link = p->next_ready;
+		p->on_ready = 0;
+	}
+
+	while (p->reading)
+		pthread_cond_wait(&gcb.workers.idle_cond, &gcb.workers.mutex);
+
+	gcb.read_bytes += p->read_bytes;
+	p->read_bytes = 0;
+
+	pthread_mutex_unlock(&gcb.workers.mutex);
+
+	session->prefetch = NULL;
+	prefetch_wake(p);
+}
+
+/*
+ * prefetch_park
+ *
+ * If no block, error or EOF of the request's session is ready, park the
+ * request until a worker thread has read one and return 1.
+ */
+static int prefetch_park(request_t* r)
+{
+	prefetch_t*	p;
+	int			parked;
+
+	if (!r->session || !r->session->prefetch)
+		return 0;
+
+	p = r->session->prefetch;
+
+	pthread_mutex_lock(&gcb.workers.mutex);
+	parked = (p->count == 0 && !p->eof && !p->ferror);
+	if (parked)
+		p->has_waiters = 1;
+	pthread_mutex_unlock(&gcb.workers.mutex);
+
+	if (parked)
+	{
+		gdebug(r, "waiting for a worker thread to read a block");
+		r->next_waiter = p->waiters;
+		p->waiters = r;
+	}
+
+	return parked;
+}
+
+/*
+ * prefetch_get_block
+ *
+ * session_get_block() for sessions read by worker threads. prefetch_park()
+ * made sure that a block, an error or EOF is ready.
+ */
+static const char* prefetch_get_block(const request_t* r, block_t* retblock)
+{
+	session_t*			session = r->session;
+	prefetch_t*			p = session->prefetch;
+	prefetch_block_t*	b = NULL;
+	const char*			ferror;
+
+	pthread_mutex_lock(&gcb.workers.mutex);
+	gcb.read_bytes += p->read_bytes;
+	p->read_bytes = 0;
+	ferror = p->ferror;
+	if (p->count > 0)
+		b = &p->blocks[p->head];
+	pthread_mutex_unlock(&gcb.workers.mutex);
+
+	delay_watchdog_timer();
+
+	if (!b)
+	{
+		if (ferror)
+		{
+			/* the message lives in the fstream, which session_end() frees */
+			ferror = apr_pstrdup(r->pool, ferror);
+			gwarning(NULL, "session_get_block end session due to %s", ferror);
+			session_end(session, 1);
+			return ferror;
+		}
+
+		gprintln(NULL, "session_get_block: end session due to EOF");
+		session_end(session, 0);
+		return 0;
+	}
+
+	/* the workers don't touch the block at head while it is ready */
+	memcpy(retblock->data, b->data, b->size);
+	retblock->top = b->size;
+
+	block_compress(r, retblock);
+
+	/* fill the block header with meta data for the client to parse and use */
+	block_fill_header(r, retblock, &b->fos);
+
+	pthread_mutex_lock(&gcb.workers.mutex);
+	p->head = (p->head + 1) % p->depth;
+	p->count--;
+	prefetch_schedule(p);
+	pthread_mutex_unlock(&gcb.workers.mutex);
+
+	return 0;
+}
+#else
+static void workers_setup(void)
+{
+}
+
+static void prefetch_create(session_t* session, request_t* r)
+{
+}
+
+static void prefetch_stop(session_t* session)
+{
+}
+
+static int prefetch_park(request_t* r)
+{
+	return 0;
+}
+
+static const char* prefetch_get_block(const request_t* r, block_t* retblock)
+{
+	return 0;
+}
+#endif
@@ -19,6 +19,12 @@
 #include "storage/fd.h"
 #include "utils/rel.h"
 
+/*
+ * Suffix of the file next to the relation's data files in which ANALYZE
+ * keeps the samples of its segment files, see writeAOSegfileSamples().
+ */
+#define AOSAMPLE_SUFFIX ".aosample"
+
 extern int AOSegmentFilePathNameLen(Relation rel);
 
 extern void FormatAOSegmentFileName(
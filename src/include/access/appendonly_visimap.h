@@ -35,6 +35,13 @@
 #define APPENDONLY_VISIMAP_MAX_RANGE 32768
 #define APPENDONLY_VISIMAP_MAX_BITMAP_SIZE 4096
 
+/*
+ * Number of loaded visibility map entries each visibility map keeps in its
+ * entry cache.  With bitmaps of at most 4 KB, this bounds the cache to a few
+ * megabytes.
+ */
+#define APPENDONLY_VISIMAP_CACHE_SIZE 1024
+
 /*
  * Data structure for the ao visibility map processing.
  *
@@ -57,6 +64,13 @@ typedef struct AppendOnlyVisimap
 	 */
 	AppendOnlyVisimapStore visimapStore;
 
+	/*
+	 * Uncompressed bitmaps of the entries already loaded from the visibility
+	 * map table, so that moving back to an entry does not search the table
+	 * again.  NULL until the first entry is loaded.
+	 */
+	HTAB	   *entryCache;
+
 } AppendOnlyVisimap;
 
 /*
@@ -109,6 +123,13 @@ bool AppendOnlyVisimap_IsVisible(
 							AppendOnlyVisimap *visiMap,
 							AOTupleId *tupleId);
 
+int AppendOnlyVisimap_GetHiddenRange(
+								 AppendOnlyVisimap *visiMap,
+								 int segno,
+								 int64 firstRowNum,
+								 int nrows,
+								 bool *hidden);
+
 void AppendOnlyVisimap_Finish(
 						 AppendOnlyVisimap *visiMap,
 						 LOCKMODE lockmode);
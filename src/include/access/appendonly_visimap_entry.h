@@ -123,6 +123,12 @@ bool AppendOnlyVisimapEntry_IsVisible(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
 
+int AppendOnlyVisimapEntry_GetHiddenRange(
+									  AppendOnlyVisimapEntry *visiMapEntry,
+									  int64 rowNum,
+									  int nrows,
+									  bool *hidden);
+
 HTSU_Result AppendOnlyVisimapEntry_HideTuple(
 								 AppendOnlyVisimapEntry *visiMapEntry,
 								 AOTupleId *aoTupleId);
@@ -42,8 +42,13 @@ typedef struct DistributedLogEntry
 
 } DistributedLogEntry;
 
-/* Number of SLRU buffers to use for the distributed log */
-#define NUM_DISTRIBUTEDLOG_BUFFERS	8
+/*
+ * The SLRU buffers of the distributed log are split into banks of this many
+ * buffers, each with its own control lock. gp_distributedlog_buffers sets
+ * the total, and so the number of banks.
+ */
+#define DISTRIBUTEDLOG_BANK_BUFFERS	8
+#define MAX_DISTRIBUTEDLOG_BANKS	128
 
 extern void DistributedLog_SetCommittedTree(TransactionId xid, int nxids, TransactionId *xids,
 								DistributedTransactionTimeStamp	distribTimeStamp,
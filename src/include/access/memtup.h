@@ -41,6 +41,7 @@ typedef struct MemTupleBindingCols
 	MemTupleAttrBinding *bindings; /* bindings for attrs (cols) */
 	short *null_saves;				/* saved space from each attribute when null */
 	short *null_saves_aligned;		/* saved space from each attribute when null - uses aligned length */
+	int *physical_order;			/* attribute indexes, in physical order */
 	bool has_null_saves_alignment_mismatch;		/* true if one or more attributes has mismatching alignment and length  */
 	bool has_dropped_attr_alignment_mismatch;	/* true if one or more dropped attributes has mismatching alignment and length */
 } MemTupleBindingCols;
@@ -150,6 +151,7 @@ extern uint32 compute_memtuple_size(MemTupleBinding *pbind, Datum *values, bool
 extern MemTuple memtuple_copy_to(MemTuple mtup, MemTuple dest, uint32 *destlen);
 extern MemTuple memtuple_form_to(MemTupleBinding *pbind, Datum *values, bool *isnull, MemTuple dest, uint32 *destlen, bool inline_toast);
 extern void memtuple_deform(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull);
+extern void memtuple_getsomeattrs(MemTuple mtup, MemTupleBinding *pbind, int natts, Datum *datum, bool *isnull);
 extern void memtuple_deform_misaligned(MemTuple mtup, MemTupleBinding *pbind, Datum *datum, bool *isnull);
 
 extern Oid MemTupleGetOid(MemTuple mtup, MemTupleBinding *pbind);
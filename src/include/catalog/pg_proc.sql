@@ -273,6 +273,16 @@
  CREATE FUNCTION enable_xform(text) RETURNS text LANGUAGE internal IMMUTABLE STRICT PARALLEL RESTRICTED AS 'enable_xform' WITH (OID=6088, DESCRIPTION="enables transformations in the optimizer");
 
  CREATE FUNCTION gp_opt_version() RETURNS text LANGUAGE internal IMMUTABLE STRICT PARALLEL SAFE AS 'gp_opt_version' WITH (OID=6089, DESCRIPTION="Returns the optimizer and gpos library versions");
+
+ CREATE FUNCTION gp_optimizer_mdcache_stats(OUT entries int8, OUT hits int8, OUT fetches int8, OUT evictions int8, OUT resets int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_optimizer_mdcache_stats' WITH (OID=6090, DESCRIPTION="statistics: optimizer metadata cache activity of the current backend");
+
+ CREATE FUNCTION gp_optimizer_mdcache_shared_stats(OUT entries int8, OUT size int8, OUT used int8, OUT hits int8, OUT misses int8, OUT inserts int8, OUT rejects int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_optimizer_mdcache_shared_stats' WITH (OID=6091, DESCRIPTION="statistics: optimizer metadata store shared by all backends");
+
+ CREATE FUNCTION gp_optimizer_profile_stats(OUT optimizations int8, OUT total_time float8, OUT query_to_dxl_time float8, OUT search_time float8, OUT dxl_to_plstmt_time float8, OUT md_fetch_time float8, OUT object_fetches int8, OUT relstats_fetches int8, OUT colstats_fetches int8, OUT cast_fetches int8, OUT comparison_fetches int8, OUT shared_md_hits int8, OUT allocations int8, OUT bytes_allocated int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_optimizer_profile_stats' WITH (OID=6095, DESCRIPTION="statistics: where the optimizations of the current backend spent their time and memory");
+
+ CREATE FUNCTION gp_optimizer_plan_cache_stats(OUT name text, OUT lookups int8, OUT hits int8, OUT cached_plans int4, OUT planning_time float8, OUT saved_time float8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_optimizer_plan_cache_stats' WITH (OID=6094, DESCRIPTION="statistics: reuse of optimizer plans by the prepared statements of the current session");
+
+ CREATE FUNCTION gp_distributedlog_stats(OUT segid int4, OUT bank int4, OUT lock_acquires int8, OUT lock_waits int8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED EXECUTE ON ALL SEGMENTS AS 'gp_distributedlog_stats' WITH (OID=6096, DESCRIPTION="statistics: contention on the banks of the distributed log");
  
  
   -- functions for the complex data type
@@ -22,7 +22,7 @@
 
    WARNING: DO NOT MODIFY THE FOLLOWING SECTION: 
    Generated by catullus.pl version 8
-   on Fri Nov  8 12:06:43 2019
+   on Sun Oct 18 09:24:06 2026
 
    Please make your changes in pg_proc.sql
 */
@@ -557,6 +557,26 @@ DESCR("enables transformations in the optimizer");
 DATA(insert OID = 6089 ( gp_opt_version  PGNSP PGUID 12 1 0 0 0 f f f f t f i s 0 0 25 "" _null_ _null_ _null_ _null_ _null_ gp_opt_version _null_ _null_ _null_ n a ));
 DESCR("Returns the optimizer and gpos library versions");
 
+/* gp_optimizer_mdcache_stats(OUT entries int8, OUT hits int8, OUT fetches int8, OUT evictions int8, OUT resets int8) => pg_catalog.record */
+DATA(insert OID = 6090 ( gp_optimizer_mdcache_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v r 0 0 2249 "" "{20,20,20,20,20}" "{o,o,o,o,o}" "{entries,hits,fetches,evictions,resets}" _null_ _null_ gp_optimizer_mdcache_stats _null_ _null_ _null_ n a ));
+DESCR("statistics: optimizer metadata cache activity of the current backend");
+
+/* gp_optimizer_mdcache_shared_stats(OUT entries int8, OUT size int8, OUT used int8, OUT hits int8, OUT misses int8, OUT inserts int8, OUT rejects int8) => pg_catalog.record */
+DATA(insert OID = 6091 ( gp_optimizer_mdcache_shared_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v r 0 0 2249 "" "{20,20,20,20,20,20,20}" "{o,o,o,o,o,o,o}" "{entries,size,used,hits,misses,inserts,rejects}" _null_ _null_ gp_optimizer_mdcache_shared_stats _null_ _null_ _null_ n a ));
+DESCR("statistics: optimizer metadata store shared by all backends");
+
+/* gp_optimizer_profile_stats(OUT optimizations int8, OUT total_time float8, OUT query_to_dxl_time float8, OUT search_time float8, OUT dxl_to_plstmt_time float8, OUT md_fetch_time float8, OUT object_fetches int8, OUT relstats_fetches int8, OUT colstats_fetches int8, OUT cast_fetches int8, OUT comparison_fetches int8, OUT shared_md_hits int8, OUT allocations int8, OUT bytes_allocated int8) => pg_catalog.record */
+DATA(insert OID = 6095 ( gp_optimizer_profile_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v r 0 0 2249 "" "{20,701,701,701,701,701,20,20,20,20,20,20,20,20}" "{o,o,o,o,o,o,o,o,o,o,o,o,o,o}" "{optimizations,total_time,query_to_dxl_time,search_time,dxl_to_plstmt_time,md_fetch_time,object_fetches,relstats_fetches,colstats_fetches,cast_fetches,comparison_fetches,shared_md_hits,allocations,bytes_allocated}" _null_ _null_ gp_optimizer_profile_stats _null_ _null_ _null_ n a ));
+DESCR("statistics: where the optimizations of the current backend spent their time and memory");
+
+/* gp_optimizer_plan_cache_stats(OUT name text, OUT lookups int8, OUT hits int8, OUT cached_plans int4, OUT planning_time float8, OUT saved_time float8) => SETOF pg_catalog.record */
+DATA(insert OID = 6094 ( gp_optimizer_plan_cache_stats  PGNSP PGUID 12 1 1000 0 0 f f f f f t v r 0 0 2249 "" "{25,20,20,23,701,701}" "{o,o,o,o,o,o}" "{name,lookups,hits,cached_plans,planning_time,saved_time}" _null_ _null_ gp_optimizer_plan_cache_stats _null_ _null_ _null_ n a ));
+DESCR("statistics: reuse of optimizer plans by the prepared statements of the current session");
+
+/* gp_distributedlog_stats(OUT segid int4, OUT bank int4, OUT lock_acquires int8, OUT lock_waits int8) => SETOF pg_catalog.record */
+DATA(insert OID = 6096 ( gp_distributedlog_stats  PGNSP PGUID 12 1 1000 0 0 f f f f f t v r 0 0 2249 "" "{23,23,20,20}" "{o,o,o,o}" "{segid,bank,lock_acquires,lock_waits}" _null_ _null_ gp_distributedlog_stats _null_ _null_ _null_ n s ));
+DESCR("statistics: contention on the banks of the distributed log");
+
 
   /* functions for the complex data type */
 /* complex_in(cstring) => complex */
@@ -315,4 +315,18 @@ typedef FormData_pg_statistic *Form_pg_statistic;
  */
 #define STATISTIC_KIND_FULLHLL  98
 
+/*
+ * A "column group" slot describes a group of correlated columns, named by
+ * the "statistics_group" option of the column the slot belongs to.  stavalues
+ * is an int2 array of the attnums of the group, that column first.
+ * stanumbers holds the estimated number of distinct combinations of the
+ * group's values (encoded like stadistinct), followed by the ncolumns x
+ * ncolumns matrix of functional dependency degrees, in row-major order:
+ * element [a][b] is the fraction of rows whose value of column b is
+ * determined by their value of column a.
+ */
+#define STATISTIC_KIND_COLUMN_GROUP  97
+
+#define STATISTIC_GROUP_MAX_COLUMNS  8
+
 #endif   /* PG_STATISTIC_H */
@@ -157,6 +157,24 @@ typedef struct AppendOnlyExecutorReadBlock
 /*
  * used for scan of append only relations using BufferedRead and VarBlocks
  */
+/*
+ * The visible tuples of the block being scanned.  They are collected in one
+ * pass when the block is read, with the visibility map applied to the whole
+ * block at once, and handed out from here.
+ */
+typedef struct AppendOnlyScanBatch
+{
+	int			nitems;			/* number of visible tuples collected */
+	int			nextitem;		/* next one to hand out */
+	int			maxitems;		/* allocated length of the arrays */
+
+	MemTuple   *tuples;			/* tuples, pointing into the block */
+	int32	   *tupleLens;
+	int64	   *rowNums;
+
+	bool	   *hidden;			/* visimap bits of the block, per row */
+} AppendOnlyScanBatch;
+
 typedef struct AppendOnlyScanDescData
 {
 	/* scan parameters */
@@ -192,7 +210,7 @@ typedef struct AppendOnlyScanDescData
 	AppendOnlyExecutorReadBlock	executorReadBlock;
 
 	/* current scan state */
-	bool		bufferDone;
+	AppendOnlyScanBatch	batch;
 
 	bool	initedStorageRoutines;
 
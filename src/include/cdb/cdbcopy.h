@@ -22,6 +22,7 @@
 #include "cdb/cdbgang.h"
 
 #define COPYOUT_CHUNK_SIZE 16 * 1024
+#define COPYIN_CHUNK_SIZE 16 * 1024
 
 struct CdbDispatcherState;
 struct CopyStateData;
@@ -32,6 +33,8 @@ typedef struct CdbCopy
 	bool		copy_in;		/* direction: true for COPY FROM false for COPY TO */
 
 	StringInfoData	copy_out_buf;/* holds a chunk of data from the database */
+	StringInfoData	*copy_in_bufs;	/* for COPY FROM, data not yet sent to
+									 * each segment, by segindex */
 
 	List		*seglist;    	/* segs that currently take part in copy.
 								 * for copy out, once a segment gave away all it's
@@ -38,6 +38,7 @@ CdbDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand,
 							  int *resultCount,
 							  bool* badGangs,
 							  List *twophaseSegments,
+							  List *readOnlySegments,
 							  char *serializedDtxContextInfo,
 							  int serializedDtxContextInfoLen);
 
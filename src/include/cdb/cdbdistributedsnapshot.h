@@ -45,6 +45,9 @@ typedef struct DistributedSnapshot
 	DistributedTransactionId        *inProgressXidArray;
 } DistributedSnapshot;
 
+/* Number of memoized results in a snapshot, must be a power of 2 */
+#define DSLM_RESULT_MEMO_SIZE 64
+
 /*
  * GPDB: Snapshot stores this information to check tuple visibility against
  * distributed transactions.
@@ -55,12 +58,22 @@ typedef struct DistributedSnapshotWithLocalMapping
 
 	/*
 	 * Cache to perform quick check for localXid, populated after reverse
-	 * mapping distributed xid to local xid.
+	 * mapping distributed xid to local xid. inProgressMappedLocalXids is
+	 * kept sorted, so it can be binary searched.
 	 */
 	TransactionId minCachedLocalXid;
 	TransactionId maxCachedLocalXid;
 	int32 currentLocalXidsCount;
 	TransactionId *inProgressMappedLocalXids;
+
+	/*
+	 * Direct-mapped memo of the settled results of
+	 * DistributedSnapshotWithLocalMapping_CommittedTest(), indexed by the low
+	 * bits of the local xid, so that a scan looks each xid up in the
+	 * distributed log only once. An invalid xid marks an empty slot.
+	 */
+	TransactionId memoLocalXids[DSLM_RESULT_MEMO_SIZE];
+	uint8 memoResults[DSLM_RESULT_MEMO_SIZE];
 } DistributedSnapshotWithLocalMapping;
 
 typedef enum
@@ -77,6 +90,9 @@ extern DistributedSnapshotCommitted DistributedSnapshotWithLocalMapping_Committe
 	TransactionId 							localXid,
 	bool isVacuumCheck);
 
+extern void DistributedSnapshotWithLocalMapping_ResetMemo(
+	DistributedSnapshotWithLocalMapping *dslm);
+
 extern void DistributedSnapshot_Reset(
 	DistributedSnapshot *distributedSnapshot);
 
@@ -236,6 +236,9 @@ typedef struct TMGXACTLOCAL
 
 	Bitmapset					*twophaseSegmentsMap;
 	List						*twophaseSegments;
+
+	/* Segments whose QE reported writing in this transaction */
+	Bitmapset					*xlogSegmentsMap;
 }	TMGXACTLOCAL;
 
 typedef struct TMGXACTSTATUS
@@ -336,6 +339,7 @@ extern bool currentDtxDispatchProtocolCommand(DtxProtocolCommand dtxProtocolComm
 extern bool doDispatchSubtransactionInternalCmd(DtxProtocolCommand cmdType);
 extern bool doDispatchDtxProtocolCommand(DtxProtocolCommand dtxProtocolCommand, char *gid,
 							 bool *badGangs, bool raiseError, List *twophaseSegments,
+							 List *readOnlySegments,
 							 char *serializedDtxContextInfo, int serializedDtxContextInfoLen);
 
 extern void markCurrentGxactWriterGangLost(void);
@@ -344,6 +348,8 @@ extern bool currentGxactWriterGangLost(void);
 
 extern void addToGxactTwophaseSegments(struct Gang* gp);
 
+extern void markGxactSegmentWroteXLog(int segindex);
+
 extern void ClearTransactionState(TransactionId latestXid);
 
 extern void DtxRecoveryMain(Datum main_arg);
@@ -254,6 +254,12 @@ extern int gp_external_max_segs;
  */
 extern bool verify_gpfdists_cert;
 
+/*
+ * Ask gpfdist to compress the data it sends with zstd, and compress the data
+ * of writable external tables sent to it, if gpfdist supports it.
+ */
+extern bool gpfdist_compression;
+
 /*
  * gp_command_count
  *
@@ -32,6 +32,22 @@ typedef struct MCVFreqPair
 	TypInfo *typinfo; /* type information of datum type */
 } MCVFreqPair;
 
+/*
+ * Sample of the live rows of one segment file of an append-only table, with
+ * the pg_aoseg and visimap counts it was taken at. While those are unchanged
+ * the file's rows are too, and a later ANALYZE can reuse the sample.
+ */
+typedef struct AOSegfileSample
+{
+	int			segno;
+	int64		modcount;
+	int64		tupcount;		/* rows in the file, including hidden ones */
+	int64		hiddencount;	/* rows hidden by the visimap */
+	double		liverows;		/* live rows seen when the sample was taken */
+	int			numrows;		/* # rows in the sample */
+	HeapTuple  *rows;
+} AOSegfileSample;
+
 /* extern functions called by commands/analyze.c */
 extern MCVFreqPair **aggregate_leaf_partition_MCVs(Oid relationOid,
 												   AttrNumber attnum,
@@ -55,5 +71,7 @@ extern int aggregate_leaf_partition_histograms(Oid relationOid,
 											   void **result);
 extern bool needs_sample(VacAttrStats **vacattrstats, int attr_cnt);
 extern bool leaf_parts_analyzed(Oid attrelid, Oid relid_exclude, List *va_cols, int elevel);
+extern AOSegfileSample *readAOSegfileSamples(Relation rel, int *nsamples);
+extern void writeAOSegfileSamples(Relation rel, AOSegfileSample *samples, int nsamples);
 
 #endif  /* ANALYZEUTILS_H */
@@ -35,6 +35,7 @@ typedef struct ExplainState
 	bool		dxl;			/* CDB: print DXL */
 	bool		timing;			/* print detailed node timing */
 	bool		summary;		/* print total planning and execution timing */
+	bool		optimizer_profile;	/* GPDB: print GPORCA optimization profile */
 	ExplainFormat format;		/* output format */
 	/* state for output formatting --- not reset for each new plan tree */
 	int			indent;			/* current indentation level */
@@ -52,6 +53,9 @@ typedef struct ExplainState
 	bool		subplanDispatchedSeparately;
 
 	PlanState  *parentPlanState;
+
+	/* was the plan produced by GPORCA for this EXPLAIN? */
+	bool		optimizer_profiled;
 } ExplainState;
 
 /* Hook for plugins to get control in ExplainOneQuery() */
@@ -233,6 +233,7 @@ extern void lazy_vacuum_rel(Relation onerel, int options,
 extern void analyze_rel(Oid relid, RangeVar *relation, int options,
 			VacuumParams *params, List *va_cols, bool in_outer_xact,
 			BufferAccessStrategy bstrategy);
+extern void validateStatisticsGroupOption(char *value);
 
 /* GPDB only */
 extern void vacuum_appendonly_rel(Relation aorel, int options,
@@ -255,9 +256,16 @@ extern int acquire_sample_rows(Relation onerel, int elevel,
 extern int acquire_inherited_sample_rows(Relation onerel, int elevel,
 							  HeapTuple *rows, int targrows,
 							  double *totalrows, double *totaldeadrows);
+extern int64 acquire_local_relation_size(Relation onerel);
 
 /* in commands/analyzefuncs.c */
 extern Datum gp_acquire_sample_rows(PG_FUNCTION_ARGS);
 extern Oid gp_acquire_sample_rows_col_type(Oid typid);
 
+/*
+ * gp_acquire_sample_rows() returns totalrows, totaldeadrows, totalbytes and
+ * oversized_cols_bitmap before the table's columns.
+ */
+#define NUM_SAMPLE_SPECIAL_COLS		4
+
 #endif   /* VACUUM_H */
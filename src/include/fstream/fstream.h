@@ -38,6 +38,17 @@ int fstream_read(fstream_t* fs, void* buffer, int size,
 				 const int read_whole_lines,
 				 const char *line_delim_str,
 				 const int line_delim_length);
+/*
+ * Returned by fstream_read_range() when the data at the current position
+ * can't be sent straight from the file, read it with fstream_read() instead.
+ */
+#define FSTREAM_RANGE_UNAVAILABLE (-2)
+
+int fstream_read_range(fstream_t* fs, int size,
+					   struct fstream_filename_and_offset* fo,
+					   const char *line_delim_str,
+					   const int line_delim_length,
+					   int* fd, int64_t* offset);
 int fstream_write(fstream_t *fs,
 				  void *buf,
 				  int size,
@@ -49,7 +60,8 @@ int64_t fstream_get_compressed_size(fstream_t* fs);
 int64_t fstream_get_compressed_position(fstream_t* fs);
 const char* fstream_get_error(fstream_t* fs);
 fstream_t* fstream_open(const char* path, const struct fstream_options* options,
-						int* response_code, const char** response_string);
+						int* response_code, const char** response_string,
+						char* response_buf, size_t response_bufsize);
 void fstream_close(fstream_t* fs);
 bool_t fstream_is_win_pipe(fstream_t *fs);
 
@@ -86,12 +86,19 @@ int gfile_open_flags(int writing, int usesync);
 #define GFILE_OPEN_FOR_WRITE_NOSYNC 1
 #define GFILE_OPEN_FOR_WRITE_SYNC   2
 
-int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, const char** response_string, struct gpfxdist_t* transform);
+/*
+ * On failure, *response_string may point into response_buf, which the caller
+ * provides, as several files may be opened at once by different threads.
+ */
+int gfile_open(gfile_t* fd, const char* fpath, int flags, int* response_code, const char** response_string,
+			   char* response_buf, size_t response_bufsize, struct gpfxdist_t* transform);
 int gfile_close(gfile_t*fd);
 off_t gfile_get_compressed_size(gfile_t*fd);
 off_t gfile_get_compressed_position(gfile_t*fd);
 ssize_t gfile_read(gfile_t* fd, void* ptr, size_t len); /* gfile_read reads as much as it can--short read indicates error. */
 ssize_t gfile_write(gfile_t* fd, void* ptr, size_t len);
+int gfile_get_file_fd(gfile_t* fd, off_t* size); /* -1 unless an uncompressed regular file opened for read */
+int gfile_seek(gfile_t* fd, off_t offset);
 void gfile_printf_then_putc_newline(const char*format,...) pg_attribute_printf(1, 2);
 void*gfile_malloc(size_t size);
 void gfile_free(void*a);
@@ -0,0 +1,10 @@
+#ifndef GPFDIST_ZSTD_H
+#define GPFDIST_ZSTD_H
+
+/*
+ * zstd level of the data that gpfdist and the segments send each other once
+ * they agree on compression with "X-GP-ZSTD: 1", cheap enough for line rate.
+ */
+#define GPFDIST_ZSTD_COMPRESSION_LEVEL 1
+
+#endif
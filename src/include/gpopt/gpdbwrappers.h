@@ -20,6 +20,9 @@
 #include "utils/faultinjector.h"
 #include "parser/parse_coerce.h"
 #include "utils/lsyscache.h"
+extern "C" {
+#include "utils/optmdcache.h"
+}
 
 // fwd declarations
 typedef struct SysScanDescData *SysScanDesc;
@@ -55,6 +58,16 @@ struct Var;
 struct Const;
 struct ArrayExpr;
 
+// metadata cache activity of this backend
+typedef struct MDCacheStats
+{
+	int64		entries;		// entries currently tracked
+	int64		hits;			// relations of a query found in the cache
+	int64		fetches;		// objects translated from the catalogs
+	int64		evictions;		// entries evicted because of catalog changes
+	int64		resets;			// full cache resets
+} MDCacheStats;
+
 namespace gpdb {
 
 	// convert datum to bool
@@ -650,9 +663,33 @@ namespace gpdb {
 	gpos::ULONG CountLeafPartTables(Oid oidRelation);
 
 	// Does the metadata cache need to be reset (because of a catalog
-	// table has been changed?)
+	// table has been changed in a way that cannot be tracked per entry?)
 	bool MDCacheNeedsReset(void);
 
+	// record an object handed to the metadata cache, so that it can later
+	// be evicted individually
+	void MDCacheRegisterEntry(const MDCacheEntryKey *key, Oid relid, AttrNumber attno);
+
+	// return the keys of the metadata cache entries invalidated since the
+	// last call, and stop tracking them
+	List *MDCacheGetInvalidatedEntries(void);
+
+	// count the metadata cache hits of the optimization of a query
+	void MDCacheCountHits(Query *query);
+
+	// metadata cache activity of this backend
+	void MDCacheGetStats(MDCacheStats *stats);
+
+	// can the shared metadata store be used for the current query? If so,
+	// returns the catalog version to pass to MDCacheSharedInsert()
+	bool MDCacheSharedBeginFetch(uint64 *catalog_version);
+
+	// look up the DXL of an object in the shared metadata store
+	char *MDCacheSharedLookup(const MDCacheEntryKey *key);
+
+	// store the DXL of an object in the shared metadata store
+	void MDCacheSharedInsert(const MDCacheEntryKey *key, Oid relid, AttrNumber attno, uint64 catalog_version, const char *dxl);
+
 	// returns true if a query cancel is requested in GPDB
 	bool IsAbortRequested(void);
 
@@ -21,8 +21,10 @@
 #include "gpos/base.h"
 #include "gpos/string/CWStringBase.h"
 
+#include "naucrates/dxl/gpdb_types.h"
 #include "naucrates/md/CSystemId.h"
 #include "naucrates/md/IMDId.h"
+#include "naucrates/md/IMDCacheObject.h"
 #include "naucrates/md/IMDProvider.h"
 
 // fwd decl
@@ -31,6 +33,8 @@ namespace gpopt
 	class CMDAccessor;
 }
 
+struct MDCacheEntryKey;
+
 namespace gpmd
 {
 	using namespace gpos;
@@ -52,6 +56,23 @@ namespace gpmd
 			// private copy ctor
 			CMDProviderRelcache(const CMDProviderRelcache&);
 
+			// identity of the metadata id in the metadata cache
+			static
+			void GetMDCacheKey(IMDId *md_id, MDCacheEntryKey *key);
+
+			// record the retrieved object for fine-grained cache invalidation,
+			// and return the relation and attribute it depends on
+			void RegisterMDObj
+				(
+				CMDAccessor *md_accessor,
+				IMDId *md_id,
+				IMDCacheObject *md_obj,
+				const MDCacheEntryKey *key,
+				OID *rel_oid,
+				INT *attno
+				)
+				const;
+
 		public:
 			// ctor/dtor
 			explicit
@@ -241,11 +241,16 @@ namespace gpdxl
 								const CHistogram *hist
 								);
 
+			// is the type one of the text types whose histograms are ignored
+			static
+			BOOL IsTextRelatedType(const IMDId *mdid);
+
 			// transform stats from pg_stats form to optimizer's preferred form
 			static
 			CDXLBucketArray *TransformStatsToDXLBucketArray
 								(
 								CMemoryPool *mp,
+								CMDAccessor *md_accessor,
 								OID att_type,
 								CDouble num_distinct,
 								CDouble null_freq,
@@ -399,6 +404,7 @@ namespace gpdxl
             CDXLColStats *GenerateStatsForSystemCols
                               (
                               CMemoryPool *mp,
+                              CMDAccessor *md_accessor,
                               OID rel_oid,
                               CMDIdColStats *mdid_col_stats,
                               CMDName *md_colname,
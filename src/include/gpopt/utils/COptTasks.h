@@ -156,6 +156,10 @@ class COptTasks
 		static
 		ICostModel *GetCostModel(CMemoryPool *mp, ULONG num_segments);
 
+		// evict the metadata cache entries invalidated by catalog changes
+		static
+		void EvictInvalidatedMDCacheEntries(CMemoryPool *mp);
+
 		// print warning messages for columns with missing statistics
 		static
 		void PrintMissingStatsWarning(CMemoryPool *mp, CMDAccessor *md_accessor, IMdIdArray *col_stats, MdidHashSet *phsmdidRel);
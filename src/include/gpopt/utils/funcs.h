@@ -22,6 +22,7 @@ extern Datum DisableXform(PG_FUNCTION_ARGS);
 extern Datum EnableXform(PG_FUNCTION_ARGS);
 extern Datum LibraryVersion();
 extern const char * OptVersion(void);
+extern void MDCacheStatsValues(int64 *entries, int64 *hits, int64 *fetches, int64 *evictions, int64 *resets);
 
 }
 
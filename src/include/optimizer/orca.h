@@ -19,8 +19,46 @@
 
 #include "pg_config.h"
 
+#include "nodes/params.h"
+#include "nodes/parsenodes.h"
+#include "nodes/plannodes.h"
+
 #ifdef USE_ORCA
 
+#include "utils/optmdcache.h"
+
+/*
+ * Where the time and memory of an ORCA optimization went.  Times are in
+ * milliseconds.  Metadata is fetched on demand by the translators and the
+ * search, so md_fetch_time overlaps the other phases.
+ */
+typedef struct OptimizerProfile
+{
+	double		query_to_dxl_time;	/* CTranslatorQueryToDXL */
+	double		search_time;		/* search stages of the optimizer */
+	double		dxl_to_plstmt_time;	/* CTranslatorDXLToPlStmt */
+	double		md_fetch_time;		/* metadata translated from the catalogs */
+	double		total_time;			/* whole of GPOPTOptimizedPlan() */
+	int			search_stages;		/* stages of a custom search strategy,
+									 * or 0 for the default strategy */
+	/*
+	 * Metadata translated from the catalogs, per MDCacheEntryKind rather
+	 * than per IMDCacheObject::Emdt type: a hit in the shared store is
+	 * counted before the DXL is parsed, when only the kind of the key is
+	 * known.
+	 */
+	int64		md_fetches[MDCACHE_NUM_ENTRY_KINDS];
+	/* metadata found in the shared store instead */
+	int64		md_shared_hits[MDCACHE_NUM_ENTRY_KINDS];
+	int64		allocations;		/* allocations through CMemoryPoolPalloc */
+	int64		bytes_allocated;	/* bytes requested through CMemoryPoolPalloc */
+} OptimizerProfile;
+
+/* profile of the last optimization, and the sum over this backend */
+extern OptimizerProfile optimizer_last_profile;
+extern OptimizerProfile optimizer_total_profile;
+extern int64 optimizer_profile_count;
+
 extern PlannedStmt * optimize_query(Query *parse, ParamListInfo boundParams);
 
 #else
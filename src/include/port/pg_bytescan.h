@@ -0,0 +1,121 @@
+/*-------------------------------------------------------------------------
+ *
+ * pg_bytescan.h
+ *	  Find the next of a few interesting bytes in a buffer.
+ *
+ * The COPY and external table parsers spend most of their time stepping
+ * over ordinary data bytes, looking for delimiters, quotes, escapes and
+ * newlines.  bytescan_find() skips such runs 16 bytes at a time with SSE2,
+ * which every x86-64 CPU has, and falls back to a plain loop elsewhere.  A
+ * set is cheap to build, so callers can build it per line.
+ *
+ * Usage:
+ *
+ *		ByteScanSet set;
+ *
+ *		bytescan_init(&set, false);
+ *		bytescan_add(&set, '\n');
+ *		bytescan_add(&set, delimc);
+ *		p = bytescan_find(&set, p, end);
+ *
+ * Portions Copyright (c) 2019-Present Pivotal Software, Inc.
+ *
+ * src/include/port/pg_bytescan.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PG_BYTESCAN_H
+#define PG_BYTESCAN_H
+
+#if defined(__SSE2__) && defined(__GNUC__)
+#include <emmintrin.h>
+#define USE_SSE2_BYTESCAN
+#endif
+
+#define BYTESCAN_MAX_BYTES	6
+
+typedef struct ByteScanSet
+{
+	int			nbytes;
+	bool		highbit;		/* also stop at any byte with the high bit set */
+	char		bytes[BYTESCAN_MAX_BYTES];
+} ByteScanSet;
+
+/*
+ * Start an empty set.  With highbit, every non-ASCII byte is interesting
+ * too, for callers that must step through multibyte characters.
+ */
+static inline void
+bytescan_init(ByteScanSet *set, bool highbit)
+{
+	set->nbytes = 0;
+	set->highbit = highbit;
+}
+
+static inline void
+bytescan_add(ByteScanSet *set, char c)
+{
+	int			i;
+
+	for (i = 0; i < set->nbytes; i++)
+	{
+		if (set->bytes[i] == c)
+			return;
+	}
+
+	Assert(set->nbytes < BYTESCAN_MAX_BYTES);
+	set->bytes[set->nbytes++] = c;
+}
+
+/*
+ * Return the first byte in [s, end) that is in the set, or end if there is
+ * none.
+ */
+static inline const char *
+bytescan_find(const ByteScanSet *set, const char *s, const char *end)
+{
+#ifdef USE_SSE2_BYTESCAN
+	if (end - s >= 16 && set->nbytes > 0)
+	{
+		__m128i		vbytes[BYTESCAN_MAX_BYTES];
+		int			nbytes = set->nbytes;
+		int			i;
+
+		for (i = 0; i < nbytes; i++)
+			vbytes[i] = _mm_set1_epi8(set->bytes[i]);
+
+		while (end - s >= 16)
+		{
+			__m128i		chunk = _mm_loadu_si128((const __m128i *) s);
+			__m128i		hits = _mm_cmpeq_epi8(chunk, vbytes[0]);
+			int			mask;
+
+			for (i = 1; i < nbytes; i++)
+				hits = _mm_or_si128(hits, _mm_cmpeq_epi8(chunk, vbytes[i]));
+			mask = _mm_movemask_epi8(hits);
+			if (set->highbit)
+				mask |= _mm_movemask_epi8(chunk);
+			if (mask != 0)
+				return s + __builtin_ctz(mask);
+			s += 16;
+		}
+	}
+#endif
+
+	for (; s < end; s++)
+	{
+		int			i;
+
+		if (set->highbit && IS_HIGHBIT_SET(*s))
+			return s;
+		for (i = 0; i < set->nbytes; i++)
+		{
+			if (*s == set->bytes[i])
+				return s;
+		}
+	}
+
+	return s;
+}
+
+#endif   /* PG_BYTESCAN_H */
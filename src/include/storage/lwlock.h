@@ -236,6 +236,7 @@ typedef enum BuiltinTrancheIds
 	LWTRANCHE_LOCK_MANAGER,
 	LWTRANCHE_PREDICATE_LOCK_MANAGER,
 	LWTRANCHE_DISTRIBUTEDLOG_BUFFERS,
+	LWTRANCHE_DISTRIBUTEDLOG_BANKS,
 	LWTRANCHE_FIRST_USER_DEFINED
 }	BuiltinTrancheIds;
 
@@ -1389,6 +1389,7 @@ extern Datum pg_extension_config_dump(PG_FUNCTION_ARGS);
 
 /* commands/prepare.c */
 extern Datum pg_prepared_statement(PG_FUNCTION_ARGS);
+extern Datum gp_optimizer_plan_cache_stats(PG_FUNCTION_ARGS);
 
 /* utils/mmgr/portalmem.c */
 extern Datum pg_cursor(PG_FUNCTION_ARGS);
@@ -1462,7 +1463,17 @@ extern Datum enable_xform(PG_FUNCTION_ARGS);
 /* Optimizer's version */
 extern Datum gp_opt_version(PG_FUNCTION_ARGS);
 
+/* Optimizer's metadata cache */
+extern Datum gp_optimizer_mdcache_stats(PG_FUNCTION_ARGS);
+extern Datum gp_optimizer_profile_stats(PG_FUNCTION_ARGS);
+
+/* utils/cache/optmdcache.c */
+extern Datum gp_optimizer_mdcache_shared_stats(PG_FUNCTION_ARGS);
+
 /* query_metrics.c */
 extern Datum gp_instrument_shmem_summary(PG_FUNCTION_ARGS);
 
+/* access/transam/distributedlog.c */
+extern Datum gp_distributedlog_stats(PG_FUNCTION_ARGS);
+
 #endif   /* BUILTINS_H */
@@ -288,10 +288,12 @@ extern bool Debug_appendonly_print_compaction;
 extern bool Debug_bitmap_print_insert;
 extern bool enable_checksum_on_tables;
 extern int  gp_max_local_distributed_cache;
+extern int  gp_distributedlog_buffers;
 extern bool gp_local_distributed_cache_stats;
 extern bool gp_appendonly_verify_block_checksums;
 extern bool gp_appendonly_verify_write_block;
 extern bool gp_appendonly_compaction;
+extern bool gp_analyze_cache_ao_samples;
 
 /*
  * Threshold of the ratio of dirty data in a segment file
@@ -318,6 +320,7 @@ extern bool gp_create_table_random_default_distribution;
 extern bool gp_allow_non_uniform_partitioning_ddl;
 extern bool gp_enable_exchange_default_partition;
 extern int  dtx_phase2_retry_count;
+extern bool gp_dtx_skip_readonly_segments;
 
 /* WAL replication debug gucs */
 extern bool debug_walrepl_snd;
@@ -453,6 +456,8 @@ extern int optimizer_minidump;
 extern int  optimizer_cost_model;
 extern bool optimizer_metadata_caching;
 extern int	optimizer_mdcache_size;
+extern int	optimizer_mdcache_shared_size;
+extern int	optimizer_plan_cache_size;
 
 /* Optimizer debugging GUCs */
 extern bool optimizer_print_query;
@@ -0,0 +1,59 @@
+/*-------------------------------------------------------------------------
+ *
+ * optmdcache.h
+ *	  Shared-memory store of serialized ORCA metadata objects.
+ *
+ *
+ * Copyright (c) 2019-Present Pivotal Software, Inc.
+ *
+ * src/include/utils/optmdcache.h
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#ifndef OPTMDCACHE_H
+#define OPTMDCACHE_H
+
+#include "access/attnum.h"
+#include "storage/sinval.h"
+
+/* kinds of ORCA metadata cache entries that are tracked for invalidation */
+typedef enum MDCacheEntryKind
+{
+	MDCACHE_ENTRY_OBJECT,		/* relation, index, type, operator, function, ... */
+	MDCACHE_ENTRY_RELSTATS,		/* relation statistics */
+	MDCACHE_ENTRY_COLSTATS,		/* column statistics */
+	MDCACHE_ENTRY_CAST,			/* cast function between two types */
+	MDCACHE_ENTRY_SCCMP			/* scalar comparison between two types */
+} MDCacheEntryKind;
+
+#define MDCACHE_NUM_ENTRY_KINDS		(MDCACHE_ENTRY_SCCMP + 1)
+
+/*
+ * Identity of a metadata cache entry. It is hashed as a blob, so it must be
+ * zeroed before it is filled in.
+ */
+typedef struct MDCacheEntryKey
+{
+	int32		kind;			/* one of MDCacheEntryKind */
+	Oid			oid;			/* object, relation, or source/left type */
+	Oid			oid2;			/* destination/right type */
+	int32		extra;			/* column position, or comparison type */
+} MDCacheEntryKey;
+
+extern Size OptMDCacheShmemSize(void);
+extern void OptMDCacheShmemInit(void);
+
+extern bool OptMDCacheSharedEnabled(void);
+
+extern void OptMDCacheInvalidateMessages(const SharedInvalidationMessage *msgs,
+										 int n);
+
+extern uint64 OptMDCacheGetCatalogVersion(void);
+extern char *OptMDCacheLookup(const MDCacheEntryKey *key,
+							  Oid *relid, AttrNumber *attno);
+extern void OptMDCacheInsert(const MDCacheEntryKey *key,
+							 Oid relid, AttrNumber attno,
+							 uint64 catalog_version, const char *data);
+
+#endif   /* OPTMDCACHE_H */
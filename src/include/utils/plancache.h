@@ -113,6 +113,14 @@ typedef struct CachedPlanSource
 	double		generic_cost;	/* cost of generic plan, or -1 if not known */
 	double		total_custom_cost;		/* total cost of custom plans so far */
 	int			num_custom_plans;		/* number of plans included in total */
+	/*
+	 * GPDB: custom plans produced by ORCA, kept for reuse with the same
+	 * parameter values (most recently used first), and their statistics.
+	 */
+	List	   *orca_plans;		/* list of CachedPlans, or NIL */
+	int64		num_orca_lookups;	/* number of reuse attempts */
+	int64		num_orca_hits;	/* number of reused plans */
+	double		orca_saved_time;	/* planning time saved by reuse, in ms */
 } CachedPlanSource;
 
 /*
@@ -140,6 +148,9 @@ typedef struct CachedPlan
 	int			generation;		/* parent's generation number for this plan */
 	int			refcount;		/* count of live references to this struct */
 	MemoryContext context;		/* context containing this CachedPlan */
+	double		planning_time;	/* time spent building the plan, in ms */
+	ParamListInfo boundParams;	/* GPDB: parameter values of a custom plan
+								 * kept in orca_plans, else NULL */
 } CachedPlan;
 
 
@@ -17,6 +17,7 @@
 
 #include "fmgr.h"
 #include "access/htup.h"
+#include "catalog/pg_statistic.h"
 #include "nodes/relation.h"
 
 
@@ -142,6 +143,19 @@ typedef struct
 	double		num_sa_scans;	/* # indexscans from ScalarArrayOps */
 } GenericCosts;
 
+/*
+ * Multi-column statistics that ANALYZE collected on a column group, see
+ * STATISTIC_KIND_COLUMN_GROUP.  degree[a][b] is the degree of the functional
+ * dependency of column b on column a.
+ */
+typedef struct ColumnGroupStats
+{
+	int			ncolumns;
+	AttrNumber	attnums[STATISTIC_GROUP_MAX_COLUMNS];
+	double		ndistinct;		/* distinct combinations, like stadistinct */
+	double		degree[STATISTIC_GROUP_MAX_COLUMNS][STATISTIC_GROUP_MAX_COLUMNS];
+} ColumnGroupStats;
+
 /* Hooks for plugins to get control when we ask for stats */
 typedef bool (*get_relation_stats_hook_type) (PlannerInfo *root,
 														  RangeTblEntry *rte,
@@ -170,6 +184,8 @@ extern void get_join_variables(PlannerInfo *root, List *args,
 				   bool *join_is_reversed);
 extern double get_variable_numdistinct(VariableStatData *vardata,
 						 bool *isdefault);
+extern bool get_column_group_stats(VariableStatData *vardata,
+					   ColumnGroupStats *group);
 extern double mcv_selectivity(VariableStatData *vardata, FmgrInfo *opproc,
 				Datum constval, bool varonleft,
 				double *sumcommonp);
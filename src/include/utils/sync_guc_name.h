@@ -11,6 +11,7 @@
 		"force_parallel_mode",
 		"gin_fuzzy_search_limit",
 		"gin_pending_list_limit",
+		"gp_analyze_cache_ao_samples",
 		"gp_blockdirectory_entry_min_range",
 		"gp_blockdirectory_minipage_size",
 		"gp_debug_linger",
@@ -72,6 +73,7 @@
 		"gp_workfile_compression",
 		"gp_workfile_limit_files_per_query",
 		"gp_workfile_limit_per_query",
+		"gpfdist_compression",
 		"idle_in_transaction_session_timeout",
 		"IntervalStyle",
 		"lc_numeric",
@@ -159,6 +159,8 @@
 		"gp_debug_pgproc",
 		"gp_debug_resqueue_priority",
 		"gp_distinct_grouping_sets_threshold",
+		"gp_distributedlog_buffers",
+		"gp_dtx_skip_readonly_segments",
 		"gp_dynamic_partition_pruning",
 		"gp_eager_agg_distinct_pruning",
 		"gp_eager_one_phase_agg",
@@ -399,6 +401,7 @@
 		"optimizer_join_order_threshold",
 		"optimizer_log",
 		"optimizer_log_failure",
+		"optimizer_mdcache_shared_size",
 		"optimizer_metadata_caching",
 		"optimizer_minidump",
 		"optimizer_multilevel_partitioning",
@@ -406,6 +409,7 @@
 		"optimizer_parallel_union",
 		"optimizer_penalize_broadcast_threshold",
 		"optimizer_penalize_skew",
+		"optimizer_plan_cache_size",
 		"optimizer_print_expression_properties",
 		"optimizer_print_group_properties",
 		"optimizer_print_job_scheduler",
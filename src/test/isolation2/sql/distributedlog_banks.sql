@@ -0,0 +1,22 @@
+-- The distributed log buffers of a segment are split into banks of 8, each
+-- with its own lock, and gp_stat_distributedlog shows one row per bank.
+-- start_ignore
+! gpconfig -c gp_distributedlog_buffers -v 24;
+! gpstop -rai;
+-- end_ignore
+
+1: show gp_distributedlog_buffers;
+1: create table distributedlog_banks_t (a int) distributed by (a);
+1: insert into distributedlog_banks_t select generate_series(1, 100);
+1: select count(*) from distributedlog_banks_t;
+
+1: select segid, count(*) as banks, min(bank), max(bank) from gp_stat_distributedlog group by segid order by segid;
+1: select count(*) from gp_stat_distributedlog where lock_acquires < 0 or lock_waits < 0 or lock_waits > lock_acquires;
+
+1: drop table distributedlog_banks_t;
+1q:
+
+-- start_ignore
+! gpconfig -r gp_distributedlog_buffers;
+! gpstop -rai;
+-- end_ignore
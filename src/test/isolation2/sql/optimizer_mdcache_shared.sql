@@ -0,0 +1,42 @@
+-- The ORCA metadata store shared by the sessions on the coordinator must
+-- follow catalog changes made by sessions that never run ORCA, and sessions
+-- that connect after a change must not be handed the old metadata.
+-- start_ignore
+! gpconfig -c optimizer_mdcache_shared_size -v 1024 --masteronly;
+! gpstop -rai;
+-- end_ignore
+
+1: create table mdcache_shared_t (a int, b int) distributed by (a);
+1: insert into mdcache_shared_t select i, i from generate_series(1, 10) i;
+1: analyze mdcache_shared_t;
+
+-- Session 1 translates the table with ORCA, and puts it in the store.
+1: set optimizer = on;
+1: select * from mdcache_shared_t where a = 1;
+1: select inserts > 0 as stored from gp_stat_optimizer_mdcache_shared;
+
+-- Session 2 changes the table without ever running ORCA.
+2: set optimizer = off;
+2: alter table mdcache_shared_t add column c int default 7;
+
+-- A session that connects after the change sees the new column, although
+-- it is served the objects that didn't change from the store.
+3: set optimizer = on;
+3: select * from mdcache_shared_t where a = 1;
+3: select hits > 0 as served from gp_stat_optimizer_mdcache_shared;
+1: select * from mdcache_shared_t where a = 1;
+
+-- The same for a change made while no other session was connected.
+1q:
+3q:
+2: alter table mdcache_shared_t rename column b to b_renamed;
+2q:
+4: set optimizer = on;
+4: select * from mdcache_shared_t where a = 1;
+
+4: drop table mdcache_shared_t;
+
+-- start_ignore
+! gpconfig -r optimizer_mdcache_shared_size --masteronly;
+! gpstop -rai;
+-- end_ignore
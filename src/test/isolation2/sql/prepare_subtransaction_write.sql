@@ -0,0 +1,55 @@
+-- Test that, with gp_dtx_skip_readonly_segments, a segment whose only
+-- writes were made in a subtransaction or to a temporary table still takes
+-- part in two-phase commit, while a segment that didn't write at all is
+-- committed without preparing.
+--
+-- With 3 segments, keys 2 and 3 are on content 0, key 1 on content 1 and
+-- key 5 on content 2.
+
+CREATE TABLE prepare_subxact_write (a int, b int) DISTRIBUTED BY (a);
+
+1: SET gp_dtx_skip_readonly_segments = on;
+1: CREATE TEMP TABLE prepare_subxact_temp (a int, b int) DISTRIBUTED BY (a);
+
+-- Make content 1 fail if it is asked to prepare.
+SELECT gp_inject_fault('start_prepare', 'error', dbid) FROM gp_segment_configuration WHERE role = 'p' AND content = 1;
+
+-- Content 1 takes part through the savepoint, but doesn't write.  It is
+-- committed in the first phase, and so never reaches the fault.
+1: BEGIN;
+1: SAVEPOINT s;
+1: INSERT INTO prepare_subxact_write VALUES (2, 2), (5, 5);
+1: RELEASE SAVEPOINT s;
+1: COMMIT;
+1: SELECT * FROM prepare_subxact_write ORDER BY a;
+
+-- Now content 1 writes, but only inside the released savepoint.  It must be
+-- asked to prepare, so the fault fires and the whole transaction aborts.
+1: BEGIN;
+1: SAVEPOINT s;
+1: INSERT INTO prepare_subxact_write VALUES (1, 1), (3, 3);
+1: RELEASE SAVEPOINT s;
+1: COMMIT;
+1: SELECT * FROM prepare_subxact_write ORDER BY a;
+
+-- Content 1 only writes to a temporary table. That writes no WAL, but still
+-- has to commit along with the rest, so content 1 must be asked to prepare.
+1: BEGIN;
+1: INSERT INTO prepare_subxact_temp VALUES (1, 1);
+1: INSERT INTO prepare_subxact_write VALUES (3, 3);
+1: COMMIT;
+1: SELECT * FROM prepare_subxact_write ORDER BY a;
+1: SELECT * FROM prepare_subxact_temp ORDER BY a;
+
+SELECT gp_inject_fault('start_prepare', 'reset', dbid) FROM gp_segment_configuration WHERE role = 'p' AND content = 1;
+
+-- Without the fault, the same transaction commits on both segments.
+1: BEGIN;
+1: SAVEPOINT s;
+1: INSERT INTO prepare_subxact_write VALUES (1, 1), (3, 3);
+1: RELEASE SAVEPOINT s;
+1: COMMIT;
+1: SELECT * FROM prepare_subxact_write ORDER BY a;
+1q:
+
+DROP TABLE prepare_subxact_write;
@@ -449,3 +449,106 @@ analyze aocs_analyze_test;
 select relname, reltuples from pg_class where relname like 'aocs_analyze_test%' order by relname;
 
 reset default_statistics_target;
+
+--
+-- Test that the merged sample is not smaller on a skewed table. All the rows
+-- are on one segment, which holds more rows than the first round asks each
+-- segment for, so the whole table fits in the sample only if that segment is
+-- asked again. Then the frequency of b = 1 is exactly 100 / 290.
+--
+set default_statistics_target=1;
+create table skewed_analyze_test (a int, b int) distributed by (a);
+insert into skewed_analyze_test select 1, case when g <= 100 then 1 else g end from generate_series(1, 290) g;
+analyze skewed_analyze_test;
+select most_common_vals, most_common_freqs from pg_stats where tablename='skewed_analyze_test' and attname='b';
+drop table skewed_analyze_test;
+reset default_statistics_target;
+
+--
+-- Test that the samples kept for append-only segment files are not reused
+-- once the files change.
+--
+create table ao_analyze_cache (i int4) with (appendonly=true) distributed by (i);
+insert into ao_analyze_cache select 1 from generate_series(1, 100);
+analyze ao_analyze_cache;
+select n_distinct, most_common_vals, most_common_freqs from pg_stats where tablename='ao_analyze_cache';
+insert into ao_analyze_cache select 2 from generate_series(1, 100);
+analyze ao_analyze_cache;
+select n_distinct, most_common_vals, most_common_freqs from pg_stats where tablename='ao_analyze_cache';
+delete from ao_analyze_cache where i = 1;
+analyze ao_analyze_cache;
+select n_distinct, most_common_vals, most_common_freqs from pg_stats where tablename='ao_analyze_cache';
+select relname, reltuples from pg_class where relname = 'ao_analyze_cache';
+drop table ao_analyze_cache;
+
+--
+-- The kept samples are removed along with the table's data files.
+--
+create function ao_analyze_cache_files() returns table(segid int, filenode oid)
+volatile language sql as $fn$
+  select gp_execution_segment(), substring(f from '^(\d+)\.aosample$')::oid
+  from pg_database d, pg_ls_dir('base/' || d.oid) f
+  where d.datname = current_database() and f like '%.aosample'
+$fn$ execute on all segments;
+create table ao_analyze_cache (i int4) with (appendonly=true) distributed by (i);
+create temp table ao_analyze_cache_nodes (segid int, relfilenode oid) distributed randomly;
+insert into ao_analyze_cache select g from generate_series(1, 1000) g;
+analyze ao_analyze_cache;
+insert into ao_analyze_cache_nodes select gp_segment_id, relfilenode from gp_dist_random('pg_class') where relname = 'ao_analyze_cache';
+select n.segid, f.filenode is not null as present from ao_analyze_cache_nodes n left join ao_analyze_cache_files() f on f.segid = n.segid and f.filenode = n.relfilenode order by 1;
+truncate ao_analyze_cache;
+select n.segid, f.filenode is not null as present from ao_analyze_cache_nodes n left join ao_analyze_cache_files() f on f.segid = n.segid and f.filenode = n.relfilenode order by 1;
+insert into ao_analyze_cache select g from generate_series(1, 1000) g;
+analyze ao_analyze_cache;
+delete from ao_analyze_cache_nodes;
+insert into ao_analyze_cache_nodes select gp_segment_id, relfilenode from gp_dist_random('pg_class') where relname = 'ao_analyze_cache';
+select n.segid, f.filenode is not null as present from ao_analyze_cache_nodes n left join ao_analyze_cache_files() f on f.segid = n.segid and f.filenode = n.relfilenode order by 1;
+drop table ao_analyze_cache;
+select n.segid, f.filenode is not null as present from ao_analyze_cache_nodes n left join ao_analyze_cache_files() f on f.segid = n.segid and f.filenode = n.relfilenode order by 1;
+drop table ao_analyze_cache_nodes;
+drop function ao_analyze_cache_files();
+
+--
+-- Test multi-column statistics on a column group. city determines country,
+-- which determines region.
+--
+create table stats_group_test (region int4, country int4, city int4) distributed by (city);
+insert into stats_group_test select g % 10, g % 100, g % 1000 from generate_series(1, 10000) g;
+alter table stats_group_test alter column city set (statistics_group = 'a,b,c,d,e,f,g,h');
+alter table stats_group_test alter column city set (statistics_group = 'country, region');
+analyze stats_group_test;
+select case when stakind1 = 97 then stavalues1::text::int2[]
+            when stakind2 = 97 then stavalues2::text::int2[]
+            when stakind3 = 97 then stavalues3::text::int2[]
+            when stakind4 = 97 then stavalues4::text::int2[] end as group_columns,
+       case when stakind1 = 97 then stanumbers1
+            when stakind2 = 97 then stanumbers2
+            when stakind3 = 97 then stanumbers3
+            when stakind4 = 97 then stanumbers4 end as group_stats
+from pg_statistic where starelid = 'stats_group_test'::regclass and staattnum = 3;
+
+-- The row estimates of the Postgres planner use the group's statistics:
+-- about 1000 groups rather than one per row, and about 10 rows for a city
+-- and its own country rather than 10 * 1/100.
+set optimizer = off;
+create function stats_group_rows(query text) returns int language plpgsql as $$
+declare
+  ln text;
+begin
+  for ln in execute 'explain ' || query loop
+    return substring(ln from 'rows=(\d+)')::int;
+  end loop;
+end;
+$$;
+select stats_group_rows('select city, country, region from stats_group_test group by city, country, region') between 500 and 2000 as groups_ok;
+select stats_group_rows('select * from stats_group_test where city = 5 and country = 5') between 5 and 20 as rows_ok;
+-- The clauses that the group covers are not damped along with the rest.
+create temp table stats_group_est (undamped int) distributed randomly;
+set gp_selectivity_damping_for_scans = off;
+insert into stats_group_est select stats_group_rows('select * from stats_group_test where city = 5 and country = 5 and region < 5');
+reset gp_selectivity_damping_for_scans;
+select stats_group_rows('select * from stats_group_test where city = 5 and country = 5 and region < 5') = undamped as not_damped from stats_group_est;
+drop table stats_group_est;
+drop function stats_group_rows(text);
+reset optimizer;
+drop table stats_group_test;
@@ -0,0 +1,24 @@
+--
+-- EXPLAIN (OPTIMIZER_PROFILE) shows where the time and memory of the GPORCA
+-- optimization went. Plans made by the Postgres planner have no profile.
+--
+-- start_matchsubs
+-- m/^\s+\w[\w ]* (Time|Stages|Fetches|Hits|Allocations|Allocated): \d+/
+-- s/: \d+(\.\d+)?$/: ###/
+-- end_matchsubs
+create table profile_t (a int, b int) distributed by (a);
+insert into profile_t select i, i from generate_series(1, 10) i;
+analyze profile_t;
+
+explain (optimizer_profile, costs off) select * from profile_t;
+explain (optimizer_profile off, costs off) select * from profile_t;
+
+-- The profile is added to the totals of the backend.
+select optimizations > 0 as profiled from gp_stat_optimizer_profile;
+
+-- No profile for a plan that GPORCA didn't make.
+set optimizer = off;
+explain (optimizer_profile, costs off) select * from profile_t;
+reset optimizer;
+
+drop table profile_t;
@@ -0,0 +1,52 @@
+--
+-- A catalog change evicts only the entries of the ORCA metadata cache that
+-- it affects. With the Postgres planner, the counters don't move.
+--
+create table mdcache_t1 (a int, b int) distributed by (a);
+create table mdcache_t2 (a int, b int) distributed by (a);
+insert into mdcache_t1 select i, i from generate_series(1, 100) i;
+insert into mdcache_t2 select i, i from generate_series(1, 100) i;
+analyze mdcache_t1;
+analyze mdcache_t2;
+
+-- Warm up the cache with both tables, and with the objects that the queries
+-- on gp_stat_optimizer_mdcache below use.
+-- start_ignore
+select count(*) from mdcache_t1 join mdcache_t2 using (a);
+select entries > 0, fetches = 0, fetches > 0, evictions > 0, resets = 0 from gp_stat_optimizer_mdcache;
+-- end_ignore
+
+select fetches as fetches_warm, hits as hits_warm from gp_stat_optimizer_mdcache \gset
+select count(*) from mdcache_t1 join mdcache_t2 using (a);
+select entries > 0 as tracked, fetches = :fetches_warm as cached,
+       hits > :hits_warm as hit
+from gp_stat_optimizer_mdcache;
+
+-- Changing one table evicts its entries, but not those of the other one.
+select fetches as fetches_before, evictions as evictions_before, resets as resets_before
+from gp_stat_optimizer_mdcache \gset
+alter table mdcache_t1 add column c int;
+select count(*) from mdcache_t2;
+select evictions > :evictions_before as evicted,
+       resets = :resets_before as not_reset,
+       fetches = :fetches_before as t2_cached
+from gp_stat_optimizer_mdcache;
+
+-- The changed table is translated again.
+select count(*) from mdcache_t1;
+select fetches > :fetches_before as t1_fetched from gp_stat_optimizer_mdcache;
+
+-- Creating a function evicts the cached types, operators, functions and
+-- aggregates, but the table itself is still found in the cache.
+select hits as hits_before, evictions as evictions_before, resets as resets_before
+from gp_stat_optimizer_mdcache \gset
+create function mdcache_f(int) returns int as 'select $1' language sql;
+select count(*) from mdcache_t2;
+select evictions > :evictions_before as evicted,
+       resets = :resets_before as not_reset,
+       hits > :hits_before as t2_hit
+from gp_stat_optimizer_mdcache;
+drop function mdcache_f(int);
+
+drop table mdcache_t1;
+drop table mdcache_t2;
@@ -0,0 +1,32 @@
+--
+-- Reuse of ORCA custom plans of prepared statements. With the Postgres
+-- planner, no plans are kept.
+--
+set optimizer_plan_cache_size = 4;
+
+create table plan_cache_t (a int, b int) distributed by (a);
+insert into plan_cache_t select i, i % 10 from generate_series(1, 100) i;
+analyze plan_cache_t;
+
+prepare plan_cache_q(int) as select count(*) from plan_cache_t where b = $1;
+
+-- The second execution with the same value reuses the plan, another value
+-- gets a plan of its own.
+execute plan_cache_q(1);
+execute plan_cache_q(1);
+execute plan_cache_q(2);
+select name, lookups, hits, cached_plans, saved_time > 0 as saved
+from gp_stat_optimizer_plan_cache;
+
+-- A change to the table releases the kept plans.
+alter table plan_cache_t add column c int;
+execute plan_cache_q(1);
+select name, lookups, hits, cached_plans from gp_stat_optimizer_plan_cache;
+execute plan_cache_q(1);
+select name, lookups, hits, cached_plans from gp_stat_optimizer_plan_cache;
+
+deallocate plan_cache_q;
+select count(*) from gp_stat_optimizer_plan_cache;
+
+drop table plan_cache_t;
+reset optimizer_plan_cache_size;